@@ -0,0 +1,312 @@
+/**
+ * \file
+ * \brief mulog benchmark that measures the cost of log calls in the configured mode
+ * \author Vladimir Petrigo
+ */
+#include "internal/config.h"
+#include "mulog.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <latch>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+    using bench_clock = std::chrono::steady_clock;
+
+#if defined(MULOG_ENABLE_DEFERRED_LOGGING) && MULOG_ENABLE_DEFERRED_LOGGING == 1
+    constexpr bool deferred_mode = true;
+#else
+    constexpr bool deferred_mode = false;
+#endif /* MULOG_ENABLE_DEFERRED_LOGGING */
+
+    /**
+     * \brief Number of log calls timed together, amortizes the clock read cost
+     */
+    constexpr size_t calls_per_sample = 32;
+    constexpr size_t default_samples = 2000;
+    constexpr size_t default_max_threads = 4;
+    constexpr size_t log_buffer_size = 64 * 1024;
+
+    std::mutex logger_mutex;
+    std::atomic<size_t> output_bytes{0};
+    const bench_clock::time_point start_time = bench_clock::now();
+
+    struct scenario {
+        std::string name;
+        size_t outputs;
+        mulog_log_level output_level;
+        std::function<int(size_t)> log;
+    };
+
+    struct producer_result {
+        std::vector<double> ns_per_call;
+        bench_clock::time_point begin;
+        bench_clock::time_point end;
+    };
+
+    struct result {
+        std::vector<double> ns_per_call;
+        double calls_per_second;
+        size_t dropped;
+    };
+
+    template <size_t Index>
+    void bench_output(const char *buf, const size_t buf_size)
+    {
+        static_cast<void>(buf);
+        output_bytes.fetch_add(buf_size, std::memory_order_relaxed);
+    }
+
+    template <size_t... Indexes>
+    constexpr auto make_outputs(std::index_sequence<Indexes...>)
+    {
+        return std::array<mulog_log_output_fn, sizeof...(Indexes)>{bench_output<Indexes>...};
+    }
+
+    constexpr auto outputs = make_outputs(std::make_index_sequence<MULOG_OUTPUT_HANDLERS>{});
+
+    double percentile(const std::vector<double> &sorted, const double rank)
+    {
+        const auto index = static_cast<size_t>(rank * static_cast<double>(sorted.size() - 1));
+
+        return sorted[index];
+    }
+
+    bool setup_logger(const scenario &bench, std::vector<char> &log_buffer)
+    {
+        mulog_reset();
+
+        if (mulog_set_log_buffer(log_buffer.data(), log_buffer.size()) != MULOG_RET_CODE_OK ||
+            mulog_set_log_level(bench.output_level) != MULOG_RET_CODE_OK) {
+            return false;
+        }
+
+        for (size_t i = 0; i < bench.outputs; ++i) {
+            if (mulog_add_output(outputs[i]) != MULOG_RET_CODE_OK) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    producer_result run_producer(const scenario &bench, const size_t samples, std::latch &start)
+    {
+        producer_result ret;
+#if defined(MULOG_ENABLE_THREAD_LOG_BUFFER) && MULOG_ENABLE_THREAD_LOG_BUFFER == 1
+        std::array<char, MULOG_SINGLE_LOG_LINE_SIZE + 64> thread_buffer{};
+
+        mulog_set_thread_log_buffer(thread_buffer.data(), thread_buffer.size());
+#endif /* MULOG_ENABLE_THREAD_LOG_BUFFER */
+
+        ret.ns_per_call.reserve(samples);
+        start.arrive_and_wait();
+        ret.begin = bench_clock::now();
+
+        for (size_t sample = 0; sample < samples; ++sample) {
+            const auto begin = bench_clock::now();
+
+            for (size_t call = 0; call < calls_per_sample; ++call) {
+                bench.log(sample * calls_per_sample + call);
+            }
+
+            const std::chrono::duration<double, std::nano> elapsed = bench_clock::now() - begin;
+
+            ret.ns_per_call.push_back(elapsed.count() / calls_per_sample);
+        }
+
+        ret.end = bench_clock::now();
+
+#if defined(MULOG_ENABLE_THREAD_LOG_BUFFER) && MULOG_ENABLE_THREAD_LOG_BUFFER == 1
+        mulog_set_thread_log_buffer(nullptr, 0);
+#endif /* MULOG_ENABLE_THREAD_LOG_BUFFER */
+
+        return ret;
+    }
+
+    result run_scenario(const scenario &bench, const size_t threads_count, const size_t samples)
+    {
+        std::vector<char> log_buffer(log_buffer_size);
+        std::vector<producer_result> thread_results(threads_count);
+        std::vector<std::thread> producers;
+        std::latch start{static_cast<std::ptrdiff_t>(threads_count)};
+        std::atomic<bool> done{false};
+
+        if (!setup_logger(bench, log_buffer)) {
+            std::fprintf(stderr, "%s: failed to set up the logger\n", bench.name.c_str());
+            std::exit(EXIT_FAILURE);
+        }
+
+        // deferred entries are drained by a single consumer while the producers are running
+        std::thread consumer([&done]() {
+            if constexpr (deferred_mode) {
+                while (!done.load(std::memory_order_acquire)) {
+                    if (mulog_deferred_process() == 0) {
+                        std::this_thread::yield();
+                    }
+                }
+
+                mulog_deferred_process();
+            }
+        });
+
+        for (size_t id = 0; id < threads_count; ++id) {
+            producers.emplace_back([&bench, &thread_results, &start, id, samples]() {
+                thread_results[id] = run_producer(bench, samples, start);
+            });
+        }
+
+        for (auto &producer : producers) {
+            producer.join();
+        }
+
+        done.store(true, std::memory_order_release);
+        consumer.join();
+
+        result ret{{}, 0.0, mulog_deferred_get_dropped_count()};
+        auto begin = thread_results.front().begin;
+        auto end = thread_results.front().end;
+
+        for (const auto &thread_result : thread_results) {
+            ret.ns_per_call.insert(ret.ns_per_call.end(), thread_result.ns_per_call.begin(),
+                                   thread_result.ns_per_call.end());
+            begin = std::min(begin, thread_result.begin);
+            end = std::max(end, thread_result.end);
+        }
+
+        const std::chrono::duration<double> elapsed = end - begin;
+
+        ret.calls_per_second = static_cast<double>(ret.ns_per_call.size() * calls_per_sample) /
+                               elapsed.count();
+
+        std::sort(ret.ns_per_call.begin(), ret.ns_per_call.end());
+        mulog_reset();
+
+        return ret;
+    }
+
+    std::vector<scenario> make_scenarios()
+    {
+        static const std::string payload(MULOG_SINGLE_LOG_LINE_SIZE, 'x');
+        std::vector<scenario> scenarios;
+
+        scenarios.push_back({"filtered level", 1, MULOG_LOG_LVL_WARNING,
+                             [](size_t i) { return MULOG_LOG_INFO("value %zu", i); }});
+        scenarios.push_back({"args: none", 1, MULOG_LOG_LVL_TRACE,
+                             [](size_t) { return MULOG_LOG_INFO("message"); }});
+        scenarios.push_back({"args: int", 1, MULOG_LOG_LVL_TRACE,
+                             [](size_t i) { return MULOG_LOG_INFO("value %zu", i); }});
+        scenarios.push_back({"args: double", 1, MULOG_LOG_LVL_TRACE, [](size_t i) {
+                                 return MULOG_LOG_INFO("value %f", static_cast<double>(i) / 3);
+                             }});
+        scenarios.push_back({"args: string", 1, MULOG_LOG_LVL_TRACE,
+                             [](size_t) { return MULOG_LOG_INFO("value %s", "string"); }});
+        scenarios.push_back({"args: mixed", 1, MULOG_LOG_LVL_TRACE, [](size_t i) {
+                                 return MULOG_LOG_INFO("%zu %s %f %x", i, "string",
+                                                       static_cast<double>(i) / 3,
+                                                       static_cast<unsigned int>(i));
+                             }});
+
+        for (const size_t size : {size_t{16}, size_t{64}, payload.size()}) {
+            if (size > payload.size()) {
+                continue;
+            }
+
+            scenarios.push_back(
+                {"size: " + std::to_string(size), 1, MULOG_LOG_LVL_TRACE, [size](size_t) {
+                     return MULOG_LOG_INFO("%.*s", static_cast<int>(size), payload.c_str());
+                 }});
+        }
+
+        for (size_t count = 2; count <= outputs.size(); ++count) {
+            scenarios.push_back({"outputs: " + std::to_string(count), count, MULOG_LOG_LVL_TRACE,
+                                 [](size_t i) { return MULOG_LOG_INFO("value %zu", i); }});
+        }
+
+        return scenarios;
+    }
+
+    size_t parse_arg(const int argc, char **argv, const int index, const size_t default_value)
+    {
+        if (argc <= index) {
+            return default_value;
+        }
+
+        const auto value = std::strtoul(argv[index], nullptr, 0);
+
+        return value > 0 ? value : default_value;
+    }
+
+    extern "C" bool mulog_config_mulog_lock(void)
+    {
+        logger_mutex.lock();
+
+        return true;
+    }
+
+    extern "C" bool mulog_config_mulog_trylock(void)
+    {
+        return logger_mutex.try_lock();
+    }
+
+    extern "C" void mulog_config_mulog_unlock(void)
+    {
+        logger_mutex.unlock();
+    }
+
+    extern "C" unsigned long mulog_config_mulog_timestamp_get(void)
+    {
+        const auto elapsed = bench_clock::now() - start_time;
+
+        return static_cast<unsigned long>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+    }
+
+    // required here to facilitate libprintf dependency requirements
+    extern "C" void putchar_(char c)
+    {
+        static_cast<void>(c);
+    }
+} // namespace
+
+/**
+ * \brief Benchmark entry point
+ *
+ * Usage: mulog_bench [samples per thread] [maximum number of producer threads]
+ */
+int main(int argc, char **argv)
+{
+    const size_t samples = parse_arg(argc, argv, 1, default_samples);
+    const size_t max_threads = parse_arg(argc, argv, 2, default_max_threads);
+
+    std::printf("mode: %s, outputs: %d, line size: %d, samples: %zu x %zu calls\n",
+                deferred_mode ? "deferred" : "realtime", MULOG_OUTPUT_HANDLERS,
+                MULOG_SINGLE_LOG_LINE_SIZE, samples, calls_per_sample);
+    std::printf("%-16s %7s %9s %9s %9s %9s %12s %9s\n", "scenario", "threads", "p50 ns", "p90 ns",
+                "p99 ns", "max ns", "calls/s", "dropped");
+
+    for (const auto &bench : make_scenarios()) {
+        for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+            const auto ret = run_scenario(bench, threads, samples);
+
+            std::printf("%-16s %7zu %9.1f %9.1f %9.1f %9.1f %12.0f %9zu\n", bench.name.c_str(),
+                        threads, percentile(ret.ns_per_call, 0.5), percentile(ret.ns_per_call, 0.9),
+                        percentile(ret.ns_per_call, 0.99), ret.ns_per_call.back(),
+                        ret.calls_per_second, ret.dropped);
+        }
+    }
+
+    std::printf("output bytes: %zu\n", output_bytes.load());
+
+    return EXIT_SUCCESS;
+}
@@ -29,6 +29,25 @@ void mulog_config_mulog_unlock(void)
 {
 }
 
+// only used with lock domains
+bool mulog_config_mulog_format_lock(void)
+{
+    return true;
+}
+
+void mulog_config_mulog_format_unlock(void)
+{
+}
+
+bool mulog_config_mulog_output_lock(void)
+{
+    return true;
+}
+
+void mulog_config_mulog_output_unlock(void)
+{
+}
+
 static void output1_fn(const char *data, const size_t data_size)
 {
     printf("Output 1: %.*s", (int)data_size, data);
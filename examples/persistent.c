@@ -0,0 +1,121 @@
+/**
+ * \file
+ * \brief Example with mulog in deferred output mode with the log buffer placed in a memory-mapped
+ * file, log entries that have not been processed before a crash are recovered on the next run
+ * \author Vladimir Petrigo
+ */
+#include "mulog.h"
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define LOG_FILE_SIZE 4096
+
+unsigned long mulog_config_mulog_timestamp_get(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+
+    return tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+bool mulog_config_mulog_lock(void)
+{
+    return true;
+}
+
+void mulog_config_mulog_unlock(void)
+{
+}
+
+// only used with lock domains
+bool mulog_config_mulog_format_lock(void)
+{
+    return true;
+}
+
+void mulog_config_mulog_format_unlock(void)
+{
+}
+
+bool mulog_config_mulog_output_lock(void)
+{
+    return true;
+}
+
+void mulog_config_mulog_output_unlock(void)
+{
+}
+
+static void output_fn(const char *data, const size_t data_size)
+{
+    printf("%.*s", (int)data_size, data);
+}
+
+static void recovered_fn(const char *data, const size_t data_size)
+{
+    printf("Recovered: %.*s", (int)data_size, data);
+}
+
+// required here to facilitate libprintf dependency requirements
+void putchar_(char c)
+{
+    (void)c;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <log file> [crash]\n", argv[0]);
+
+        return 1;
+    }
+
+    const int fd = open(argv[1], O_RDWR | O_CREAT, 0644);
+
+    if (fd < 0 || ftruncate(fd, LOG_FILE_SIZE) != 0) {
+        perror("open");
+
+        return 1;
+    }
+
+    char *buffer = mmap(NULL, LOG_FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (buffer == MAP_FAILED) {
+        perror("mmap");
+
+        return 1;
+    }
+
+    // entries left by the previous run must be taken before the buffer is set again
+    const int recovered = mulog_deferred_recover(buffer, LOG_FILE_SIZE, recovered_fn);
+
+    if (recovered >= 0) {
+        printf("%d bytes recovered\n", recovered);
+    }
+
+    mulog_set_persistent_log_buffer(buffer, LOG_FILE_SIZE);
+    mulog_set_log_level(MULOG_LOG_LVL_TRACE);
+    mulog_add_output(output_fn);
+
+    MULOG_LOG_DBG("Hello");
+    MULOG_LOG_WARN("World!");
+    MULOG_LOG_ERR("Error: 123456");
+
+    // exit without processing, the entries are recovered by the next run
+    if (argc > 2 && strcmp(argv[2], "crash") == 0) {
+        _exit(2);
+    }
+
+    mulog_deferred_process();
+    mulog_reset();
+    munmap(buffer, LOG_FILE_SIZE);
+
+    return 0;
+}
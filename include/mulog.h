@@ -11,6 +11,7 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
 #include <stddef.h>
 
 /**
@@ -20,6 +21,18 @@ extern "C" {
 
 #define MULOG_PRINTF_ATTR                                                                          \
     __attribute__((format(printf, 2, 3))) /**< Printf-like function attribute */
+#define MULOG_INSTANCE_PRINTF_ATTR                                                                 \
+    __attribute__((format(printf, 3, 4))) /**< Printf-like instance function attribute */
+
+/**
+ * \brief Lowest log level compiled into the log level macros
+ * \details Numeric value of a mulog_log_level entry. Macros of the levels below it expand to
+ * a constant 0, so their log calls and format strings are not compiled in. Set by the
+ * `MULOG_COMPILE_TIME_LEVEL` CMake option.
+ */
+#if !defined(MULOG_COMPILE_TIME_LEVEL)
+#define MULOG_COMPILE_TIME_LEVEL 0
+#endif
 
 /**
  * \brief Log levels
@@ -34,6 +47,15 @@ enum mulog_log_level {
     MULOG_LOG_LVL_COUNT,
 };
 
+/**
+ * \brief Deferred mode policies for a log entry that does not fit into the log buffer
+ */
+enum mulog_overflow_policy {
+    MULOG_OVERFLOW_DROP_NEWEST, /**< Drop the new log entry */
+    MULOG_OVERFLOW_DROP_OLDEST, /**< Drop the oldest stored log entries until the new one fits */
+    MULOG_OVERFLOW_BLOCK,       /**< Retry until the consumer frees space or a spin limit is hit */
+};
+
 enum mulog_ret_code {
     MULOG_RET_CODE_OK = 0,
     MULOG_RET_CODE_NO_MEM = -1,
@@ -43,6 +65,65 @@ enum mulog_ret_code {
     MULOG_RET_CODE_LOCK_FAILED = -5,
 };
 
+/**
+ * \brief Lowest log level accepted by at least one registered output
+ * \details Private, maintained by the library and read by the log macros to skip disabled log calls
+ * without taking the logger lock. Set to MULOG_LOG_LVL_COUNT if there are no outputs registered.
+ */
+extern enum mulog_log_level mulog_min_log_level;
+
+#if defined(MULOG_ENABLE_CALL_SITES) && MULOG_ENABLE_CALL_SITES == 1
+/**
+ * \brief Log call site descriptor
+ * \details Every log level macro expansion places a static descriptor into the `mulog_call_sites`
+ * linker section. A disabled call site skips the log call with a single load.
+ */
+struct mulog_call_site {
+    const char *fmt;            /**< Format string of the log call */
+    const char *file;           /**< Source file of the log call */
+    unsigned int line;          /**< Source line of the log call */
+    enum mulog_log_level level; /**< Log level of the log call */
+    bool enabled;               /**< Whether the log call is enabled */
+};
+
+/**
+ * \brief Call site enumeration callback
+ * \param[in] site Call site descriptor
+ * \param[in] arg User argument passed to mulog_call_site_for_each()
+ */
+typedef void (*mulog_call_site_fn)(struct mulog_call_site *site, void *arg);
+#endif /* MULOG_ENABLE_CALL_SITES */
+
+/**
+ * \brief Limits of a single mulog_deferred_process_budget() call, 0 disables a limit
+ */
+struct mulog_process_budget {
+    size_t max_bytes;          /**< Number of output bytes after which processing stops */
+    size_t max_records;        /**< Number of log entries after which processing stops */
+    unsigned long max_time_ms; /**< Processing time measured with the timestamp function */
+};
+
+#if defined(MULOG_ENABLE_DRAIN_WORKER) && MULOG_ENABLE_DRAIN_WORKER == 1
+/**
+ * \brief Deferred mode drain worker configuration
+ */
+struct mulog_drain_worker_config {
+    size_t watermark;             /**< Log buffer usage in bytes that wakes the worker up */
+    unsigned long max_latency_ms; /**< Maximum time a stored log entry waits for the worker */
+};
+#endif /* MULOG_ENABLE_DRAIN_WORKER */
+
+#if defined(MULOG_ENABLE_NONBLOCKING_LOG) && MULOG_ENABLE_NONBLOCKING_LOG == 1
+/**
+ * \brief Counters of log calls that have found the logger lock taken
+ */
+struct mulog_contention_stats {
+    size_t contended; /**< Log calls that have not acquired the lock at the first try */
+    size_t spilled;   /**< Contended log entries kept in the spill slot of the calling thread */
+    size_t dropped;   /**< Contended log entries dropped as the spill slot was already taken */
+};
+#endif /* MULOG_ENABLE_NONBLOCKING_LOG */
+
 /**
  * \brief Function definition to be used by mulog for performing logging to a preferred interface/environment
  * \details mulog provides a log line string to this function, and it is up to a caller to send it properly to an
@@ -53,6 +134,53 @@ enum mulog_ret_code {
  */
 typedef void (*mulog_log_output_fn)(const char *, size_t);
 
+/**
+ * \brief Log line passed to a vectored output function
+ */
+struct mulog_iovec {
+    const char *base; /**< Log line, not null-terminated */
+    size_t len;       /**< Log line size in bytes */
+};
+
+/**
+ * \brief Vectored output function definition
+ * \details Takes several log lines at once, so a sink can write them with a single `writev()` call.
+ * Lines are in the logging order and are only valid during the call. Only supported in deferred
+ * mode, where up to `MULOG_OUTPUT_BATCH_SIZE` lines are passed per call.
+ */
+typedef void (*mulog_log_output_vec_fn)(const struct mulog_iovec *lines, size_t count);
+
+/**
+ * \brief Output function with a user context
+ * \details Takes a log line the same way as mulog_log_output_fn. The context lets a single
+ * function serve several sinks, for example, a file per shard, without global state.
+ */
+typedef void (*mulog_output_write_fn)(void *ctx, const char *data, size_t data_size);
+
+/**
+ * \brief Function called once an output with a user context is removed from the logger
+ * \details Lets a buffered sink flush pending data and release its resources. Called with the
+ * logger lock held, so it must not call the logger.
+ */
+typedef void (*mulog_output_close_fn)(void *ctx);
+
+/**
+ * \brief Output with a user context
+ */
+struct mulog_output {
+    mulog_output_write_fn write; /**< Writes a log line */
+    mulog_output_close_fn close; /**< Optional, called once the output is removed */
+    void *ctx;                   /**< User context passed to the functions */
+};
+
+/**
+ * \brief Storage of a single registered output
+ * \details Private, only used to size the output registry passed to mulog_set_output_registry().
+ */
+struct mulog_output_slot {
+    void *reserved[12]; /**< Output state managed by the library */
+};
+
 /**
  * \brief Set log buffer to be used for formatting log lines
  * \param[in] buf Logging buffer storage
@@ -60,6 +188,70 @@ typedef void (*mulog_log_output_fn)(const char *, size_t);
  */
 enum mulog_ret_code mulog_set_log_buffer(char *buf, size_t buf_size);
 
+/**
+ * \brief Set log buffer reserved for warning and error entries in deferred mode
+ * \details Warning and error entries are stored in this buffer, so a flood of lower level entries
+ * does not make them dropped. mulog_deferred_process() outputs them before other entries. While
+ * the buffer is set, every stored log line starts with a `#<N> ` sequence number, which restores
+ * the logging order, gaps in the sequence show dropped entries. Must be set before log calls that
+ * may use it.
+ * \param[in] buf Priority log buffer storage, NULL to store all entries in the log buffer
+ * \param[in] buf_size Size of the buffer storage
+ * \return MULOG_RET_CODE_OK on success, MULOG_RET_CODE_UNSUPPORTED in realtime mode
+ */
+enum mulog_ret_code mulog_set_priority_log_buffer(char *buf, size_t buf_size);
+
+/**
+ * \brief Set flight recorder buffer for log entries below the persist level in deferred mode
+ * \details Log entries below the persist level are only kept in the flight recorder, the oldest
+ * ones are overwritten by new ones, so they cost a copy into memory and never reach the outputs in
+ * steady state. An error entry or mulog_flight_recorder_dump() moves the recorded entries to the
+ * log buffer ahead of the error, so the outputs get the context of the error. The global log level
+ * has to allow the recorded levels.
+ * \param[in] buf Flight recorder storage, NULL to remove the flight recorder
+ * \param[in] buf_size Size of the buffer storage, limits the number of recorded entries
+ * \param[in] persist_level Entries of this and higher levels are stored in the log buffer
+ * \return MULOG_RET_CODE_OK on success, MULOG_RET_CODE_INVALID_ARG for an invalid log level or a
+ * buffer that is too small, MULOG_RET_CODE_UNSUPPORTED in realtime mode or in lock-free mode
+ */
+enum mulog_ret_code mulog_set_flight_recorder(char *buf, size_t buf_size,
+                                              enum mulog_log_level persist_level);
+
+/**
+ * \brief Move log entries kept in the flight recorder to the log buffer
+ * \details The entries are output by the next mulog_deferred_process() call. Entries that do not
+ * fit into the log buffer are counted as dropped.
+ * \return Number of entries taken from the flight recorder, MULOG_RET_CODE_UNSUPPORTED in realtime
+ * mode or in lock-free mode
+ */
+int mulog_flight_recorder_dump(void);
+
+/**
+ * \brief Set log buffer that keeps not yet processed log entries over a crash in deferred mode
+ * \details Used instead of the buffer set with mulog_set_log_buffer(). The buffer starts with a
+ * header that keeps read and write positions protected with checksums, so the buffer may be
+ * placed in a memory-mapped file or a memory region that survives a reset, and log entries that
+ * have not been processed before a crash are recovered with mulog_deferred_recover(). Previous
+ * buffer content is dropped, so it must be recovered before the buffer is set. Entries stored in
+ * the priority log buffer are not recovered.
+ * \param[in] buf Log buffer storage aligned to 4 bytes
+ * \param[in] buf_size Size of the buffer storage
+ * \return MULOG_RET_CODE_OK on success, MULOG_RET_CODE_INVALID_ARG if the buffer is misaligned or
+ * too small, MULOG_RET_CODE_UNSUPPORTED in realtime mode or with the deferred arguments capture
+ */
+enum mulog_ret_code mulog_set_persistent_log_buffer(char *buf, size_t buf_size);
+
+/**
+ * \brief Set log buffer to be used for formatting log lines in the calling thread
+ * \details Log lines of the calling thread are formatted into the given buffer without taking
+ * the logger lock, only the output dispatch is serialized. Requires realtime mode with
+ * `MULOG_ENABLE_THREAD_LOG_BUFFER` enabled. The buffer must stay valid until it is replaced, or
+ * removed by passing NULL, or the thread exits.
+ * \param[in] buf Logging buffer storage, NULL to use the buffer set with mulog_set_log_buffer()
+ * \param[in] buf_size Size of the buffer storage
+ */
+enum mulog_ret_code mulog_set_thread_log_buffer(char *buf, size_t buf_size);
+
 /**
  * \brief Set logger global log level
  * \param[in] level Log level below which log calls are ignored
@@ -79,6 +271,10 @@ enum mulog_ret_code mulog_set_channel_log_level(mulog_log_output_fn output,
 
 /**
  * \brief Add output function that will be used for logging
+ * \details Outputs and their log levels are published as a snapshot that is replaced as a whole on
+ * every change, so passing log entries to the outputs does not depend on the logger lock. A change
+ * does not wait for the outputs of the previous snapshot, the removed outputs are closed once no
+ * log entry is passed to them. Until then the next change returns MULOG_RET_CODE_LOCK_FAILED.
  * \param[in] output Logging output function
  */
 enum mulog_ret_code mulog_add_output(mulog_log_output_fn output);
@@ -97,10 +293,66 @@ enum mulog_ret_code mulog_add_output_with_log_level(mulog_log_output_fn output,
  */
 enum mulog_ret_code mulog_unregister_output(mulog_log_output_fn output);
 
+/**
+ * \brief Add vectored output function that will be used for logging
+ * \details Lines below the given level are filtered out of the lines passed to the output.
+ * The output is affected by mulog_set_log_level() the same way as other outputs.
+ * \param[in] output Vectored logging output function
+ * \param[in] level Log level to set for the channel
+ * \return MULOG_RET_CODE_OK on success, MULOG_RET_CODE_UNSUPPORTED in realtime mode
+ */
+enum mulog_ret_code mulog_add_output_vec(mulog_log_output_vec_fn output,
+                                         enum mulog_log_level level);
+
+/**
+ * \brief Remove the given vectored output function from the logger
+ * \param[in] output Vectored output function
+ */
+enum mulog_ret_code mulog_unregister_output_vec(mulog_log_output_vec_fn output);
+
+/**
+ * \brief Add output with a user context that will be used for logging
+ * \details The output descriptor is copied into the output registry, so it does not have to stay
+ * valid after the call. Several outputs may share the write function as long as their contexts
+ * differ. The output is affected by mulog_set_log_level() the same way as other outputs.
+ * \param[in] output Output descriptor
+ * \param[in] level Log level to set for the channel
+ * \return MULOG_RET_CODE_OK on success, MULOG_RET_CODE_INVALID_ARG for a NULL descriptor or write
+ * function or an invalid log level, MULOG_RET_CODE_NO_MEM if the output registry is full
+ */
+enum mulog_ret_code mulog_add_output_ctx(const struct mulog_output *output,
+                                         enum mulog_log_level level);
+
+/**
+ * \brief Remove the output with the given write function and context from the logger
+ * \details Calls the close function of the output after the output has been removed.
+ * mulog_unregister_all_outputs() and mulog_reset() close the removed outputs as well.
+ * \param[in] write Write function of the output
+ * \param[in] ctx User context of the output
+ */
+enum mulog_ret_code mulog_unregister_output_ctx(mulog_output_write_fn write, const void *ctx);
+
+/**
+ * \brief Set storage for registered outputs
+ * \details By default up to `MULOG_OUTPUT_HANDLERS` outputs can be registered. A registry provided
+ * by the caller replaces the built-in storage and the registered outputs are moved to it, so the
+ * number of outputs is only limited by the registry size. The registry can be grown at runtime by
+ * setting a larger one, which must not overlap the current one. The registry must stay valid until
+ * it is replaced or mulog_reset() is called, the replaced registry is no longer used once no log
+ * entry is passed to the outputs kept in it.
+ * \param[in] slots Registry storage, NULL to go back to the built-in storage
+ * \param[in] count Number of registry slots
+ * \return MULOG_RET_CODE_OK on success, MULOG_RET_CODE_INVALID_ARG for an empty registry or the
+ * registry in use, MULOG_RET_CODE_NO_MEM if the registered outputs do not fit into the registry
+ */
+enum mulog_ret_code mulog_set_output_registry(struct mulog_output_slot *slots, size_t count);
+
 /**
  * \brief Remove all registered outputs
+ * \return MULOG_RET_CODE_OK on success, MULOG_RET_CODE_LOCK_FAILED if the lock can not be taken or
+ * the outputs replaced by the previous change are still in use
  */
-void mulog_unregister_all_outputs(void);
+enum mulog_ret_code mulog_unregister_all_outputs(void);
 
 /**
  * \brief Reset mulog module
@@ -114,7 +366,7 @@ void mulog_reset(void);
  * executing any pending log operations that were deferred.
  *
  * \warning This function must be called by a single log consumer, as it does not include
- * any locking mechanisms.
+ * any locking mechanisms unless the MULOG_OVERFLOW_DROP_OLDEST policy is set.
  * It interacts with the underlying circular buffer to read as much data as possible and sends that
  * data to the registered outputs.
  *
@@ -123,6 +375,311 @@ void mulog_reset(void);
  */
 int mulog_deferred_process(void);
 
+/**
+ * \brief Processes deferred log entries until the log buffer is empty or the budget is exhausted
+ * \details Limits are checked before every log entry, so the entry that exceeds a limit is output
+ * whole and at least one entry is output per call. Has the same single consumer requirement as
+ * mulog_deferred_process().
+ * \param[in] budget Processing limits
+ * \param[out] remaining Optional, set to the number of log buffer bytes still in use
+ * \return Number of bytes passed to the outputs, MULOG_RET_CODE_INVALID_ARG if the budget is NULL,
+ * MULOG_RET_CODE_UNSUPPORTED in realtime mode or for a time limit without the timestamp output
+ */
+int mulog_deferred_process_budget(const struct mulog_process_budget *budget, size_t *remaining);
+
+/**
+ * \brief Get the number of log entries dropped in deferred mode
+ * \details A log entry is dropped as a whole if it does not fit into the free space of the log
+ * buffer. The counter is reset by mulog_reset(). Always returns 0 in realtime mode.
+ * \return Number of log entries dropped since the last reset
+ */
+size_t mulog_deferred_get_dropped_count(void);
+
+/**
+ * \brief Pass log entries left in a persistent log buffer to the output function
+ * \details Takes the content of a buffer previously set with mulog_set_persistent_log_buffer(),
+ * for example, after the program that used it has crashed, and passes not yet processed log
+ * entries to the output in the logging order. The buffer content is not changed. The buffer must
+ * not be the one currently set for logging. Does not take the logger lock. Entries of log calls
+ * interrupted by the crash are skipped, with the same lock-free mode limitation as
+ * mulog_deferred_emergency_flush().
+ * \param[in] buf Persistent log buffer storage
+ * \param[in] buf_size Size of the buffer storage
+ * \param[in] output Output function to pass recovered log entries to
+ * \return Number of bytes passed to the output, MULOG_RET_CODE_NOT_FOUND if the buffer does not
+ * keep a valid header, MULOG_RET_CODE_INVALID_ARG for a NULL buffer or output,
+ * MULOG_RET_CODE_UNSUPPORTED in realtime mode or with the deferred arguments capture
+ */
+int mulog_deferred_recover(const char *buf, size_t buf_size, mulog_log_output_fn output);
+
+/**
+ * \brief Pass log entries stored in deferred mode to the raw write function from a crash handler
+ * \details Async-signal-safe, meant to be called from a SIGSEGV or SIGABRT handler: does not take
+ * the logger lock, does not call registered outputs or the timestamp callback and does not modify
+ * the log buffer, so it is safe to interrupt a log call or mulog_deferred_process() with it.
+ * Stored entries are passed to the write function, priority entries first and flight recorder
+ * entries next, followed by an error line with the given message. Entries are not removed, the
+ * function is meant to be the last logger call of the program. The entry of an interrupted log
+ * call is not complete and is skipped. In lock-free mode a log call interrupted right after it
+ * has reserved its entry, before the entry is marked as busy, hides the entries stored after it.
+ * \param[in] write Raw write function, must be async-signal-safe itself, e.g. a `write()` call
+ * \param[in] message Final record message, NULL to skip the final record
+ * \return Number of bytes passed to the write function, MULOG_RET_CODE_INVALID_ARG if the write
+ * function is NULL, MULOG_RET_CODE_LOCK_FAILED if another emergency flush is running,
+ * MULOG_RET_CODE_UNSUPPORTED in realtime mode
+ */
+int mulog_deferred_emergency_flush(mulog_log_output_fn write, const char *message);
+
+/**
+ * \brief Get the number of dropped log entries of the given log level in deferred mode
+ * \param[in] level Log level
+ * \return Number of log entries of the level dropped since the last reset, 0 in realtime mode
+ */
+size_t mulog_deferred_get_level_dropped_count(enum mulog_log_level level);
+
+/**
+ * \brief Set the deferred mode policy for log entries that do not fit into the log buffer
+ * \details Every dropped entry is counted, and the next mulog_deferred_process() call passes a
+ * "N log entries dropped" line to all outputs before the stored entries.
+ * With MULOG_OVERFLOW_DROP_OLDEST, mulog_deferred_process() takes the logger lock, as producers
+ * remove stored entries. The policy must not be switched to it while entries are processed.
+ * The policy is reset to MULOG_OVERFLOW_DROP_NEWEST by mulog_reset().
+ * \param[in] policy Overflow policy
+ * \param[in] spin_limit Number of retries before a log entry is dropped with MULOG_OVERFLOW_BLOCK
+ * \return MULOG_RET_CODE_OK on success, MULOG_RET_CODE_UNSUPPORTED in realtime mode or for
+ * MULOG_OVERFLOW_DROP_OLDEST in lock-free mode, MULOG_RET_CODE_INVALID_ARG for an unknown policy
+ */
+enum mulog_ret_code mulog_deferred_set_overflow_policy(enum mulog_overflow_policy policy,
+                                                       size_t spin_limit);
+
+#if defined(MULOG_ENABLE_DRAIN_WORKER) && MULOG_ENABLE_DRAIN_WORKER == 1
+/**
+ * \brief Start the deferred mode drain worker
+ * \details The worker runs in its own thread and calls mulog_deferred_process(), so the
+ * application must not call it while the worker is running. The worker sleeps until the log
+ * buffer usage reaches the watermark or the maximum latency expires, a watermark of 0 wakes it up
+ * for every stored entry. A log call only wakes the sleeping worker up, outputs are never called
+ * from the log call. Calling the function while the worker is running updates its configuration.
+ * \param[in] config Worker configuration
+ * \return MULOG_RET_CODE_OK on success, MULOG_RET_CODE_INVALID_ARG if the configuration is NULL or
+ * the maximum latency is 0, MULOG_RET_CODE_NO_MEM if the worker thread has not been started
+ */
+enum mulog_ret_code mulog_deferred_worker_start(const struct mulog_drain_worker_config *config);
+
+/**
+ * \brief Stop the deferred mode drain worker
+ * \details Waits until the worker drains the log buffer and exits. Called by mulog_reset().
+ */
+void mulog_deferred_worker_stop(void);
+#endif /* MULOG_ENABLE_DRAIN_WORKER */
+
+#if defined(MULOG_ENABLE_NONBLOCKING_LOG) && MULOG_ENABLE_NONBLOCKING_LOG == 1
+/**
+ * \brief Get the contention counters of the default logger
+ * \details Log calls take the logger lock with mulog_config_mulog_trylock(). A log call that finds
+ * the lock taken returns 0 without waiting. Its entry is formatted into the spill slot of the
+ * calling thread and logged before the next entry of the thread once the lock is acquired, or
+ * dropped if the slot already keeps an entry. mulog_reset() clears the counters and discards the
+ * spilled entries of all threads.
+ * \return Contention counters of the default logger
+ */
+struct mulog_contention_stats mulog_get_contention_stats(void);
+
+/**
+ * \brief Log the entry kept in the spill slot of the calling thread
+ * \details Waits for the lock of the instance the entry has been logged with. A thread that stops
+ * logging calls it to pass its last contended entry to the outputs.
+ * \return Number of bytes logged, 0 if the spill slot is empty, MULOG_RET_CODE_LOCK_FAILED if the
+ * lock has not been acquired
+ */
+int mulog_flush_spill_slot(void);
+#endif /* MULOG_ENABLE_NONBLOCKING_LOG */
+
+#if defined(MULOG_ENABLE_CALL_SITES) && MULOG_ENABLE_CALL_SITES == 1
+/**
+ * \brief Get the number of log call sites in the program
+ * \return Number of log level macro expansions linked into the program
+ */
+size_t mulog_call_site_count(void);
+
+/**
+ * \brief Get a log call site descriptor
+ * \details The index of a call site does not change while the program runs, so it can be used as
+ * a call site ID.
+ * \param[in] index Call site index, less than mulog_call_site_count()
+ * \return Call site descriptor, or NULL if the index is out of range
+ */
+struct mulog_call_site *mulog_call_site_get(size_t index);
+
+/**
+ * \brief Call a function for every log call site in the program
+ * \param[in] fn Function to call
+ * \param[in] arg User argument passed to the function
+ */
+void mulog_call_site_for_each(mulog_call_site_fn fn, void *arg);
+
+/**
+ * \brief Enable or disable log call sites
+ * \details A call site matches if its source file path ends with `file` and it is at the given
+ * line. A disabled call site does not log regardless of the log levels.
+ * \param[in] file Source file path suffix, NULL to match any file
+ * \param[in] line Source line, 0 to match any line
+ * \param[in] enabled Whether to enable or disable the matching call sites
+ * \return Number of matching call sites
+ */
+size_t mulog_call_site_enable(const char *file, unsigned int line, bool enabled);
+#endif /* MULOG_ENABLE_CALL_SITES */
+
+/**
+ * \brief Logger instance
+ * \details Opaque handle of a logger with its own log buffer, log level, outputs and lock, so
+ * subsystems do not share the logger state. Instances are taken from a static pool of
+ * `MULOG_INSTANCES` entries. The global API works with the default instance, which is also
+ * referred to by a NULL handle. Advanced configuration such as the priority log buffer, the flight
+ * recorder, the overflow policy and the drain worker is only available for the default instance,
+ * as well as the log macros.
+ */
+struct mulog_instance;
+
+/**
+ * \brief Logger instance lock callbacks
+ * \details Serialize the instance in the same way mulog_config_mulog_lock() and
+ * mulog_config_mulog_unlock() serialize the default instance, so instances used by different
+ * subsystems do not contend for a single lock. In non-blocking mode log calls take the lock with
+ * the try-lock callback, which is required there and must not wait for the lock.
+ */
+struct mulog_instance_lock {
+    bool (*lock)(void *arg);   /**< Acquires the lock, returns false if it has not been acquired */
+    void (*unlock)(void *arg); /**< Releases the lock */
+    void *arg;                 /**< User argument passed to the callbacks */
+#if defined(MULOG_ENABLE_NONBLOCKING_LOG) && MULOG_ENABLE_NONBLOCKING_LOG == 1
+    bool (*trylock)(void *arg); /**< Acquires the lock only if it is free */
+#endif /* MULOG_ENABLE_NONBLOCKING_LOG */
+};
+
+/**
+ * \brief Create a logger instance
+ * \details The instance starts in the state of the default instance after mulog_reset(): no log
+ * buffer, no outputs and the debug global log level.
+ * \param[in] lock Instance lock callbacks, copied into the instance, NULL to use
+ * mulog_config_mulog_lock() and mulog_config_mulog_unlock()
+ * \return Instance handle, or NULL if all instances are in use (there are none if
+ * `MULOG_INSTANCES` is 0), the lock callbacks are incomplete (including a missing trylock callback
+ * in non-blocking mode) or the global lock has not been acquired
+ */
+struct mulog_instance *mulog_instance_init(const struct mulog_instance_lock *lock);
+
+/**
+ * \brief Release a logger instance
+ * \details Removes the instance outputs and log buffer and returns the instance to the pool, the
+ * handle must not be used afterwards. Does nothing for the default instance.
+ * \param[in] instance Instance handle
+ */
+void mulog_instance_deinit(struct mulog_instance *instance);
+
+/**
+ * \brief Set log buffer of a logger instance, see mulog_set_log_buffer()
+ * \param[in] instance Instance handle, NULL for the default instance
+ * \param[in] buf Logging buffer storage
+ * \param[in] buf_size Size of the buffer storage
+ */
+enum mulog_ret_code mulog_instance_set_log_buffer(struct mulog_instance *instance, char *buf,
+                                                  size_t buf_size);
+
+/**
+ * \brief Set global log level of a logger instance, see mulog_set_log_level()
+ * \param[in] instance Instance handle, NULL for the default instance
+ * \param[in] level Log level below which log calls are ignored
+ */
+enum mulog_ret_code mulog_instance_set_log_level(struct mulog_instance *instance,
+                                                 enum mulog_log_level level);
+
+/**
+ * \brief Add output function to a logger instance
+ * \param[in] instance Instance handle, NULL for the default instance
+ * \param[in] output Logging output function
+ * \param[in] level Log level to set for the channel
+ */
+enum mulog_ret_code mulog_instance_add_output(struct mulog_instance *instance,
+                                              mulog_log_output_fn output,
+                                              enum mulog_log_level level);
+
+/**
+ * \brief Remove the given output function from a logger instance
+ * \param[in] instance Instance handle, NULL for the default instance
+ * \param[in] output Output function
+ */
+enum mulog_ret_code mulog_instance_unregister_output(struct mulog_instance *instance,
+                                                     mulog_log_output_fn output);
+
+/**
+ * \brief Add output with a user context to a logger instance, see mulog_add_output_ctx()
+ * \param[in] instance Instance handle, NULL for the default instance
+ * \param[in] output Output descriptor
+ * \param[in] level Log level to set for the channel
+ */
+enum mulog_ret_code mulog_instance_add_output_ctx(struct mulog_instance *instance,
+                                                  const struct mulog_output *output,
+                                                  enum mulog_log_level level);
+
+/**
+ * \brief Remove output with a user context from a logger instance, see
+ * mulog_unregister_output_ctx()
+ * \param[in] instance Instance handle, NULL for the default instance
+ * \param[in] write Write function of the output
+ * \param[in] ctx User context of the output
+ */
+enum mulog_ret_code mulog_instance_unregister_output_ctx(struct mulog_instance *instance,
+                                                         mulog_output_write_fn write,
+                                                         const void *ctx);
+
+/**
+ * \brief Set storage for outputs of a logger instance, see mulog_set_output_registry()
+ * \details mulog_instance_deinit() makes the instance go back to the built-in storage.
+ * \param[in] instance Instance handle, NULL for the default instance
+ * \param[in] slots Registry storage, NULL to go back to the built-in storage
+ * \param[in] count Number of registry slots
+ */
+enum mulog_ret_code mulog_instance_set_output_registry(struct mulog_instance *instance,
+                                                       struct mulog_output_slot *slots,
+                                                       size_t count);
+
+/**
+ * \brief Process deferred log entries of a logger instance, see mulog_deferred_process()
+ * \param[in] instance Instance handle, NULL for the default instance
+ * \return Number of bytes passed to the outputs, MULOG_RET_CODE_UNSUPPORTED in realtime mode
+ */
+int mulog_instance_process(struct mulog_instance *instance);
+
+/**
+ * \brief Get the number of log entries dropped by a logger instance in deferred mode
+ * \param[in] instance Instance handle, NULL for the default instance
+ * \return Number of log entries dropped since the instance has been created
+ */
+size_t mulog_instance_get_dropped_count(struct mulog_instance *instance);
+
+/**
+ * \brief Log a message through a logger instance, see mulog_log()
+ * \details Takes the instance lock, unless lock-free mode is enabled.
+ * \param[in] instance Instance handle, NULL for the default instance
+ * \param[in] level Log level of the message
+ * \param[in] fmt Format string for the log message, similar to printf
+ * \param[in] ... Additional arguments for the format string
+ * \return Number of bytes logged, or 0 if the message has been filtered out
+ */
+int mulog_instance_log(struct mulog_instance *instance, enum mulog_log_level level,
+                       const char *fmt, ...) MULOG_INSTANCE_PRINTF_ATTR;
+
+#if defined(MULOG_ENABLE_NONBLOCKING_LOG) && MULOG_ENABLE_NONBLOCKING_LOG == 1
+/**
+ * \brief Get the contention counters of a logger instance, see mulog_get_contention_stats()
+ * \param[in] instance Instance handle, NULL for the default instance
+ * \return Contention counters since the instance has been created
+ */
+struct mulog_contention_stats
+mulog_instance_get_contention_stats(struct mulog_instance *instance);
+#endif /* MULOG_ENABLE_NONBLOCKING_LOG */
+
 /**
  * \brief Logs messages at the specified log level
  *
@@ -137,10 +694,66 @@ int mulog_deferred_process(void);
  */
 int mulog_log(enum mulog_log_level level, const char *fmt, ...) MULOG_PRINTF_ATTR;
 
+/**
+ * \brief Checks whether a log entry of the given level may be output by any registered output
+ * \details The check does not take the logger lock and is used by the log macros to skip a log call
+ * before its arguments are evaluated. A concurrent configuration change may be observed with
+ * a delay, mulog_log() checks the log level again under the logger lock.
+ * \param level Log level to check
+ * \return Non-zero if the log level is enabled, 0 otherwise
+ */
+static inline int mulog_is_log_level_enabled(const enum mulog_log_level level)
+{
+    return level >= MULOG_COMPILE_TIME_LEVEL &&
+           level >= __atomic_load_n(&mulog_min_log_level, __ATOMIC_RELAXED);
+}
+
+/**
+ * \brief Logs a message at the given level if any registered output accepts it
+ * \details Private, used by the log level macros. With call sites enabled, the expansion also
+ * registers a call site descriptor and is skipped if the call site is disabled.
+ */
+#if defined(MULOG_ENABLE_CALL_SITES) && MULOG_ENABLE_CALL_SITES == 1
+#define MULOG_LOG_ENABLED(level, fmt, ...)                                                         \
+    __extension__({                                                                                \
+        static struct mulog_call_site mulog_call_site_                                             \
+            __attribute__((section("mulog_call_sites"), used)) = {fmt, __FILE__, __LINE__, level,  \
+                                                                  true};                           \
+        (__atomic_load_n(&mulog_call_site_.enabled, __ATOMIC_RELAXED) &&                           \
+         mulog_is_log_level_enabled(level))                                                        \
+            ? mulog_log(level, fmt, ##__VA_ARGS__)                                                 \
+            : 0;                                                                                   \
+    })
+#else
+#define MULOG_LOG_ENABLED(level, fmt, ...)                                                         \
+    (mulog_is_log_level_enabled(level) ? mulog_log(level, fmt, ##__VA_ARGS__) : 0)
+#endif /* MULOG_ENABLE_CALL_SITES */
+
+/**
+ * \brief Result of a log call compiled out with MULOG_COMPILE_TIME_LEVEL
+ * \details Private, keeps a stripped log call from being reported as a statement with no effect.
+ * \return Always 0, no characters logged
+ */
+static inline int mulog_log_stripped(void)
+{
+    return 0;
+}
+
+/**
+ * \brief Compiles a log call out while keeping the format string check
+ * \details Private, used by the log level macros below MULOG_COMPILE_TIME_LEVEL. The call is in
+ * a branch that is never taken, so neither the call nor the format string are emitted, and the
+ * arguments are not evaluated.
+ */
+#define MULOG_LOG_STRIPPED(level, fmt, ...)                                                        \
+    (0 ? mulog_log(level, fmt, ##__VA_ARGS__) : mulog_log_stripped())
+
 /**
  * \brief Logs a message with trace level.
  *
- * This macro logs a trace level message using the specified format string.
+ * This macro logs a trace level message using the specified format string. The call and the
+ * evaluation of its arguments are skipped if no registered output accepts the trace level, or
+ * the level is below MULOG_COMPILE_TIME_LEVEL.
  *
  * \param fmt The format string (printf-style).
  * \param ... Additional arguments for the format string.
@@ -150,7 +763,11 @@ int mulog_log(enum mulog_log_level level, const char *fmt, ...) MULOG_PRINTF_ATT
  * MULOG_LOG_TRACE("This is a trace message, value: %d", 42);
  * \endcode
  */
-#define MULOG_LOG_TRACE(fmt, ...) mulog_log(MULOG_LOG_LVL_TRACE, fmt, ##__VA_ARGS__)
+#if MULOG_COMPILE_TIME_LEVEL <= 0
+#define MULOG_LOG_TRACE(fmt, ...) MULOG_LOG_ENABLED(MULOG_LOG_LVL_TRACE, fmt, ##__VA_ARGS__)
+#else
+#define MULOG_LOG_TRACE(fmt, ...) MULOG_LOG_STRIPPED(MULOG_LOG_LVL_TRACE, fmt, ##__VA_ARGS__)
+#endif
 
 /**
  * \brief Logs a message with debug level.
@@ -165,7 +782,11 @@ int mulog_log(enum mulog_log_level level, const char *fmt, ...) MULOG_PRINTF_ATT
  * MULOG_LOG_DBG("This is a debug message, value: %d", 42);
  * \endcode
  */
-#define MULOG_LOG_DBG(fmt, ...) mulog_log(MULOG_LOG_LVL_DEBUG, fmt, ##__VA_ARGS__)
+#if MULOG_COMPILE_TIME_LEVEL <= 1
+#define MULOG_LOG_DBG(fmt, ...) MULOG_LOG_ENABLED(MULOG_LOG_LVL_DEBUG, fmt, ##__VA_ARGS__)
+#else
+#define MULOG_LOG_DBG(fmt, ...) MULOG_LOG_STRIPPED(MULOG_LOG_LVL_DEBUG, fmt, ##__VA_ARGS__)
+#endif
 
 /**
  * \brief Logs a message with info level.
@@ -180,7 +801,11 @@ int mulog_log(enum mulog_log_level level, const char *fmt, ...) MULOG_PRINTF_ATT
  * MULOG_LOG_INFO("This is an info message, value: %d", 42);
  * \endcode
  */
-#define MULOG_LOG_INFO(fmt, ...) mulog_log(MULOG_LOG_LVL_INFO, fmt, ##__VA_ARGS__)
+#if MULOG_COMPILE_TIME_LEVEL <= 2
+#define MULOG_LOG_INFO(fmt, ...) MULOG_LOG_ENABLED(MULOG_LOG_LVL_INFO, fmt, ##__VA_ARGS__)
+#else
+#define MULOG_LOG_INFO(fmt, ...) MULOG_LOG_STRIPPED(MULOG_LOG_LVL_INFO, fmt, ##__VA_ARGS__)
+#endif
 
 /**
  * \brief Logs a message with warning level.
@@ -195,7 +820,11 @@ int mulog_log(enum mulog_log_level level, const char *fmt, ...) MULOG_PRINTF_ATT
  * MULOG_LOG_WARN("This is a warning message, value: %d", 42);
  * \endcode
  */
-#define MULOG_LOG_WARN(fmt, ...) mulog_log(MULOG_LOG_LVL_WARNING, fmt, ##__VA_ARGS__)
+#if MULOG_COMPILE_TIME_LEVEL <= 3
+#define MULOG_LOG_WARN(fmt, ...) MULOG_LOG_ENABLED(MULOG_LOG_LVL_WARNING, fmt, ##__VA_ARGS__)
+#else
+#define MULOG_LOG_WARN(fmt, ...) MULOG_LOG_STRIPPED(MULOG_LOG_LVL_WARNING, fmt, ##__VA_ARGS__)
+#endif
 
 /**
  * \brief Logs a message with error level.
@@ -210,7 +839,11 @@ int mulog_log(enum mulog_log_level level, const char *fmt, ...) MULOG_PRINTF_ATT
  * MULOG_LOG_ERR("This is an error message, value: %d", 42);
  * \endcode
  */
-#define MULOG_LOG_ERR(fmt, ...) mulog_log(MULOG_LOG_LVL_ERROR, fmt, ##__VA_ARGS__)
+#if MULOG_COMPILE_TIME_LEVEL <= 4
+#define MULOG_LOG_ERR(fmt, ...) MULOG_LOG_ENABLED(MULOG_LOG_LVL_ERROR, fmt, ##__VA_ARGS__)
+#else
+#define MULOG_LOG_ERR(fmt, ...) MULOG_LOG_STRIPPED(MULOG_LOG_LVL_ERROR, fmt, ##__VA_ARGS__)
+#endif
 
 /**
  * @}
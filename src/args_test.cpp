@@ -0,0 +1,283 @@
+/**
+ * \file
+ * \brief Printf-like arguments capture tests
+ * \author Vladimir Petrigo
+ */
+#include "internal/args.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace {
+    std::array<unsigned char, 256> captured{};
+    int captured_size = 0;
+
+    __attribute__((format(printf, 1, 2))) int capture(const char *fmt, ...)
+    {
+        va_list args;
+
+        va_start(args, fmt);
+        captured_size = args_capture(captured.data(), captured.size(), fmt, args);
+        va_end(args);
+
+        return captured_size;
+    }
+
+    std::string format_captured(const char *fmt)
+    {
+        std::array<char, 256> out{};
+        const auto ret = args_format(out.data(), out.size(), fmt, captured.data(), captured_size);
+
+        REQUIRE(ret >= 0);
+        REQUIRE(static_cast<size_t>(ret) < out.size());
+
+        return std::string{out.data(), static_cast<size_t>(ret)};
+    }
+
+    __attribute__((format(printf, 1, 2))) int encode(const char *fmt, ...)
+    {
+        va_list args;
+
+        va_start(args, fmt);
+        captured_size = args_encode(captured.data(), captured.size(), fmt, args);
+        va_end(args);
+
+        return captured_size;
+    }
+
+    std::string format_encoded(const char *fmt)
+    {
+        std::array<char, 256> out{};
+        const auto ret = args_decode(out.data(), out.size(), fmt, captured.data(), captured_size);
+
+        REQUIRE(ret >= 0);
+        REQUIRE(static_cast<size_t>(ret) < out.size());
+
+        return std::string{out.data(), static_cast<size_t>(ret)};
+    }
+
+    __attribute__((format(printf, 1, 2))) std::string format_expected(const char *fmt, ...)
+    {
+        std::array<char, 256> out{};
+        va_list args;
+
+        va_start(args, fmt);
+        const auto ret = std::vsnprintf(out.data(), out.size(), fmt, args);
+        va_end(args);
+
+        return std::string{out.data(), static_cast<size_t>(ret)};
+    }
+
+    extern "C" void putchar_(int c)
+    {
+    }
+} // namespace
+
+#define REQUIRE_SAME_OUTPUT(fmt, ...)                                                              \
+    do {                                                                                           \
+        REQUIRE(capture(fmt, __VA_ARGS__) >= 0);                                                   \
+        REQUIRE(format_expected(fmt, __VA_ARGS__) == format_captured(fmt));                        \
+    } while (0)
+
+#define REQUIRE_SAME_ENCODED_OUTPUT(fmt, ...)                                                      \
+    do {                                                                                           \
+        REQUIRE(encode(fmt, __VA_ARGS__) >= 0);                                                    \
+        REQUIRE(format_expected(fmt, __VA_ARGS__) == format_encoded(fmt));                         \
+    } while (0)
+
+TEST_CASE("ArgsTests - NoArguments", "[args]")
+{
+    REQUIRE(0 == capture("Hello, world!"));
+    REQUIRE("Hello, world!" == format_captured("Hello, world!"));
+    REQUIRE(1 == capture("%s", ""));
+    REQUIRE(0 == capture(""));
+    REQUIRE(format_captured("").empty());
+}
+
+TEST_CASE("ArgsTests - Integers", "[args]")
+{
+    REQUIRE_SAME_OUTPUT("%d %i %u", -42, 42, 42U);
+    REQUIRE_SAME_OUTPUT("%hhd %hd %ld %lld", static_cast<signed char>(-1),
+                        static_cast<short>(-300), -100000L, -10000000000LL);
+    REQUIRE_SAME_OUTPUT("%hhu %hu %lu %llu", static_cast<unsigned char>(255),
+                        static_cast<unsigned short>(65535), 100000UL, 10000000000ULL);
+    REQUIRE_SAME_OUTPUT("%jd %zu %td", static_cast<intmax_t>(-7), static_cast<size_t>(7),
+                        static_cast<ptrdiff_t>(-7));
+    REQUIRE_SAME_OUTPUT("%x %X %o %#x %08x", 0xdeadU, 0xbeefU, 8U, 0x10U, 0x1fU);
+    REQUIRE_SAME_OUTPUT("[%-5d] [%+d] [% d] [%05d]", 1, 2, 3, -4);
+    REQUIRE_SAME_OUTPUT("%c%c%c", 'a', 'b', 'c');
+}
+
+TEST_CASE("ArgsTests - FloatingPoint", "[args]")
+{
+    REQUIRE_SAME_OUTPUT("%f %e %g", 3.14159, 2.5e10, 0.0001);
+    REQUIRE_SAME_OUTPUT("%.2f %10.3f %-10.1f|", 1.005, -2.5, 7.25);
+}
+
+TEST_CASE("ArgsTests - Strings", "[args]")
+{
+    REQUIRE_SAME_OUTPUT("%s, %s!", "Hello", "world");
+    REQUIRE_SAME_OUTPUT("[%10s] [%-10s] [%.3s]", "right", "left", "truncated");
+
+    std::string volatile_str{"original"};
+    REQUIRE(capture("%s", volatile_str.c_str()) > 0);
+    volatile_str = "changed!";
+    REQUIRE("original" == format_captured("%s"));
+
+    const char *null_str = nullptr;
+    REQUIRE(capture("%s", null_str) > 0);
+    REQUIRE("(null)" == format_captured("%s"));
+}
+
+TEST_CASE("ArgsTests - StarWidthAndPrecision", "[args]")
+{
+    REQUIRE_SAME_OUTPUT("[%*d]", 6, 42);
+    REQUIRE_SAME_OUTPUT("[%.*f]", 3, 1.23456);
+    REQUIRE_SAME_OUTPUT("[%*.*s]", 8, 3, "abcdef");
+    REQUIRE_SAME_OUTPUT("[%-*d]", 4, 7);
+}
+
+TEST_CASE("ArgsTests - PrecisionLimitsStringRead", "[args]")
+{
+    // the strings are not null terminated, only the characters within the precision are read
+    const std::array<char, 4> packet{'d', 'a', 't', 'a'};
+
+    REQUIRE(capture("[%.*s]", static_cast<int>(packet.size()), packet.data()) > 0);
+    REQUIRE("[data]" == format_captured("[%.*s]"));
+    REQUIRE(capture("[%.2s] [%6.3s]", packet.data(), packet.data()) > 0);
+    REQUIRE("[da] [   dat]" == format_captured("[%.2s] [%6.3s]"));
+
+    // a negative precision is ignored, a larger one stops at the null terminator
+    REQUIRE_SAME_OUTPUT("[%.*s] [%.*s]", -1, "abc", 10, "abc");
+    REQUIRE_SAME_OUTPUT("[%.0s] [%.10s]", "abc", "abc");
+}
+
+TEST_CASE("ArgsTests - PointerAndPercent", "[args]")
+{
+    int value = 0;
+
+    REQUIRE_SAME_OUTPUT("%p", static_cast<void *>(&value));
+    REQUIRE(0 == capture("100%%"));
+    REQUIRE("100%" == format_captured("100%%"));
+    REQUIRE_SAME_OUTPUT("%d%% done", 50);
+}
+
+TEST_CASE("ArgsTests - InvalidSpecification", "[args]")
+{
+    REQUIRE(0 == capture("trailing %"));
+    REQUIRE("trailing %" == format_captured("trailing %"));
+}
+
+TEST_CASE("ArgsTests - OutputTruncation", "[args]")
+{
+    const char *fmt = "%s %d";
+    std::array<char, 8> out{};
+
+    REQUIRE(capture(fmt, "truncated", 12345) > 0);
+
+    const auto ret = args_format(out.data(), out.size(), fmt, captured.data(), captured_size);
+    REQUIRE(15 == ret);
+    REQUIRE(std::string{"truncat"} == out.data());
+    REQUIRE(15 == args_format(nullptr, 0, fmt, captured.data(), captured_size));
+}
+
+TEST_CASE("ArgsTests - CaptureBufferTooSmall", "[args]")
+{
+    std::array<unsigned char, 6> small{};
+    const auto capture_small = [&small](const char *fmt, ...) {
+        va_list args;
+
+        va_start(args, fmt);
+        const auto ret = args_capture(small.data(), small.size(), fmt, args);
+        va_end(args);
+
+        return ret;
+    };
+
+    // fixed size arguments that do not fit fail the capture
+    REQUIRE(capture_small("%lld", 1LL) < 0);
+    // strings are truncated to the available space
+    const auto ret = capture_small("%s", "long string");
+    REQUIRE(small.size() == static_cast<size_t>(ret));
+
+    std::array<char, 16> out{};
+    REQUIRE(5 == args_format(out.data(), out.size(), "%s", small.data(), ret));
+    REQUIRE(std::string{"long "} == out.data());
+}
+
+TEST_CASE("ArgsTests - MalformedCapturedData", "[args]")
+{
+    std::array<char, 16> out{};
+
+    REQUIRE(capture("%d %s", 1, "abc") > 0);
+    // arguments are missing
+    REQUIRE(args_format(out.data(), out.size(), "%d %s", captured.data(), sizeof(int)) < 0);
+    // string is not null terminated
+    REQUIRE(args_format(out.data(), out.size(), "%d %s", captured.data(), captured_size - 1) < 0);
+}
+
+TEST_CASE("ArgsTests - EncodedArguments", "[args]")
+{
+    int value = 0;
+
+    REQUIRE_SAME_ENCODED_OUTPUT("%d %i %u", -42, 42, 42U);
+    REQUIRE_SAME_ENCODED_OUTPUT("%hhd %hd %ld %lld", static_cast<signed char>(-1),
+                                static_cast<short>(-300), -100000L, -10000000000LL);
+    REQUIRE_SAME_ENCODED_OUTPUT("%lu %llu %zu %td", 100000UL, 18446744073709551615ULL,
+                                static_cast<size_t>(7), static_cast<ptrdiff_t>(-7));
+    REQUIRE_SAME_ENCODED_OUTPUT("%jd %ju", static_cast<intmax_t>(INT64_MIN),
+                                static_cast<uintmax_t>(UINT64_MAX));
+    REQUIRE_SAME_ENCODED_OUTPUT("%f %e %.3g", 3.14159, -2.5e10, 0.0001);
+    REQUIRE_SAME_ENCODED_OUTPUT("%s, %s! %c", "Hello", "world", 'x');
+    REQUIRE_SAME_ENCODED_OUTPUT("[%*.*s] [%-*d]", 8, 3, "abcdef", -4, 7);
+    REQUIRE_SAME_ENCODED_OUTPUT("%p %d%%", static_cast<void *>(&value), 50);
+    REQUIRE(0 == encode("no arguments"));
+    REQUIRE("no arguments" == format_encoded("no arguments"));
+}
+
+TEST_CASE("ArgsTests - EncodedArgumentsAreCompact", "[args]")
+{
+    // small integers take a single byte regardless of their type
+    REQUIRE(3 == encode("%d %lu %lld", -1, 1UL, 63LL));
+    // strings are stored with the null terminator
+    REQUIRE(4 == encode("%s", "abc"));
+    // floating point values are always stored as doubles
+    REQUIRE(8 == encode("%f", 1.0));
+}
+
+TEST_CASE("ArgsTests - EncodeBufferTooSmall", "[args]")
+{
+    std::array<unsigned char, 4> small{};
+    const auto encode_small = [&small](const char *fmt, ...) {
+        va_list args;
+
+        va_start(args, fmt);
+        const auto ret = args_encode(small.data(), small.size(), fmt, args);
+        va_end(args);
+
+        return ret;
+    };
+
+    REQUIRE(encode_small("%f", 1.0) < 0);
+    REQUIRE(encode_small("%llu", 18446744073709551615ULL) < 0);
+    // strings are never truncated
+    REQUIRE(encode_small("%s", "long string") < 0);
+    REQUIRE(4 == encode_small("%s", "abc"));
+}
+
+TEST_CASE("ArgsTests - MalformedEncodedData", "[args]")
+{
+    std::array<char, 16> out{};
+
+    REQUIRE(encode("%d %f", 300, 1.0) > 0);
+    // the variable length integer is incomplete
+    REQUIRE(args_decode(out.data(), out.size(), "%d %f", captured.data(), 1) < 0);
+    // the double is incomplete
+    REQUIRE(args_decode(out.data(), out.size(), "%d %f", captured.data(), captured_size - 1) < 0);
+}
@@ -0,0 +1,848 @@
+/**
+ * \file
+ * \brief Printf-like arguments capture and deferred formatting implementation
+ * \author Vladimir Petrigo
+ */
+
+#include "internal/args.h"
+#include "internal/wire.h"
+
+#include <printf/printf.h>
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * \brief Maximum size of a single conversion specification that can be formatted, including
+ * the null terminator
+ */
+#define ARGS_SPEC_SIZE 32
+
+enum args_type {
+    ARGS_TYPE_NONE,    /**< Not a conversion specification, output as is */
+    ARGS_TYPE_PERCENT, /**< `%%` conversion */
+    ARGS_TYPE_SKIP,    /**< Argument is consumed, but not stored (`%n`) */
+    ARGS_TYPE_INT,
+    ARGS_TYPE_LONG,
+    ARGS_TYPE_LLONG,
+    ARGS_TYPE_INTMAX,
+    ARGS_TYPE_SIZE,
+    ARGS_TYPE_PTRDIFF,
+    ARGS_TYPE_UINT,
+    ARGS_TYPE_ULONG,
+    ARGS_TYPE_ULLONG,
+    ARGS_TYPE_UINTMAX,
+    ARGS_TYPE_DOUBLE,
+    ARGS_TYPE_LDOUBLE,
+    ARGS_TYPE_POINTER,
+    ARGS_TYPE_STRING,
+};
+
+enum args_length {
+    ARGS_LENGTH_NONE,
+    ARGS_LENGTH_CHAR,
+    ARGS_LENGTH_SHORT,
+    ARGS_LENGTH_LONG,
+    ARGS_LENGTH_LLONG,
+    ARGS_LENGTH_INTMAX,
+    ARGS_LENGTH_SIZE,
+    ARGS_LENGTH_PTRDIFF,
+    ARGS_LENGTH_LDOUBLE,
+};
+
+struct args_spec {
+    size_t size;         /**< Specification length starting from `%` */
+    size_t stars;        /**< Number of `*` width/precision arguments */
+    int precision;       /**< Literal precision, negative if not specified */
+    bool star_precision; /**< Precision is given by the last `*` argument */
+    enum args_type type; /**< Argument type */
+};
+
+static enum args_type args_signed_type(const enum args_length length)
+{
+    switch (length) {
+    case ARGS_LENGTH_LONG:
+        return ARGS_TYPE_LONG;
+    case ARGS_LENGTH_LLONG:
+        return ARGS_TYPE_LLONG;
+    case ARGS_LENGTH_INTMAX:
+        return ARGS_TYPE_INTMAX;
+    case ARGS_LENGTH_SIZE:
+        return ARGS_TYPE_SIZE;
+    case ARGS_LENGTH_PTRDIFF:
+        return ARGS_TYPE_PTRDIFF;
+    default:
+        return ARGS_TYPE_INT;
+    }
+}
+
+static enum args_type args_unsigned_type(const enum args_length length)
+{
+    switch (length) {
+    case ARGS_LENGTH_LONG:
+        return ARGS_TYPE_ULONG;
+    case ARGS_LENGTH_LLONG:
+        return ARGS_TYPE_ULLONG;
+    case ARGS_LENGTH_INTMAX:
+        return ARGS_TYPE_UINTMAX;
+    case ARGS_LENGTH_SIZE:
+        return ARGS_TYPE_SIZE;
+    case ARGS_LENGTH_PTRDIFF:
+        return ARGS_TYPE_PTRDIFF;
+    default:
+        return ARGS_TYPE_UINT;
+    }
+}
+
+static const char *args_parse_length(const char *it, enum args_length *length)
+{
+    switch (*it) {
+    case 'h':
+        if (it[1] == 'h') {
+            *length = ARGS_LENGTH_CHAR;
+            return it + 2;
+        }
+
+        *length = ARGS_LENGTH_SHORT;
+        return it + 1;
+    case 'l':
+        if (it[1] == 'l') {
+            *length = ARGS_LENGTH_LLONG;
+            return it + 2;
+        }
+
+        *length = ARGS_LENGTH_LONG;
+        return it + 1;
+    case 'j':
+        *length = ARGS_LENGTH_INTMAX;
+        return it + 1;
+    case 'z':
+        *length = ARGS_LENGTH_SIZE;
+        return it + 1;
+    case 't':
+        *length = ARGS_LENGTH_PTRDIFF;
+        return it + 1;
+    case 'L':
+        *length = ARGS_LENGTH_LDOUBLE;
+        return it + 1;
+    default:
+        *length = ARGS_LENGTH_NONE;
+        return it;
+    }
+}
+
+static enum args_type args_conversion_type(const char conversion, const enum args_length length)
+{
+    switch (conversion) {
+    case 'd':
+    case 'i':
+        return args_signed_type(length);
+    case 'u':
+    case 'o':
+    case 'x':
+    case 'X':
+    case 'b':
+        return args_unsigned_type(length);
+    case 'c':
+        return ARGS_TYPE_INT;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+        return length == ARGS_LENGTH_LDOUBLE ? ARGS_TYPE_LDOUBLE : ARGS_TYPE_DOUBLE;
+    case 'p':
+        return ARGS_TYPE_POINTER;
+    case 's':
+        return ARGS_TYPE_STRING;
+    case 'n':
+        return ARGS_TYPE_SKIP;
+    case '%':
+        return ARGS_TYPE_PERCENT;
+    default:
+        return ARGS_TYPE_NONE;
+    }
+}
+
+/**
+ * \brief Finds and parses the next conversion specification in the format string.
+ *
+ * \param fmt The format string
+ * \param[out] spec Parsed conversion specification
+ * \return Pointer to the `%` character of the specification, or NULL if there are no more
+ *         specifications in the format string
+ */
+static const char *args_next_spec(const char *fmt, struct args_spec *spec)
+{
+    const char *begin = strchr(fmt, '%');
+
+    if (begin == NULL) {
+        return NULL;
+    }
+
+    const char *it = begin + 1;
+    enum args_length length;
+
+    spec->stars = 0;
+    spec->precision = -1;
+    spec->star_precision = false;
+
+    while (*it != '\0' && strchr("-+ #0", *it) != NULL) {
+        ++it;
+    }
+
+    if (*it == '*') {
+        ++spec->stars;
+        ++it;
+    }
+
+    while (*it >= '0' && *it <= '9') {
+        ++it;
+    }
+
+    if (*it == '.') {
+        ++it;
+        spec->precision = 0;
+
+        if (*it == '*') {
+            ++spec->stars;
+            spec->star_precision = true;
+            ++it;
+        }
+
+        while (*it >= '0' && *it <= '9') {
+            const int digit = *it - '0';
+
+            spec->precision =
+                spec->precision > (INT_MAX - digit) / 10 ? INT_MAX : spec->precision * 10 + digit;
+            ++it;
+        }
+    }
+
+    it = args_parse_length(it, &length);
+    spec->type = args_conversion_type(*it, length);
+
+    if (spec->type == ARGS_TYPE_NONE) {
+        // not a valid specification, consume it as a literal text without arguments
+        spec->stars = 0;
+        spec->star_precision = false;
+        spec->size = (size_t)(it - begin) + (*it != '\0');
+    } else {
+        spec->size = (size_t)(it - begin) + 1;
+    }
+
+    return begin;
+}
+
+/**
+ * \brief Gets the length of a `%s` argument that is printed for a conversion specification.
+ *
+ * A string does not have to be null terminated if the precision limits its length, so it is not
+ * read past the precision.
+ *
+ * \param spec Conversion specification of the string
+ * \param stars Values of the `*` arguments of the specification
+ * \param str The string
+ * \return Number of characters of the string that are printed
+ */
+static size_t args_string_length(const struct args_spec *spec, const int *stars, const char *str)
+{
+    // a negative `*` precision is taken as if the precision is omitted
+    const int precision = spec->star_precision ? stars[spec->stars - 1] : spec->precision;
+
+    if (precision < 0) {
+        return strlen(str);
+    }
+
+    const char *end = memchr(str, '\0', (size_t)precision);
+
+    return end != NULL ? (size_t)(end - str) : (size_t)precision;
+}
+
+static bool args_store(unsigned char *buf, const size_t buf_size, size_t *offset,
+                       const void *value, const size_t size)
+{
+    if (buf_size - *offset < size) {
+        return false;
+    }
+
+    memcpy(buf + *offset, value, size);
+    *offset += size;
+
+    return true;
+}
+
+static bool args_load(const unsigned char *buf, const size_t buf_size, size_t *offset,
+                      void *value, const size_t size)
+{
+    if (buf_size - *offset < size) {
+        return false;
+    }
+
+    memcpy(value, buf + *offset, size);
+    *offset += size;
+
+    return true;
+}
+
+#define ARGS_CAPTURE_VALUE(type)                                                                   \
+    do {                                                                                           \
+        const type value = va_arg(args, type);                                                     \
+                                                                                                   \
+        if (!args_store(out, buf_size, &offset, &value, sizeof(value))) {                          \
+            return -1;                                                                             \
+        }                                                                                          \
+    } while (0)
+
+int args_capture(void *buf, const size_t buf_size, const char *fmt, va_list args)
+{
+    unsigned char *out = buf;
+    size_t offset = 0;
+    struct args_spec spec;
+    const char *it = fmt;
+
+    while ((it = args_next_spec(it, &spec)) != NULL) {
+        it += spec.size;
+
+        int stars[2] = {0, 0};
+
+        for (size_t i = 0; i < spec.stars; ++i) {
+            stars[i] = va_arg(args, int);
+
+            if (!args_store(out, buf_size, &offset, &stars[i], sizeof(stars[i]))) {
+                return -1;
+            }
+        }
+
+        switch (spec.type) {
+        case ARGS_TYPE_NONE:
+        case ARGS_TYPE_PERCENT:
+            break;
+        case ARGS_TYPE_SKIP:
+            (void)va_arg(args, void *);
+            break;
+        case ARGS_TYPE_INT:
+            ARGS_CAPTURE_VALUE(int);
+            break;
+        case ARGS_TYPE_LONG:
+            ARGS_CAPTURE_VALUE(long);
+            break;
+        case ARGS_TYPE_LLONG:
+            ARGS_CAPTURE_VALUE(long long);
+            break;
+        case ARGS_TYPE_INTMAX:
+            ARGS_CAPTURE_VALUE(intmax_t);
+            break;
+        case ARGS_TYPE_SIZE:
+            ARGS_CAPTURE_VALUE(size_t);
+            break;
+        case ARGS_TYPE_PTRDIFF:
+            ARGS_CAPTURE_VALUE(ptrdiff_t);
+            break;
+        case ARGS_TYPE_UINT:
+            ARGS_CAPTURE_VALUE(unsigned int);
+            break;
+        case ARGS_TYPE_ULONG:
+            ARGS_CAPTURE_VALUE(unsigned long);
+            break;
+        case ARGS_TYPE_ULLONG:
+            ARGS_CAPTURE_VALUE(unsigned long long);
+            break;
+        case ARGS_TYPE_UINTMAX:
+            ARGS_CAPTURE_VALUE(uintmax_t);
+            break;
+        case ARGS_TYPE_DOUBLE:
+            ARGS_CAPTURE_VALUE(double);
+            break;
+        case ARGS_TYPE_LDOUBLE:
+            ARGS_CAPTURE_VALUE(long double);
+            break;
+        case ARGS_TYPE_POINTER:
+            ARGS_CAPTURE_VALUE(void *);
+            break;
+        case ARGS_TYPE_STRING: {
+            const char *str = va_arg(args, const char *);
+
+            if (str == NULL) {
+                str = "(null)";
+            }
+
+            if (offset >= buf_size) {
+                return -1;
+            }
+
+            const size_t available = buf_size - offset - 1;
+            const size_t len = args_string_length(&spec, stars, str);
+            const size_t to_copy = len > available ? available : len;
+
+            memcpy(out + offset, str, to_copy);
+            out[offset + to_copy] = '\0';
+            offset += to_copy + 1;
+            break;
+        }
+        }
+    }
+
+    return (int)offset;
+}
+
+static bool args_store_varint(unsigned char *buf, const size_t buf_size, size_t *offset,
+                              const uint64_t value)
+{
+    const size_t size = wire_put_varint(buf + *offset, buf_size - *offset, value);
+
+    *offset += size;
+
+    return size != 0;
+}
+
+#define ARGS_ENCODE_SIGNED(type)                                                                   \
+    do {                                                                                           \
+        const int64_t value = (int64_t)va_arg(args, type);                                         \
+                                                                                                   \
+        if (!args_store_varint(out, buf_size, &offset, wire_zigzag_encode(value))) {               \
+            return -1;                                                                             \
+        }                                                                                          \
+    } while (0)
+
+#define ARGS_ENCODE_UNSIGNED(type)                                                                 \
+    do {                                                                                           \
+        const uint64_t value = (uint64_t)va_arg(args, type);                                       \
+                                                                                                   \
+        if (!args_store_varint(out, buf_size, &offset, value)) {                                   \
+            return -1;                                                                             \
+        }                                                                                          \
+    } while (0)
+
+#define ARGS_ENCODE_DOUBLE(type)                                                                   \
+    do {                                                                                           \
+        const double value = (double)va_arg(args, type);                                           \
+        uint64_t bits;                                                                             \
+                                                                                                   \
+        memcpy(&bits, &value, sizeof(bits));                                                       \
+                                                                                                   \
+        for (size_t i = 0; i < sizeof(bits); ++i) {                                                \
+            const unsigned char byte = (unsigned char)(bits >> (8 * i));                           \
+                                                                                                   \
+            if (!args_store(out, buf_size, &offset, &byte, sizeof(byte))) {                        \
+                return -1;                                                                         \
+            }                                                                                      \
+        }                                                                                          \
+    } while (0)
+
+_Static_assert(sizeof(double) == sizeof(uint64_t), "Wire format expects 64-bit doubles");
+
+int args_encode(void *buf, const size_t buf_size, const char *fmt, va_list args)
+{
+    unsigned char *out = buf;
+    size_t offset = 0;
+    struct args_spec spec;
+    const char *it = fmt;
+
+    while ((it = args_next_spec(it, &spec)) != NULL) {
+        it += spec.size;
+
+        int stars[2] = {0, 0};
+
+        for (size_t i = 0; i < spec.stars; ++i) {
+            stars[i] = va_arg(args, int);
+
+            if (!args_store_varint(out, buf_size, &offset, wire_zigzag_encode(stars[i]))) {
+                return -1;
+            }
+        }
+
+        switch (spec.type) {
+        case ARGS_TYPE_NONE:
+        case ARGS_TYPE_PERCENT:
+            break;
+        case ARGS_TYPE_SKIP:
+            (void)va_arg(args, void *);
+            break;
+        case ARGS_TYPE_INT:
+            ARGS_ENCODE_SIGNED(int);
+            break;
+        case ARGS_TYPE_LONG:
+            ARGS_ENCODE_SIGNED(long);
+            break;
+        case ARGS_TYPE_LLONG:
+            ARGS_ENCODE_SIGNED(long long);
+            break;
+        case ARGS_TYPE_INTMAX:
+            ARGS_ENCODE_SIGNED(intmax_t);
+            break;
+        case ARGS_TYPE_PTRDIFF:
+            ARGS_ENCODE_SIGNED(ptrdiff_t);
+            break;
+        case ARGS_TYPE_SIZE:
+            ARGS_ENCODE_UNSIGNED(size_t);
+            break;
+        case ARGS_TYPE_UINT:
+            ARGS_ENCODE_UNSIGNED(unsigned int);
+            break;
+        case ARGS_TYPE_ULONG:
+            ARGS_ENCODE_UNSIGNED(unsigned long);
+            break;
+        case ARGS_TYPE_ULLONG:
+            ARGS_ENCODE_UNSIGNED(unsigned long long);
+            break;
+        case ARGS_TYPE_UINTMAX:
+            ARGS_ENCODE_UNSIGNED(uintmax_t);
+            break;
+        case ARGS_TYPE_POINTER:
+            ARGS_ENCODE_UNSIGNED(uintptr_t);
+            break;
+        case ARGS_TYPE_DOUBLE:
+            ARGS_ENCODE_DOUBLE(double);
+            break;
+        case ARGS_TYPE_LDOUBLE:
+            ARGS_ENCODE_DOUBLE(long double);
+            break;
+        case ARGS_TYPE_STRING: {
+            const char *str = va_arg(args, const char *);
+
+            if (str == NULL) {
+                str = "(null)";
+            }
+
+            const size_t len = args_string_length(&spec, stars, str);
+            const char terminator = '\0';
+
+            // strings are not truncated, a record with a partial string can not be decoded
+            if (!args_store(out, buf_size, &offset, str, len) ||
+                !args_store(out, buf_size, &offset, &terminator, sizeof(terminator))) {
+                return -1;
+            }
+
+            break;
+        }
+        }
+    }
+
+    return (int)offset;
+}
+
+/**
+ * \brief Appends a text to the output buffer, keeping track of the total output length.
+ *
+ * \param buf Output buffer
+ * \param buf_size Output buffer size
+ * \param written Total output length so far
+ * \param str Text to append
+ * \param len Text length
+ */
+static void args_append(char *buf, const size_t buf_size, size_t *written, const char *str,
+                        const size_t len)
+{
+    if (*written + 1 < buf_size) {
+        const size_t available = buf_size - *written - 1;
+
+        memcpy(buf + *written, str, len > available ? available : len);
+    }
+
+    *written += len;
+}
+
+union args_value {
+    int i;
+    long l;
+    long long ll;
+    intmax_t im;
+    size_t sz;
+    ptrdiff_t pd;
+    unsigned int u;
+    unsigned long ul;
+    unsigned long long ull;
+    uintmax_t uim;
+    double d;
+    long double ld;
+    void *p;
+    const char *s;
+};
+
+static bool args_load_value(const unsigned char *buf, const size_t buf_size, size_t *offset,
+                            const enum args_type type, union args_value *value)
+{
+    switch (type) {
+    case ARGS_TYPE_INT:
+        return args_load(buf, buf_size, offset, &value->i, sizeof(value->i));
+    case ARGS_TYPE_LONG:
+        return args_load(buf, buf_size, offset, &value->l, sizeof(value->l));
+    case ARGS_TYPE_LLONG:
+        return args_load(buf, buf_size, offset, &value->ll, sizeof(value->ll));
+    case ARGS_TYPE_INTMAX:
+        return args_load(buf, buf_size, offset, &value->im, sizeof(value->im));
+    case ARGS_TYPE_SIZE:
+        return args_load(buf, buf_size, offset, &value->sz, sizeof(value->sz));
+    case ARGS_TYPE_PTRDIFF:
+        return args_load(buf, buf_size, offset, &value->pd, sizeof(value->pd));
+    case ARGS_TYPE_UINT:
+        return args_load(buf, buf_size, offset, &value->u, sizeof(value->u));
+    case ARGS_TYPE_ULONG:
+        return args_load(buf, buf_size, offset, &value->ul, sizeof(value->ul));
+    case ARGS_TYPE_ULLONG:
+        return args_load(buf, buf_size, offset, &value->ull, sizeof(value->ull));
+    case ARGS_TYPE_UINTMAX:
+        return args_load(buf, buf_size, offset, &value->uim, sizeof(value->uim));
+    case ARGS_TYPE_DOUBLE:
+        return args_load(buf, buf_size, offset, &value->d, sizeof(value->d));
+    case ARGS_TYPE_LDOUBLE:
+        return args_load(buf, buf_size, offset, &value->ld, sizeof(value->ld));
+    case ARGS_TYPE_POINTER:
+        return args_load(buf, buf_size, offset, &value->p, sizeof(value->p));
+    case ARGS_TYPE_STRING: {
+        if (*offset >= buf_size) {
+            return false;
+        }
+
+        const char *str = (const char *)buf + *offset;
+        const char *end = memchr(str, '\0', buf_size - *offset);
+
+        if (end == NULL) {
+            return false;
+        }
+
+        value->s = str;
+        *offset += (size_t)(end - str) + 1;
+
+        return true;
+    }
+    default:
+        return true;
+    }
+}
+
+/**
+ * \brief Loads a single argument value stored with args_encode().
+ *
+ * Values are converted to the host type expected by the conversion specification.
+ */
+static bool args_load_wire_value(const unsigned char *buf, const size_t buf_size, size_t *offset,
+                                 const enum args_type type, union args_value *value)
+{
+    uint64_t raw = 0;
+
+    switch (type) {
+    case ARGS_TYPE_DOUBLE:
+    case ARGS_TYPE_LDOUBLE: {
+        unsigned char bytes[sizeof(raw)];
+        double d;
+
+        if (!args_load(buf, buf_size, offset, bytes, sizeof(bytes))) {
+            return false;
+        }
+
+        for (size_t i = 0; i < sizeof(bytes); ++i) {
+            raw |= (uint64_t)bytes[i] << (8 * i);
+        }
+
+        memcpy(&d, &raw, sizeof(d));
+
+        if (type == ARGS_TYPE_DOUBLE) {
+            value->d = d;
+        } else {
+            value->ld = d;
+        }
+
+        return true;
+    }
+    case ARGS_TYPE_STRING:
+    case ARGS_TYPE_NONE:
+    case ARGS_TYPE_PERCENT:
+    case ARGS_TYPE_SKIP:
+        return args_load_value(buf, buf_size, offset, type, value);
+    default:
+        break;
+    }
+
+    const size_t size = wire_get_varint(buf + *offset, buf_size - *offset, &raw);
+
+    if (size == 0) {
+        return false;
+    }
+
+    *offset += size;
+
+    switch (type) {
+    case ARGS_TYPE_INT:
+        value->i = (int)wire_zigzag_decode(raw);
+        break;
+    case ARGS_TYPE_LONG:
+        value->l = (long)wire_zigzag_decode(raw);
+        break;
+    case ARGS_TYPE_LLONG:
+        value->ll = (long long)wire_zigzag_decode(raw);
+        break;
+    case ARGS_TYPE_INTMAX:
+        value->im = (intmax_t)wire_zigzag_decode(raw);
+        break;
+    case ARGS_TYPE_PTRDIFF:
+        value->pd = (ptrdiff_t)wire_zigzag_decode(raw);
+        break;
+    case ARGS_TYPE_SIZE:
+        value->sz = (size_t)raw;
+        break;
+    case ARGS_TYPE_UINT:
+        value->u = (unsigned int)raw;
+        break;
+    case ARGS_TYPE_ULONG:
+        value->ul = (unsigned long)raw;
+        break;
+    case ARGS_TYPE_ULLONG:
+        value->ull = (unsigned long long)raw;
+        break;
+    case ARGS_TYPE_UINTMAX:
+        value->uim = (uintmax_t)raw;
+        break;
+    default:
+        value->p = (void *)(uintptr_t)raw;
+        break;
+    }
+
+    return true;
+}
+
+/**
+ * \brief Loads a single argument value of the given type from the stored arguments.
+ */
+typedef bool (*args_loader_fn)(const unsigned char *buf, size_t buf_size, size_t *offset,
+                               enum args_type type, union args_value *value);
+
+#define ARGS_SNPRINTF(value)                                                                       \
+    (stars_count == 0   ? snprintf_(buf, buf_size, spec, value)                                    \
+     : stars_count == 1 ? snprintf_(buf, buf_size, spec, stars[0], value)                          \
+                        : snprintf_(buf, buf_size, spec, stars[0], stars[1], value))
+
+static int args_format_value(char *buf, const size_t buf_size, const char *spec,
+                             const size_t stars_count, const int *stars,
+                             const enum args_type type, const union args_value *value)
+{
+    switch (type) {
+    case ARGS_TYPE_INT:
+        return ARGS_SNPRINTF(value->i);
+    case ARGS_TYPE_LONG:
+        return ARGS_SNPRINTF(value->l);
+    case ARGS_TYPE_LLONG:
+        return ARGS_SNPRINTF(value->ll);
+    case ARGS_TYPE_INTMAX:
+        return ARGS_SNPRINTF(value->im);
+    case ARGS_TYPE_SIZE:
+        return ARGS_SNPRINTF(value->sz);
+    case ARGS_TYPE_PTRDIFF:
+        return ARGS_SNPRINTF(value->pd);
+    case ARGS_TYPE_UINT:
+        return ARGS_SNPRINTF(value->u);
+    case ARGS_TYPE_ULONG:
+        return ARGS_SNPRINTF(value->ul);
+    case ARGS_TYPE_ULLONG:
+        return ARGS_SNPRINTF(value->ull);
+    case ARGS_TYPE_UINTMAX:
+        return ARGS_SNPRINTF(value->uim);
+    case ARGS_TYPE_DOUBLE:
+        return ARGS_SNPRINTF(value->d);
+    case ARGS_TYPE_LDOUBLE:
+        return ARGS_SNPRINTF(value->ld);
+    case ARGS_TYPE_POINTER:
+        return ARGS_SNPRINTF(value->p);
+    case ARGS_TYPE_STRING:
+        return ARGS_SNPRINTF(value->s);
+    default:
+        return 0;
+    }
+}
+
+/**
+ * \brief Formats a string from a format string and stored arguments.
+ *
+ * \param buf Buffer to format the string into, may be NULL if `buf_size` is 0
+ * \param buf_size Size of the buffer in bytes
+ * \param fmt The format string arguments were stored for
+ * \param args Stored arguments
+ * \param args_size Size of the stored arguments in bytes
+ * \param load Function that loads a single stored argument
+ * \return Number of characters that would have been written if the buffer was large enough, not
+ *         counting the null terminator, or a negative value if stored arguments are malformed
+ */
+static int args_format_stored(char *buf, const size_t buf_size, const char *fmt, const void *args,
+                              const size_t args_size, const args_loader_fn load)
+{
+    const unsigned char *in = args;
+    size_t offset = 0;
+    size_t written = 0;
+    struct args_spec spec;
+    const char *it = fmt;
+    const char *next;
+
+    while ((next = args_next_spec(it, &spec)) != NULL) {
+        args_append(buf, buf_size, &written, it, (size_t)(next - it));
+        it = next + spec.size;
+
+        int stars[2] = {0, 0};
+        union args_value value;
+
+        for (size_t i = 0; i < spec.stars; ++i) {
+            if (!load(in, args_size, &offset, ARGS_TYPE_INT, &value)) {
+                return -1;
+            }
+
+            stars[i] = value.i;
+        }
+
+        if (!load(in, args_size, &offset, spec.type, &value)) {
+            return -1;
+        }
+
+        if (spec.type == ARGS_TYPE_PERCENT) {
+            args_append(buf, buf_size, &written, "%", 1);
+            continue;
+        }
+
+        if (spec.type == ARGS_TYPE_NONE || spec.size >= ARGS_SPEC_SIZE) {
+            // not a conversion or too long to be formatted, output it as is
+            args_append(buf, buf_size, &written, next, spec.size);
+            continue;
+        }
+
+        char spec_str[ARGS_SPEC_SIZE];
+
+        memcpy(spec_str, next, spec.size);
+        spec_str[spec.size] = '\0';
+
+        const int ret =
+            args_format_value(written < buf_size ? buf + written : NULL,
+                              written < buf_size ? buf_size - written : 0, spec_str, spec.stars,
+                              stars, spec.type, &value);
+
+        if (ret < 0) {
+            return ret;
+        }
+
+        written += (size_t)ret;
+    }
+
+    args_append(buf, buf_size, &written, it, strlen(it));
+
+    if (buf_size > 0) {
+        buf[written < buf_size ? written : buf_size - 1] = '\0';
+    }
+
+    return (int)written;
+}
+
+int args_format(char *buf, const size_t buf_size, const char *fmt, const void *args,
+                const size_t args_size)
+{
+    return args_format_stored(buf, buf_size, fmt, args, args_size, args_load_value);
+}
+
+int args_decode(char *buf, const size_t buf_size, const char *fmt, const void *args,
+                const size_t args_size)
+{
+    return args_format_stored(buf, buf_size, fmt, args, args_size, args_load_wire_value);
+}
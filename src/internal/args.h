@@ -0,0 +1,93 @@
+/**
+ * \file
+ * \brief Printf-like arguments capture and deferred formatting
+ * \author Vladimir Petrigo
+ */
+
+#ifndef ARGS_H
+#define ARGS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdarg.h>
+#include <stddef.h>
+
+/**
+ * \brief Captures raw argument values referenced by a printf-like format string.
+ *
+ * Each conversion specification of the format string is parsed and the corresponding argument
+ * (including `*` field width and precision arguments) is copied into the buffer with its
+ * promoted type. Strings passed to `%s` are copied inline with the null terminator, so the caller
+ * does not need to keep them alive. Only the characters within the precision of the conversion are
+ * read, so a string limited by the precision does not have to be null terminated. Strings that do
+ * not fit into the buffer are truncated.
+ * Arguments of `%n` conversions are consumed but not stored.
+ *
+ * \note Captured arguments are only meaningful together with the same format string, so the
+ * format string must outlive the captured data (e.g. a string literal).
+ *
+ * \param buf Buffer to store captured arguments to
+ * \param buf_size Size of the buffer in bytes
+ * \param fmt The format string
+ * \param args The arguments for the format string
+ * \return Number of bytes stored in the buffer, or a negative value if the arguments do not fit
+ *         into the buffer
+ */
+int args_capture(void *buf, size_t buf_size, const char *fmt, va_list args);
+
+/**
+ * \brief Formats a string from a format string and arguments captured with args_capture().
+ *
+ * Behaves like `vsnprintf_()`: at most `buf_size - 1` characters are written, and the output is
+ * always null terminated if `buf_size` is not 0.
+ *
+ * \param buf Buffer to format the string into, may be NULL if `buf_size` is 0
+ * \param buf_size Size of the buffer in bytes
+ * \param fmt The format string arguments were captured for
+ * \param args Captured arguments
+ * \param args_size Size of the captured arguments in bytes
+ * \return Number of characters that would have been written if the buffer was large enough, not
+ *         counting the null terminator, or a negative value if captured arguments are malformed
+ */
+int args_format(char *buf, size_t buf_size, const char *fmt, const void *args, size_t args_size);
+
+/**
+ * \brief Encodes argument values referenced by a printf-like format string in a portable form.
+ *
+ * Unlike args_capture(), the encoding does not depend on the host type sizes or byte order, so
+ * the arguments can be decoded with args_decode() on a different machine. Integers and pointers
+ * are stored as variable length integers (zigzag encoded if signed), floating point values as
+ * little endian IEEE 754 doubles, and strings inline with the null terminator. Like in
+ * args_capture(), only the characters of a string within the conversion precision are stored.
+ *
+ * \param buf Buffer to store encoded arguments to
+ * \param buf_size Size of the buffer in bytes
+ * \param fmt The format string
+ * \param args The arguments for the format string
+ * \return Number of bytes stored in the buffer, or a negative value if the arguments do not fit
+ *         into the buffer
+ */
+int args_encode(void *buf, size_t buf_size, const char *fmt, va_list args);
+
+/**
+ * \brief Formats a string from a format string and arguments encoded with args_encode().
+ *
+ * Behaves like args_format().
+ *
+ * \param buf Buffer to format the string into, may be NULL if `buf_size` is 0
+ * \param buf_size Size of the buffer in bytes
+ * \param fmt The format string arguments were encoded for
+ * \param args Encoded arguments
+ * \param args_size Size of the encoded arguments in bytes
+ * \return Number of characters that would have been written if the buffer was large enough, not
+ *         counting the null terminator, or a negative value if encoded arguments are malformed
+ */
+int args_decode(char *buf, size_t buf_size, const char *fmt, const void *args, size_t args_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ARGS_H */
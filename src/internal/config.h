@@ -41,12 +41,60 @@ extern "C" {
  */
 #define MULOG_OUTPUT_HANDLERS (MULOG_INTERNAL_OUTPUT_HANDLERS)
 
+/**
+ * \brief Maximum number of deferred log lines passed to a vectored output function at once
+ */
+#define MULOG_OUTPUT_BATCH_SIZE (MULOG_INTERNAL_OUTPUT_BATCH_SIZE)
+
+/**
+ * \brief Maximum number of logger instances that can be created in addition to the default logger
+ */
+#define MULOG_INSTANCES (MULOG_INTERNAL_INSTANCES)
+
+/**
+ * \brief Flag to control whether deferred log entries are stored in a lock-free multi-producer
+ * ring, so log calls do not take the logger lock
+ */
+#define MULOG_ENABLE_LOCKFREE_DEFERRED (MULOG_INTERNAL_ENABLE_LOCKFREE_DEFERRED)
+
+/**
+ * \brief Flag to control whether deferred log calls store the format string and raw arguments
+ * instead of formatted text, so formatting is done by mulog_deferred_process()
+ */
+#define MULOG_ENABLE_DEFERRED_ARGS_CAPTURE (MULOG_INTERNAL_ENABLE_DEFERRED_ARGS_CAPTURE)
+
+/**
+ * \brief Flag to control whether threads may register their own log format buffers in realtime
+ * mode, so formatting does not require the logger lock
+ */
+#define MULOG_ENABLE_THREAD_LOG_BUFFER (MULOG_INTERNAL_ENABLE_THREAD_LOG_BUFFER)
+
+/**
+ * \brief Flag to control whether log calls are encoded into binary records instead of text lines
+ */
+#define MULOG_ENABLE_BINARY_OUTPUT (MULOG_INTERNAL_ENABLE_BINARY_OUTPUT)
+
+/**
+ * \brief Flag to control whether the default logger takes separate locks for configuration changes,
+ * log entry formatting and output dispatch
+ */
+#define MULOG_ENABLE_LOCK_DOMAINS (MULOG_INTERNAL_ENABLE_LOCK_DOMAINS)
+
 /**
  * \brief Log line termination
  */
 #define MULOG_LOG_LINE_TERMINATION "\n"
 #else
 #include MULOG_INTERNAL_CONFIG_PATH
+
+// custom configurations written for an earlier version do not define the newer settings
+#if !defined(MULOG_OUTPUT_BATCH_SIZE)
+#define MULOG_OUTPUT_BATCH_SIZE 8
+#endif /* MULOG_OUTPUT_BATCH_SIZE */
+
+#if !defined(MULOG_INSTANCES)
+#define MULOG_INSTANCES 0
+#endif /* MULOG_INSTANCES */
 #endif /* #if !defined(MULOG_INTERNAL_CONFIG_PATH) */
 
 /**
@@ -68,6 +116,78 @@ extern bool mulog_config_mulog_lock(void);
  */
 extern void mulog_config_mulog_unlock(void);
 
+/**
+ * \brief External function that is used for locking the log buffer of the default logger with
+ * separate lock domains
+ * \details Taken by log calls to format an entry into the log buffer, or to store it in deferred
+ * mode. Configuration calls that change the log buffer take it after mulog_config_mulog_lock().
+ * \return Status of the lock operation
+ * \retval true Lock has been successfully acquired
+ * \retval false Lock has not been acquired
+ */
+extern bool mulog_config_mulog_format_lock(void);
+
+/**
+ * \brief External function that is used for unlocking the log buffer of the default logger with
+ * separate lock domains
+ */
+extern void mulog_config_mulog_format_unlock(void);
+
+/**
+ * \brief External function that is used for locking the outputs of the default logger with
+ * separate lock domains
+ * \details Taken by realtime log calls to pass an entry to the outputs, and by
+ * mulog_deferred_process() in deferred mode. Always taken after mulog_config_mulog_format_lock()
+ * when both are held.
+ * \return Status of the lock operation
+ * \retval true Lock has been successfully acquired
+ * \retval false Lock has not been acquired
+ */
+extern bool mulog_config_mulog_output_lock(void);
+
+/**
+ * \brief External function that is used for unlocking the outputs of the default logger with
+ * separate lock domains
+ */
+extern void mulog_config_mulog_output_unlock(void);
+
+/**
+ * \brief External function that is used for locking logger without waiting in non-blocking mode
+ * \details Log calls take the lock with it, configuration calls still use
+ * mulog_config_mulog_lock(). Required in non-blocking mode, it must not wait for the lock.
+ * \return Status of the lock operation
+ * \retval true Lock has been successfully acquired
+ * \retval false Lock is held by another thread or has not been acquired
+ */
+extern bool mulog_config_mulog_trylock(void);
+
+/**
+ * \brief External function that is used for starting the deferred mode drain worker thread
+ * \param worker Worker routine to run in the new thread, it returns once the worker is stopped
+ * \return Status of the start operation
+ * \retval true Worker thread has been started
+ * \retval false Worker thread has not been started
+ */
+extern bool mulog_config_mulog_worker_start(void (*worker)(void));
+
+/**
+ * \brief External function that is used for waiting until the drain worker thread exits
+ */
+extern void mulog_config_mulog_worker_join(void);
+
+/**
+ * \brief External function that is used for putting the drain worker to sleep
+ * \details Returns once mulog_config_mulog_worker_wake() is called or the timeout expires. A wake
+ * up that happens before the call must not be lost.
+ * \param timeout_ms Maximum time to sleep in milliseconds
+ */
+extern void mulog_config_mulog_worker_wait(unsigned long timeout_ms);
+
+/**
+ * \brief External function that is used for waking up the drain worker
+ */
+extern void mulog_config_mulog_worker_wake(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -6,296 +6,1262 @@
 
 #include "internal/interface.h"
 #include "internal/config.h"
+#include "internal/output_table.h"
 #include "internal/utils.h"
-#include "list.h"
 
-#include <lwrb/lwrb.h>
+#if defined(MULOG_ENABLE_DEFERRED_ARGS_CAPTURE) && MULOG_ENABLE_DEFERRED_ARGS_CAPTURE == 1
+#include "internal/args.h"
+#endif
+
+#include "internal/deferred/ring.h"
+
 #include <printf/printf.h>
 
+#include <stddef.h>
+#include <string.h>
+
 struct logger_ctx {
-    lwrb_t ring_buf;
+    struct log_ring ring_buf;
+    struct log_ring priority_ring;              /**< Storage for warning and error entries */
+    struct log_ring recorder_ring;              /**< Flight recorder storage */
+    enum mulog_log_level persist_level;         /**< Lower entries go to the flight recorder */
+    unsigned long sequence;                     /**< Sequence number of the last log entry */
     enum mulog_log_level global_level;
+    bool global_level_set;                      /**< Whether the global level has been set */
+    enum mulog_overflow_policy overflow_policy; /**< Policy for entries that do not fit */
+    size_t spin_limit;                          /**< Retries of the blocking overflow policy */
+    size_t dropped[MULOG_LOG_LVL_COUNT];        /**< Number of dropped log entries per level */
+    size_t reported_dropped; /**< Number of dropped log entries reported to the outputs */
 };
 
-struct out_function {
-    mulog_log_output_fn output;
-    enum mulog_log_level log_level;
-    struct list_node node;
-};
-
-#ifndef MULOG_OUTPUT_HANDLERS
-#error "Define MULOG_OUTPUT_HANDLERS to a number of maximum output handlers that can be registered"
+#if !defined(MULOG_OUTPUT_BATCH_SIZE) || MULOG_OUTPUT_BATCH_SIZE < 1
+#error "Define MULOG_OUTPUT_BATCH_SIZE to a maximum number of log lines passed to outputs at once"
 #endif
 
-struct handles {
-    LIST_HEAD_VAR(out_functions);
-    size_t out_count;
-    struct out_function fns[MULOG_OUTPUT_HANDLERS];
+/**
+ * \brief Log lines taken from the ring and passed to the outputs at once
+ */
+struct output_batch {
+    struct mulog_iovec lines[MULOG_OUTPUT_BATCH_SIZE];    /**< Log lines in the logging order */
+    enum mulog_log_level levels[MULOG_OUTPUT_BATCH_SIZE]; /**< Log level of each line */
+    size_t count;                                         /**< Number of lines in the batch */
 };
 
-static struct logger_ctx log_ctx = {
-    .global_level = MULOG_LOG_LVL_DEBUG,
+#if defined(MULOG_ENABLE_DEFERRED_ARGS_CAPTURE) && MULOG_ENABLE_DEFERRED_ARGS_CAPTURE == 1
+/**
+ * \brief Log entry with captured arguments stored in the ring buffer
+ */
+struct log_record {
+    const char *fmt;                                    /**< Format string of the log entry */
+    unsigned long timestamp;                            /**< Log entry raw timestamp */
+    unsigned long sequence;                             /**< Log entry sequence number */
+    enum mulog_log_level level;                         /**< Log entry level */
+    unsigned char args[MULOG_SINGLE_LOG_LINE_SIZE + 1]; /**< Captured format arguments */
 };
-static struct handles handles = {
-    .out_functions = LIST_HEAD_INIT_VAR,
+
+_Static_assert(sizeof(struct log_record) <= LOG_RING_RECORD_MAX_SIZE,
+               "Log record must fit into a ring record");
+
+/**
+ * \brief Maximum size of a log line formatted from a record
+ */
+#define LOG_LINE_MAX_SIZE                                                                          \
+    (LOG_PREFIX_SIZE + MULOG_SINGLE_LOG_LINE_SIZE + sizeof(MULOG_LOG_LINE_TERMINATION))
+#else
+/**
+ * \brief Size of the log level stored in front of each formatted line in the ring buffer
+ */
+#define LOG_LINE_LEVEL_SIZE 1
+#endif /* MULOG_ENABLE_DEFERRED_ARGS_CAPTURE */
+
+#if !defined(MULOG_INSTANCES) || MULOG_INSTANCES < 0
+#error "Define MULOG_INSTANCES to a number of logger instances that can be created"
+#endif
+
+/**
+ * \brief Logger state, the default logger and every logger instance have their own
+ */
+struct logger {
+    struct logger_ctx ctx;
+    struct output_table outputs; /**< Registered output functions */
+#if defined(MULOG_ENABLE_DEFERRED_ARGS_CAPTURE) && MULOG_ENABLE_DEFERRED_ARGS_CAPTURE == 1
+    char batch_lines[MULOG_OUTPUT_BATCH_SIZE][LOG_LINE_MAX_SIZE]; /**< Lines of the output batch */
+#endif /* MULOG_ENABLE_DEFERRED_ARGS_CAPTURE */
 };
 
 /**
- * \brief Outputs a log entry to all registered output functions.
+ * \brief Default logger followed by the loggers of the instances, which are reset before use
  *
- * This function iterates through all registered output functions and writes the
- * provided log entry buffer to each of them.
+ * A zero-initialized logger has no outputs and logs with the default settings.
+ */
+static struct logger loggers[1 + MULOG_INSTANCES];
+
+/**
+ * \brief Passes a log line to an output function that takes one line per call.
  *
- * \param buf Pointer to the buffer containing the log entry to be output.
- * \param buf_size Size of the buffer in bytes.
+ * \param fn The output function.
+ * \param line The log line.
  */
-static void output_log_entry(const char *buf, const size_t buf_size)
+static inline void write_out_function(const struct out_function *fn,
+                                      const struct mulog_iovec *line)
 {
-    struct list_node *it;
+    if (fn->output != NULL) {
+        fn->output(line->base, line->len);
+    } else {
+        fn->ctx_output.write(fn->ctx_output.ctx, line->base, line->len);
+    }
+}
 
-    LIST_FOR_EACH(it, &handles.out_functions)
-    {
-        const struct out_function *fn = LIST_ENTRY(it, struct out_function, node);
+/**
+ * \brief Outputs a batch of log lines to all the registered output functions. Each output gets
+ *        the lines with a log level higher than or equal to its own log level.
+ *
+ * Vectored outputs get all their lines with a single call, other outputs get a call per line.
+ * The consumer may run without the logger lock, so the outputs are taken from a snapshot that is
+ * not changed while the batch is output.
+ *
+ * \param logger The logger.
+ * \param batch The log lines to output.
+ */
+static void output_batch(struct logger *logger, const struct output_batch *batch)
+{
+    const struct out_table *outputs = output_table_acquire(&logger->outputs);
+    enum mulog_log_level max_level = MULOG_LOG_LVL_TRACE;
+
+    for (size_t i = 0; i < batch->count; ++i) {
+        if (batch->levels[i] > max_level) {
+            max_level = batch->levels[i];
+        }
+    }
+
+    // outputs are ordered by their log level, the rest of them take none of the lines
+    const size_t out_count = out_table_get_count(outputs, max_level);
+
+    for (size_t n = 0; n < out_count; ++n) {
+        const struct out_function *fn = &outputs->fns[n];
+        const enum mulog_log_level log_level = fn->log_level;
+
+        if (fn->output_vec != NULL) {
+            struct mulog_iovec lines[MULOG_OUTPUT_BATCH_SIZE];
+            size_t count = 0;
+
+            for (size_t i = 0; i < batch->count; ++i) {
+                if (log_level <= batch->levels[i]) {
+                    lines[count++] = batch->lines[i];
+                }
+            }
+
+            if (count > 0) {
+                fn->output_vec(lines, count);
+            }
+
+            continue;
+        }
 
-        fn->output(buf, buf_size);
+        for (size_t i = 0; i < batch->count; ++i) {
+            if (log_level <= batch->levels[i]) {
+                write_out_function(fn, &batch->lines[i]);
+            }
+        }
     }
+
+    output_table_release(outputs);
+}
+
+/**
+ * \brief Adds a log line to the batch.
+ *
+ * \param batch The batch to add the line to, must not be full.
+ * \param log_level The log level of the line.
+ * \param line The log line.
+ * \param line_size The log line size in bytes.
+ * \return The log line size in bytes.
+ */
+static size_t add_batch_line(struct output_batch *batch, const enum mulog_log_level log_level,
+                             const char *line, const size_t line_size)
+{
+    batch->lines[batch->count].base = line;
+    batch->lines[batch->count].len = line_size;
+    batch->levels[batch->count] = log_level;
+    ++batch->count;
+
+    return line_size;
+}
+
+/**
+ * \brief Outputs a log entry to all the registered output functions that have a log level
+ *        lower than or equal to the log level of the entry.
+ *
+ * \param logger The logger.
+ * \param log_level The log level of the entry.
+ * \param buf Pointer to the buffer containing the log entry to be output.
+ * \param buf_size Size of the buffer in bytes.
+ */
+static void output_log_entry(struct logger *logger, const enum mulog_log_level log_level,
+                             const char *buf, const size_t buf_size)
+{
+    struct output_batch batch = {.count = 0};
+
+    add_batch_line(&batch, log_level, buf, buf_size);
+    output_batch(logger, &batch);
 }
 
 /**
- * \brief Prepend a timestamp to the specified ring buffer.
+ * \brief Formats a log entry prefix with a sequence number, a timestamp and a log level.
  *
- * This function generates a timestamp string in the format "sssssss.mmm " where
- * sssssss represents the seconds and mmm represents the milliseconds, and writes
- * it to the specified ring buffer if timestamp logging is enabled.
+ * The sequence number format is `#N `, it is omitted for the sequence number 0. The timestamp
+ * format is `sssssss.mmm ` where sssssss represents the seconds and mmm represents
+ * the milliseconds. The timestamp is omitted if timestamp logging is disabled.
  *
- * \param ring_buf Pointer to the ring buffer where the timestamp will be written.
- * \return The number of bytes written to the ring buffer. Returns 0 if timestamp
- * logging is disabled.
+ * \param buf The buffer to format the prefix into.
+ * \param buf_size The size of the buffer.
+ * \param level The log level of the entry.
+ * \param timestamp_ms The timestamp of the entry in milliseconds.
+ * \param sequence The sequence number of the entry.
+ * \return The number of characters written to the buffer, or a negative value if an error occurs.
  */
-static inline size_t prepend_timestamp_rb(lwrb_t *ring_buf)
+static int format_prefix(char *buf, const size_t buf_size, const enum mulog_log_level level,
+                         const unsigned long timestamp_ms, const unsigned long sequence)
 {
+    const char *level_str[] = {
+        [MULOG_LOG_LVL_TRACE] = MULOG_TRACE_LVL, [MULOG_LOG_LVL_DEBUG] = MULOG_DEBUG_LVL,
+        [MULOG_LOG_LVL_INFO] = MULOG_INFO_LVL,   [MULOG_LOG_LVL_WARNING] = MULOG_WARNING_LVL,
+        [MULOG_LOG_LVL_ERROR] = MULOG_ERROR_LVL,
+    };
+    const int sequence_size = sequence != 0 ? snprintf_(buf, buf_size, "#%lu ", sequence) : 0;
+
+    if (sequence_size < 0 || (size_t)sequence_size >= buf_size) {
+        return -1;
+    }
+
 #if defined(MULOG_ENABLE_TIMESTAMP) && MULOG_ENABLE_TIMESTAMP == 1
-    char timestamp_buffer[16];
-    const unsigned long timestamp_ms = mulog_config_mulog_timestamp_get();
     const unsigned long ms = timestamp_ms % 1000;
     const unsigned long sec = timestamp_ms / 1000;
+    const int ret = snprintf_(buf + sequence_size, buf_size - (size_t)sequence_size,
+                              "%07lu.%03lu %s: ", sec, ms, level_str[level]);
+#else
+    UNUSED(timestamp_ms);
     const int ret =
-        snprintf_(timestamp_buffer, ARRAY_SIZE(timestamp_buffer), "%07lu.%03lu ", sec, ms);
+        snprintf_(buf + sequence_size, buf_size - (size_t)sequence_size, "%s: ", level_str[level]);
+#endif /* MULOG_ENABLE_TIMESTAMP */
 
-    if (ret < 0) {
-        return 0;
-    }
+    return ret < 0 ? ret : sequence_size + ret;
+}
 
-    return lwrb_write(ring_buf, timestamp_buffer, ret);
+/**
+ * \brief Gets the current timestamp for a log entry.
+ *
+ * \return The current timestamp in milliseconds, or 0 if timestamp logging is disabled.
+ */
+static inline unsigned long get_timestamp(void)
+{
+#if defined(MULOG_ENABLE_TIMESTAMP) && MULOG_ENABLE_TIMESTAMP == 1
+    return mulog_config_mulog_timestamp_get();
 #else
-    UNUSED(buf);
-    UNUSED(buf_size);
     return 0;
 #endif /* MULOG_ENABLE_TIMESTAMP */
 }
 
-static inline size_t prepend_level_rb(enum mulog_log_level level, lwrb_t *ring_buf)
+/**
+ * \brief Publishes the lowest log level accepted by the registered output functions.
+ *
+ * Must be called after every change of the outputs. The value is read by the log macros, which
+ * only log through the default logger, so other loggers do not publish it.
+ *
+ * \param logger The logger to update.
+ */
+static void update_min_log_level(struct logger *logger)
 {
-    const char *level_str[] = {
-        [MULOG_LOG_LVL_TRACE] = MULOG_TRACE_LVL, [MULOG_LOG_LVL_DEBUG] = MULOG_DEBUG_LVL,
-        [MULOG_LOG_LVL_INFO] = MULOG_INFO_LVL,   [MULOG_LOG_LVL_WARNING] = MULOG_WARNING_LVL,
-        [MULOG_LOG_LVL_ERROR] = MULOG_ERROR_LVL,
-    };
-    const char *trailing_symbols = ": ";
-    // we need to write log level + ':' + ' '
-    const size_t trailing_size = 2;
-    const size_t level_size = strlen(level_str[level]);
-    const size_t to_output = level_size + trailing_size;
-    const size_t size = lwrb_get_free(ring_buf);
-
-    if (size < to_output) {
-        return 0;
+    if (logger == &loggers[0]) {
+        __atomic_store_n(&mulog_min_log_level, output_table_get_min_level(&logger->outputs),
+                         __ATOMIC_RELAXED);
     }
+}
+
+struct logger *interface_get_logger(const size_t index)
+{
+    return index < ARRAY_SIZE(loggers) ? &loggers[index] : NULL;
+}
+
+enum mulog_ret_code interface_add_output_default(struct logger *logger,
+                                                 const mulog_log_output_fn output)
+{
+    const enum mulog_log_level level =
+        logger->ctx.global_level_set ? logger->ctx.global_level : MULOG_LOG_LVL_DEBUG;
 
-    size_t written = 0;
+    return interface_add_output(logger, output, level);
+}
+
+/**
+ * \brief Registers an output function.
+ *
+ * \param logger The logger.
+ * \param out The output function to copy into the output table.
+ * \return Status code indicating the result of the operation.
+ */
+static enum mulog_ret_code add_out_function(struct logger *logger, const struct out_function *out)
+{
+    const enum mulog_ret_code ret = output_table_add(&logger->outputs, out);
 
-    written += lwrb_write(ring_buf, level_str[level], level_size);
-    written += lwrb_write(ring_buf, trailing_symbols, trailing_size);
+    update_min_log_level(logger);
 
-    return written;
+    return ret;
 }
 
-enum mulog_ret_code interface_add_output_default(const mulog_log_output_fn output)
+/**
+ * \brief Removes a registered output function and closes it.
+ *
+ * \param logger The logger.
+ * \param out The output function to remove, compared by the functions and the user context.
+ * \return Status code indicating the result of the operation.
+ */
+static enum mulog_ret_code remove_out_function(struct logger *logger,
+                                               const struct out_function *out)
 {
-    return interface_add_output(output, log_ctx.global_level);
+    const enum mulog_ret_code ret = output_table_remove(&logger->outputs, out);
+
+    update_min_log_level(logger);
+
+    return ret;
 }
 
-enum mulog_ret_code interface_add_output(const mulog_log_output_fn output,
+enum mulog_ret_code interface_add_output(struct logger *logger, const mulog_log_output_fn output,
                                          const enum mulog_log_level log_level)
 {
-    if (output == NULL || log_level >= MULOG_LOG_LVL_COUNT) {
+    const struct out_function out = {.output = output, .log_level = log_level};
+
+    return output == NULL ? MULOG_RET_CODE_INVALID_ARG : add_out_function(logger, &out);
+}
+
+enum mulog_ret_code interface_add_output_vec(struct logger *logger,
+                                             const mulog_log_output_vec_fn output,
+                                             const enum mulog_log_level log_level)
+{
+    const struct out_function out = {.output_vec = output, .log_level = log_level};
+
+    return output == NULL ? MULOG_RET_CODE_INVALID_ARG : add_out_function(logger, &out);
+}
+
+enum mulog_ret_code interface_add_output_ctx(struct logger *logger,
+                                             const struct mulog_output *output,
+                                             const enum mulog_log_level log_level)
+{
+    if (output == NULL || output->write == NULL) {
         return MULOG_RET_CODE_INVALID_ARG;
     }
 
-    if (log_ctx.global_level != log_level) {
-        return MULOG_RET_CODE_UNSUPPORTED;
+    const struct out_function out = {.ctx_output = *output, .log_level = log_level};
+
+    return add_out_function(logger, &out);
+}
+
+enum mulog_ret_code interface_set_output_registry(struct logger *logger,
+                                                  struct mulog_output_slot *slots,
+                                                  const size_t count)
+{
+    if (slots != NULL && count == 0) {
+        return MULOG_RET_CODE_INVALID_ARG;
     }
 
-    struct out_function *fn = NULL;
+    // slots only reserve the space, each of them holds an output function of both snapshots
+    return output_table_set_storage(&logger->outputs, (void *)slots, count);
+}
 
-    for (size_t i = 0; i < ARRAY_SIZE(handles.fns); ++i) {
-        if (LIST_NODE_IS_DANGLING(&handles.fns[i].node)) {
-            fn = &handles.fns[i];
-            break;
-        }
+enum mulog_ret_code interface_set_log_buffer(struct logger *logger, char *log_buffer,
+                                             const size_t log_buffer_size)
+{
+    return log_ring_init(&logger->ctx.ring_buf, log_buffer, log_buffer_size)
+               ? MULOG_RET_CODE_OK
+               : MULOG_RET_CODE_INVALID_ARG;
+}
+
+enum mulog_ret_code interface_set_priority_log_buffer(struct logger *logger, char *log_buffer,
+                                                      const size_t log_buffer_size)
+{
+    if (log_buffer == NULL) {
+        log_ring_free(&logger->ctx.priority_ring);
+
+        return MULOG_RET_CODE_OK;
     }
 
-    if (fn == NULL) {
-        return MULOG_RET_CODE_NO_MEM;
+    return log_ring_init(&logger->ctx.priority_ring, log_buffer, log_buffer_size)
+               ? MULOG_RET_CODE_OK
+               : MULOG_RET_CODE_INVALID_ARG;
+}
+
+enum mulog_ret_code interface_set_flight_recorder(struct logger *logger, char *log_buffer,
+                                                  const size_t log_buffer_size,
+                                                  const enum mulog_log_level persist_level)
+{
+#if defined(MULOG_ENABLE_LOCKFREE_DEFERRED) && MULOG_ENABLE_LOCKFREE_DEFERRED == 1
+    // producers would have to overwrite each other's entries without the lock
+    UNUSED(logger);
+    UNUSED(log_buffer);
+    UNUSED(log_buffer_size);
+    UNUSED(persist_level);
+    return MULOG_RET_CODE_UNSUPPORTED;
+#else
+    if (log_buffer == NULL) {
+        log_ring_free(&logger->ctx.recorder_ring);
+
+        return MULOG_RET_CODE_OK;
     }
 
-    LIST_NODE_INIT(&fn->node);
-    ++handles.out_count;
-    fn->output = output;
-    fn->log_level = log_level;
-    list_head_add(&handles.out_functions, &fn->node);
+    if (persist_level >= MULOG_LOG_LVL_COUNT ||
+        !log_ring_init(&logger->ctx.recorder_ring, log_buffer, log_buffer_size)) {
+        return MULOG_RET_CODE_INVALID_ARG;
+    }
+
+    logger->ctx.persist_level = persist_level;
 
     return MULOG_RET_CODE_OK;
+#endif /* MULOG_ENABLE_LOCKFREE_DEFERRED */
 }
 
-enum mulog_ret_code interface_set_log_buffer(char *log_buffer, const size_t log_buffer_size)
+enum mulog_ret_code interface_set_persistent_log_buffer(struct logger *logger, char *log_buffer,
+                                                        const size_t log_buffer_size)
 {
-    return lwrb_init(&log_ctx.ring_buf, log_buffer, log_buffer_size) != 0
+#if defined(MULOG_ENABLE_DEFERRED_ARGS_CAPTURE) && MULOG_ENABLE_DEFERRED_ARGS_CAPTURE == 1
+    // captured records point to format strings that do not survive a restart
+    UNUSED(logger);
+    UNUSED(log_buffer);
+    UNUSED(log_buffer_size);
+    return MULOG_RET_CODE_UNSUPPORTED;
+#else
+    return log_ring_init_persistent(&logger->ctx.ring_buf, log_buffer, log_buffer_size)
                ? MULOG_RET_CODE_OK
                : MULOG_RET_CODE_INVALID_ARG;
+#endif /* MULOG_ENABLE_DEFERRED_ARGS_CAPTURE */
+}
+
+enum mulog_ret_code interface_set_thread_log_buffer(char *log_buffer, const size_t log_buffer_size)
+{
+    UNUSED(log_buffer);
+    UNUSED(log_buffer_size);
+    return MULOG_RET_CODE_UNSUPPORTED;
+}
+
+bool interface_has_thread_log_buffer(void)
+{
+    return false;
 }
 
-enum mulog_ret_code interface_set_global_log_level(const enum mulog_log_level log_level)
+enum mulog_ret_code interface_set_global_log_level(struct logger *logger,
+                                                   const enum mulog_log_level log_level)
 {
     if (log_level >= MULOG_LOG_LVL_COUNT) {
         return MULOG_RET_CODE_INVALID_ARG;
     }
 
-    log_ctx.global_level = log_level;
+    const enum mulog_ret_code ret = output_table_set_all_levels(&logger->outputs, log_level);
 
-    return MULOG_RET_CODE_OK;
+    if (ret == MULOG_RET_CODE_OK) {
+        logger->ctx.global_level = log_level;
+        logger->ctx.global_level_set = true;
+        update_min_log_level(logger);
+    }
+
+    return ret;
 }
 
-enum mulog_ret_code interface_set_log_level_per_output(const enum mulog_log_level log_level,
+enum mulog_ret_code interface_set_log_level_per_output(struct logger *logger,
+                                                       const enum mulog_log_level log_level,
                                                        const mulog_log_output_fn output)
 {
-    UNUSED(log_level);
-    UNUSED(output);
-    return MULOG_RET_CODE_UNSUPPORTED;
+    if (log_level >= MULOG_LOG_LVL_COUNT) {
+        return MULOG_RET_CODE_INVALID_ARG;
+    }
+
+    const enum mulog_ret_code ret = output_table_set_level(&logger->outputs, output, log_level);
+
+    update_min_log_level(logger);
+
+    return ret;
 }
 
-enum mulog_ret_code interface_unregister_output(const mulog_log_output_fn output)
+enum mulog_ret_code interface_unregister_output(struct logger *logger,
+                                                const mulog_log_output_fn output)
 {
-    struct list_node *it = NULL;
+    const struct out_function out = {.output = output};
 
-    LIST_FOR_EACH(it, &handles.out_functions)
-    {
-        const struct out_function *out = LIST_ENTRY(it, struct out_function, node);
+    return output == NULL ? MULOG_RET_CODE_NOT_FOUND : remove_out_function(logger, &out);
+}
 
-        if (out->output == output) {
-            list_head_del(it);
-            --handles.out_count;
-            break;
-        }
+enum mulog_ret_code interface_unregister_output_vec(struct logger *logger,
+                                                    const mulog_log_output_vec_fn output)
+{
+    const struct out_function out = {.output_vec = output};
+
+    return output == NULL ? MULOG_RET_CODE_NOT_FOUND : remove_out_function(logger, &out);
+}
+
+enum mulog_ret_code interface_unregister_output_ctx(struct logger *logger,
+                                                    const mulog_output_write_fn write,
+                                                    const void *ctx)
+{
+    const struct out_function out = {.ctx_output = {.write = write, .ctx = (void *)ctx}};
+
+    return write == NULL ? MULOG_RET_CODE_NOT_FOUND : remove_out_function(logger, &out);
+}
+
+enum mulog_ret_code interface_unregister_all_outputs(struct logger *logger)
+{
+    const enum mulog_ret_code ret = output_table_clear(&logger->outputs);
+
+    update_min_log_level(logger);
+
+    return ret;
+}
+
+void interface_reset(struct logger *logger)
+{
+    output_table_reset(&logger->outputs);
+    logger->ctx.global_level_set = false;
+    __atomic_store_n(&logger->ctx.overflow_policy, MULOG_OVERFLOW_DROP_NEWEST, __ATOMIC_RELAXED);
+    __atomic_store_n(&logger->ctx.spin_limit, 0, __ATOMIC_RELAXED);
+
+    for (size_t i = 0; i < ARRAY_SIZE(logger->ctx.dropped); ++i) {
+        __atomic_store_n(&logger->ctx.dropped[i], 0, __ATOMIC_RELAXED);
     }
 
-    if (it == NULL) {
-        return MULOG_RET_CODE_NOT_FOUND;
+    logger->ctx.reported_dropped = 0;
+    update_min_log_level(logger);
+    log_ring_free(&logger->ctx.ring_buf);
+    log_ring_free(&logger->ctx.priority_ring);
+    log_ring_free(&logger->ctx.recorder_ring);
+    logger->ctx.persist_level = MULOG_LOG_LVL_TRACE;
+    __atomic_store_n(&logger->ctx.sequence, 0, __ATOMIC_RELAXED);
+}
+
+size_t interface_get_dropped_count(struct logger *logger)
+{
+    size_t dropped = 0;
+
+    for (size_t i = 0; i < ARRAY_SIZE(logger->ctx.dropped); ++i) {
+        dropped += __atomic_load_n(&logger->ctx.dropped[i], __ATOMIC_RELAXED);
     }
 
+    return dropped;
+}
+
+size_t interface_get_level_dropped_count(struct logger *logger, const enum mulog_log_level level)
+{
+    return level < MULOG_LOG_LVL_COUNT
+               ? __atomic_load_n(&logger->ctx.dropped[level], __ATOMIC_RELAXED)
+               : 0;
+}
+
+enum mulog_ret_code interface_set_overflow_policy(struct logger *logger,
+                                                  const enum mulog_overflow_policy policy,
+                                                  const size_t spin_limit)
+{
+    switch (policy) {
+    case MULOG_OVERFLOW_DROP_NEWEST:
+    case MULOG_OVERFLOW_BLOCK:
+        break;
+    case MULOG_OVERFLOW_DROP_OLDEST:
+#if defined(MULOG_ENABLE_LOCKFREE_DEFERRED) && MULOG_ENABLE_LOCKFREE_DEFERRED == 1
+        // lock-free producers can not remove records the consumer may be reading
+        return MULOG_RET_CODE_UNSUPPORTED;
+#else
+        break;
+#endif /* MULOG_ENABLE_LOCKFREE_DEFERRED */
+    default:
+        return MULOG_RET_CODE_INVALID_ARG;
+    }
+
+    __atomic_store_n(&logger->ctx.spin_limit, spin_limit, __ATOMIC_RELAXED);
+    __atomic_store_n(&logger->ctx.overflow_policy, policy, __ATOMIC_RELAXED);
+
     return MULOG_RET_CODE_OK;
 }
 
-void interface_unregister_all_outputs(void)
+bool interface_is_deferred_log_locked(struct logger *logger)
 {
-    struct list_node *it = NULL;
-    struct list_node *temp = NULL;
+    return __atomic_load_n(&logger->ctx.overflow_policy, __ATOMIC_RELAXED) ==
+           MULOG_OVERFLOW_DROP_OLDEST;
+}
+
+size_t interface_get_deferred_usage(struct logger *logger)
+{
+    const size_t used = log_ring_get_used(&logger->ctx.ring_buf);
+
+    return log_ring_is_ready(&logger->ctx.priority_ring)
+               ? used + log_ring_get_used(&logger->ctx.priority_ring)
+               : used;
+}
 
-    LIST_FOR_EACH_SAFE(it, temp, &handles.out_functions)
-    {
-        list_head_del(it);
+/**
+ * \brief Accounts a log entry that has not been stored in the ring.
+ *
+ * \param logger The logger.
+ * \param level The log level of the entry.
+ * \return Always 0, the number of bytes stored for the entry.
+ */
+static int drop_log_entry(struct logger *logger, const enum mulog_log_level level)
+{
+    if (level < MULOG_LOG_LVL_COUNT) {
+        __atomic_fetch_add(&logger->ctx.dropped[level], 1, __ATOMIC_RELAXED);
     }
+
+    return 0;
 }
 
-void interface_reset(void)
+/**
+ * \brief Gets the log level of a record stored in the ring.
+ *
+ * \param record The record data.
+ * \param record_size The record size in bytes.
+ * \return The log level of the record, or MULOG_LOG_LVL_COUNT if the record is malformed.
+ */
+static enum mulog_log_level get_record_level(const void *record, const size_t record_size)
 {
-    handles.out_count = 0;
-    log_ctx.global_level = MULOG_LOG_LVL_DEBUG;
-    LIST_HEAD_INIT(&handles.out_functions);
+#if defined(MULOG_ENABLE_DEFERRED_ARGS_CAPTURE) && MULOG_ENABLE_DEFERRED_ARGS_CAPTURE == 1
+    enum mulog_log_level level = MULOG_LOG_LVL_COUNT;
 
-    for (size_t i = 0; i < ARRAY_SIZE(handles.fns); ++i) {
-        LIST_NODE_INIT(&handles.fns[i].node);
+    // ring records are not aligned, copy the level out
+    if (record_size >= offsetof(struct log_record, args)) {
+        memcpy(&level, (const unsigned char *)record + offsetof(struct log_record, level),
+               sizeof(level));
     }
 
-    lwrb_reset(&log_ctx.ring_buf);
-    lwrb_free(&log_ctx.ring_buf);
+    return level < MULOG_LOG_LVL_COUNT ? level : MULOG_LOG_LVL_COUNT;
+#else
+    const enum mulog_log_level level = (enum mulog_log_level)((const unsigned char *)record)[0];
+
+    return record_size > LOG_LINE_LEVEL_SIZE && level < MULOG_LOG_LVL_COUNT ? level
+                                                                            : MULOG_LOG_LVL_COUNT;
+#endif /* MULOG_ENABLE_DEFERRED_ARGS_CAPTURE */
 }
 
-int interface_log_output(const enum mulog_log_level level, const char *fmt, va_list args)
+#if !defined(MULOG_ENABLE_LOCKFREE_DEFERRED) || MULOG_ENABLE_LOCKFREE_DEFERRED == 0
+/**
+ * \brief Drops the oldest record stored in the ring.
+ *
+ * Only called with the logger lock held, which the consumer also takes with this policy.
+ *
+ * \param logger The logger.
+ * \param ring The ring to drop the record from.
+ * \return true if a record has been dropped, false if the ring is empty.
+ */
+static bool drop_oldest_log_entry(struct logger *logger, struct log_ring *ring)
 {
-    if (list_head_empty(&handles.out_functions) || lwrb_is_ready(&log_ctx.ring_buf) == 0 ||
-        level >= MULOG_LOG_LVL_COUNT || level < log_ctx.global_level) {
+    size_t record_size;
+    const void *record = log_ring_peek(ring, &record_size);
+
+    if (record == NULL) {
+        return false;
+    }
+
+    drop_log_entry(logger, get_record_level(record, record_size));
+    log_ring_release(ring);
+
+    return true;
+}
+#endif /* MULOG_ENABLE_LOCKFREE_DEFERRED */
+
+/**
+ * \brief Selects the ring a log entry is stored in.
+ *
+ * \param logger The logger.
+ * \param level The log level of the entry.
+ * \return The flight recorder ring for entries below the persist level, the priority ring for
+ *         warning and error entries, or the log ring otherwise. A ring is only selected if set.
+ */
+static struct log_ring *get_log_ring(struct logger *logger, const enum mulog_log_level level)
+{
+    if (level < logger->ctx.persist_level && log_ring_is_ready(&logger->ctx.recorder_ring)) {
+        return &logger->ctx.recorder_ring;
+    }
+
+    return level >= MULOG_LOG_LVL_WARNING && log_ring_is_ready(&logger->ctx.priority_ring)
+               ? &logger->ctx.priority_ring
+               : &logger->ctx.ring_buf;
+}
+
+/**
+ * \brief Reserves flight recorder storage for a log entry, overwriting the oldest entries.
+ *
+ * Overwritten entries are expected to be lost, so they are not counted as dropped.
+ *
+ * \param logger The logger.
+ * \param size The log entry size in bytes.
+ * \param[out] entry Reserved log entry storage.
+ * \return true if the storage has been reserved, false if the entry does not fit into the
+ *         recorder.
+ */
+static bool reserve_recorder_entry(struct logger *logger, const size_t size,
+                                   struct log_ring_reservation *entry)
+{
+    if (!log_ring_can_fit(&logger->ctx.recorder_ring, size)) {
+        return false;
+    }
+
+    while (!log_ring_reserve(&logger->ctx.recorder_ring, size, entry)) {
+        size_t record_size;
+
+        if (log_ring_peek(&logger->ctx.recorder_ring, &record_size) == NULL) {
+            return false;
+        }
+
+        log_ring_release(&logger->ctx.recorder_ring);
+    }
+
+    return true;
+}
+
+/**
+ * \brief Moves the entries kept in the flight recorder to the given ring.
+ *
+ * Called with the logger lock held, which is the only way the recorder ring is accessed.
+ *
+ * \param logger The logger.
+ * \param ring The ring to move the entries to.
+ * \return The number of entries taken from the recorder.
+ */
+static size_t dump_flight_recorder(struct logger *logger, struct log_ring *ring)
+{
+    size_t dumped = 0;
+    size_t record_size;
+    const void *record;
+
+    if (!log_ring_is_ready(&logger->ctx.recorder_ring)) {
+        return 0;
+    }
+
+    while ((record = log_ring_peek(&logger->ctx.recorder_ring, &record_size)) != NULL) {
+        if (!log_ring_write(ring, record, record_size)) {
+            drop_log_entry(logger, get_record_level(record, record_size));
+        }
+
+        log_ring_release(&logger->ctx.recorder_ring);
+        ++dumped;
+    }
+
+    return dumped;
+}
+
+int interface_dump_flight_recorder(struct logger *logger)
+{
+#if defined(MULOG_ENABLE_LOCKFREE_DEFERRED) && MULOG_ENABLE_LOCKFREE_DEFERRED == 1
+    UNUSED(logger);
+    return MULOG_RET_CODE_UNSUPPORTED;
+#else
+    return (int)dump_flight_recorder(logger, &logger->ctx.ring_buf);
+#endif /* MULOG_ENABLE_LOCKFREE_DEFERRED */
+}
+
+/**
+ * \brief Takes the sequence number of a new log entry.
+ *
+ * Entries are stored in two rings and output out of order while the priority ring is set, so each
+ * entry gets a number the logging order can be restored with. A dropped entry leaves a gap.
+ *
+ * \param logger The logger.
+ * \return The sequence number, or 0 if the priority ring is not set.
+ */
+static unsigned long take_sequence(struct logger *logger)
+{
+    return log_ring_is_ready(&logger->ctx.priority_ring)
+               ? __atomic_add_fetch(&logger->ctx.sequence, 1, __ATOMIC_RELAXED)
+               : 0;
+}
+
+/**
+ * \brief Reserves ring storage for a log entry according to the overflow policy.
+ *
+ * \param logger The logger.
+ * \param ring The ring to reserve the storage in.
+ * \param size The log entry size in bytes.
+ * \param[out] entry Reserved log entry storage.
+ * \return true if the storage has been reserved, false if the entry has to be dropped.
+ */
+static bool reserve_log_entry(struct logger *logger, struct log_ring *ring, const size_t size,
+                              struct log_ring_reservation *entry)
+{
+    const enum mulog_overflow_policy policy =
+        __atomic_load_n(&logger->ctx.overflow_policy, __ATOMIC_RELAXED);
+    size_t spins = __atomic_load_n(&logger->ctx.spin_limit, __ATOMIC_RELAXED);
+
+    if (ring == &logger->ctx.recorder_ring) {
+        return reserve_recorder_entry(logger, size, entry);
+    }
+
+    while (!log_ring_reserve(ring, size, entry)) {
+#if !defined(MULOG_ENABLE_LOCKFREE_DEFERRED) || MULOG_ENABLE_LOCKFREE_DEFERRED == 0
+        // stored records are not dropped for an entry that would not fit into the empty ring
+        if (policy == MULOG_OVERFLOW_DROP_OLDEST && log_ring_can_fit(ring, size) &&
+            drop_oldest_log_entry(logger, ring)) {
+            continue;
+        }
+#endif /* MULOG_ENABLE_LOCKFREE_DEFERRED */
+
+        if (policy != MULOG_OVERFLOW_BLOCK || spins == 0) {
+            return false;
+        }
+
+        --spins;
+    }
+
+    return true;
+}
+
+/**
+ * \brief Passes a line with the number of log entries dropped since the previous such line to all
+ *        outputs.
+ *
+ * \param logger The logger.
+ * \return The size of the line, or 0 if no log entries have been dropped.
+ */
+static size_t output_dropped_marker(struct logger *logger)
+{
+    const size_t dropped = interface_get_dropped_count(logger);
+
+    if (dropped == logger->ctx.reported_dropped) {
         return 0;
     }
 
-    size_t written = 0;
-    size_t processed = prepend_timestamp_rb(&log_ctx.ring_buf);
+    char line[LOG_PREFIX_SIZE + 32 + sizeof(MULOG_LOG_LINE_TERMINATION)];
+    const int prefix_size =
+        format_prefix(line, LOG_PREFIX_SIZE, MULOG_LOG_LVL_WARNING, get_timestamp(), 0);
 
-    if (processed == 0) {
+    if (prefix_size < 0) {
         return 0;
     }
 
-    written += processed;
-    processed = prepend_level_rb(level, &log_ctx.ring_buf);
+    const int ret = snprintf_(line + prefix_size, sizeof(line) - (size_t)prefix_size,
+                              "%lu log entries dropped%s",
+                              (unsigned long)(dropped - logger->ctx.reported_dropped),
+                              MULOG_LOG_LINE_TERMINATION);
 
-    if (processed == 0) {
+    if (ret < 0) {
         return 0;
     }
 
-    written += processed;
+    const size_t line_size = (size_t)prefix_size + (size_t)ret;
+
+    // the marker is passed to every output regardless of its log level
+    logger->ctx.reported_dropped = dropped;
+    output_log_entry(logger, MULOG_LOG_LVL_COUNT, line, line_size);
+
+    return line_size;
+}
+
+/**
+ * \brief Checks whether processing has to stop before the next log entry.
+ *
+ * \param budget Processing limits, or NULL for no limits.
+ * \param processed Number of bytes passed to the outputs so far.
+ * \param records Number of log entries taken from the ring so far.
+ * \param start Timestamp of the processing start.
+ * \return true if any of the limits has been reached, false otherwise.
+ */
+static bool is_budget_exhausted(const struct mulog_process_budget *budget, const size_t processed,
+                                const size_t records, const unsigned long start)
+{
+    if (budget == NULL) {
+        return false;
+    }
+
+    return (budget->max_bytes != 0 && processed >= budget->max_bytes) ||
+           (budget->max_records != 0 && records >= budget->max_records) ||
+           (budget->max_time_ms != 0 && get_timestamp() - start >= budget->max_time_ms);
+}
+
+/**
+ * \brief Checks whether the processing budget can be applied.
+ *
+ * \param budget Processing limits, or NULL for no limits.
+ * \return true if the budget is supported, false otherwise.
+ */
+static bool is_budget_supported(const struct mulog_process_budget *budget)
+{
+#if defined(MULOG_ENABLE_TIMESTAMP) && MULOG_ENABLE_TIMESTAMP == 1
+    UNUSED(budget);
+
+    return true;
+#else
+    // there is no clock to measure the processing time with
+    return budget == NULL || budget->max_time_ms == 0;
+#endif /* MULOG_ENABLE_TIMESTAMP */
+}
+
+/**
+ * \brief Checks whether a log entry of the given level has to be stored.
+ *
+ * An entry is stored if at least one output accepts its level, outputs are filtered again when
+ * the entry is processed. Producers may run without the logger lock, so only the lowest accepted
+ * log level published with the output snapshot is read.
+ *
+ * \param logger The logger.
+ * \param level The log level of the entry.
+ * \return true if the entry has to be stored, false otherwise.
+ */
+static bool is_log_entry_accepted(struct logger *logger, const enum mulog_log_level level)
+{
+    return log_ring_is_ready(&logger->ctx.ring_buf) && level < MULOG_LOG_LVL_COUNT &&
+           level >= output_table_get_min_level(&logger->outputs);
+}
+
+#if defined(MULOG_ENABLE_DEFERRED_ARGS_CAPTURE) && MULOG_ENABLE_DEFERRED_ARGS_CAPTURE == 1
+int interface_log_output(struct logger *logger, const enum mulog_log_level level, const char *fmt,
+                         va_list args)
+{
+    if (!is_log_entry_accepted(logger, level)) {
+        return 0;
+    }
+
+    struct log_record record;
+    const int args_size = args_capture(record.args, ARRAY_SIZE(record.args), fmt, args);
+
+    if (args_size < 0) {
+        return drop_log_entry(logger, level);
+    }
+
+    struct log_ring *ring = get_log_ring(logger, level);
+
+    // the recorded context is output ahead of the error entry
+    if (level == MULOG_LOG_LVL_ERROR) {
+        dump_flight_recorder(logger, ring);
+    }
+
+    record.fmt = fmt;
+    record.timestamp = get_timestamp();
+    record.sequence = take_sequence(logger);
+    record.level = level;
+
+    const size_t record_size = offsetof(struct log_record, args) + (size_t)args_size;
+    struct log_ring_reservation entry;
+
+    if (!reserve_log_entry(logger, ring, record_size, &entry)) {
+        return drop_log_entry(logger, level);
+    }
+
+    memcpy(entry.data, &record, record_size);
+    log_ring_commit(ring, &entry, record_size);
+
+    return (int)record_size;
+}
+
+/**
+ * \brief Formats a record taken from the ring into a log line.
+ *
+ * \param line The buffer of LOG_LINE_MAX_SIZE bytes to format the line into.
+ * \param data The record data.
+ * \param record_size The record size in bytes.
+ * \param[out] level The log level of the record.
+ * \return The log line size in bytes, or 0 if the record is malformed.
+ */
+static size_t format_log_record(char *line, const void *data, const size_t record_size,
+                                enum mulog_log_level *level)
+{
+    struct log_record record;
+    const size_t termination_size = strlen(MULOG_LOG_LINE_TERMINATION);
+    const size_t args_offset = offsetof(struct log_record, args);
+
+    if (record_size < args_offset || record_size > sizeof(record) ||
+        get_record_level(data, record_size) >= MULOG_LOG_LVL_COUNT) {
+        return 0;
+    }
+
+    // ring records are not aligned, copy the record out to access its fields
+    memcpy(&record, data, record_size);
+
+    const int prefix_size =
+        format_prefix(line, LOG_PREFIX_SIZE, record.level, record.timestamp, record.sequence);
+    const int ret = prefix_size < 0 ? prefix_size
+                                    : args_format(line + prefix_size,
+                                                  MULOG_SINGLE_LOG_LINE_SIZE + 1, record.fmt,
+                                                  record.args, record_size - args_offset);
+
+    if (ret < 0) {
+        return 0;
+    }
+
+    const size_t max_single_log_size = MULOG_SINGLE_LOG_LINE_SIZE;
+    const size_t message_size =
+        (size_t)ret > max_single_log_size ? max_single_log_size : (size_t)ret;
+    const size_t line_size = (size_t)prefix_size + message_size + termination_size;
+
+    memcpy(line + prefix_size + message_size, MULOG_LOG_LINE_TERMINATION, termination_size);
+    *level = record.level;
+
+    return line_size;
+}
+
+/**
+ * \brief Formats a record taken from the ring and adds the line to the output batch.
+ *
+ * \param logger The logger.
+ * \param batch The batch to add the line to, must not be full.
+ * \param data The record data.
+ * \param record_size The record size in bytes.
+ * \return The log line size in bytes, or 0 if the record is malformed.
+ */
+static size_t add_batch_record(struct logger *logger, struct output_batch *batch, const void *data,
+                               const size_t record_size)
+{
+    char *line = logger->batch_lines[batch->count];
+    enum mulog_log_level level;
+    const size_t line_size = format_log_record(line, data, record_size, &level);
+
+    return line_size == 0 ? 0 : add_batch_line(batch, level, line, line_size);
+}
+#else
+int interface_log_output(struct logger *logger, const enum mulog_log_level level, const char *fmt,
+                         va_list args)
+{
+    if (!is_log_entry_accepted(logger, level)) {
+        return 0;
+    }
+
+    struct log_ring *ring = get_log_ring(logger, level);
+
+    // the recorded context is output ahead of the error entry
+    if (level == MULOG_LOG_LVL_ERROR) {
+        dump_flight_recorder(logger, ring);
+    }
+    char prefix[LOG_PREFIX_SIZE];
+    const int prefix_size =
+        format_prefix(prefix, ARRAY_SIZE(prefix), level, get_timestamp(), take_sequence(logger));
+
+    if (prefix_size < 0) {
+        return prefix_size;
+    }
+
     va_list args_copy;
     va_copy(args_copy, args);
     const int ret = vsnprintf_(NULL, 0, fmt, args_copy);
+    va_end(args_copy);
 
     if (ret < 0) {
         return ret;
     }
 
     const size_t max_single_log_size = MULOG_SINGLE_LOG_LINE_SIZE;
-    const size_t available_size = lwrb_get_free(&log_ctx.ring_buf);
-    size_t to_write = ret;
+    const size_t termination_size = strlen(MULOG_LOG_LINE_TERMINATION);
+    const size_t message_size =
+        (size_t)ret > max_single_log_size ? max_single_log_size : (size_t)ret;
+    const size_t line_size = (size_t)prefix_size + message_size + termination_size;
+    struct log_ring_reservation entry;
 
-    if (to_write > max_single_log_size || to_write > available_size) {
-        to_write = to_write > available_size ? available_size : max_single_log_size;
+    // the line is either stored whole or dropped, one extra byte is reserved for the null
+    // terminator written by vsnprintf_()
+    if (!reserve_log_entry(logger, ring, LOG_LINE_LEVEL_SIZE + line_size + 1, &entry)) {
+        return drop_log_entry(logger, level);
     }
 
-    char buffer[to_write + 1];
-    vsnprintf_(buffer, ARRAY_SIZE(buffer), fmt, args);
+    char *line = (char *)entry.data + LOG_LINE_LEVEL_SIZE;
 
-    written += lwrb_write(&log_ctx.ring_buf, buffer, to_write);
-    written += lwrb_write(&log_ctx.ring_buf, MULOG_LOG_LINE_TERMINATION,
-                          strlen(MULOG_LOG_LINE_TERMINATION));
+    // the level is kept in front of the line to filter outputs when the line is processed
+    entry.data[0] = (unsigned char)level;
+    memcpy(line, prefix, prefix_size);
+    vsnprintf_(line + prefix_size, message_size + 1, fmt, args);
+    memcpy(line + prefix_size + message_size, MULOG_LOG_LINE_TERMINATION, termination_size);
+    log_ring_commit(ring, &entry, LOG_LINE_LEVEL_SIZE + line_size);
 
-    return written;
+    return (int)line_size;
 }
 
-int interface_deferred_log(void)
+/**
+ * \brief Adds a line stored in the ring to the output batch without copying it.
+ *
+ * \param logger The logger.
+ * \param batch The batch to add the line to, must not be full.
+ * \param record The record data, remains valid until the record is released.
+ * \param record_size The record size in bytes.
+ * \return The log line size in bytes, or 0 if the record is malformed.
+ */
+static size_t add_batch_record(struct logger *logger, struct output_batch *batch,
+                               const unsigned char *record, const size_t record_size)
 {
-    size_t data_size = lwrb_get_full(&log_ctx.ring_buf);
-    const int ret = data_size;
+    const enum mulog_log_level level = get_record_level(record, record_size);
+
+    // lines are taken from the ring in place, no per-logger storage is needed
+    UNUSED(logger);
+
+    if (level >= MULOG_LOG_LVL_COUNT) {
+        return 0;
+    }
+
+    return add_batch_line(batch, level, (const char *)record + LOG_LINE_LEVEL_SIZE,
+                          record_size - LOG_LINE_LEVEL_SIZE);
+}
+#endif /* MULOG_ENABLE_DEFERRED_ARGS_CAPTURE */
+
+/**
+ * \brief Context of passing stored records to an output one by one
+ */
+struct record_output_ctx {
+    mulog_log_output_fn output; /**< Output to pass log lines to */
+    size_t written;             /**< Number of bytes passed to the output */
+};
 
-    while (data_size > 0) {
-        const char *read_buf = lwrb_get_linear_block_read_address(&log_ctx.ring_buf);
-        size_t read_buf_size = lwrb_get_linear_block_read_length(&log_ctx.ring_buf);
+/**
+ * \brief Passes the log line of a stored record to the output of the context.
+ *
+ * Only calls reentrant code, so it may be used from a signal handler.
+ *
+ * \param record The record data.
+ * \param record_size The record size in bytes.
+ * \param arg The record output context.
+ */
+static void output_stored_record(const void *record, const size_t record_size, void *arg)
+{
+    struct record_output_ctx *ctx = arg;
+#if defined(MULOG_ENABLE_DEFERRED_ARGS_CAPTURE) && MULOG_ENABLE_DEFERRED_ARGS_CAPTURE == 1
+    char line[LOG_LINE_MAX_SIZE];
+    enum mulog_log_level level;
+    const size_t line_size = format_log_record(line, record, record_size, &level);
 
-        if (read_buf_size > data_size) {
-            read_buf_size = data_size;
+    if (line_size == 0) {
+        return;
+    }
+#else
+    const char *line = (const char *)record + LOG_LINE_LEVEL_SIZE;
+    const size_t line_size = record_size - LOG_LINE_LEVEL_SIZE;
+
+    if (get_record_level(record, record_size) >= MULOG_LOG_LVL_COUNT) {
+        return;
+    }
+#endif /* MULOG_ENABLE_DEFERRED_ARGS_CAPTURE */
+
+    ctx->output(line, line_size);
+    ctx->written += line_size;
+}
+
+int interface_recover_log(const char *log_buffer, const size_t log_buffer_size,
+                          const mulog_log_output_fn output)
+{
+#if defined(MULOG_ENABLE_DEFERRED_ARGS_CAPTURE) && MULOG_ENABLE_DEFERRED_ARGS_CAPTURE == 1
+    UNUSED(log_buffer);
+    UNUSED(log_buffer_size);
+    UNUSED(output);
+    return MULOG_RET_CODE_UNSUPPORTED;
+#else
+    struct record_output_ctx ctx = {.output = output, .written = 0};
+
+    if (!log_ring_recover(log_buffer, log_buffer_size, output_stored_record, &ctx)) {
+        return MULOG_RET_CODE_NOT_FOUND;
+    }
+
+    return (int)ctx.written;
+#endif /* MULOG_ENABLE_DEFERRED_ARGS_CAPTURE */
+}
+
+/**
+ * \brief Passes the final record of an emergency flush to the output.
+ *
+ * The record is put together without formatting and without a timestamp, as the timestamp
+ * callback is not required to be async-signal-safe.
+ *
+ * \param output The output to pass the record to.
+ * \param message The final record message, truncated to MULOG_SINGLE_LOG_LINE_SIZE.
+ * \return The record size in bytes.
+ */
+static size_t output_final_record(const mulog_log_output_fn output, const char *message)
+{
+    static const char prefix[] = MULOG_ERROR_LVL ": ";
+    const size_t prefix_size = sizeof(prefix) - 1;
+    const size_t termination_size = strlen(MULOG_LOG_LINE_TERMINATION);
+    char line[sizeof(prefix) + MULOG_SINGLE_LOG_LINE_SIZE + sizeof(MULOG_LOG_LINE_TERMINATION)];
+    size_t message_size = 0;
+
+    while (message_size < MULOG_SINGLE_LOG_LINE_SIZE && message[message_size] != '\0') {
+        ++message_size;
+    }
+
+    memcpy(line, prefix, prefix_size);
+    memcpy(line + prefix_size, message, message_size);
+    memcpy(line + prefix_size + message_size, MULOG_LOG_LINE_TERMINATION, termination_size);
+    output(line, prefix_size + message_size + termination_size);
+
+    return prefix_size + message_size + termination_size;
+}
+
+int interface_emergency_flush(const mulog_log_output_fn output, const char *message)
+{
+    static bool flushing;
+    struct logger *logger = &loggers[0];
+    struct record_output_ctx ctx = {.output = output, .written = 0};
+
+    // a nested signal or another crashing thread must not interleave its lines with this flush
+    if (__atomic_test_and_set(&flushing, __ATOMIC_ACQUIRE)) {
+        return MULOG_RET_CODE_LOCK_FAILED;
+    }
+
+    log_ring_for_each(&logger->ctx.priority_ring, output_stored_record, &ctx);
+    log_ring_for_each(&logger->ctx.recorder_ring, output_stored_record, &ctx);
+    log_ring_for_each(&logger->ctx.ring_buf, output_stored_record, &ctx);
+
+    if (message != NULL) {
+        ctx.written += output_final_record(output, message);
+    }
+
+    __atomic_clear(&flushing, __ATOMIC_RELEASE);
+
+    return (int)ctx.written;
+}
+
+/**
+ * \brief Outputs records stored in the ring in batches.
+ *
+ * \param logger The logger.
+ * \param ring The ring to take the records from.
+ * \param budget Processing limits, or NULL for no limits.
+ * \param start Timestamp of the processing start.
+ * \param[in,out] processed Number of bytes passed to the outputs so far.
+ * \param[in,out] records Number of log entries taken from the rings so far.
+ */
+static void process_log_ring(struct logger *logger, struct log_ring *ring,
+                             const struct mulog_process_budget *budget, const unsigned long start,
+                             size_t *processed, size_t *records)
+{
+    // the time limit has to account for the time spent in the outputs, so every line is output
+    // before the next one is taken
+    const size_t batch_size =
+        budget != NULL && budget->max_time_ms != 0 ? 1 : MULOG_OUTPUT_BATCH_SIZE;
+
+    for (;;) {
+        struct output_batch batch = {.count = 0};
+        const size_t batch_start = *records;
+        size_t record_size;
+        const void *record;
+
+        // records stay in the ring until the whole batch is output
+        while (batch.count < batch_size &&
+               !is_budget_exhausted(budget, *processed, *records, start) &&
+               (record = log_ring_peek_next(ring, &record_size)) != NULL) {
+            ++*records;
+            *processed += add_batch_record(logger, &batch, record, record_size);
+        }
+
+        if (*records == batch_start) {
+            break;
         }
 
-        output_log_entry(read_buf, read_buf_size);
-        lwrb_skip(&log_ctx.ring_buf, read_buf_size);
-        data_size -= read_buf_size;
+        output_batch(logger, &batch);
+        log_ring_release(ring);
     }
+}
 
-    return ret;
+int interface_deferred_log(struct logger *logger, const struct mulog_process_budget *budget)
+{
+    if (!is_budget_supported(budget)) {
+        return MULOG_RET_CODE_UNSUPPORTED;
+    }
+
+    const unsigned long start =
+        budget != NULL && budget->max_time_ms != 0 ? get_timestamp() : 0;
+    size_t processed = output_dropped_marker(logger);
+    size_t records = 0;
+
+    // warning and error entries are output first, their sequence numbers keep the logging order
+    if (log_ring_is_ready(&logger->ctx.priority_ring)) {
+        process_log_ring(logger, &logger->ctx.priority_ring, budget, start, &processed, &records);
+    }
+
+    process_log_ring(logger, &logger->ctx.ring_buf, budget, start, &processed, &records);
+
+    return (int)processed;
 }
@@ -0,0 +1,530 @@
+/**
+ * \file
+ * \brief Deferred logging record ring implementation
+ * \author Vladimir Petrigo
+ */
+
+#include "internal/deferred/ring.h"
+#include "internal/utils.h"
+
+#include <string.h>
+
+/**
+ * \brief Persistent ring header magic value
+ */
+#define LOG_RING_HEADER_MAGIC 0x474f4c4dUL
+
+#if defined(MULOG_ENABLE_LOCKFREE_DEFERRED) && MULOG_ENABLE_LOCKFREE_DEFERRED == 1
+#define LOG_RING_HEADER_LAYOUT 2UL
+#else
+#define LOG_RING_HEADER_LAYOUT 1UL
+#endif /* MULOG_ENABLE_LOCKFREE_DEFERRED */
+
+/**
+ * \brief Ring position kept in the persistent ring header
+ *
+ * Every position is stored in two slots updated in turn. A slot torn by a crash in the middle of
+ * an update fails the checksum check, so the position from the other slot is used.
+ */
+struct log_ring_index {
+    uint32_t pos;      /**< Position in the ring storage */
+    uint32_t sequence; /**< Update counter, the slot with the newer one holds the latest position */
+    uint32_t checksum; /**< Checksum of the header layout, position and update counter */
+};
+
+/**
+ * \brief Persistent ring header placed in front of the ring storage
+ */
+struct log_ring_header {
+    uint32_t magic;                 /**< LOG_RING_HEADER_MAGIC for a valid header */
+    uint32_t layout;                /**< Record layout of the ring */
+    uint32_t offset;                /**< Ring storage offset from the header start */
+    uint32_t size;                  /**< Ring storage size in bytes */
+    struct log_ring_index read[2];  /**< Consumer position */
+    struct log_ring_index write[2]; /**< Producer position, not used in the lock-free mode */
+};
+
+static uint32_t get_index_checksum(const struct log_ring_header *header, const uint32_t pos,
+                                   const uint32_t sequence)
+{
+    const uint32_t words[] = {
+        LOG_RING_HEADER_MAGIC, header->layout, header->offset, header->size, pos, sequence,
+    };
+    uint32_t checksum = 2166136261UL;
+
+    for (size_t i = 0; i < ARRAY_SIZE(words); ++i) {
+        checksum = (checksum ^ words[i]) * 16777619UL;
+    }
+
+    return checksum;
+}
+
+static bool is_newer_sequence(const uint32_t sequence, const uint32_t other)
+{
+    return (int32_t)(sequence - other) > 0;
+}
+
+static void save_ring_index(const struct log_ring_header *header, struct log_ring_index *slots,
+                            const size_t pos)
+{
+    const uint32_t sequence = (is_newer_sequence(slots[1].sequence, slots[0].sequence)
+                                   ? slots[1].sequence
+                                   : slots[0].sequence) +
+                              1U;
+    struct log_ring_index *slot = &slots[sequence & 1U];
+
+    // the checksum is stored last, so the slot is valid only once the position is complete
+    __atomic_store_n(&slot->checksum, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->pos, (uint32_t)pos, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->sequence, sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->checksum, get_index_checksum(header, (uint32_t)pos, sequence),
+                     __ATOMIC_RELEASE);
+}
+
+static bool load_ring_index(const struct log_ring_header *header,
+                            const struct log_ring_index *slots, size_t *pos)
+{
+    const struct log_ring_index *latest = NULL;
+
+    for (size_t i = 0; i < 2; ++i) {
+        if (slots[i].checksum == get_index_checksum(header, slots[i].pos, slots[i].sequence) &&
+            (latest == NULL || is_newer_sequence(slots[i].sequence, latest->sequence))) {
+            latest = &slots[i];
+        }
+    }
+
+    if (latest == NULL) {
+        return false;
+    }
+
+    *pos = latest->pos;
+
+    return true;
+}
+
+static const struct log_ring_header *get_valid_header(const void *buf, const size_t size)
+{
+    const struct log_ring_header *header = buf;
+
+    if (buf == NULL || (uintptr_t)buf % _Alignof(struct log_ring_header) != 0 ||
+        size < sizeof(*header) || header->magic != LOG_RING_HEADER_MAGIC ||
+        header->layout != LOG_RING_HEADER_LAYOUT || header->offset < sizeof(*header) ||
+        header->offset > size || header->size == 0 || header->size > size - header->offset) {
+        return NULL;
+    }
+
+    return header;
+}
+
+static void attach_ring_header(struct log_ring *ring, void *buf, const void *storage,
+                               const size_t storage_size)
+{
+    struct log_ring_header *header = buf;
+
+    memset(header, 0, sizeof(*header));
+    header->layout = LOG_RING_HEADER_LAYOUT;
+    header->offset = (uint32_t)((const unsigned char *)storage - (const unsigned char *)buf);
+    header->size = (uint32_t)storage_size;
+    save_ring_index(header, header->read, 0);
+    save_ring_index(header, header->write, 0);
+    __atomic_store_n(&header->magic, LOG_RING_HEADER_MAGIC, __ATOMIC_RELEASE);
+    ring->header = header;
+}
+
+static void detach_ring_header(struct log_ring *ring)
+{
+    // records dropped with the ring must not be recovered from its storage
+    if (ring->header != NULL) {
+        __atomic_store_n(&ring->header->magic, 0, __ATOMIC_RELEASE);
+        ring->header = NULL;
+    }
+}
+
+#if defined(MULOG_ENABLE_LOCKFREE_DEFERRED) && MULOG_ENABLE_LOCKFREE_DEFERRED == 1
+bool log_ring_init(struct log_ring *ring, void *buf, const size_t size)
+{
+    ring->header = NULL;
+    ring->read_pos = 0;
+
+    return mpsc_ring_init(&ring->ring, buf, size);
+}
+
+bool log_ring_init_persistent(struct log_ring *ring, void *buf, const size_t size)
+{
+    struct log_ring_header *header = buf;
+
+    if (buf == NULL || (uintptr_t)buf % _Alignof(struct log_ring_header) != 0 ||
+        size <= sizeof(*header) || size - sizeof(*header) > UINT32_MAX ||
+        !log_ring_init(ring, header + 1, size - sizeof(*header))) {
+        return false;
+    }
+
+    attach_ring_header(ring, buf, ring->ring.buf, ring->ring.size);
+
+    return true;
+}
+
+bool log_ring_recover(const void *buf, const size_t size, const log_ring_record_fn fn, void *arg)
+{
+    const struct log_ring_header *header = get_valid_header(buf, size);
+    size_t pos;
+
+    if (header == NULL || header->size % MPSC_RING_ALIGN != 0 ||
+        !load_ring_index(header, header->read, &pos) || pos >= 2 * (size_t)header->size) {
+        return false;
+    }
+
+    const unsigned char *storage = (const unsigned char *)buf + header->offset;
+    size_t offset = pos < header->size ? pos : pos - header->size;
+
+    // producer positions are not stored, records are taken until the free space that reads as 0,
+    // records of log calls interrupted by the crash are marked busy and skipped
+    for (size_t scanned = 0; scanned < header->size;) {
+        uint32_t value;
+
+        memcpy(&value, storage + offset, sizeof(value));
+
+        if (value == 0) {
+            break;
+        }
+
+        const size_t len = value & MPSC_RING_LEN_MASK;
+        const size_t total = mpsc_ring_align(MPSC_RING_HDR_SIZE + len);
+
+        if (total > header->size - offset || total > header->size - scanned) {
+            break;
+        }
+
+        if ((value & (MPSC_RING_FLAG_READY | MPSC_RING_FLAG_DISCARD)) == MPSC_RING_FLAG_READY) {
+            fn(storage + offset + MPSC_RING_HDR_SIZE, len, arg);
+        }
+
+        offset = offset + total == header->size ? 0 : offset + total;
+        scanned += total;
+    }
+
+    return true;
+}
+
+void log_ring_free(struct log_ring *ring)
+{
+    detach_ring_header(ring);
+    mpsc_ring_reset(&ring->ring);
+    mpsc_ring_free(&ring->ring);
+    ring->read_pos = 0;
+}
+
+bool log_ring_is_ready(const struct log_ring *ring)
+{
+    return mpsc_ring_is_ready(&ring->ring);
+}
+
+bool log_ring_can_fit(const struct log_ring *ring, const size_t size)
+{
+    return size <= LOG_RING_RECORD_MAX_SIZE &&
+           mpsc_ring_align(MPSC_RING_HDR_SIZE + size) <= ring->ring.size;
+}
+
+size_t log_ring_get_used(const struct log_ring *ring)
+{
+    return mpsc_ring_get_full(&ring->ring);
+}
+
+bool log_ring_reserve(struct log_ring *ring, const size_t size,
+                      struct log_ring_reservation *reservation)
+{
+    if (size > LOG_RING_RECORD_MAX_SIZE ||
+        !mpsc_ring_reserve(&ring->ring, size, &reservation->entry)) {
+        return false;
+    }
+
+    reservation->data = reservation->entry.data;
+    reservation->size = size;
+
+    return true;
+}
+
+void log_ring_commit(struct log_ring *ring, const struct log_ring_reservation *reservation,
+                     const size_t size)
+{
+    UNUSED(ring);
+    mpsc_ring_commit(&reservation->entry, size);
+}
+
+const void *log_ring_peek(struct log_ring *ring, size_t *size)
+{
+    ring->read_pos = __atomic_load_n(&ring->ring.tail, __ATOMIC_RELAXED);
+
+    return log_ring_peek_next(ring, size);
+}
+
+const void *log_ring_peek_next(struct log_ring *ring, size_t *size)
+{
+    return mpsc_ring_peek_at(&ring->ring, &ring->read_pos, size);
+}
+
+void log_ring_for_each(struct log_ring *ring, const log_ring_record_fn fn, void *arg)
+{
+    size_t pos = mpsc_ring_get_read_pos(&ring->ring);
+    size_t record_size;
+    const void *record;
+
+    // records of interrupted log calls are skipped instead of hiding the records after them
+    while ((record = mpsc_ring_scan_at(&ring->ring, &pos, &record_size)) != NULL) {
+        fn(record, record_size, arg);
+    }
+}
+
+void log_ring_release(struct log_ring *ring)
+{
+    // released records are zeroed, so the position is saved first to keep the rest recoverable
+    if (ring->header != NULL) {
+        save_ring_index(ring->header, ring->header->read, ring->read_pos);
+    }
+
+    mpsc_ring_release_to(&ring->ring, ring->read_pos);
+}
+#else
+_Static_assert(LOG_RING_RECORD_MAX_SIZE <= UINT16_MAX, "Record size must fit the length prefix");
+
+typedef uint16_t log_ring_len_t;
+
+static size_t get_write_pos(const struct log_ring *ring)
+{
+    return (size_t)((unsigned char *)lwrb_get_linear_block_write_address((lwrb_t *)&ring->ring) -
+                    ring->ring.buff);
+}
+
+static size_t get_read_pos(const struct log_ring *ring)
+{
+    return (size_t)((unsigned char *)lwrb_get_linear_block_read_address((lwrb_t *)&ring->ring) -
+                    ring->ring.buff);
+}
+
+static void copy_from_storage(void *dst, const unsigned char *storage, const size_t storage_size,
+                              const size_t pos, const size_t size)
+{
+    const size_t linear = storage_size - pos < size ? storage_size - pos : size;
+
+    memcpy(dst, storage + pos, linear);
+    memcpy((unsigned char *)dst + linear, storage, size - linear);
+}
+
+/**
+ * \brief Passes length-prefixed records stored between the given positions to the function.
+ *
+ * \param storage Ring storage
+ * \param storage_size Ring storage size in bytes
+ * \param read Position of the oldest record
+ * \param write Position past the newest record
+ * \param fn Function to pass records to
+ * \param arg Argument to pass to the function
+ */
+static void walk_records(const unsigned char *storage, const size_t storage_size, size_t read,
+                         const size_t write, const log_ring_record_fn fn, void *arg)
+{
+    size_t available = write >= read ? write - read : storage_size - read + write;
+    unsigned char record[LOG_RING_RECORD_MAX_SIZE];
+
+    while (available > sizeof(log_ring_len_t)) {
+        log_ring_len_t record_size;
+
+        copy_from_storage(&record_size, storage, storage_size, read, sizeof(record_size));
+
+        if (record_size == 0 || record_size > sizeof(record) ||
+            available - sizeof(record_size) < record_size) {
+            break;
+        }
+
+        copy_from_storage(record, storage, storage_size,
+                          (read + sizeof(record_size)) % storage_size, record_size);
+        fn(record, record_size, arg);
+        read = (read + sizeof(record_size) + record_size) % storage_size;
+        available -= sizeof(record_size) + record_size;
+    }
+}
+
+bool log_ring_init(struct log_ring *ring, void *buf, const size_t size)
+{
+    ring->header = NULL;
+    ring->read_offset = 0;
+
+    return lwrb_init(&ring->ring, buf, size) != 0;
+}
+
+bool log_ring_init_persistent(struct log_ring *ring, void *buf, const size_t size)
+{
+    struct log_ring_header *header = buf;
+
+    if (buf == NULL || (uintptr_t)buf % _Alignof(struct log_ring_header) != 0 ||
+        size <= sizeof(*header) || size - sizeof(*header) > UINT32_MAX ||
+        !log_ring_init(ring, header + 1, size - sizeof(*header))) {
+        return false;
+    }
+
+    attach_ring_header(ring, buf, ring->ring.buff, ring->ring.size);
+
+    return true;
+}
+
+bool log_ring_recover(const void *buf, const size_t size, const log_ring_record_fn fn, void *arg)
+{
+    const struct log_ring_header *header = get_valid_header(buf, size);
+    size_t read;
+    size_t write;
+
+    if (header == NULL || !load_ring_index(header, header->read, &read) ||
+        !load_ring_index(header, header->write, &write) || read >= header->size ||
+        write >= header->size) {
+        return false;
+    }
+
+    walk_records((const unsigned char *)buf + header->offset, header->size, read, write, fn, arg);
+
+    return true;
+}
+
+void log_ring_free(struct log_ring *ring)
+{
+    detach_ring_header(ring);
+    lwrb_reset(&ring->ring);
+    lwrb_free(&ring->ring);
+    ring->read_offset = 0;
+}
+
+bool log_ring_is_ready(const struct log_ring *ring)
+{
+    return lwrb_is_ready((lwrb_t *)&ring->ring) != 0;
+}
+
+bool log_ring_can_fit(const struct log_ring *ring, const size_t size)
+{
+    // lwrb keeps one byte of its storage unused to tell a full ring from an empty one
+    return size <= LOG_RING_RECORD_MAX_SIZE && ring->ring.size > 0 &&
+           sizeof(log_ring_len_t) + size <= ring->ring.size - 1;
+}
+
+size_t log_ring_get_used(const struct log_ring *ring)
+{
+    return lwrb_get_full((lwrb_t *)&ring->ring);
+}
+
+bool log_ring_reserve(struct log_ring *ring, const size_t size,
+                      struct log_ring_reservation *reservation)
+{
+    const size_t record_size = sizeof(log_ring_len_t) + size;
+
+    if (size > LOG_RING_RECORD_MAX_SIZE || lwrb_get_free(&ring->ring) < record_size) {
+        return false;
+    }
+
+    // the record is filled in place unless it wraps around the ring end
+    if (lwrb_get_linear_block_write_length(&ring->ring) >= record_size) {
+        unsigned char *write_ptr = lwrb_get_linear_block_write_address(&ring->ring);
+
+        reservation->data = write_ptr + sizeof(log_ring_len_t);
+    } else {
+        reservation->data = ring->write_buffer;
+    }
+
+    reservation->size = size;
+
+    return true;
+}
+
+void log_ring_commit(struct log_ring *ring, const struct log_ring_reservation *reservation,
+                     const size_t size)
+{
+    const log_ring_len_t record_size = (log_ring_len_t)size;
+
+    // the consumer does not take a record until its length prefix and data are both in the ring
+    if (reservation->data == ring->write_buffer) {
+        lwrb_write(&ring->ring, &record_size, sizeof(record_size));
+        lwrb_write(&ring->ring, ring->write_buffer, size);
+    } else {
+        memcpy(reservation->data - sizeof(record_size), &record_size, sizeof(record_size));
+        lwrb_advance(&ring->ring, sizeof(record_size) + size);
+    }
+
+    if (ring->header != NULL) {
+        save_ring_index(ring->header, ring->header->write, get_write_pos(ring));
+    }
+}
+
+const void *log_ring_peek(struct log_ring *ring, size_t *size)
+{
+    ring->read_offset = 0;
+
+    return log_ring_peek_next(ring, size);
+}
+
+const void *log_ring_peek_next(struct log_ring *ring, size_t *size)
+{
+    log_ring_len_t record_size;
+    const size_t available = lwrb_get_full(&ring->ring) - ring->read_offset;
+    const size_t data_offset = ring->read_offset + sizeof(record_size);
+
+    // records are never empty, anything else means there is no complete record stored
+    if (available < sizeof(record_size) ||
+        lwrb_peek(&ring->ring, ring->read_offset, &record_size, sizeof(record_size)) !=
+            sizeof(record_size) ||
+        record_size == 0 || record_size > sizeof(ring->read_buffer) ||
+        available - sizeof(record_size) < record_size) {
+        return NULL;
+    }
+
+    const size_t linear = lwrb_get_linear_block_read_length(&ring->ring);
+    const unsigned char *data = lwrb_get_linear_block_read_address(&ring->ring);
+
+    ring->read_offset = data_offset + record_size;
+    *size = record_size;
+
+    // hand out the record in place unless it wraps around the ring end
+    if (data_offset + record_size <= linear) {
+        return data + data_offset;
+    }
+
+    if (data_offset >= linear) {
+        return ring->ring.buff + (data_offset - linear);
+    }
+
+    lwrb_peek(&ring->ring, data_offset, ring->read_buffer, record_size);
+
+    return ring->read_buffer;
+}
+
+void log_ring_for_each(struct log_ring *ring, const log_ring_record_fn fn, void *arg)
+{
+    if (!log_ring_is_ready(ring)) {
+        return;
+    }
+
+    // records are copied out, so the peeked records and their copies are left intact
+    walk_records(ring->ring.buff, ring->ring.size, get_read_pos(ring), get_write_pos(ring), fn,
+                 arg);
+}
+
+void log_ring_release(struct log_ring *ring)
+{
+    lwrb_skip(&ring->ring, ring->read_offset);
+    ring->read_offset = 0;
+
+    if (ring->header != NULL) {
+        save_ring_index(ring->header, ring->header->read, get_read_pos(ring));
+    }
+}
+#endif /* MULOG_ENABLE_LOCKFREE_DEFERRED */
+
+bool log_ring_write(struct log_ring *ring, const void *record, const size_t size)
+{
+    struct log_ring_reservation reservation;
+
+    if (!log_ring_reserve(ring, size, &reservation)) {
+        return false;
+    }
+
+    memcpy(reservation.data, record, size);
+    log_ring_commit(ring, &reservation, size);
+
+    return true;
+}
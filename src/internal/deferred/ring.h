@@ -0,0 +1,243 @@
+/**
+ * \file
+ * \brief Deferred logging record ring interface
+ * \author Vladimir Petrigo
+ */
+
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "internal/config.h"
+
+#if defined(MULOG_ENABLE_LOCKFREE_DEFERRED) && MULOG_ENABLE_LOCKFREE_DEFERRED == 1
+#include "mpsc_ring.h"
+#else
+#include <lwrb/lwrb.h>
+#endif /* MULOG_ENABLE_LOCKFREE_DEFERRED */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * \brief Maximum size of a log entry prefix (timestamp and log level)
+ */
+#define LOG_PREFIX_SIZE 64
+
+/**
+ * \brief Maximum size of a single record stored in the ring (log level, prefix, message and line
+ * termination)
+ */
+#define LOG_RING_RECORD_MAX_SIZE                                                                   \
+    (1 + LOG_PREFIX_SIZE + MULOG_SINGLE_LOG_LINE_SIZE + sizeof(MULOG_LOG_LINE_TERMINATION))
+
+struct log_ring_header;
+
+/**
+ * \brief Function that takes a record passed by log_ring_recover() or log_ring_for_each()
+ *
+ * \param record Record data, only valid during the call
+ * \param size Record size in bytes
+ * \param arg Argument passed along with the function
+ */
+typedef void (*log_ring_record_fn)(const void *record, size_t size, void *arg);
+
+/**
+ * \brief Ring of variable size log records
+ *
+ * Every record is reserved, filled in place and committed as a whole, so the consumer never sees
+ * a partially stored record or several records glued together. In the lock-free mode records are
+ * stored in the multi-producer ring. Otherwise, each record is stored in the lwrb ring with a
+ * length prefix. Records are filled and read in place, only a record that wraps around the ring
+ * end goes through an intermediate buffer.
+ *
+ * The consumer may peek several records in a row and release them at once, so a batch of records
+ * is handed to outputs without copying.
+ *
+ * A persistent ring keeps a header with its read and write positions in front of the storage, so
+ * records that have not been released can be recovered from the storage after a crash.
+ */
+struct log_ring {
+    struct log_ring_header *header; /**< Persistent ring header, NULL for a regular ring */
+#if defined(MULOG_ENABLE_LOCKFREE_DEFERRED) && MULOG_ENABLE_LOCKFREE_DEFERRED == 1
+    struct mpsc_ring ring; /**< Record storage */
+    size_t read_pos;       /**< Position past the last peeked record */
+#else
+    lwrb_t ring;                                           /**< Record storage */
+    size_t read_offset;                                    /**< Size of all peeked records */
+    unsigned char read_buffer[LOG_RING_RECORD_MAX_SIZE];  /**< Copy of a wrapped peeked record */
+    unsigned char write_buffer[LOG_RING_RECORD_MAX_SIZE]; /**< Storage for a wrapped reservation */
+#endif /* MULOG_ENABLE_LOCKFREE_DEFERRED */
+};
+
+/**
+ * \brief Record reservation made with log_ring_reserve()
+ */
+struct log_ring_reservation {
+    unsigned char *data; /**< Reserved record storage */
+    size_t size;         /**< Reserved record size */
+#if defined(MULOG_ENABLE_LOCKFREE_DEFERRED) && MULOG_ENABLE_LOCKFREE_DEFERRED == 1
+    struct mpsc_ring_reservation entry; /**< Underlying ring reservation */
+#endif /* MULOG_ENABLE_LOCKFREE_DEFERRED */
+};
+
+/**
+ * \brief Initializes a ring over the given storage.
+ *
+ * \param ring Ring to initialize
+ * \param buf Ring storage
+ * \param size Ring storage size in bytes
+ * \return true if the ring has been initialized, false otherwise
+ */
+bool log_ring_init(struct log_ring *ring, void *buf, size_t size);
+
+/**
+ * \brief Initializes a persistent ring over the given storage.
+ *
+ * The ring header is placed at the beginning of the storage, the rest of it keeps records.
+ * Previous storage content is dropped.
+ *
+ * \param ring Ring to initialize
+ * \param buf Ring storage aligned to 4 bytes
+ * \param size Ring storage size in bytes
+ * \return true if the ring has been initialized, false otherwise
+ */
+bool log_ring_init_persistent(struct log_ring *ring, void *buf, size_t size);
+
+/**
+ * \brief Passes records that have not been released to the given function.
+ *
+ * Works on the storage of a persistent ring that is not attached to any ring, for example, after
+ * the program that used the storage has crashed. The storage content is not changed.
+ *
+ * \param buf Persistent ring storage
+ * \param size Persistent ring storage size in bytes
+ * \param fn Function to pass records to in the storing order
+ * \param arg Argument to pass to the function
+ * \return true if the storage keeps a valid persistent ring, false otherwise
+ */
+bool log_ring_recover(const void *buf, size_t size, log_ring_record_fn fn, void *arg);
+
+/**
+ * \brief Drops all stored records and detaches the ring from its storage.
+ *
+ * \param ring Ring to free
+ */
+void log_ring_free(struct log_ring *ring);
+
+/**
+ * \brief Checks whether the ring has storage attached.
+ *
+ * \param ring Ring to check
+ * \return true if the ring is ready to store records, false otherwise
+ */
+bool log_ring_is_ready(const struct log_ring *ring);
+
+/**
+ * \brief Checks whether a record fits into the empty ring.
+ *
+ * \param ring Ring to check
+ * \param size Record size in bytes
+ * \return true if the record can be stored once enough records are released, false otherwise
+ */
+bool log_ring_can_fit(const struct log_ring *ring, size_t size);
+
+/**
+ * \brief Gets the amount of the ring storage taken by stored records.
+ *
+ * \param ring Ring to check
+ * \return Number of bytes in use, including per-record overhead
+ */
+size_t log_ring_get_used(const struct log_ring *ring);
+
+/**
+ * \brief Reserves contiguous storage for a record.
+ *
+ * The reservation must be completed with log_ring_commit(). Only a single reservation may be
+ * pending at a time unless the lock-free mode is enabled.
+ *
+ * \param ring Ring to reserve the record in
+ * \param size Record size in bytes, at most LOG_RING_RECORD_MAX_SIZE
+ * \param[out] reservation Reserved record storage
+ * \return true if the storage has been reserved, false if the record does not fit into the free
+ *         space
+ */
+bool log_ring_reserve(struct log_ring *ring, size_t size, struct log_ring_reservation *reservation);
+
+/**
+ * \brief Publishes a reserved record to the consumer.
+ *
+ * \param ring Ring the record has been reserved in
+ * \param reservation Reservation made with log_ring_reserve()
+ * \param size Actual record size in bytes, not greater than the reserved size
+ */
+void log_ring_commit(struct log_ring *ring, const struct log_ring_reservation *reservation,
+                     size_t size);
+
+/**
+ * \brief Stores a record in the ring as a whole.
+ *
+ * \param ring Ring to store the record to
+ * \param record Record data
+ * \param size Record size in bytes, at most LOG_RING_RECORD_MAX_SIZE
+ * \return true if the record has been stored, false if it does not fit into the free space
+ */
+bool log_ring_write(struct log_ring *ring, const void *record, size_t size);
+
+/**
+ * \brief Gets the oldest record stored in the ring without removing it.
+ *
+ * Restarts log_ring_peek_next() from the record that follows the oldest one.
+ *
+ * \param ring Ring to get the record from
+ * \param[out] size Record size in bytes
+ * \return Pointer to the record data, or NULL if there are no records. The data remains valid until
+ *         log_ring_release() is called.
+ */
+const void *log_ring_peek(struct log_ring *ring, size_t *size);
+
+/**
+ * \brief Gets the record that follows the last peeked one without removing any record.
+ *
+ * Starts from the oldest record if no record has been peeked since the last release. Only a single
+ * record of the peeked ones may wrap around the ring end, so the data of all peeked records
+ * remains valid at the same time.
+ *
+ * \param ring Ring to get the record from
+ * \param[out] size Record size in bytes
+ * \return Pointer to the record data, or NULL if there are no more records. The data remains valid
+ *         until log_ring_release() is called.
+ */
+const void *log_ring_peek_next(struct log_ring *ring, size_t *size);
+
+/**
+ * \brief Passes all stored records to the given function without removing them.
+ *
+ * Neither the ring nor its storage is modified, so the function may be called from a signal
+ * handler that has interrupted a producer or the consumer of the ring. Records that are still
+ * being stored are skipped, and records that are being released are not passed again. In the
+ * lock-free mode the records stored after a producer interrupted between its reservation and
+ * marking the record as busy are not passed.
+ *
+ * \param ring Ring to take the records from
+ * \param fn Function to pass records to in the storing order
+ * \param arg Argument to pass to the function
+ */
+void log_ring_for_each(struct log_ring *ring, log_ring_record_fn fn, void *arg);
+
+/**
+ * \brief Removes all records obtained with log_ring_peek() and log_ring_peek_next() from the ring.
+ *
+ * \param ring Ring to remove the records from
+ */
+void log_ring_release(struct log_ring *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOG_RING_H */
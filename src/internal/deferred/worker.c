@@ -0,0 +1,104 @@
+/**
+ * \file
+ * \brief Deferred logging drain worker implementation
+ * \author Vladimir Petrigo
+ */
+
+#include "internal/deferred/worker.h"
+#include "internal/config.h"
+#include "internal/interface.h"
+
+#include <stdbool.h>
+
+struct drain_worker {
+    size_t watermark;             /**< Log buffer usage that wakes the worker up */
+    unsigned long max_latency_ms; /**< Maximum worker sleep time */
+    bool running;                 /**< Cleared to make the worker thread exit */
+    bool started;                 /**< Whether the worker thread has been started */
+    bool sleeping;                /**< Set while the worker may wait for a wake up */
+};
+
+static struct drain_worker worker;
+
+/**
+ * \brief Checks whether the worker has to sleep before the next drain.
+ *
+ * \return true if the log buffer is empty or its usage is below the watermark, false otherwise
+ */
+static bool is_worker_idle(void)
+{
+    // the worker only drains the default logger
+    const size_t used = interface_get_deferred_usage(interface_get_logger(0));
+
+    return used == 0 || used < __atomic_load_n(&worker.watermark, __ATOMIC_RELAXED);
+}
+
+/**
+ * \brief Drain worker thread routine.
+ */
+static void worker_run(void)
+{
+    while (__atomic_load_n(&worker.running, __ATOMIC_ACQUIRE)) {
+        // the flag is raised before the usage check, so an entry stored after the check always
+        // sees it and wakes the worker up
+        __atomic_store_n(&worker.sleeping, true, __ATOMIC_SEQ_CST);
+
+        if (is_worker_idle()) {
+            mulog_config_mulog_worker_wait(
+                __atomic_load_n(&worker.max_latency_ms, __ATOMIC_RELAXED));
+        }
+
+        __atomic_store_n(&worker.sleeping, false, __ATOMIC_SEQ_CST);
+        mulog_deferred_process();
+    }
+
+    // entries stored before the worker has been stopped are not lost
+    mulog_deferred_process();
+}
+
+enum mulog_ret_code worker_start(const size_t watermark, const unsigned long max_latency_ms)
+{
+    __atomic_store_n(&worker.watermark, watermark, __ATOMIC_RELAXED);
+    __atomic_store_n(&worker.max_latency_ms, max_latency_ms, __ATOMIC_RELAXED);
+
+    if (worker.started) {
+        // the running worker picks the new configuration up on its next wake up
+        mulog_config_mulog_worker_wake();
+
+        return MULOG_RET_CODE_OK;
+    }
+
+    __atomic_store_n(&worker.running, true, __ATOMIC_RELEASE);
+
+    if (!mulog_config_mulog_worker_start(worker_run)) {
+        __atomic_store_n(&worker.running, false, __ATOMIC_RELEASE);
+
+        return MULOG_RET_CODE_NO_MEM;
+    }
+
+    worker.started = true;
+
+    return MULOG_RET_CODE_OK;
+}
+
+void worker_stop(void)
+{
+    if (!worker.started) {
+        return;
+    }
+
+    __atomic_store_n(&worker.running, false, __ATOMIC_RELEASE);
+    mulog_config_mulog_worker_wake();
+    mulog_config_mulog_worker_join();
+    worker.started = false;
+    __atomic_store_n(&worker.sleeping, false, __ATOMIC_RELAXED);
+}
+
+void worker_notify(void)
+{
+    // only the producer that clears the flag wakes the worker up
+    if (__atomic_load_n(&worker.sleeping, __ATOMIC_SEQ_CST) && !is_worker_idle() &&
+        __atomic_exchange_n(&worker.sleeping, false, __ATOMIC_SEQ_CST)) {
+        mulog_config_mulog_worker_wake();
+    }
+}
@@ -0,0 +1,46 @@
+/**
+ * \file
+ * \brief Deferred logging drain worker interface
+ * \author Vladimir Petrigo
+ */
+
+#ifndef WORKER_H
+#define WORKER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "mulog.h"
+
+#include <stddef.h>
+
+/**
+ * \brief Starts the drain worker or updates the configuration of the running one.
+ *
+ * \param watermark Log buffer usage in bytes that wakes the worker up.
+ * \param max_latency_ms Maximum time the worker sleeps before it drains the log buffer.
+ * \return MULOG_RET_CODE_OK on success or MULOG_RET_CODE_NO_MEM if the worker thread has not been
+ *         started.
+ */
+enum mulog_ret_code worker_start(size_t watermark, unsigned long max_latency_ms);
+
+/**
+ * \brief Stops the drain worker after it drains the log buffer.
+ *
+ * Does nothing if the worker is not running.
+ */
+void worker_stop(void);
+
+/**
+ * \brief Wakes the drain worker up if the log buffer usage has reached the watermark.
+ *
+ * Called by producers after an entry has been stored. Cheap unless the worker has to be woken up.
+ */
+void worker_notify(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORKER_H */
@@ -0,0 +1,103 @@
+/**
+ * \file
+ * \brief POSIX threads backend of the deferred logging drain worker
+ * \author Vladimir Petrigo
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "internal/config.h"
+#include "internal/utils.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+#define MS_IN_SEC 1000UL
+#define NS_IN_MS  1000000L
+#define NS_IN_SEC 1000000000L
+
+struct worker_thread {
+    pthread_t thread;      /**< Worker thread handle */
+    pthread_mutex_t mutex; /**< Protects the pending wake up flag */
+    pthread_cond_t cond;   /**< Signalled on wake up, uses the monotonic clock */
+    pthread_once_t once;   /**< Condition variable initialization guard */
+    void (*routine)(void); /**< Worker routine */
+    bool pending;          /**< Wake up requested and not consumed yet */
+};
+
+static struct worker_thread worker_thread = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .once = PTHREAD_ONCE_INIT,
+};
+
+/**
+ * \brief Initializes the condition variable, so timeouts are not affected by system time changes.
+ */
+static void init_worker_cond(void)
+{
+    pthread_condattr_t attr;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&worker_thread.cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static void *run_worker(void *arg)
+{
+    UNUSED(arg);
+    worker_thread.routine();
+
+    return NULL;
+}
+
+// PUBLIC FUNCTION DEFINITIONS
+
+bool mulog_config_mulog_worker_start(void (*worker)(void))
+{
+    pthread_once(&worker_thread.once, init_worker_cond);
+    worker_thread.routine = worker;
+    worker_thread.pending = false;
+
+    return pthread_create(&worker_thread.thread, NULL, run_worker, NULL) == 0;
+}
+
+void mulog_config_mulog_worker_join(void)
+{
+    pthread_join(worker_thread.thread, NULL);
+}
+
+void mulog_config_mulog_worker_wait(const unsigned long timeout_ms)
+{
+    struct timespec deadline;
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += (time_t)(timeout_ms / MS_IN_SEC);
+    deadline.tv_nsec += (long)(timeout_ms % MS_IN_SEC) * NS_IN_MS;
+
+    if (deadline.tv_nsec >= NS_IN_SEC) {
+        ++deadline.tv_sec;
+        deadline.tv_nsec -= NS_IN_SEC;
+    }
+
+    pthread_mutex_lock(&worker_thread.mutex);
+
+    while (!worker_thread.pending) {
+        if (pthread_cond_timedwait(&worker_thread.cond, &worker_thread.mutex, &deadline) != 0) {
+            break;
+        }
+    }
+
+    worker_thread.pending = false;
+    pthread_mutex_unlock(&worker_thread.mutex);
+}
+
+void mulog_config_mulog_worker_wake(void)
+{
+    pthread_mutex_lock(&worker_thread.mutex);
+    worker_thread.pending = true;
+    pthread_cond_signal(&worker_thread.cond);
+    pthread_mutex_unlock(&worker_thread.mutex);
+}
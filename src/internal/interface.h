@@ -14,76 +14,315 @@ extern "C" {
 #include "mulog.h"
 
 #include <stdarg.h>
+#include <stdbool.h>
 #include <stddef.h>
 
+/**
+ * \brief Logger state defined by the logging mode implementation
+ */
+struct logger;
+
+/**
+ * \brief Gets a logger by its index.
+ *
+ * \param index Logger index, 0 for the default logger and 1 to MULOG_INSTANCES for the loggers of
+ *              the instances.
+ * \return Pointer to the logger, or NULL if the index is out of range.
+ */
+struct logger *interface_get_logger(size_t index);
+
 /**
  * \brief Adds a default output function to the logging interface with the global log level.
  *
+ * \param logger The logger.
  * \param output The output function to be added.
  * \return Status code indicating the result of the operation.
  */
-enum mulog_ret_code interface_add_output_default(mulog_log_output_fn output);
+enum mulog_ret_code interface_add_output_default(struct logger *logger, mulog_log_output_fn output);
 
 /**
  * \brief Adds a specific output function to the logging interface with the specified log level.
  *
+ * \param logger The logger.
  * \param output The output function to be added.
  * \param log_level The log level associated with the output function.
  * \return Status code indicating the result of the operation.
  */
-enum mulog_ret_code interface_add_output(mulog_log_output_fn output,
+enum mulog_ret_code interface_add_output(struct logger *logger, mulog_log_output_fn output,
                                          enum mulog_log_level log_level);
 
+/**
+ * \brief Adds a vectored output function to the logging interface with the specified log level.
+ *
+ * \param logger The logger.
+ * \param output The vectored output function to be added.
+ * \param log_level The log level associated with the output function.
+ * \return Status code indicating the result of the operation.
+ */
+enum mulog_ret_code interface_add_output_vec(struct logger *logger, mulog_log_output_vec_fn output,
+                                             enum mulog_log_level log_level);
+
+/**
+ * \brief Adds an output with a user context to the logging interface with the specified log level.
+ *
+ * \param logger The logger.
+ * \param output The output descriptor, copied into the output registry.
+ * \param log_level The log level associated with the output.
+ * \return Status code indicating the result of the operation.
+ */
+enum mulog_ret_code interface_add_output_ctx(struct logger *logger,
+                                             const struct mulog_output *output,
+                                             enum mulog_log_level log_level);
+
+/**
+ * \brief Sets the storage for the registered outputs.
+ *
+ * \param logger The logger.
+ * \param slots The registry storage, or NULL to use the built-in storage.
+ * \param count The number of registry slots.
+ * \return Status code indicating the result of the operation.
+ */
+enum mulog_ret_code interface_set_output_registry(struct logger *logger,
+                                                  struct mulog_output_slot *slots, size_t count);
+
 /**
  * \brief Sets the log buffer for the logging interface.
  *
+ * \param logger The logger.
  * \param log_buffer Pointer to the buffer where log entries will be stored.
  * \param log_buffer_size Size of the log buffer in bytes.
  * \return Status code indicating the result of the operation.
  */
-enum mulog_ret_code interface_set_log_buffer(char *log_buffer, size_t log_buffer_size);
+enum mulog_ret_code interface_set_log_buffer(struct logger *logger, char *log_buffer,
+                                             size_t log_buffer_size);
+
+/**
+ * \brief Sets the log buffer reserved for warning and error entries.
+ *
+ * \param logger The logger.
+ * \param log_buffer Pointer to the buffer where priority log entries will be stored, or NULL to
+ *                   remove the priority buffer.
+ * \param log_buffer_size Size of the log buffer in bytes.
+ * \return Status code indicating the result of the operation.
+ */
+enum mulog_ret_code interface_set_priority_log_buffer(struct logger *logger, char *log_buffer,
+                                                      size_t log_buffer_size);
+
+/**
+ * \brief Sets the flight recorder buffer for log entries below the persist level.
+ *
+ * \param logger The logger.
+ * \param log_buffer Pointer to the buffer where recorded log entries will be stored, or NULL to
+ *                   remove the flight recorder.
+ * \param log_buffer_size Size of the log buffer in bytes.
+ * \param persist_level Log level from which entries are stored in the log buffer.
+ * \return Status code indicating the result of the operation.
+ */
+enum mulog_ret_code interface_set_flight_recorder(struct logger *logger, char *log_buffer,
+                                                  size_t log_buffer_size,
+                                                  enum mulog_log_level persist_level);
+
+/**
+ * \brief Moves log entries kept in the flight recorder to the log buffer.
+ *
+ * \param logger The logger.
+ * \return Number of moved log entries or a negative status code.
+ */
+int interface_dump_flight_recorder(struct logger *logger);
+
+/**
+ * \brief Sets the log buffer that keeps log entries recoverable after a crash.
+ *
+ * \param logger The logger.
+ * \param log_buffer Pointer to the buffer where the header and log entries will be stored.
+ * \param log_buffer_size Size of the log buffer in bytes.
+ * \return Status code indicating the result of the operation.
+ */
+enum mulog_ret_code interface_set_persistent_log_buffer(struct logger *logger, char *log_buffer,
+                                                        size_t log_buffer_size);
+
+/**
+ * \brief Passes log entries left in a persistent log buffer to the output function.
+ *
+ * \param log_buffer Pointer to the persistent log buffer content.
+ * \param log_buffer_size Size of the log buffer in bytes.
+ * \param output Output function to pass the recovered log entries to.
+ * \return Number of bytes passed to the output or a negative status code.
+ */
+int interface_recover_log(const char *log_buffer, size_t log_buffer_size,
+                          mulog_log_output_fn output);
+
+/**
+ * \brief Passes stored log entries and a final record to the output without taking the lock.
+ *
+ * \param output Async-signal-safe output function.
+ * \param message Final record message, or NULL to skip it.
+ * \return Number of bytes passed to the output or a negative status code.
+ */
+int interface_emergency_flush(mulog_log_output_fn output, const char *message);
+
+/**
+ * \brief Sets the log buffer for the calling thread.
+ *
+ * \param log_buffer Pointer to the buffer where log entries of the calling thread will be
+ *                   formatted, or NULL to remove the thread buffer.
+ * \param log_buffer_size Size of the log buffer.
+ * \return Status code indicating the result of the operation.
+ */
+enum mulog_ret_code interface_set_thread_log_buffer(char *log_buffer, size_t log_buffer_size);
+
+/**
+ * \brief Checks whether the calling thread has its own log buffer.
+ *
+ * \return true if the calling thread has a log buffer set, false otherwise.
+ */
+bool interface_has_thread_log_buffer(void);
+
+/**
+ * \brief Formats a log entry into the log buffer of the calling thread.
+ *
+ * Does not access shared logger state, so it can be called without the logger lock.
+ *
+ * \param logger The logger.
+ * \param level The log level of the entry.
+ * \param fmt The format string for the log message.
+ * \param args The arguments for the format string.
+ * \return The number of bytes formatted, or a negative value if an error occurs.
+ */
+int interface_format_thread_log_entry(struct logger *logger, enum mulog_log_level level,
+                                      const char *fmt, va_list args);
+
+/**
+ * \brief Outputs the log entry formatted with interface_format_thread_log_entry().
+ *
+ * \param logger The logger.
+ * \param level The log level of the entry.
+ * \param size The size of the formatted entry.
+ * \return The number of bytes output, or 0 if there is no output for the log level.
+ */
+int interface_output_thread_log_entry(struct logger *logger, enum mulog_log_level level,
+                                      size_t size);
+
+/**
+ * \brief Formats a log entry into a caller buffer.
+ *
+ * Does not access shared logger state, so it can be called without the logger lock.
+ *
+ * \param logger The logger.
+ * \param level The log level of the entry.
+ * \param buf The buffer to format the entry into.
+ * \param buf_size The size of the buffer.
+ * \param fmt The format string for the log message.
+ * \param args The arguments for the format string.
+ * \return The number of bytes formatted, 0 if the log level is not accepted, or a negative value
+ *         if an error occurs.
+ */
+int interface_format_log_entry(struct logger *logger, enum mulog_log_level level, char *buf,
+                               size_t buf_size, const char *fmt, va_list args);
+
+/**
+ * \brief Formats a log entry into the shared log buffer of the logger.
+ *
+ * The log buffer is used as two halves in turns, so an entry can be formatted into one half while
+ * the entry in the other half is passed to the outputs. Must be called with the format lock held,
+ * the output lock has to be taken before it is released.
+ *
+ * \param logger The logger.
+ * \param level The log level of the entry.
+ * \param fmt The format string for the log message.
+ * \param args The arguments for the format string.
+ * \param entry Set to the formatted entry, which stays valid until the next but one call.
+ * \return The number of bytes formatted, 0 if the entry has not been formatted, or a negative value
+ *         if an error occurs.
+ */
+int interface_format_shared_log_entry(struct logger *logger, enum mulog_log_level level,
+                                      const char *fmt, va_list args, const char **entry);
+
+/**
+ * \brief Outputs a log entry formatted with interface_format_log_entry() or
+ *        interface_format_shared_log_entry().
+ *
+ * \param logger The logger.
+ * \param level The log level of the entry.
+ * \param buf The formatted entry.
+ * \param size The size of the formatted entry.
+ * \return The number of bytes output, or 0 if there is no output for the log level.
+ */
+int interface_output_log_entry(struct logger *logger, enum mulog_log_level level, const char *buf,
+                               size_t size);
 
 /**
  * \brief Sets the global log level for the logging interface.
  *
+ * \param logger The logger.
  * \param log_level The log level to be set globally. It should be a valid value from the `mulog_log_level` enum.
  * \return Status code indicating the result of the operation. Returns `MULOG_RET_CODE_OK` on success or
  *         `MULOG_RET_CODE_INVALID_ARG` if the provided `log_level` is invalid.
  */
-enum mulog_ret_code interface_set_global_log_level(enum mulog_log_level log_level);
+enum mulog_ret_code interface_set_global_log_level(struct logger *logger,
+                                                   enum mulog_log_level log_level);
 
 /**
  * \brief Sets the log level for a specified output function.
  *
+ * \param logger The logger.
  * \param log_level The log level to be set for the specified output.
  * \param output The output function for which the log level is to be set.
  * \return Status code indicating the result of the operation.
  */
-enum mulog_ret_code interface_set_log_level_per_output(enum mulog_log_level log_level,
+enum mulog_ret_code interface_set_log_level_per_output(struct logger *logger,
+                                                       enum mulog_log_level log_level,
                                                        mulog_log_output_fn output);
 
 /**
  * \brief Unregisters a previously registered output function from the logging interface.
  *
+ * \param logger The logger.
  * \param output The output function to be removed.
  * \return Status code indicating the result of the unregistration operation.
  */
-enum mulog_ret_code interface_unregister_output(mulog_log_output_fn output);
+enum mulog_ret_code interface_unregister_output(struct logger *logger, mulog_log_output_fn output);
+
+/**
+ * \brief Unregisters a previously registered vectored output function.
+ *
+ * \param logger The logger.
+ * \param output The vectored output function to be removed.
+ * \return Status code indicating the result of the unregistration operation.
+ */
+enum mulog_ret_code interface_unregister_output_vec(struct logger *logger,
+                                                    mulog_log_output_vec_fn output);
+
+/**
+ * \brief Unregisters a previously registered output with a user context and closes it.
+ *
+ * \param logger The logger.
+ * \param write The write function of the output.
+ * \param ctx The user context of the output.
+ * \return Status code indicating the result of the unregistration operation.
+ */
+enum mulog_ret_code interface_unregister_output_ctx(struct logger *logger,
+                                                    mulog_output_write_fn write, const void *ctx);
 
 /**
  * \brief Unregisters all output functions from the logging interface.
  *
  * Removes all registered output functions, ensuring that no functions
- * will be called to handle log messages.
+ * will be called to handle log messages. Outputs with a user context are closed.
+ *
+ * \param logger The logger to remove the output functions from.
+ * \return Status code indicating the result of the operation.
  */
-void interface_unregister_all_outputs(void);
+enum mulog_ret_code interface_unregister_all_outputs(struct logger *logger);
 /**
  * \brief Resets the interface to its initial state.
  *
  * This function performs a complete reset of the interface, clearing any
  * configuration or state that may have been previously set.
+ *
+ * \param logger The logger to reset.
  */
-void interface_reset(void);
+void interface_reset(struct logger *logger);
 
 /**
  * \brief Outputs a log message at the specified log level with formatting.
@@ -92,19 +331,68 @@ void interface_reset(void);
  * log level and format string. It processes the timestamp and log level information,
  * formats the message, and writes it to the ring buffer.
  *
+ * \param logger The logger.
  * \param level The log level at which the message should be output.
  * \param fmt The format string for the log message.
  * \param args The arguments for the format string.
  * \return The number of bytes written to the ring buffer, or zero on error.
  */
-int interface_log_output(enum mulog_log_level level, const char *fmt, va_list args);
+int interface_log_output(struct logger *logger, enum mulog_log_level level, const char *fmt,
+                         va_list args);
+
+/**
+ * \brief Gets the number of log entries dropped since the last reset.
+ *
+ * \param logger The logger.
+ * \return Number of log entries that have not been stored due to lack of space.
+ */
+size_t interface_get_dropped_count(struct logger *logger);
+
+/**
+ * \brief Gets the number of log entries of the given level dropped since the last reset.
+ *
+ * \param logger The logger.
+ * \param level The log level of the dropped entries.
+ * \return Number of log entries of the level that have not been stored.
+ */
+size_t interface_get_level_dropped_count(struct logger *logger, enum mulog_log_level level);
+
+/**
+ * \brief Sets the policy for log entries that do not fit into the log buffer.
+ *
+ * \param logger The logger.
+ * \param policy The overflow policy.
+ * \param spin_limit Number of retries before an entry is dropped with the blocking policy.
+ * \return MULOG_RET_CODE_OK on success or an error code otherwise.
+ */
+enum mulog_ret_code interface_set_overflow_policy(struct logger *logger,
+                                                  enum mulog_overflow_policy policy,
+                                                  size_t spin_limit);
+
+/**
+ * \brief Checks whether deferred log entries have to be processed under the logger lock.
+ *
+ * \param logger The logger.
+ * \return true if producers may remove stored entries, false otherwise.
+ */
+bool interface_is_deferred_log_locked(struct logger *logger);
+
+/**
+ * \brief Gets the amount of the log buffer taken by deferred log entries.
+ *
+ * \param logger The logger.
+ * \return Number of bytes waiting to be processed, always 0 in realtime mode.
+ */
+size_t interface_get_deferred_usage(struct logger *logger);
 
 /**
  * \brief Logs deferred messages using the interface's logging mechanism.
  *
- * \return Status code indicating that the operation is unsupported.
+ * \param logger The logger.
+ * \param budget Processing limits, or NULL to process all stored entries.
+ * \return Number of bytes passed to the outputs, or a negative status code.
  */
-int interface_deferred_log(void);
+int interface_deferred_log(struct logger *logger, const struct mulog_process_budget *budget);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,420 @@
+/**
+ * \file
+ * \brief Copy-on-write table of the registered output functions implementation
+ * \author Vladimir Petrigo
+ */
+
+#include "internal/output_table.h"
+#include "internal/utils.h"
+
+#include <limits.h>
+#include <stdbool.h>
+
+// every registry slot keeps the output function for both snapshots
+_Static_assert(2 * sizeof(struct out_function) <= sizeof(struct mulog_output_slot) &&
+                   _Alignof(struct out_function) <= _Alignof(struct mulog_output_slot),
+               "Output functions of both snapshots must fit into an output registry slot");
+
+/**
+ * \brief Flag of the reader count set once a snapshot is replaced, cleared by its last reader
+ */
+#define SNAPSHOT_RETIRED ((size_t)1 << (sizeof(size_t) * CHAR_BIT - 1))
+
+/**
+ * \brief Flag of the reader count set while the last reader releases a replaced snapshot
+ */
+#define SNAPSHOT_RELEASING ((size_t)1 << (sizeof(size_t) * CHAR_BIT - 2))
+
+// PRIVATE VARIABLE DEFINITIONS
+
+/**
+ * \brief Snapshot without outputs taken from a table that has not been updated yet
+ */
+static struct out_table empty_table;
+
+// PRIVATE FUNCTION DEFINITIONS
+
+/**
+ * \brief Checks whether two output functions refer to the same output.
+ *
+ * \param lhs The first output function
+ * \param rhs The second output function
+ * \return true if the functions and the user context match, false otherwise
+ */
+static inline bool is_same_out_function(const struct out_function *lhs,
+                                        const struct out_function *rhs)
+{
+    return lhs->output == rhs->output && lhs->output_vec == rhs->output_vec &&
+           lhs->ctx_output.write == rhs->ctx_output.write &&
+           lhs->ctx_output.ctx == rhs->ctx_output.ctx;
+}
+
+/**
+ * \brief Closes an output function removed from the table.
+ *
+ * \param fn The output function, only outputs with a user context have a close function
+ */
+static inline void close_out_function(const struct out_function *fn)
+{
+    if (fn->ctx_output.close != NULL) {
+        fn->ctx_output.close(fn->ctx_output.ctx);
+    }
+}
+
+/**
+ * \brief Releases a replaced snapshot once it has no readers and closes the removed outputs.
+ *
+ * Called by the writer that replaces the snapshot and by every reader that leaves it, only the one
+ * that sees no readers left releases it.
+ *
+ * \param snapshot Snapshot that is no longer active
+ */
+static void release_snapshot(struct out_table *snapshot)
+{
+    size_t state = SNAPSHOT_RETIRED;
+
+    if (!__atomic_compare_exchange_n(&snapshot->readers, &state, SNAPSHOT_RELEASING, false,
+                                     __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+        return;
+    }
+
+    for (size_t i = 0; i < snapshot->removed_count; ++i) {
+        close_out_function(&snapshot->fns[snapshot->removed_first + i]);
+    }
+
+    snapshot->fns = snapshot->released_fns;
+    // readers that have not noticed the swap yet may have counted themselves in the meantime
+    __atomic_and_fetch(&snapshot->readers, ~SNAPSHOT_RELEASING, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * \brief Checks whether a replaced snapshot has been released by its readers.
+ *
+ * Readers that have not noticed the swap yet may still count themselves, but they never read it.
+ *
+ * \param snapshot Snapshot to check
+ * \return true if the snapshot can be filled by the next update, false otherwise
+ */
+static inline bool is_released(const struct out_table *snapshot)
+{
+    return (__atomic_load_n(&snapshot->readers, __ATOMIC_SEQ_CST) &
+            (SNAPSHOT_RETIRED | SNAPSHOT_RELEASING)) == 0;
+}
+
+/**
+ * \brief Gets the snapshot the next update fills.
+ *
+ * \param table Output table to update
+ * \return The inactive snapshot
+ */
+static inline struct out_table *get_inactive(struct output_table *table)
+{
+    return table->active == &table->tables[0] ? &table->tables[1] : &table->tables[0];
+}
+
+/**
+ * \brief Brings a zero-initialized table to its initial state before its first update.
+ *
+ * \param table Output table to update
+ */
+static inline void prepare_update(struct output_table *table)
+{
+    if (table->active == NULL) {
+        output_table_reset(table);
+    }
+}
+
+/**
+ * \brief Gets the inactive snapshot filled with the active output configuration.
+ *
+ * The inactive snapshot is not read by anyone once it has been released, readers that have not
+ * noticed the previous swap yet only touch its reader count and retry.
+ *
+ * \param table Output table to update
+ * \return The snapshot to update and publish with publish_update(), or NULL if a reader still
+ *         holds it
+ */
+static struct out_table *begin_update(struct output_table *table)
+{
+    struct out_table *active = table->active;
+    struct out_table *next = get_inactive(table);
+
+    // a reader may update the table from an output or wait for the writer lock, so it is never
+    // waited for
+    if (!is_released(next)) {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < active->count; ++i) {
+        next->fns[i] = active->fns[i];
+    }
+
+    next->count = active->count;
+    active->removed_first = 0;
+    active->removed_count = 0;
+    active->released_fns = active->fns;
+
+    return next;
+}
+
+/**
+ * \brief Restores the output order of a snapshot and makes it active.
+ *
+ * The previous snapshot is released by the last of its readers, or right away if it has none.
+ *
+ * \param table Output table to update
+ * \param next Snapshot taken with begin_update()
+ */
+static void publish_update(struct output_table *table, struct out_table *next)
+{
+    struct out_function *fns = next->fns;
+    const size_t count = next->count;
+
+    // the table is short and mostly ordered, a stable insertion sort keeps the registration order
+    for (size_t i = 1; i < count; ++i) {
+        const struct out_function fn = fns[i];
+        size_t j = i;
+
+        for (; j > 0 && fns[j - 1].log_level > fn.log_level; --j) {
+            fns[j] = fns[j - 1];
+        }
+
+        fns[j] = fn;
+    }
+
+    size_t level_count = 0;
+
+    for (size_t level = 0; level < MULOG_LOG_LVL_COUNT; ++level) {
+        while (level_count < count && fns[level_count].log_level <= level) {
+            ++level_count;
+        }
+
+        next->level_counts[level] = level_count;
+    }
+
+    struct out_table *prev = table->active;
+
+    __atomic_store_n(&table->active, next, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&table->min_level, count > 0 ? fns[0].log_level : MULOG_LOG_LVL_COUNT,
+                     __ATOMIC_RELAXED);
+    __atomic_or_fetch(&prev->readers, SNAPSHOT_RETIRED, __ATOMIC_SEQ_CST);
+    release_snapshot(prev);
+}
+
+// PUBLIC FUNCTION DEFINITIONS
+
+void output_table_reset(struct output_table *table)
+{
+    table->capacity = ARRAY_SIZE(table->fns) / 2;
+    table->storage = table->fns;
+
+    for (size_t i = 0; i < ARRAY_SIZE(table->tables); ++i) {
+        table->tables[i].fns = table->storage + i * table->capacity;
+        table->tables[i].count = 0;
+        table->tables[i].readers = 0;
+        table->tables[i].removed_first = 0;
+        table->tables[i].removed_count = 0;
+        table->tables[i].released_fns = table->tables[i].fns;
+
+        for (size_t level = 0; level < MULOG_LOG_LVL_COUNT; ++level) {
+            table->tables[i].level_counts[level] = 0;
+        }
+    }
+
+    __atomic_store_n(&table->min_level, MULOG_LOG_LVL_COUNT, __ATOMIC_RELAXED);
+    // readers take the snapshot once it is set up
+    __atomic_store_n(&table->active, &table->tables[0], __ATOMIC_SEQ_CST);
+}
+
+const struct out_table *output_table_acquire(struct output_table *table)
+{
+    for (;;) {
+        struct out_table *active = __atomic_load_n(&table->active, __ATOMIC_SEQ_CST);
+        // a zero-initialized table has no outputs until its first update
+        struct out_table *snapshot = active != NULL ? active : &empty_table;
+
+        __atomic_add_fetch(&snapshot->readers, 1, __ATOMIC_SEQ_CST);
+
+        // the writer may have swapped the snapshot before it has seen the reader
+        if (active == __atomic_load_n(&table->active, __ATOMIC_SEQ_CST)) {
+            return snapshot;
+        }
+
+        output_table_release(snapshot);
+    }
+}
+
+void output_table_release(const struct out_table *snapshot)
+{
+    struct out_table *released = (struct out_table *)snapshot;
+
+    if (__atomic_sub_fetch(&released->readers, 1, __ATOMIC_SEQ_CST) == SNAPSHOT_RETIRED) {
+        release_snapshot(released);
+    }
+}
+
+enum mulog_log_level output_table_get_min_level(const struct output_table *table)
+{
+    return __atomic_load_n(&table->active, __ATOMIC_RELAXED) != NULL
+               ? __atomic_load_n(&table->min_level, __ATOMIC_RELAXED)
+               : MULOG_LOG_LVL_COUNT;
+}
+
+enum mulog_ret_code output_table_add(struct output_table *table, const struct out_function *out)
+{
+    prepare_update(table);
+
+    if (out->log_level >= MULOG_LOG_LVL_COUNT) {
+        return MULOG_RET_CODE_INVALID_ARG;
+    }
+
+    if (table->active->count == table->capacity) {
+        return MULOG_RET_CODE_NO_MEM;
+    }
+
+    struct out_table *next = begin_update(table);
+
+    if (next == NULL) {
+        return MULOG_RET_CODE_LOCK_FAILED;
+    }
+
+    next->fns[next->count++] = *out;
+    publish_update(table, next);
+
+    return MULOG_RET_CODE_OK;
+}
+
+enum mulog_ret_code output_table_remove(struct output_table *table, const struct out_function *out)
+{
+    prepare_update(table);
+
+    const struct out_table *active = table->active;
+
+    for (size_t i = 0; i < active->count; ++i) {
+        if (!is_same_out_function(&active->fns[i], out)) {
+            continue;
+        }
+
+        struct out_table *next = begin_update(table);
+
+        if (next == NULL) {
+            return MULOG_RET_CODE_LOCK_FAILED;
+        }
+
+        // the remaining outputs stay back to back and ordered
+        for (size_t j = i + 1; j < next->count; ++j) {
+            next->fns[j - 1] = next->fns[j];
+        }
+
+        --next->count;
+        // the previous snapshot keeps the removed output until it is released
+        table->active->removed_first = i;
+        table->active->removed_count = 1;
+        publish_update(table, next);
+
+        return MULOG_RET_CODE_OK;
+    }
+
+    return MULOG_RET_CODE_NOT_FOUND;
+}
+
+enum mulog_ret_code output_table_set_level(struct output_table *table,
+                                           const mulog_log_output_fn output,
+                                           const enum mulog_log_level log_level)
+{
+    prepare_update(table);
+
+    const struct out_table *active = table->active;
+
+    for (size_t i = 0; i < active->count; ++i) {
+        if (active->fns[i].output == NULL || active->fns[i].output != output) {
+            continue;
+        }
+
+        struct out_table *next = begin_update(table);
+
+        if (next == NULL) {
+            return MULOG_RET_CODE_LOCK_FAILED;
+        }
+
+        next->fns[i].log_level = log_level;
+        publish_update(table, next);
+
+        return MULOG_RET_CODE_OK;
+    }
+
+    return MULOG_RET_CODE_NOT_FOUND;
+}
+
+enum mulog_ret_code output_table_set_all_levels(struct output_table *table,
+                                                const enum mulog_log_level log_level)
+{
+    prepare_update(table);
+
+    struct out_table *next = begin_update(table);
+
+    if (next == NULL) {
+        return MULOG_RET_CODE_LOCK_FAILED;
+    }
+
+    for (size_t i = 0; i < next->count; ++i) {
+        next->fns[i].log_level = log_level;
+    }
+
+    publish_update(table, next);
+
+    return MULOG_RET_CODE_OK;
+}
+
+enum mulog_ret_code output_table_clear(struct output_table *table)
+{
+    prepare_update(table);
+
+    struct out_table *next = begin_update(table);
+
+    if (next == NULL) {
+        return MULOG_RET_CODE_LOCK_FAILED;
+    }
+
+    next->count = 0;
+    // the previous snapshot keeps the removed outputs until it is released
+    table->active->removed_count = table->active->count;
+    publish_update(table, next);
+
+    return MULOG_RET_CODE_OK;
+}
+
+enum mulog_ret_code output_table_set_storage(struct output_table *table,
+                                             struct out_function *storage, const size_t capacity)
+{
+    prepare_update(table);
+
+    struct out_function *fns = storage != NULL ? storage : table->fns;
+    const size_t size = storage != NULL ? capacity : ARRAY_SIZE(table->fns) / 2;
+
+    if (fns == table->storage) {
+        // outputs can not be moved within the storage they are kept in
+        return storage == NULL ? MULOG_RET_CODE_OK : MULOG_RET_CODE_INVALID_ARG;
+    }
+
+    if (table->active->count > size) {
+        return MULOG_RET_CODE_NO_MEM;
+    }
+
+    struct out_table *next = get_inactive(table);
+
+    if (!is_released(next)) {
+        return MULOG_RET_CODE_LOCK_FAILED;
+    }
+
+    // the inactive snapshot is moved first, the active one once it is released
+    next->fns = fns;
+    next = begin_update(table);
+
+    table->active->released_fns = fns + size;
+    table->storage = fns;
+    table->capacity = size;
+    publish_update(table, next);
+
+    return MULOG_RET_CODE_OK;
+}
@@ -0,0 +1,205 @@
+/**
+ * \file
+ * \brief Copy-on-write table of the registered output functions
+ * \author Vladimir Petrigo
+ */
+
+#ifndef OUTPUT_TABLE_H
+#define OUTPUT_TABLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "internal/config.h"
+#include "mulog.h"
+
+#include <stddef.h>
+
+#ifndef MULOG_OUTPUT_HANDLERS
+#error "Define MULOG_OUTPUT_HANDLERS to a number of maximum output handlers that can be registered"
+#endif
+
+/**
+ * \brief Registered output function, only one of the output kinds is set
+ */
+struct out_function {
+    mulog_log_output_fn output;         /**< Output that takes one line per call */
+    mulog_log_output_vec_fn output_vec; /**< Vectored output that takes several lines per call */
+    struct mulog_output ctx_output;     /**< Output with a user context */
+    enum mulog_log_level log_level;     /**< Lowest log level passed to the output */
+};
+
+/**
+ * \brief Immutable snapshot of the output configuration
+ *
+ * Output functions are kept back to back ordered by their log level, so the outputs that accept
+ * a log level are always the leading ones. The number of them is precomputed for every log level
+ * when the snapshot is published.
+ */
+struct out_table {
+    struct out_function *fns;                 /**< Output functions ordered by their log level */
+    size_t count;                             /**< Number of output functions */
+    size_t level_counts[MULOG_LOG_LVL_COUNT]; /**< Number of leading outputs taking each level */
+    size_t readers;                           /**< Number of readers and the release state */
+    size_t removed_first;                     /**< First output closed once released */
+    size_t removed_count;                     /**< Number of outputs closed once released */
+    struct out_function *released_fns;        /**< Storage the snapshot takes once released */
+};
+
+/**
+ * \brief Output configuration published as one of two snapshots
+ *
+ * Readers take the active snapshot with output_table_acquire() and never wait for a writer. A
+ * writer fills the other snapshot with the updated configuration and publishes it with a single
+ * pointer swap. The previous snapshot is released by the last of its readers, which also closes
+ * the removed outputs, so the writer never waits for readers. An output may update the table or
+ * log through a logger while a writer holds the logger lock.
+ *
+ * Writers have to be serialized by the caller. The next update fills the previous snapshot, so it
+ * fails while a reader still holds the previous snapshot.
+ *
+ * A zero-initialized table has no outputs and is set up with the built-in storage by its first
+ * update.
+ */
+struct output_table {
+    struct out_table tables[2];     /**< Active snapshot and the one the next update fills */
+    struct out_table *active;       /**< Snapshot taken by readers */
+    struct out_function *storage;   /**< Storage of both snapshots, fns or the user registry */
+    size_t capacity;                /**< Number of output functions a snapshot holds */
+    enum mulog_log_level min_level; /**< Lowest log level accepted by the active snapshot */
+    struct out_function fns[2 * MULOG_OUTPUT_HANDLERS];
+};
+
+/**
+ * \brief Brings an output table to its initial state without outputs and with the built-in
+ *        storage.
+ *
+ * Registered outputs are dropped without being closed. Must not be called while the table is
+ * read by other threads.
+ *
+ * \param table Output table to reset
+ */
+void output_table_reset(struct output_table *table);
+
+/**
+ * \brief Takes the active snapshot of the output configuration.
+ *
+ * The snapshot is not changed until it is released with output_table_release().
+ *
+ * \param table Output table to take the snapshot of
+ * \return The active snapshot
+ */
+const struct out_table *output_table_acquire(struct output_table *table);
+
+/**
+ * \brief Releases a snapshot taken with output_table_acquire().
+ *
+ * The last reader of a snapshot replaced by an update closes the outputs removed by the update.
+ *
+ * \param snapshot Snapshot to release
+ */
+void output_table_release(const struct out_table *snapshot);
+
+/**
+ * \brief Gets the number of leading outputs of a snapshot that accept a log level.
+ *
+ * \param snapshot Snapshot of the output configuration
+ * \param level The log level, MULOG_LOG_LVL_COUNT for all outputs
+ * \return Number of outputs to pass an entry of the level to
+ */
+static inline size_t out_table_get_count(const struct out_table *snapshot,
+                                         const enum mulog_log_level level)
+{
+    return level < MULOG_LOG_LVL_COUNT ? snapshot->level_counts[level] : snapshot->count;
+}
+
+/**
+ * \brief Gets the lowest log level accepted by the registered outputs.
+ *
+ * Can be called without taking a snapshot, for example, to skip a log entry before it is
+ * formatted.
+ *
+ * \param table Output table to check
+ * \return The lowest accepted log level, or MULOG_LOG_LVL_COUNT if there are no outputs
+ */
+enum mulog_log_level output_table_get_min_level(const struct output_table *table);
+
+/**
+ * \brief Registers an output function after the outputs of the same log level.
+ *
+ * \param table Output table to add the output to
+ * \param out The output function to copy into the table
+ * \return MULOG_RET_CODE_OK on success, MULOG_RET_CODE_INVALID_ARG for an invalid log level,
+ *         MULOG_RET_CODE_NO_MEM if the table is full or MULOG_RET_CODE_LOCK_FAILED if a reader
+ *         still holds the snapshot replaced by the previous update
+ */
+enum mulog_ret_code output_table_add(struct output_table *table, const struct out_function *out);
+
+/**
+ * \brief Removes an output function and closes it once no reader calls it.
+ *
+ * \param table Output table to remove the output from
+ * \param out The output function to remove, compared by the functions and the user context
+ * \return MULOG_RET_CODE_OK on success, MULOG_RET_CODE_NOT_FOUND if there is no such output or
+ *         MULOG_RET_CODE_LOCK_FAILED if a reader still holds the snapshot replaced by the previous
+ *         update
+ */
+enum mulog_ret_code output_table_remove(struct output_table *table, const struct out_function *out);
+
+/**
+ * \brief Sets the log level of an output function that takes one line per call.
+ *
+ * \param table Output table the output is registered in
+ * \param output The output function
+ * \param log_level The log level to set
+ * \return MULOG_RET_CODE_OK on success, MULOG_RET_CODE_NOT_FOUND if there is no such output or
+ *         MULOG_RET_CODE_LOCK_FAILED if a reader still holds the snapshot replaced by the previous
+ *         update
+ */
+enum mulog_ret_code output_table_set_level(struct output_table *table, mulog_log_output_fn output,
+                                           enum mulog_log_level log_level);
+
+/**
+ * \brief Sets the log level of all output functions.
+ *
+ * \param table Output table to update
+ * \param log_level The log level to set
+ * \return MULOG_RET_CODE_OK on success or MULOG_RET_CODE_LOCK_FAILED if a reader still holds the
+ *         snapshot replaced by the previous update
+ */
+enum mulog_ret_code output_table_set_all_levels(struct output_table *table,
+                                                enum mulog_log_level log_level);
+
+/**
+ * \brief Removes all output functions and closes them once no reader calls them.
+ *
+ * \param table Output table to clear
+ * \return MULOG_RET_CODE_OK on success or MULOG_RET_CODE_LOCK_FAILED if a reader still holds the
+ *         snapshot replaced by the previous update
+ */
+enum mulog_ret_code output_table_clear(struct output_table *table);
+
+/**
+ * \brief Moves the output functions to another storage.
+ *
+ * The storage keeps both snapshots, so it has to hold twice the number of output functions a
+ * snapshot holds. The previous storage is not used once the readers holding the previous snapshot
+ * release it.
+ *
+ * \param table Output table to update
+ * \param storage Storage for the output functions, or NULL to use the built-in storage
+ * \param capacity Number of output functions a snapshot holds
+ * \return MULOG_RET_CODE_OK on success, MULOG_RET_CODE_INVALID_ARG if the storage is already in
+ *         use, MULOG_RET_CODE_NO_MEM if the registered outputs do not fit or
+ *         MULOG_RET_CODE_LOCK_FAILED if a reader still holds the snapshot replaced by the previous
+ *         update
+ */
+enum mulog_ret_code output_table_set_storage(struct output_table *table,
+                                             struct out_function *storage, size_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OUTPUT_TABLE_H */
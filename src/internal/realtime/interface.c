@@ -6,8 +6,12 @@
 
 #include "internal/interface.h"
 #include "internal/config.h"
+#include "internal/output_table.h"
 #include "internal/utils.h"
-#include "list.h"
+
+#if defined(MULOG_ENABLE_BINARY_OUTPUT) && MULOG_ENABLE_BINARY_OUTPUT == 1
+#include "internal/wire.h"
+#endif /* MULOG_ENABLE_BINARY_OUTPUT */
 
 #include <printf/printf.h>
 
@@ -18,101 +22,151 @@
  */
 struct logger_ctx {
     enum mulog_log_level global_level; /**< Global log level used for init new outputs */
+    bool global_level_set;             /**< Whether the global log level has been set */
     char *log_buffer;                  /**< Log entry format buffer */
     size_t log_buffer_size;            /**< Size of the log entry buffer */
+#if defined(MULOG_ENABLE_BINARY_OUTPUT) && MULOG_ENABLE_BINARY_OUTPUT == 1
+    unsigned long last_timestamp;      /**< Timestamp of the last binary log record */
+#endif /* MULOG_ENABLE_BINARY_OUTPUT */
+#if defined(MULOG_ENABLE_LOCK_DOMAINS) && MULOG_ENABLE_LOCK_DOMAINS == 1
+    size_t next_half;                  /**< Log buffer half the next shared entry is formatted in */
+#endif /* MULOG_ENABLE_LOCK_DOMAINS */
 };
 
-struct out_function {
-    mulog_log_output_fn output;
-    enum mulog_log_level log_level;
-    struct list_node node;
-};
-
-#ifndef MULOG_OUTPUT_HANDLERS
-#error "Define MULOG_OUTPUT_HANDLERS to a number of maximum output handlers that can be registered"
+#if !defined(MULOG_INSTANCES) || MULOG_INSTANCES < 0
+#error "Define MULOG_INSTANCES to a number of logger instances that can be created"
 #endif
 
-struct handles {
-    LIST_HEAD_VAR(out_functions);
-    size_t out_count;
-    struct out_function fns[MULOG_OUTPUT_HANDLERS];
+/**
+ * \brief Logger state, the default logger and every logger instance have their own
+ */
+struct logger {
+    struct logger_ctx ctx;
+    struct output_table outputs; /**< Registered output functions */
 };
 
 // PRIVATE VARIABLE DEFINITIONS
 
-static struct logger_ctx log_ctx = {
-    .global_level = MULOG_LOG_LVL_DEBUG,
-};
-static struct handles handles = {
-    .out_functions = LIST_HEAD_INIT_VAR,
+/**
+ * \brief Default logger followed by the loggers of the instances, which are reset before use
+ *
+ * A zero-initialized logger has no outputs and logs with the default settings.
+ */
+static struct logger loggers[1 + MULOG_INSTANCES];
+
+#if defined(MULOG_ENABLE_THREAD_LOG_BUFFER) && MULOG_ENABLE_THREAD_LOG_BUFFER == 1
+/**
+ * \brief Log entry format buffer owned by a thread
+ */
+struct thread_log_buffer {
+    char *log_buffer;       /**< Log entry format buffer */
+    size_t log_buffer_size; /**< Size of the log entry buffer */
 };
 
+static _Thread_local struct thread_log_buffer thread_log_buffer;
+#endif /* MULOG_ENABLE_THREAD_LOG_BUFFER */
+
 // PRIVATE FUNCTION DEFINITIONS
 
 /**
- * \brief Sets the log level for all output functions.
+ * \brief Publishes the lowest log level accepted by the registered output functions.
+ *
+ * Must be called after every change of the outputs. The value is read by the log macros without
+ * the logger lock to skip disabled log calls. The macros only log through the default logger, so
+ * other loggers do not publish it.
  *
- * \param log_level The log level to set for all output functions.
+ * \param logger The logger to update.
  */
-static void set_log_level_for_all_outputs(const enum mulog_log_level log_level)
+static void update_min_log_level(struct logger *logger)
 {
-    struct list_node *it;
-
-    LIST_FOR_EACH(it, &handles.out_functions)
-    {
-        struct out_function *fn = LIST_ENTRY(it, struct out_function, node);
-
-        fn->log_level = log_level;
+    if (logger == &loggers[0]) {
+        __atomic_store_n(&mulog_min_log_level, output_table_get_min_level(&logger->outputs),
+                         __ATOMIC_RELAXED);
     }
 }
 
 /**
- * \brief Count the number of output functions with log level above a specified level.
+ * \brief Checks whether any registered output function accepts a log level.
  *
- * This function iterates through a list of output functions and counts how many
- * have a log level greater than or equal to the specified log level.
+ * \param logger The logger.
+ * \param level The log level.
+ * \return true if the log entry of the level has to be formatted, false otherwise.
+ */
+static inline bool is_log_level_accepted(struct logger *logger, const enum mulog_log_level level)
+{
+    return level < MULOG_LOG_LVL_COUNT && level >= output_table_get_min_level(&logger->outputs);
+}
+
+/**
+ * \brief Registers an output function.
  *
- * \param log_level The log level to compare against.
- * \return The number of output functions with a log level above the specified level.
+ * \param logger The logger.
+ * \param out The output function to copy into the output table.
+ * \return Status code indicating the result of the operation.
  */
-static size_t get_num_outputs_above_level(const enum mulog_log_level log_level)
+static enum mulog_ret_code add_out_function(struct logger *logger, const struct out_function *out)
 {
-    struct list_node *it;
-    size_t logger_count = 0;
+    const enum mulog_ret_code ret = output_table_add(&logger->outputs, out);
 
-    LIST_FOR_EACH(it, &handles.out_functions)
-    {
-        const struct out_function *out = LIST_ENTRY(it, struct out_function, node);
+    update_min_log_level(logger);
 
-        if (out->log_level <= log_level) {
-            ++logger_count;
-        }
-    }
+    return ret;
+}
+
+/**
+ * \brief Removes an output function and closes it.
+ *
+ * \param logger The logger.
+ * \param out The output function to remove, compared by the functions and the user context.
+ * \return Status code indicating the result of the operation.
+ */
+static enum mulog_ret_code remove_out_function(struct logger *logger,
+                                               const struct out_function *out)
+{
+    const enum mulog_ret_code ret = output_table_remove(&logger->outputs, out);
+
+    update_min_log_level(logger);
 
-    return logger_count;
+    return ret;
+}
+
+/**
+ * \brief Passes a log entry to an output function.
+ *
+ * \param fn The output function.
+ * \param buf The buffer containing the log entry.
+ * \param buf_size The size of the buffer containing the log entry.
+ */
+static inline void write_out_function(const struct out_function *fn, const char *buf,
+                                      const size_t buf_size)
+{
+    if (fn->output != NULL) {
+        fn->output(buf, buf_size);
+    } else {
+        fn->ctx_output.write(fn->ctx_output.ctx, buf, buf_size);
+    }
 }
 
 /**
  * \brief Outputs a log entry to all the configured output functions that have a log level
  *        lower than or equal to the specified log level.
  *
+ * \param logger The logger.
  * \param log_level The log level of the entry to be output.
  * \param buf The buffer containing the log entry.
  * \param buf_size The size of the buffer containing the log entry.
  */
-static void output_log_entry(const enum mulog_log_level log_level, const char *buf,
-                             const size_t buf_size)
+static void output_log_entry(struct logger *logger, const enum mulog_log_level log_level,
+                             const char *buf, const size_t buf_size)
 {
-    struct list_node *it;
-
-    LIST_FOR_EACH(it, &handles.out_functions)
-    {
-        const struct out_function *fn = LIST_ENTRY(it, struct out_function, node);
+    const struct out_table *outputs = output_table_acquire(&logger->outputs);
+    const size_t count = out_table_get_count(outputs, log_level);
 
-        if (fn->log_level <= log_level) {
-            fn->output(buf, buf_size);
-        }
+    for (size_t i = 0; i < count; ++i) {
+        write_out_function(&outputs->fns[i], buf, buf_size);
     }
+
+    output_table_release(outputs);
 }
 
 /**
@@ -179,204 +233,496 @@ static inline int line_termination(char *buf, const size_t buf_size)
     return snprintf_(buf, buf_size, "%s", "\n");
 }
 
+#if !defined(MULOG_ENABLE_BINARY_OUTPUT) || MULOG_ENABLE_BINARY_OUTPUT == 0
+/**
+ * \brief Formats a log entry with a timestamp, a log level and a line termination.
+ *
+ * The entry is truncated to the buffer size if it does not fit.
+ *
+ * \param buf The buffer to format the entry into.
+ * \param buf_size The size of the buffer.
+ * \param level The log level of the entry.
+ * \param fmt The format string for the log message.
+ * \param args The arguments for the format string.
+ * \return The number of characters to output from the buffer, or a negative value if an error
+ *         occurs.
+ */
+static int format_log_entry(char *buf, const size_t buf_size, const enum mulog_log_level level,
+                            const char *fmt, va_list args)
+{
+    size_t offset = 0;
+    int ret = prepend_timestamp(buf, buf_size);
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    offset += ret;
+
+    if (buf_size < offset) {
+        return (int)buf_size - 1;
+    }
+
+    ret = prepend_level(buf + offset, buf_size - offset, level);
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    offset += ret;
+
+    if (buf_size < offset) {
+        return (int)buf_size - 1;
+    }
+
+    ret = vsnprintf_(buf + offset, buf_size - offset, fmt, args);
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    offset += ret;
+
+    if (buf_size < offset) {
+        return (int)buf_size - 1;
+    }
+
+    ret = line_termination(buf + offset, buf_size - offset);
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    offset += ret;
+
+    if (buf_size < offset) {
+        offset = buf_size - 1;
+    }
+
+    return (int)offset;
+}
+#else
+/**
+ * \brief Encodes a binary log record with a timestamp delta and a log level.
+ *
+ * Records are never truncated, a record that does not fit into the buffer is dropped.
+ *
+ * \param logger The logger.
+ * \param buf The buffer to encode the record into.
+ * \param buf_size The size of the buffer.
+ * \param level The log level of the record.
+ * \param fmt The format string for the log message.
+ * \param args The arguments for the format string.
+ * \return The number of bytes to output from the buffer, or 0 if the record does not fit.
+ */
+static int encode_log_entry(struct logger *logger, char *buf, const size_t buf_size,
+                            const enum mulog_log_level level, const char *fmt, va_list args)
+{
+#if defined(MULOG_ENABLE_TIMESTAMP) && MULOG_ENABLE_TIMESTAMP == 1
+    const unsigned long timestamp = mulog_config_mulog_timestamp_get();
+#else
+    const unsigned long timestamp = 0;
+#endif /* MULOG_ENABLE_TIMESTAMP */
+    const int ret = wire_encode_record(buf, buf_size, level, timestamp - logger->ctx.last_timestamp,
+                                       fmt, args);
+
+    if (ret < 0) {
+        return 0;
+    }
+
+    logger->ctx.last_timestamp = timestamp;
+
+    return ret;
+}
+#endif /* MULOG_ENABLE_BINARY_OUTPUT */
+
 // PUBLIC FUNCTION DEFINITIONS
 
-enum mulog_ret_code interface_add_output_default(const mulog_log_output_fn output)
+struct logger *interface_get_logger(const size_t index)
 {
-    return interface_add_output(output, log_ctx.global_level);
+    return index < ARRAY_SIZE(loggers) ? &loggers[index] : NULL;
 }
 
-enum mulog_ret_code interface_add_output(const mulog_log_output_fn output,
+enum mulog_ret_code interface_add_output_default(struct logger *logger,
+                                                 const mulog_log_output_fn output)
+{
+    const enum mulog_log_level level =
+        logger->ctx.global_level_set ? logger->ctx.global_level : MULOG_LOG_LVL_DEBUG;
+
+    return interface_add_output(logger, output, level);
+}
+
+enum mulog_ret_code interface_add_output(struct logger *logger, const mulog_log_output_fn output,
                                          const enum mulog_log_level log_level)
 {
-    if (output == NULL || log_level >= MULOG_LOG_LVL_COUNT) {
+    if (output == NULL) {
         return MULOG_RET_CODE_INVALID_ARG;
     }
 
-    struct out_function *fn = NULL;
+    const struct out_function out = {.output = output, .log_level = log_level};
+
+    return add_out_function(logger, &out);
+}
 
-    for (size_t i = 0; i < ARRAY_SIZE(handles.fns); ++i) {
-        if (LIST_NODE_IS_DANGLING(&handles.fns[i].node)) {
-            fn = &handles.fns[i];
-            break;
-        }
+enum mulog_ret_code interface_add_output_ctx(struct logger *logger,
+                                             const struct mulog_output *output,
+                                             const enum mulog_log_level log_level)
+{
+    if (output == NULL || output->write == NULL) {
+        return MULOG_RET_CODE_INVALID_ARG;
     }
 
-    if (fn == NULL) {
-        return MULOG_RET_CODE_NO_MEM;
+    const struct out_function out = {.ctx_output = *output, .log_level = log_level};
+
+    return add_out_function(logger, &out);
+}
+
+enum mulog_ret_code interface_set_output_registry(struct logger *logger,
+                                                  struct mulog_output_slot *slots,
+                                                  const size_t count)
+{
+    if (slots != NULL && count == 0) {
+        return MULOG_RET_CODE_INVALID_ARG;
     }
 
-    LIST_NODE_INIT(&fn->node);
-    ++handles.out_count;
-    fn->output = output;
-    fn->log_level = log_level;
-    list_head_add(&handles.out_functions, &fn->node);
+    // slots only reserve the space, each of them holds an output function of both snapshots
+    return output_table_set_storage(&logger->outputs, (void *)slots, count);
+}
 
-    return MULOG_RET_CODE_OK;
+enum mulog_ret_code interface_add_output_vec(struct logger *logger,
+                                             const mulog_log_output_vec_fn output,
+                                             const enum mulog_log_level log_level)
+{
+    // log lines are output one at a time as they are logged, there is nothing to batch
+    UNUSED(logger);
+    UNUSED(output);
+    UNUSED(log_level);
+    return MULOG_RET_CODE_UNSUPPORTED;
 }
 
-enum mulog_ret_code interface_set_log_buffer(char *log_buffer, const size_t log_buffer_size)
+enum mulog_ret_code interface_set_log_buffer(struct logger *logger, char *log_buffer,
+                                             const size_t log_buffer_size)
 {
-    log_ctx.log_buffer = log_buffer;
-    log_ctx.log_buffer_size = log_buffer_size;
+    logger->ctx.log_buffer = log_buffer;
+    logger->ctx.log_buffer_size = log_buffer_size;
+#if defined(MULOG_ENABLE_LOCK_DOMAINS) && MULOG_ENABLE_LOCK_DOMAINS == 1
+    logger->ctx.next_half = 0;
+#endif /* MULOG_ENABLE_LOCK_DOMAINS */
 
     return MULOG_RET_CODE_OK;
 }
 
-enum mulog_ret_code interface_set_global_log_level(const enum mulog_log_level log_level)
+enum mulog_ret_code interface_set_priority_log_buffer(struct logger *logger, char *log_buffer,
+                                                      const size_t log_buffer_size)
+{
+    // log lines are not stored, there is nothing to prioritize
+    UNUSED(logger);
+    UNUSED(log_buffer);
+    UNUSED(log_buffer_size);
+    return MULOG_RET_CODE_UNSUPPORTED;
+}
+
+enum mulog_ret_code interface_set_flight_recorder(struct logger *logger, char *log_buffer,
+                                                  const size_t log_buffer_size,
+                                                  const enum mulog_log_level persist_level)
+{
+    // log lines are output from the log call, there is no storage to record them in
+    UNUSED(logger);
+    UNUSED(log_buffer);
+    UNUSED(log_buffer_size);
+    UNUSED(persist_level);
+    return MULOG_RET_CODE_UNSUPPORTED;
+}
+
+int interface_dump_flight_recorder(struct logger *logger)
+{
+    UNUSED(logger);
+    return MULOG_RET_CODE_UNSUPPORTED;
+}
+
+enum mulog_ret_code interface_set_persistent_log_buffer(struct logger *logger, char *log_buffer,
+                                                        const size_t log_buffer_size)
+{
+    // log lines are not stored, there is nothing to recover
+    UNUSED(logger);
+    UNUSED(log_buffer);
+    UNUSED(log_buffer_size);
+    return MULOG_RET_CODE_UNSUPPORTED;
+}
+
+int interface_recover_log(const char *log_buffer, const size_t log_buffer_size,
+                          const mulog_log_output_fn output)
+{
+    UNUSED(log_buffer);
+    UNUSED(log_buffer_size);
+    UNUSED(output);
+    return MULOG_RET_CODE_UNSUPPORTED;
+}
+
+int interface_emergency_flush(const mulog_log_output_fn output, const char *message)
+{
+    // log lines are output from the log call, there is nothing left to flush
+    UNUSED(output);
+    UNUSED(message);
+    return MULOG_RET_CODE_UNSUPPORTED;
+}
+
+enum mulog_ret_code interface_set_global_log_level(struct logger *logger,
+                                                   const enum mulog_log_level log_level)
 {
     if (log_level >= MULOG_LOG_LVL_COUNT) {
         return MULOG_RET_CODE_INVALID_ARG;
     }
 
-    log_ctx.global_level = log_level;
-    set_log_level_for_all_outputs(log_ctx.global_level);
+    const enum mulog_ret_code ret = output_table_set_all_levels(&logger->outputs, log_level);
 
-    return MULOG_RET_CODE_OK;
+    if (ret == MULOG_RET_CODE_OK) {
+        logger->ctx.global_level = log_level;
+        logger->ctx.global_level_set = true;
+        update_min_log_level(logger);
+    }
+
+    return ret;
 }
 
-enum mulog_ret_code interface_set_log_level_per_output(const enum mulog_log_level log_level,
+enum mulog_ret_code interface_set_log_level_per_output(struct logger *logger,
+                                                       const enum mulog_log_level log_level,
                                                        const mulog_log_output_fn output)
 {
     if (log_level >= MULOG_LOG_LVL_COUNT) {
         return MULOG_RET_CODE_INVALID_ARG;
     }
 
-    struct list_node *it;
-
-    LIST_FOR_EACH(it, &handles.out_functions)
-    {
-        struct out_function *fn = LIST_ENTRY(it, struct out_function, node);
+    const enum mulog_ret_code ret = output_table_set_level(&logger->outputs, output, log_level);
 
-        if (fn->output == output) {
-            fn->log_level = log_level;
+    update_min_log_level(logger);
 
-            return MULOG_RET_CODE_OK;
-        }
-    }
-
-    return MULOG_RET_CODE_NOT_FOUND;
+    return ret;
 }
 
-enum mulog_ret_code interface_unregister_output(const mulog_log_output_fn output)
+enum mulog_ret_code interface_unregister_output(struct logger *logger,
+                                                const mulog_log_output_fn output)
 {
-    struct list_node *it = NULL;
+    const struct out_function out = {.output = output};
 
-    LIST_FOR_EACH(it, &handles.out_functions)
-    {
-        const struct out_function *out = LIST_ENTRY(it, struct out_function, node);
+    return output == NULL ? MULOG_RET_CODE_NOT_FOUND : remove_out_function(logger, &out);
+}
 
-        if (out->output == output) {
-            list_head_del(it);
-            --handles.out_count;
-            break;
-        }
-    }
+enum mulog_ret_code interface_unregister_output_ctx(struct logger *logger,
+                                                    const mulog_output_write_fn write,
+                                                    const void *ctx)
+{
+    const struct out_function out = {.ctx_output = {.write = write, .ctx = (void *)ctx}};
 
-    if (it == NULL) {
-        return MULOG_RET_CODE_NOT_FOUND;
-    }
+    return write == NULL ? MULOG_RET_CODE_NOT_FOUND : remove_out_function(logger, &out);
+}
 
-    return MULOG_RET_CODE_OK;
+enum mulog_ret_code interface_unregister_output_vec(struct logger *logger,
+                                                    const mulog_log_output_vec_fn output)
+{
+    UNUSED(logger);
+    UNUSED(output);
+    return MULOG_RET_CODE_UNSUPPORTED;
 }
 
-void interface_unregister_all_outputs(void)
+enum mulog_ret_code interface_unregister_all_outputs(struct logger *logger)
 {
-    struct list_node *it = NULL;
-    struct list_node *temp = NULL;
+    const enum mulog_ret_code ret = output_table_clear(&logger->outputs);
 
-    LIST_FOR_EACH_SAFE(it, temp, &handles.out_functions)
-    {
-        list_head_del(it);
-    }
+    update_min_log_level(logger);
+
+    return ret;
 }
 
-void interface_reset(void)
+void interface_reset(struct logger *logger)
 {
-    handles.out_count = 0;
-    log_ctx.log_buffer = NULL;
-    log_ctx.log_buffer_size = 0;
-    log_ctx.global_level = MULOG_LOG_LVL_DEBUG;
-    LIST_HEAD_INIT(&handles.out_functions);
-
-    for (size_t i = 0; i < ARRAY_SIZE(handles.fns); ++i) {
-        LIST_NODE_INIT(&handles.fns[i].node);
-    }
+    output_table_reset(&logger->outputs);
+    logger->ctx.log_buffer = NULL;
+    logger->ctx.log_buffer_size = 0;
+    logger->ctx.global_level_set = false;
+#if defined(MULOG_ENABLE_BINARY_OUTPUT) && MULOG_ENABLE_BINARY_OUTPUT == 1
+    logger->ctx.last_timestamp = 0;
+#endif /* MULOG_ENABLE_BINARY_OUTPUT */
+#if defined(MULOG_ENABLE_LOCK_DOMAINS) && MULOG_ENABLE_LOCK_DOMAINS == 1
+    logger->ctx.next_half = 0;
+#endif /* MULOG_ENABLE_LOCK_DOMAINS */
+    update_min_log_level(logger);
 }
 
-int interface_log_output(const enum mulog_log_level level, const char *fmt, va_list args)
+int interface_log_output(struct logger *logger, const enum mulog_log_level level, const char *fmt,
+                         va_list args)
 {
-    if (list_head_empty(&handles.out_functions) || log_ctx.log_buffer == NULL ||
-        log_ctx.log_buffer_size == 0 || level >= MULOG_LOG_LVL_COUNT) {
+    if (!is_log_level_accepted(logger, level) || logger->ctx.log_buffer == NULL ||
+        logger->ctx.log_buffer_size == 0) {
         return 0;
     }
 
-    const size_t logger_count = get_num_outputs_above_level(level);
+#if defined(MULOG_ENABLE_BINARY_OUTPUT) && MULOG_ENABLE_BINARY_OUTPUT == 1
+    const int ret =
+        encode_log_entry(logger, logger->ctx.log_buffer, logger->ctx.log_buffer_size, level, fmt,
+                         args);
 
-    if (logger_count == 0) {
-        return 0;
+    if (ret <= 0) {
+        return ret;
     }
-
-    size_t offset = 0;
-    int ret = 0;
-
-    ret = prepend_timestamp(log_ctx.log_buffer, log_ctx.log_buffer_size);
+#else
+    const int ret =
+        format_log_entry(logger->ctx.log_buffer, logger->ctx.log_buffer_size, level, fmt, args);
 
     if (ret < 0) {
         return ret;
     }
+#endif /* MULOG_ENABLE_BINARY_OUTPUT */
 
-    offset += ret;
+    output_log_entry(logger, level, logger->ctx.log_buffer, ret);
 
-    if (log_ctx.log_buffer_size < offset) {
-        offset = (int)log_ctx.log_buffer_size - 1;
-        goto exit;
+    return ret;
+}
+
+enum mulog_ret_code interface_set_thread_log_buffer(char *log_buffer, const size_t log_buffer_size)
+{
+#if defined(MULOG_ENABLE_THREAD_LOG_BUFFER) && MULOG_ENABLE_THREAD_LOG_BUFFER == 1
+    if (log_buffer != NULL && log_buffer_size == 0) {
+        return MULOG_RET_CODE_INVALID_ARG;
     }
 
-    ret = prepend_level(log_ctx.log_buffer + offset, log_ctx.log_buffer_size - offset, level);
+    thread_log_buffer.log_buffer = log_buffer;
+    thread_log_buffer.log_buffer_size = log_buffer == NULL ? 0 : log_buffer_size;
 
-    if (ret < 0) {
-        return ret;
+    return MULOG_RET_CODE_OK;
+#else
+    UNUSED(log_buffer);
+    UNUSED(log_buffer_size);
+    return MULOG_RET_CODE_UNSUPPORTED;
+#endif /* MULOG_ENABLE_THREAD_LOG_BUFFER */
+}
+
+bool interface_has_thread_log_buffer(void)
+{
+#if defined(MULOG_ENABLE_THREAD_LOG_BUFFER) && MULOG_ENABLE_THREAD_LOG_BUFFER == 1
+    return thread_log_buffer.log_buffer != NULL;
+#else
+    return false;
+#endif /* MULOG_ENABLE_THREAD_LOG_BUFFER */
+}
+
+#if defined(MULOG_ENABLE_THREAD_LOG_BUFFER) && MULOG_ENABLE_THREAD_LOG_BUFFER == 1
+int interface_format_thread_log_entry(struct logger *logger, const enum mulog_log_level level,
+                                      const char *fmt, va_list args)
+{
+    // the lowest accepted log level is only a hint here, outputs are checked again for the output
+    if (thread_log_buffer.log_buffer == NULL || !is_log_level_accepted(logger, level)) {
+        return 0;
     }
 
-    offset += ret;
+    return format_log_entry(thread_log_buffer.log_buffer, thread_log_buffer.log_buffer_size, level,
+                            fmt, args);
+}
 
-    if (log_ctx.log_buffer_size < offset) {
-        offset = log_ctx.log_buffer_size - 1;
-        goto exit;
+int interface_output_thread_log_entry(struct logger *logger, const enum mulog_log_level level,
+                                      const size_t size)
+{
+    if (!is_log_level_accepted(logger, level)) {
+        return 0;
     }
 
-    ret = vsnprintf_(log_ctx.log_buffer + offset, log_ctx.log_buffer_size - offset, fmt, args);
+    output_log_entry(logger, level, thread_log_buffer.log_buffer, size);
 
-    if (ret < 0) {
-        return ret;
+    return (int)size;
+}
+#endif /* MULOG_ENABLE_THREAD_LOG_BUFFER */
+
+#if defined(MULOG_ENABLE_NONBLOCKING_LOG) && MULOG_ENABLE_NONBLOCKING_LOG == 1
+int interface_format_log_entry(struct logger *logger, const enum mulog_log_level level, char *buf,
+                               const size_t buf_size, const char *fmt, va_list args)
+{
+    if (!is_log_level_accepted(logger, level)) {
+        return 0;
     }
 
-    offset += ret;
+    return format_log_entry(buf, buf_size, level, fmt, args);
+}
+#endif /* MULOG_ENABLE_NONBLOCKING_LOG */
 
-    if (log_ctx.log_buffer_size < offset) {
-        offset = log_ctx.log_buffer_size - 1;
-        goto exit;
+#if defined(MULOG_ENABLE_LOCK_DOMAINS) && MULOG_ENABLE_LOCK_DOMAINS == 1
+int interface_format_shared_log_entry(struct logger *logger, const enum mulog_log_level level,
+                                      const char *fmt, va_list args, const char **entry)
+{
+    const size_t half_size = logger->ctx.log_buffer_size / 2;
+
+    if (!is_log_level_accepted(logger, level) || logger->ctx.log_buffer == NULL ||
+        half_size == 0) {
+        return 0;
     }
 
-    ret = line_termination(log_ctx.log_buffer + offset, log_ctx.log_buffer_size - offset);
+    char *buf = logger->ctx.log_buffer + logger->ctx.next_half * half_size;
+#if defined(MULOG_ENABLE_BINARY_OUTPUT) && MULOG_ENABLE_BINARY_OUTPUT == 1
+    const int ret = encode_log_entry(logger, buf, half_size, level, fmt, args);
+#else
+    const int ret = format_log_entry(buf, half_size, level, fmt, args);
+#endif /* MULOG_ENABLE_BINARY_OUTPUT */
 
-    if (ret < 0) {
-        return ret;
+    if (ret > 0) {
+        // the next entry is formatted into the other half while this one is passed to the outputs
+        logger->ctx.next_half ^= 1;
+        *entry = buf;
     }
 
-    offset += ret;
+    return ret;
+}
+#endif /* MULOG_ENABLE_LOCK_DOMAINS */
 
-    if (log_ctx.log_buffer_size < offset) {
-        offset = log_ctx.log_buffer_size - 1;
+int interface_output_log_entry(struct logger *logger, const enum mulog_log_level level,
+                               const char *buf, const size_t size)
+{
+    if (!is_log_level_accepted(logger, level)) {
+        return 0;
     }
-exit:
-    output_log_entry(level, log_ctx.log_buffer, offset);
 
-    return (int)offset;
+    output_log_entry(logger, level, buf, size);
+
+    return (int)size;
+}
+
+size_t interface_get_dropped_count(struct logger *logger)
+{
+    UNUSED(logger);
+    return 0;
+}
+
+size_t interface_get_level_dropped_count(struct logger *logger, const enum mulog_log_level level)
+{
+    UNUSED(logger);
+    UNUSED(level);
+    return 0;
+}
+
+enum mulog_ret_code interface_set_overflow_policy(struct logger *logger,
+                                                  const enum mulog_overflow_policy policy,
+                                                  const size_t spin_limit)
+{
+    UNUSED(logger);
+    UNUSED(policy);
+    UNUSED(spin_limit);
+    return MULOG_RET_CODE_UNSUPPORTED;
+}
+
+bool interface_is_deferred_log_locked(struct logger *logger)
+{
+    UNUSED(logger);
+    return false;
 }
 
-int interface_deferred_log(void)
+size_t interface_get_deferred_usage(struct logger *logger)
 {
+    UNUSED(logger);
+    return 0;
+}
+
+int interface_deferred_log(struct logger *logger, const struct mulog_process_budget *budget)
+{
+    UNUSED(logger);
+    UNUSED(budget);
+
     return MULOG_RET_CODE_UNSUPPORTED;
 }
@@ -16,3 +16,26 @@ bool mulog_config_mulog_lock(void)
 void mulog_config_mulog_unlock(void)
 {
 }
+
+bool mulog_config_mulog_trylock(void)
+{
+    return true;
+}
+
+bool mulog_config_mulog_format_lock(void)
+{
+    return true;
+}
+
+void mulog_config_mulog_format_unlock(void)
+{
+}
+
+bool mulog_config_mulog_output_lock(void)
+{
+    return true;
+}
+
+void mulog_config_mulog_output_unlock(void)
+{
+}
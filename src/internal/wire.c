@@ -0,0 +1,110 @@
+/**
+ * \file
+ * \brief Binary log record wire format implementation
+ * \author Vladimir Petrigo
+ */
+
+#include "internal/wire.h"
+#include "internal/args.h"
+
+#include <stdint.h>
+
+const char mulog_wire_anchor[] = "mulog";
+
+int64_t wire_fmt_id(const char *fmt)
+{
+    return (int64_t)((uintptr_t)fmt - (uintptr_t)mulog_wire_anchor);
+}
+
+int wire_encode_record(void *buf, const size_t buf_size, const enum mulog_log_level level,
+                       const unsigned long timestamp_delta, const char *fmt, va_list args)
+{
+    unsigned char *out = buf;
+    size_t offset = WIRE_RECORD_LENGTH_SIZE;
+    size_t size;
+
+    if (buf_size <= offset) {
+        return -1;
+    }
+
+    out[offset++] = (unsigned char)level;
+    size = wire_put_varint(out + offset, buf_size - offset, timestamp_delta);
+
+    if (size == 0) {
+        return -1;
+    }
+
+    offset += size;
+    size = wire_put_varint(out + offset, buf_size - offset, wire_zigzag_encode(wire_fmt_id(fmt)));
+
+    if (size == 0) {
+        return -1;
+    }
+
+    offset += size;
+
+    const int args_size = args_encode(out + offset, buf_size - offset, fmt, args);
+
+    if (args_size < 0) {
+        return args_size;
+    }
+
+    offset += (size_t)args_size;
+
+    const size_t payload_size = offset - WIRE_RECORD_LENGTH_SIZE;
+
+    if (payload_size > UINT16_MAX) {
+        return -1;
+    }
+
+    out[0] = (unsigned char)(payload_size & 0xFFU);
+    out[1] = (unsigned char)(payload_size >> 8);
+
+    return (int)offset;
+}
+
+int wire_decode_record(const void *buf, const size_t buf_size, struct wire_record *record)
+{
+    const unsigned char *in = buf;
+
+    if (buf_size < WIRE_RECORD_LENGTH_SIZE) {
+        return 0;
+    }
+
+    const size_t payload_size = (size_t)in[0] | ((size_t)in[1] << 8);
+    const size_t record_size = WIRE_RECORD_LENGTH_SIZE + payload_size;
+
+    if (buf_size < record_size) {
+        return 0;
+    }
+
+    size_t offset = WIRE_RECORD_LENGTH_SIZE;
+    uint64_t value;
+    size_t size;
+
+    if (payload_size == 0 || in[offset] >= MULOG_LOG_LVL_COUNT) {
+        return -1;
+    }
+
+    record->level = (enum mulog_log_level)in[offset++];
+    size = wire_get_varint(in + offset, record_size - offset, &value);
+
+    if (size == 0) {
+        return -1;
+    }
+
+    offset += size;
+    record->timestamp_delta = (unsigned long)value;
+    size = wire_get_varint(in + offset, record_size - offset, &value);
+
+    if (size == 0) {
+        return -1;
+    }
+
+    offset += size;
+    record->fmt_id = wire_zigzag_decode(value);
+    record->args = in + offset;
+    record->args_size = record_size - offset;
+
+    return (int)record_size;
+}
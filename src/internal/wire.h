@@ -0,0 +1,160 @@
+/**
+ * \file
+ * \brief Binary log record wire format
+ * \author Vladimir Petrigo
+ */
+
+#ifndef WIRE_H
+#define WIRE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "mulog.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * \brief Size of the record length field
+ */
+#define WIRE_RECORD_LENGTH_SIZE 2
+
+/**
+ * \brief Maximum size of a variable length integer
+ */
+#define WIRE_VARINT_MAX_SIZE 10
+
+/**
+ * \brief Decoded binary log record
+ *
+ * A record on the wire consists of:
+ * - payload length, 16-bit little endian, not counting the length field itself
+ * - log level, 1 byte
+ * - timestamp delta from the previous record in milliseconds, variable length integer
+ * - format string ID, zigzag encoded variable length integer
+ * - format arguments encoded with args_encode()
+ */
+struct wire_record {
+    enum mulog_log_level level;    /**< Log level of the record */
+    unsigned long timestamp_delta; /**< Milliseconds elapsed since the previous record */
+    int64_t fmt_id;                /**< Format string ID, see wire_fmt_id() */
+    const unsigned char *args;     /**< Encoded format arguments */
+    size_t args_size;              /**< Size of the encoded format arguments in bytes */
+};
+
+/**
+ * \brief Anchor the format string IDs are relative to
+ *
+ * The ID of a format string is its offset from this object within the program image, so the
+ * host decoder can find the format string in the program ELF file regardless of the load address.
+ */
+extern const char mulog_wire_anchor[];
+
+/**
+ * \brief Encodes a value as a little endian base 128 variable length integer.
+ *
+ * \param buf Buffer to store the value to
+ * \param buf_size Size of the buffer in bytes
+ * \param value Value to encode
+ * \return Number of bytes stored, or 0 if the value does not fit into the buffer
+ */
+static inline size_t wire_put_varint(unsigned char *buf, const size_t buf_size, uint64_t value)
+{
+    size_t size = 0;
+
+    do {
+        if (size == buf_size) {
+            return 0;
+        }
+
+        buf[size++] = (unsigned char)((value & 0x7FU) | (value > 0x7FU ? 0x80U : 0U));
+        value >>= 7;
+    } while (value != 0);
+
+    return size;
+}
+
+/**
+ * \brief Decodes a little endian base 128 variable length integer.
+ *
+ * \param buf Buffer to load the value from
+ * \param buf_size Size of the buffer in bytes
+ * \param[out] value Decoded value
+ * \return Number of bytes consumed, or 0 if the buffer does not contain a complete value
+ */
+static inline size_t wire_get_varint(const unsigned char *buf, const size_t buf_size,
+                                     uint64_t *value)
+{
+    uint64_t result = 0;
+
+    for (size_t i = 0; i < buf_size && i < WIRE_VARINT_MAX_SIZE; ++i) {
+        result |= (uint64_t)(buf[i] & 0x7FU) << (7 * i);
+
+        if ((buf[i] & 0x80U) == 0) {
+            *value = result;
+
+            return i + 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Maps a signed value to an unsigned one, so small negative values stay short.
+ */
+static inline uint64_t wire_zigzag_encode(const int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+/**
+ * \brief Restores a signed value mapped with wire_zigzag_encode().
+ */
+static inline int64_t wire_zigzag_decode(const uint64_t value)
+{
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1U);
+}
+
+/**
+ * \brief Gets the ID of a format string.
+ *
+ * \param fmt Format string, must be a part of the program image (e.g. a string literal)
+ * \return Format string ID
+ */
+int64_t wire_fmt_id(const char *fmt);
+
+/**
+ * \brief Encodes a log record.
+ *
+ * \param buf Buffer to encode the record to
+ * \param buf_size Size of the buffer in bytes
+ * \param level Log level of the record
+ * \param timestamp_delta Milliseconds elapsed since the previous record
+ * \param fmt The format string
+ * \param args The arguments for the format string
+ * \return Size of the encoded record in bytes, or a negative value if the record does not fit
+ *         into the buffer
+ */
+int wire_encode_record(void *buf, size_t buf_size, enum mulog_log_level level,
+                       unsigned long timestamp_delta, const char *fmt, va_list args);
+
+/**
+ * \brief Decodes a log record from the beginning of a byte stream.
+ *
+ * \param buf Byte stream
+ * \param buf_size Size of the byte stream in bytes
+ * \param[out] record Decoded record, refers to the byte stream data
+ * \return Size of the decoded record in bytes, 0 if the stream does not contain a complete record
+ *         yet, or a negative value if the record is malformed
+ */
+int wire_decode_record(const void *buf, size_t buf_size, struct wire_record *record);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WIRE_H */
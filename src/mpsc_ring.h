@@ -0,0 +1,497 @@
+/**
+ * \file
+ * \brief Lock-free multi-producer single-consumer record ring interface implementation
+ * \author Vladimir Petrigo
+ */
+
+#ifndef MPSC_RING_H
+#define MPSC_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * \brief Record header flag: record has been committed by a producer
+ */
+#define MPSC_RING_FLAG_READY ((uint32_t)1U << 31)
+
+/**
+ * \brief Record header flag: record carries no payload for the consumer (padding or aborted
+ * reservation) and must be skipped
+ */
+#define MPSC_RING_FLAG_DISCARD ((uint32_t)1U << 30)
+
+/**
+ * \brief Record header flag: record has been reserved, but is still being filled by a producer, the
+ * header keeps the reserved length
+ */
+#define MPSC_RING_FLAG_BUSY ((uint32_t)1U << 29)
+
+/**
+ * \brief Record header mask for the record length
+ */
+#define MPSC_RING_LEN_MASK (MPSC_RING_FLAG_BUSY - 1U)
+
+/**
+ * \brief Record header size in bytes
+ */
+#define MPSC_RING_HDR_SIZE (sizeof(uint32_t))
+
+/**
+ * \brief Size alignment of every record slot in the ring
+ */
+#define MPSC_RING_ALIGN (sizeof(uint32_t))
+
+/**
+ * \brief Multi-producer single-consumer ring of variable size records
+ *
+ * Producers reserve a whole record with a single CAS on the write position, fill the reserved
+ * slot in parallel and publish it by storing its header. A single consumer takes committed records
+ * in reservation order. Positions are kept in the [0, 2 * size) range to distinguish between
+ * an empty and a full ring without wasting storage.
+ *
+ * Free space is kept zeroed by the consumer, so a record header reads as 0 until the producer marks
+ * the record as busy right after its reservation.
+ */
+struct mpsc_ring {
+    unsigned char *buf; /**< Ring storage aligned to MPSC_RING_ALIGN */
+    size_t size;        /**< Usable ring storage size, multiple of MPSC_RING_ALIGN */
+    size_t head;        /**< Producers reservation position */
+    size_t tail;        /**< Consumer position */
+    size_t released;    /**< Consumer release position, ahead of tail while records are zeroed */
+};
+
+/**
+ * \brief Reservation made by a producer
+ */
+struct mpsc_ring_reservation {
+    unsigned char *data; /**< Reserved payload storage */
+    size_t size;         /**< Reserved payload size */
+};
+
+static inline size_t mpsc_ring_align(const size_t size)
+{
+    return (size + MPSC_RING_ALIGN - 1) & ~(MPSC_RING_ALIGN - 1);
+}
+
+static inline size_t mpsc_ring_offset(const struct mpsc_ring *ring, const size_t pos)
+{
+    return pos < ring->size ? pos : pos - ring->size;
+}
+
+static inline size_t mpsc_ring_used(const struct mpsc_ring *ring, const size_t head,
+                                    const size_t tail)
+{
+    return head >= tail ? head - tail : 2 * ring->size - tail + head;
+}
+
+static inline size_t mpsc_ring_advance(const struct mpsc_ring *ring, const size_t pos,
+                                       const size_t len)
+{
+    const size_t next = pos + len;
+
+    return next >= 2 * ring->size ? next - 2 * ring->size : next;
+}
+
+static inline uint32_t *mpsc_ring_header(const struct mpsc_ring *ring, const size_t pos)
+{
+    return (uint32_t *)(void *)(ring->buf + mpsc_ring_offset(ring, pos));
+}
+
+/**
+ * \brief Initialize a ring over the given storage
+ *
+ * \param ring Ring to initialize
+ * \param buf Ring storage
+ * \param size Ring storage size in bytes
+ * \return true if the ring has been initialized, false if the storage is too small to hold any
+ *         record
+ */
+static inline bool mpsc_ring_init(struct mpsc_ring *ring, void *buf, const size_t size)
+{
+    ring->buf = NULL;
+    ring->size = 0;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->released = 0;
+
+    if (buf == NULL) {
+        return false;
+    }
+
+    const uintptr_t addr = (uintptr_t)buf;
+    const size_t skip = mpsc_ring_align(addr) - addr;
+
+    if (size < skip + 2 * MPSC_RING_ALIGN) {
+        return false;
+    }
+
+    ring->buf = (unsigned char *)buf + skip;
+    ring->size = (size - skip) & ~(MPSC_RING_ALIGN - 1);
+    memset(ring->buf, 0, ring->size);
+
+    return true;
+}
+
+/**
+ * \brief Check whether the ring has storage assigned
+ *
+ * \param ring Ring to check
+ * \return true if the ring is ready to be used, false otherwise
+ */
+static inline bool mpsc_ring_is_ready(const struct mpsc_ring *ring)
+{
+    return ring->buf != NULL;
+}
+
+/**
+ * \brief Drop all ring content
+ *
+ * \warning Must not be called concurrently with producers or the consumer
+ * \param ring Ring to reset
+ */
+static inline void mpsc_ring_reset(struct mpsc_ring *ring)
+{
+    if (ring->buf != NULL) {
+        memset(ring->buf, 0, ring->size);
+    }
+
+    ring->head = 0;
+    ring->tail = 0;
+    ring->released = 0;
+}
+
+/**
+ * \brief Detach the ring from its storage
+ *
+ * \warning Must not be called concurrently with producers or the consumer
+ * \param ring Ring to detach
+ */
+static inline void mpsc_ring_free(struct mpsc_ring *ring)
+{
+    ring->buf = NULL;
+    ring->size = 0;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->released = 0;
+}
+
+/**
+ * \brief Get amount of the ring storage in use, including record headers and padding
+ *
+ * \param ring Ring to check
+ * \return Number of bytes in use
+ */
+static inline size_t mpsc_ring_get_full(const struct mpsc_ring *ring)
+{
+    const size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    const size_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+    return mpsc_ring_used(ring, head, tail);
+}
+
+/**
+ * \brief Reserve a contiguous record in the ring
+ *
+ * Safe to call from multiple producers concurrently. Each successful reservation must be followed
+ * by either mpsc_ring_commit() or mpsc_ring_abort(), otherwise the consumer stalls at that record.
+ *
+ * \param ring Ring to reserve record in
+ * \param size Record payload size
+ * \param[out] reservation Reserved record
+ * \return true if the record has been reserved, false if there is not enough free space
+ */
+static inline bool mpsc_ring_reserve(struct mpsc_ring *ring, const size_t size,
+                                     struct mpsc_ring_reservation *reservation)
+{
+    if (ring->buf == NULL || size > MPSC_RING_LEN_MASK) {
+        return false;
+    }
+
+    const size_t total = mpsc_ring_align(MPSC_RING_HDR_SIZE + size);
+    size_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    size_t pad;
+    size_t need;
+
+    do {
+        const size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        const size_t contiguous = ring->size - mpsc_ring_offset(ring, head);
+
+        pad = contiguous < total ? contiguous : 0;
+        need = pad + total;
+
+        if (need > ring->size - mpsc_ring_used(ring, head, tail)) {
+            return false;
+        }
+    } while (!__atomic_compare_exchange_n(&ring->head, &head, mpsc_ring_advance(ring, head, need),
+                                          true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+
+    if (pad != 0) {
+        __atomic_store_n(mpsc_ring_header(ring, head),
+                         MPSC_RING_FLAG_READY | MPSC_RING_FLAG_DISCARD |
+                             (uint32_t)(pad - MPSC_RING_HDR_SIZE),
+                         __ATOMIC_RELEASE);
+        head = mpsc_ring_advance(ring, head, pad);
+    }
+
+    // readers that do not wait for the record skip it by the reserved length
+    __atomic_store_n(mpsc_ring_header(ring, head), MPSC_RING_FLAG_BUSY | (uint32_t)size,
+                     __ATOMIC_RELAXED);
+    // the header must not be stored after the payload written by an interrupted producer
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    reservation->data = ring->buf + mpsc_ring_offset(ring, head) + MPSC_RING_HDR_SIZE;
+    reservation->size = size;
+
+    return true;
+}
+
+/**
+ * \brief Publish a reserved record to the consumer
+ *
+ * A record may be committed with a size smaller than reserved, the unused tail of the slot is
+ * turned into a padding record.
+ *
+ * \param reservation Record reserved with mpsc_ring_reserve()
+ * \param size Actual record payload size, must not exceed the reserved size
+ */
+static inline void mpsc_ring_commit(const struct mpsc_ring_reservation *reservation,
+                                    const size_t size)
+{
+    const size_t len = size < reservation->size ? size : reservation->size;
+    const size_t reserved_total = mpsc_ring_align(MPSC_RING_HDR_SIZE + reservation->size);
+    const size_t total = mpsc_ring_align(MPSC_RING_HDR_SIZE + len);
+
+    if (reserved_total != total) {
+        unsigned char *pad = reservation->data - MPSC_RING_HDR_SIZE + total;
+
+        __atomic_store_n((uint32_t *)(void *)pad,
+                         MPSC_RING_FLAG_READY | MPSC_RING_FLAG_DISCARD |
+                             (uint32_t)(reserved_total - total - MPSC_RING_HDR_SIZE),
+                         __ATOMIC_RELAXED);
+    }
+
+    __atomic_store_n((uint32_t *)(void *)(reservation->data - MPSC_RING_HDR_SIZE),
+                     MPSC_RING_FLAG_READY | (uint32_t)len, __ATOMIC_RELEASE);
+}
+
+/**
+ * \brief Give up a reserved record, the consumer will skip it
+ *
+ * \param reservation Record reserved with mpsc_ring_reserve()
+ */
+static inline void mpsc_ring_abort(const struct mpsc_ring_reservation *reservation)
+{
+    __atomic_store_n((uint32_t *)(void *)(reservation->data - MPSC_RING_HDR_SIZE),
+                     MPSC_RING_FLAG_READY | MPSC_RING_FLAG_DISCARD | (uint32_t)reservation->size,
+                     __ATOMIC_RELEASE);
+}
+/**
+ * \brief Get the oldest committed record
+ *
+ * Padding and aborted records in front of the oldest committed record are released on the way.
+ *
+ * \warning Must be called by a single consumer only
+ * \param ring Ring to get record from
+ * \param[out] size Record payload size
+ * \return Pointer to the record payload or NULL if there is no committed record. The payload
+ *         remains valid until mpsc_ring_release() is called.
+ */
+static inline const void *mpsc_ring_peek(struct mpsc_ring *ring, size_t *size)
+{
+    if (ring->buf == NULL) {
+        return NULL;
+    }
+
+    size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+
+    for (;;) {
+        uint32_t *header = mpsc_ring_header(ring, tail);
+        const uint32_t value = __atomic_load_n(header, __ATOMIC_ACQUIRE);
+
+        if ((value & MPSC_RING_FLAG_READY) == 0) {
+            return NULL;
+        }
+
+        if ((value & MPSC_RING_FLAG_DISCARD) == 0) {
+            *size = value & MPSC_RING_LEN_MASK;
+
+            return header + 1;
+        }
+
+        const size_t total = mpsc_ring_align(MPSC_RING_HDR_SIZE + (value & MPSC_RING_LEN_MASK));
+
+        tail = mpsc_ring_advance(ring, tail, total);
+        __atomic_store_n(&ring->released, tail, __ATOMIC_RELEASE);
+        memset(header, 0, total);
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * \brief Release the record obtained with mpsc_ring_peek() and return its storage to producers
+ *
+ * \warning Must be called by a single consumer only
+ * \param ring Ring to release record in
+ */
+static inline void mpsc_ring_release(struct mpsc_ring *ring)
+{
+    const size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    uint32_t *header = mpsc_ring_header(ring, tail);
+    const uint32_t value = __atomic_load_n(header, __ATOMIC_RELAXED);
+
+    if ((value & MPSC_RING_FLAG_READY) == 0) {
+        return;
+    }
+
+    const size_t total = mpsc_ring_align(MPSC_RING_HDR_SIZE + (value & MPSC_RING_LEN_MASK));
+    const size_t next = mpsc_ring_advance(ring, tail, total);
+
+    __atomic_store_n(&ring->released, next, __ATOMIC_RELEASE);
+    memset(header, 0, total);
+    __atomic_store_n(&ring->tail, next, __ATOMIC_RELEASE);
+}
+
+/**
+ * \brief Get the committed record at the given position without releasing records in front of it
+ *
+ * Lets the consumer take several records in a row and return their storage at once with
+ * mpsc_ring_release_to(). Padding and aborted records are skipped, but not released.
+ *
+ * \warning Must be called by a single consumer only
+ * \param ring Ring to get record from
+ * \param[in,out] pos Position to look the record up at, the consumer position for the first
+ *                    record. Set past the returned record.
+ * \param[out] size Record payload size
+ * \return Pointer to the record payload or NULL if there is no committed record at the position.
+ *         The payload remains valid until it is released with mpsc_ring_release_to().
+ */
+static inline const void *mpsc_ring_peek_at(struct mpsc_ring *ring, size_t *pos, size_t *size)
+{
+    if (ring->buf == NULL) {
+        return NULL;
+    }
+
+    size_t next = *pos;
+
+    for (;;) {
+        // a full ring wraps the position back to the oldest record that is still in use
+        if (next == __atomic_load_n(&ring->head, __ATOMIC_RELAXED)) {
+            return NULL;
+        }
+
+        uint32_t *header = mpsc_ring_header(ring, next);
+        const uint32_t value = __atomic_load_n(header, __ATOMIC_ACQUIRE);
+
+        if ((value & MPSC_RING_FLAG_READY) == 0) {
+            return NULL;
+        }
+
+        const size_t total = mpsc_ring_align(MPSC_RING_HDR_SIZE + (value & MPSC_RING_LEN_MASK));
+
+        next = mpsc_ring_advance(ring, next, total);
+
+        if ((value & MPSC_RING_FLAG_DISCARD) == 0) {
+            *pos = next;
+            *size = value & MPSC_RING_LEN_MASK;
+
+            return header + 1;
+        }
+    }
+}
+
+/**
+ * \brief Release all records in front of the given position and return their storage to producers
+ *
+ * \warning Must be called by a single consumer only
+ * \param ring Ring to release records in
+ * \param pos Position updated by mpsc_ring_peek_at()
+ */
+static inline void mpsc_ring_release_to(struct mpsc_ring *ring, const size_t pos)
+{
+    size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+
+    // the tail can not be moved before the records are zeroed, producers would reuse them
+    __atomic_store_n(&ring->released, pos, __ATOMIC_RELEASE);
+
+    while (tail != pos) {
+        uint32_t *header = mpsc_ring_header(ring, tail);
+        const uint32_t value = __atomic_load_n(header, __ATOMIC_RELAXED);
+        const size_t total = mpsc_ring_align(MPSC_RING_HDR_SIZE + (value & MPSC_RING_LEN_MASK));
+
+        memset(header, 0, total);
+        tail = mpsc_ring_advance(ring, tail, total);
+    }
+
+    __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+}
+
+/**
+ * \brief Get the position of the oldest record that is not being released by the consumer
+ *
+ * \param ring Ring to check
+ * \return Position to start mpsc_ring_scan_at() from
+ */
+static inline size_t mpsc_ring_get_read_pos(const struct mpsc_ring *ring)
+{
+    return __atomic_load_n(&ring->released, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * \brief Get the committed record at the given position without waiting for records in front of it
+ *
+ * Unlike mpsc_ring_peek_at(), records that are still being filled by producers are skipped, so the
+ * function may interrupt a producer or the consumer, e.g. to pass the records to a crash handler.
+ * Records are neither released nor modified. The lookup stops at a record that has been reserved,
+ * but not marked as busy yet, which only lasts for a few instructions of mpsc_ring_reserve().
+ *
+ * \param ring Ring to get record from
+ * \param[in,out] pos Position to look the record up at, mpsc_ring_get_read_pos() for the first
+ *                    record. Set past the returned record.
+ * \param[out] size Record payload size
+ * \return Pointer to the record payload or NULL if there are no more committed records
+ */
+static inline const void *mpsc_ring_scan_at(const struct mpsc_ring *ring, size_t *pos,
+                                            size_t *size)
+{
+    if (ring->buf == NULL) {
+        return NULL;
+    }
+
+    size_t next = *pos;
+
+    for (;;) {
+        if (next == __atomic_load_n(&ring->head, __ATOMIC_RELAXED)) {
+            return NULL;
+        }
+
+        const uint32_t value = __atomic_load_n(mpsc_ring_header(ring, next), __ATOMIC_ACQUIRE);
+
+        if (value == 0) {
+            return NULL;
+        }
+
+        const size_t total = mpsc_ring_align(MPSC_RING_HDR_SIZE + (value & MPSC_RING_LEN_MASK));
+        const uint32_t *header = mpsc_ring_header(ring, next);
+
+        next = mpsc_ring_advance(ring, next, total);
+
+        if ((value & (MPSC_RING_FLAG_READY | MPSC_RING_FLAG_DISCARD)) == MPSC_RING_FLAG_READY) {
+            *pos = next;
+            *size = value & MPSC_RING_LEN_MASK;
+
+            return header + 1;
+        }
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MPSC_RING_H */
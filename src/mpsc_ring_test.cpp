@@ -0,0 +1,368 @@
+/**
+ * \file
+ * \brief Lock-free multi-producer single-consumer ring tests
+ * \author Vladimir Petrigo
+ */
+#include "mpsc_ring.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+    bool push(mpsc_ring &ring, const std::string_view record)
+    {
+        mpsc_ring_reservation reservation{};
+
+        if (!mpsc_ring_reserve(&ring, record.size(), &reservation)) {
+            return false;
+        }
+
+        std::memcpy(reservation.data, record.data(), record.size());
+        mpsc_ring_commit(&reservation, record.size());
+
+        return true;
+    }
+
+    std::string_view peek(mpsc_ring &ring)
+    {
+        size_t size = 0;
+        const auto *data = static_cast<const char *>(mpsc_ring_peek(&ring, &size));
+
+        return data == nullptr ? std::string_view{} : std::string_view{data, size};
+    }
+} // namespace
+
+TEST_CASE("MpscRingTests - InvalidStorage", "[mpsc_ring]")
+{
+    alignas(uint32_t) std::array<unsigned char, 4> small{};
+    mpsc_ring ring{};
+
+    REQUIRE_FALSE(mpsc_ring_init(&ring, nullptr, 128));
+    REQUIRE_FALSE(mpsc_ring_is_ready(&ring));
+    REQUIRE_FALSE(mpsc_ring_init(&ring, small.data(), small.size()));
+    REQUIRE_FALSE(mpsc_ring_is_ready(&ring));
+
+    mpsc_ring_reservation reservation{};
+    size_t size = 0;
+
+    REQUIRE_FALSE(mpsc_ring_reserve(&ring, 1, &reservation));
+    REQUIRE(nullptr == mpsc_ring_peek(&ring, &size));
+}
+
+TEST_CASE("MpscRingTests - UnalignedStorage", "[mpsc_ring]")
+{
+    alignas(uint32_t) std::array<unsigned char, 67> storage{};
+    mpsc_ring ring{};
+
+    REQUIRE(mpsc_ring_init(&ring, storage.data() + 1, storage.size() - 1));
+    REQUIRE(0 == reinterpret_cast<uintptr_t>(ring.buf) % MPSC_RING_ALIGN);
+    REQUIRE(0 == ring.size % MPSC_RING_ALIGN);
+    REQUIRE(ring.size <= storage.size() - 1);
+    REQUIRE(push(ring, "abc"));
+    REQUIRE("abc" == peek(ring));
+}
+
+TEST_CASE("MpscRingTests - SingleRecord", "[mpsc_ring]")
+{
+    alignas(uint32_t) std::array<unsigned char, 64> storage{};
+    mpsc_ring ring{};
+
+    REQUIRE(mpsc_ring_init(&ring, storage.data(), storage.size()));
+    REQUIRE(peek(ring).empty());
+    REQUIRE(0 == mpsc_ring_get_full(&ring));
+    REQUIRE(push(ring, "Hello"));
+    REQUIRE(mpsc_ring_align(MPSC_RING_HDR_SIZE + 5) == mpsc_ring_get_full(&ring));
+    REQUIRE("Hello" == peek(ring));
+    // peek does not consume the record
+    REQUIRE("Hello" == peek(ring));
+    mpsc_ring_release(&ring);
+    REQUIRE(peek(ring).empty());
+    REQUIRE(0 == mpsc_ring_get_full(&ring));
+}
+
+TEST_CASE("MpscRingTests - Full", "[mpsc_ring]")
+{
+    alignas(uint32_t) std::array<unsigned char, 32> storage{};
+    mpsc_ring ring{};
+
+    REQUIRE(mpsc_ring_init(&ring, storage.data(), storage.size()));
+    // each record occupies a header and 4 bytes of payload
+    for (size_t i = 0; i < storage.size() / 8; ++i) {
+        REQUIRE(push(ring, "1234"));
+    }
+
+    REQUIRE(storage.size() == mpsc_ring_get_full(&ring));
+    REQUIRE_FALSE(push(ring, "1"));
+    REQUIRE_FALSE(push(ring, ""));
+    REQUIRE("1234" == peek(ring));
+    mpsc_ring_release(&ring);
+    REQUIRE(push(ring, "5678"));
+    REQUIRE_FALSE(push(ring, "9"));
+}
+
+TEST_CASE("MpscRingTests - TooLargeRecord", "[mpsc_ring]")
+{
+    alignas(uint32_t) std::array<unsigned char, 32> storage{};
+    const std::string large(storage.size(), 'a');
+    mpsc_ring ring{};
+
+    REQUIRE(mpsc_ring_init(&ring, storage.data(), storage.size()));
+    REQUIRE_FALSE(push(ring, large));
+    REQUIRE(push(ring, std::string_view{large}.substr(0, storage.size() - MPSC_RING_HDR_SIZE)));
+    REQUIRE(large.substr(0, storage.size() - MPSC_RING_HDR_SIZE) == peek(ring));
+}
+
+TEST_CASE("MpscRingTests - WrapAround", "[mpsc_ring]")
+{
+    alignas(uint32_t) std::array<unsigned char, 32> storage{};
+    mpsc_ring ring{};
+
+    REQUIRE(mpsc_ring_init(&ring, storage.data(), storage.size()));
+    REQUIRE(push(ring, "0123456789"));
+    REQUIRE(push(ring, "abc"));
+    REQUIRE("0123456789" == peek(ring));
+    mpsc_ring_release(&ring);
+    // the last 8 bytes of the storage are too small for the record, they are turned into padding
+    // and the record is placed at the beginning of the storage
+    REQUIRE(push(ring, "0123456789"));
+    REQUIRE("abc" == peek(ring));
+    mpsc_ring_release(&ring);
+    REQUIRE("0123456789" == peek(ring));
+    mpsc_ring_release(&ring);
+    REQUIRE(peek(ring).empty());
+    REQUIRE(0 == mpsc_ring_get_full(&ring));
+
+    for (size_t i = 0; i < 100; ++i) {
+        const auto record = std::to_string(i * 997);
+
+        REQUIRE(push(ring, record));
+        REQUIRE(record == peek(ring));
+        mpsc_ring_release(&ring);
+    }
+}
+
+TEST_CASE("MpscRingTests - UncommittedRecordBlocksConsumer", "[mpsc_ring]")
+{
+    alignas(uint32_t) std::array<unsigned char, 64> storage{};
+    mpsc_ring ring{};
+    mpsc_ring_reservation first{};
+    mpsc_ring_reservation second{};
+
+    REQUIRE(mpsc_ring_init(&ring, storage.data(), storage.size()));
+    REQUIRE(mpsc_ring_reserve(&ring, 3, &first));
+    REQUIRE(mpsc_ring_reserve(&ring, 3, &second));
+    std::memcpy(second.data, "def", 3);
+    mpsc_ring_commit(&second, 3);
+    REQUIRE(peek(ring).empty());
+    std::memcpy(first.data, "abc", 3);
+    mpsc_ring_commit(&first, 3);
+    REQUIRE("abc" == peek(ring));
+    mpsc_ring_release(&ring);
+    REQUIRE("def" == peek(ring));
+}
+
+TEST_CASE("MpscRingTests - AbortAndShrink", "[mpsc_ring]")
+{
+    alignas(uint32_t) std::array<unsigned char, 64> storage{};
+    mpsc_ring ring{};
+    mpsc_ring_reservation aborted{};
+    mpsc_ring_reservation shrunk{};
+
+    REQUIRE(mpsc_ring_init(&ring, storage.data(), storage.size()));
+    REQUIRE(mpsc_ring_reserve(&ring, 8, &aborted));
+    REQUIRE(mpsc_ring_reserve(&ring, 16, &shrunk));
+    REQUIRE(push(ring, "tail"));
+    mpsc_ring_abort(&aborted);
+    std::memcpy(shrunk.data, "ab", 2);
+    mpsc_ring_commit(&shrunk, 2);
+    REQUIRE("ab" == peek(ring));
+    mpsc_ring_release(&ring);
+    REQUIRE("tail" == peek(ring));
+    mpsc_ring_release(&ring);
+    REQUIRE(peek(ring).empty());
+    REQUIRE(0 == mpsc_ring_get_full(&ring));
+}
+
+TEST_CASE("MpscRingTests - Reset", "[mpsc_ring]")
+{
+    alignas(uint32_t) std::array<unsigned char, 64> storage{};
+    mpsc_ring ring{};
+
+    REQUIRE(mpsc_ring_init(&ring, storage.data(), storage.size()));
+    REQUIRE(push(ring, "abc"));
+    mpsc_ring_reset(&ring);
+    REQUIRE(peek(ring).empty());
+    REQUIRE(push(ring, "def"));
+    REQUIRE("def" == peek(ring));
+    mpsc_ring_free(&ring);
+    REQUIRE_FALSE(mpsc_ring_is_ready(&ring));
+    REQUIRE_FALSE(push(ring, "abc"));
+}
+
+TEST_CASE("MpscRingTests - PeekAtAndReleaseTo", "[mpsc_ring]")
+{
+    alignas(uint32_t) std::array<unsigned char, 32> storage{};
+    mpsc_ring ring{};
+    mpsc_ring_reservation aborted{};
+
+    const auto peek_at = [&ring](size_t &pos) {
+        size_t size = 0;
+        const auto *data = static_cast<const char *>(mpsc_ring_peek_at(&ring, &pos, &size));
+
+        return data == nullptr ? std::string_view{} : std::string_view{data, size};
+    };
+
+    REQUIRE(mpsc_ring_init(&ring, storage.data(), storage.size()));
+
+    // every record takes 8 bytes, the ring is completely full
+    for (const auto *record : {"0123", "4567", "89ab", "cdef"}) {
+        REQUIRE(push(ring, record));
+    }
+
+    size_t pos = ring.tail;
+
+    for (const auto *record : {"0123", "4567", "89ab", "cdef"}) {
+        REQUIRE(record == peek_at(pos));
+    }
+
+    REQUIRE(peek_at(pos).empty());
+    REQUIRE(storage.size() == mpsc_ring_get_full(&ring));
+    mpsc_ring_release_to(&ring, pos);
+    REQUIRE(0 == mpsc_ring_get_full(&ring));
+
+    // aborted records are skipped, but released together with the records around them
+    REQUIRE(push(ring, "0123456789"));
+    REQUIRE(mpsc_ring_reserve(&ring, 2, &aborted));
+    mpsc_ring_abort(&aborted);
+    REQUIRE(push(ring, "ab"));
+    pos = ring.tail;
+    REQUIRE("0123456789" == peek_at(pos));
+    REQUIRE("ab" == peek_at(pos));
+    REQUIRE(peek_at(pos).empty());
+    mpsc_ring_release_to(&ring, pos);
+    REQUIRE(0 == mpsc_ring_get_full(&ring));
+    REQUIRE(peek(ring).empty());
+}
+
+TEST_CASE("MpscRingTests - ScanSkipsRecordsInProgress", "[mpsc_ring]")
+{
+    alignas(uint32_t) std::array<unsigned char, 64> storage{};
+    mpsc_ring ring{};
+    mpsc_ring_reservation first{};
+    mpsc_ring_reservation aborted{};
+
+    const auto scan = [&ring] {
+        std::vector<std::string_view> records;
+        size_t pos = mpsc_ring_get_read_pos(&ring);
+        size_t size = 0;
+        const char *data;
+
+        while ((data = static_cast<const char *>(mpsc_ring_scan_at(&ring, &pos, &size))) !=
+               nullptr) {
+            records.emplace_back(data, size);
+        }
+
+        return records;
+    };
+
+    REQUIRE(mpsc_ring_init(&ring, storage.data(), storage.size()));
+    REQUIRE(mpsc_ring_reserve(&ring, 3, &first));
+    REQUIRE(mpsc_ring_reserve(&ring, 8, &aborted));
+    mpsc_ring_abort(&aborted);
+    REQUIRE(push(ring, "def"));
+
+    // the consumer waits for the record in progress, the scan passes the committed one
+    REQUIRE(peek(ring).empty());
+    REQUIRE(std::vector<std::string_view>{"def"} == scan());
+
+    std::memcpy(first.data, "abc", 3);
+    mpsc_ring_commit(&first, 3);
+    REQUIRE(std::vector<std::string_view>{"abc", "def"} == scan());
+
+    // a release interrupted after zeroing the first record does not hide the rest
+    size_t pos = ring.tail;
+    size_t size = 0;
+    REQUIRE(nullptr != mpsc_ring_peek_at(&ring, &pos, &size));
+    ring.released = pos;
+    std::memset(storage.data(), 0, pos);
+    REQUIRE(std::vector<std::string_view>{"def"} == scan());
+}
+
+TEST_CASE("MpscRingTests - MultipleProducers", "[mpsc_ring]")
+{
+    constexpr size_t producers = 4;
+    constexpr uint32_t records_per_producer = 20000;
+    struct record {
+        uint32_t producer;
+        uint32_t seq;
+        uint32_t check;
+    };
+    alignas(uint32_t) std::array<unsigned char, 512> storage{};
+    mpsc_ring ring{};
+
+    REQUIRE(mpsc_ring_init(&ring, storage.data(), storage.size()));
+
+    std::vector<std::thread> threads;
+
+    for (uint32_t id = 0; id < producers; ++id) {
+        threads.emplace_back([&ring, id]() {
+            for (uint32_t seq = 0; seq < records_per_producer; ++seq) {
+                const record value{id, seq, id ^ seq ^ 0xA5A5A5A5U};
+                // vary record size to exercise wrap around padding
+                const size_t size = sizeof(value) + seq % 7;
+                mpsc_ring_reservation reservation{};
+
+                while (!mpsc_ring_reserve(&ring, size, &reservation)) {
+                    std::this_thread::yield();
+                }
+
+                std::memcpy(reservation.data, &value, sizeof(value));
+                mpsc_ring_commit(&reservation, size);
+            }
+        });
+    }
+
+    std::array<uint32_t, producers> expected_seq{};
+    size_t received = 0;
+    bool valid = true;
+
+    while (received < producers * records_per_producer) {
+        size_t size = 0;
+        const void *data = mpsc_ring_peek(&ring, &size);
+
+        if (data == nullptr) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        record value{};
+        std::memcpy(&value, data, sizeof(value));
+        mpsc_ring_release(&ring);
+        ++received;
+
+        valid = valid && value.producer < producers &&
+                value.check == (value.producer ^ value.seq ^ 0xA5A5A5A5U) &&
+                size == sizeof(value) + value.seq % 7 && expected_seq[value.producer] == value.seq;
+
+        if (value.producer < producers) {
+            expected_seq[value.producer] = value.seq + 1;
+        }
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    REQUIRE(valid);
+    REQUIRE(peek(ring).empty());
+
+    for (const auto seq : expected_seq) {
+        REQUIRE(records_per_producer == seq);
+    }
+}
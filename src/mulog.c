@@ -7,56 +7,697 @@
 #include "mulog.h"
 #include "internal/config.h"
 #include "internal/interface.h"
+#include "internal/utils.h"
+
+#if defined(MULOG_ENABLE_DRAIN_WORKER) && MULOG_ENABLE_DRAIN_WORKER == 1
+#include "internal/deferred/worker.h"
+#endif /* MULOG_ENABLE_DRAIN_WORKER */
 
 #include <stdarg.h>
+#include <string.h>
+
+// PUBLIC VARIABLE DEFINITIONS
+
+enum mulog_log_level mulog_min_log_level = MULOG_LOG_LVL_COUNT;
+
+#if !defined(MULOG_INSTANCES) || MULOG_INSTANCES < 0
+#error "Define MULOG_INSTANCES to a number of logger instances that can be created"
+#endif
+
+// PRIVATE TYPE DECLARATIONS
+
+/**
+ * \brief Logger instance, refers to a logger of the logging mode implementation
+ */
+struct mulog_instance {
+    size_t index;                    /**< Index of the instance logger */
+    struct mulog_instance_lock lock; /**< Lock callbacks, the global lock is used if not set */
+    bool used;                       /**< Whether the instance has been taken from the pool */
+};
+
+// PRIVATE VARIABLE DEFINITIONS
+
+/**
+ * \brief Instance of the global API and NULL instance handles
+ */
+static struct mulog_instance default_instance = {.index = 0};
+
+#if MULOG_INSTANCES > 0
+/**
+ * \brief Pool of instances created with mulog_instance_init()
+ */
+static struct mulog_instance instances[MULOG_INSTANCES];
+#endif /* MULOG_INSTANCES */
+
+#if defined(MULOG_ENABLE_NONBLOCKING_LOG) && MULOG_ENABLE_NONBLOCKING_LOG == 1
+/**
+ * \brief Log entry of a contended log call kept until the calling thread acquires the lock
+ */
+struct spill_slot {
+    const struct mulog_instance *instance;  /**< Instance of the entry, NULL if the slot is free */
+    size_t generation;                      /**< Spill generation of the instance of the entry */
+    enum mulog_log_level level;             /**< Log level of the entry */
+    size_t size;                            /**< Size of the formatted entry */
+    char entry[MULOG_SINGLE_LOG_LINE_SIZE]; /**< Entry formatted at the time of the log call */
+};
+
+/**
+ * \brief Spill slot of the calling thread
+ */
+static _Thread_local struct spill_slot spill_slot;
+
+/**
+ * \brief Contention counters of the default instance and the instances, indexed by the logger
+ */
+static struct mulog_contention_stats contention_stats[MULOG_INSTANCES + 1];
+
+/**
+ * \brief Spill generations of the default instance and the instances, indexed by the logger
+ *
+ * A generation is bumped to discard the entries of the instance kept in the spill slots of all
+ * threads, the slots of other threads are not reachable.
+ */
+static size_t spill_generations[MULOG_INSTANCES + 1];
+#endif /* MULOG_ENABLE_NONBLOCKING_LOG */
+
+#if defined(MULOG_ENABLE_CALL_SITES) && MULOG_ENABLE_CALL_SITES == 1
+// PRIVATE VARIABLE DECLARATIONS
+
+// section bounds are provided by the linker, weak references stay NULL if there are no call sites
+extern struct mulog_call_site __start_mulog_call_sites[] __attribute__((weak));
+extern struct mulog_call_site __stop_mulog_call_sites[] __attribute__((weak));
+
+// PRIVATE FUNCTION DEFINITIONS
+
+/**
+ * \brief Checks whether a call site matches the given location.
+ *
+ * \param site Call site to check
+ * \param file Source file path suffix, NULL to match any file
+ * \param line Source line, 0 to match any line
+ * \return true if the call site matches, false otherwise
+ */
+static bool is_call_site_matched(const struct mulog_call_site *site, const char *file,
+                                 const unsigned int line)
+{
+    if (line != 0 && site->line != line) {
+        return false;
+    }
+
+    if (file == NULL) {
+        return true;
+    }
+
+    const size_t site_file_len = strlen(site->file);
+    const size_t file_len = strlen(file);
+
+    return site_file_len >= file_len &&
+           strcmp(site->file + site_file_len - file_len, file) == 0;
+}
+#endif /* MULOG_ENABLE_CALL_SITES */
+
+/**
+ * \brief Wakes the drain worker up after a log entry has been stored.
+ *
+ * \param ret Result of the log call
+ * \return The result of the log call
+ */
+static inline int notify_drain_worker(const int ret)
+{
+#if defined(MULOG_ENABLE_DRAIN_WORKER) && MULOG_ENABLE_DRAIN_WORKER == 1
+    if (ret > 0) {
+        worker_notify();
+    }
+#endif /* MULOG_ENABLE_DRAIN_WORKER */
+
+    return ret;
+}
+
+/**
+ * \brief Gets the instance an instance handle refers to.
+ *
+ * \param instance Instance handle, NULL for the default instance
+ * \return The instance
+ */
+static inline const struct mulog_instance *get_instance(const struct mulog_instance *instance)
+{
+    return instance != NULL ? instance : &default_instance;
+}
+
+/**
+ * \brief Gets the logger of an instance.
+ *
+ * \param instance The instance
+ * \return The instance logger
+ */
+static inline struct logger *get_instance_logger(const struct mulog_instance *instance)
+{
+    return interface_get_logger(instance->index);
+}
+
+/**
+ * \brief Gets the logger of the default instance.
+ *
+ * \return The default logger
+ */
+static inline struct logger *get_default_logger(void)
+{
+    return get_instance_logger(&default_instance);
+}
+
+/**
+ * \brief Takes the lock of an instance.
+ *
+ * \param instance The instance
+ * \return true if the lock has been acquired, false otherwise
+ */
+static bool lock_instance(const struct mulog_instance *instance)
+{
+    return instance->lock.lock != NULL ? instance->lock.lock(instance->lock.arg)
+                                       : mulog_config_mulog_lock();
+}
+
+/**
+ * \brief Releases the lock of an instance.
+ *
+ * \param instance The instance
+ */
+static void unlock_instance(const struct mulog_instance *instance)
+{
+    if (instance->lock.unlock != NULL) {
+        instance->lock.unlock(instance->lock.arg);
+    } else {
+        mulog_config_mulog_unlock();
+    }
+}
+
+#if defined(MULOG_ENABLE_LOCK_DOMAINS) && MULOG_ENABLE_LOCK_DOMAINS == 1
+/**
+ * \brief Checks whether an instance takes separate locks for configuration, formatting and output.
+ *
+ * Instances serialize everything with a single lock, only the default instance has lock domains.
+ *
+ * \param instance The instance
+ * \return true if the format and output locks are used, false otherwise
+ */
+static inline bool has_lock_domains(const struct mulog_instance *instance)
+{
+    return instance == &default_instance;
+}
+#endif /* MULOG_ENABLE_LOCK_DOMAINS */
+
+/**
+ * \brief Takes the locks of an instance for a change of its log buffer.
+ *
+ * With lock domains the format and output locks are taken after the configuration lock, so the
+ * log buffer is neither written by log calls nor read by the outputs while it is changed.
+ *
+ * \param instance The instance
+ * \return true if the locks have been acquired, false otherwise
+ */
+static bool lock_instance_buffer(const struct mulog_instance *instance)
+{
+    if (!lock_instance(instance)) {
+        return false;
+    }
+
+#if defined(MULOG_ENABLE_LOCK_DOMAINS) && MULOG_ENABLE_LOCK_DOMAINS == 1
+    if (!has_lock_domains(instance)) {
+        return true;
+    }
+
+    if (!mulog_config_mulog_format_lock()) {
+        unlock_instance(instance);
+        return false;
+    }
+
+    if (!mulog_config_mulog_output_lock()) {
+        mulog_config_mulog_format_unlock();
+        unlock_instance(instance);
+        return false;
+    }
+#endif /* MULOG_ENABLE_LOCK_DOMAINS */
+
+    return true;
+}
+
+/**
+ * \brief Releases the locks taken with lock_instance_buffer().
+ *
+ * \param instance The instance
+ */
+static void unlock_instance_buffer(const struct mulog_instance *instance)
+{
+#if defined(MULOG_ENABLE_LOCK_DOMAINS) && MULOG_ENABLE_LOCK_DOMAINS == 1
+    if (has_lock_domains(instance)) {
+        mulog_config_mulog_output_unlock();
+        mulog_config_mulog_format_unlock();
+    }
+#endif /* MULOG_ENABLE_LOCK_DOMAINS */
+
+    unlock_instance(instance);
+}
+
+#if defined(MULOG_ENABLE_NONBLOCKING_LOG) && MULOG_ENABLE_NONBLOCKING_LOG == 1
+/**
+ * \brief Takes the lock of an instance if it is free.
+ *
+ * \param instance The instance
+ * \return true if the lock has been acquired, false otherwise
+ */
+static bool try_lock_instance(const struct mulog_instance *instance)
+{
+    if (instance->lock.lock == NULL) {
+        return mulog_config_mulog_trylock();
+    }
+
+    return instance->lock.trylock(instance->lock.arg);
+}
+
+/**
+ * \brief Discards the entries of an instance kept in the spill slots of all threads.
+ *
+ * \param instance The instance
+ */
+static inline void discard_spilled_entries(const struct mulog_instance *instance)
+{
+    __atomic_add_fetch(&spill_generations[instance->index], 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * \brief Clears the contention counters of an instance and discards its spilled entries.
+ *
+ * \param instance The instance
+ */
+static void reset_contention(const struct mulog_instance *instance)
+{
+    struct mulog_contention_stats *stats = &contention_stats[instance->index];
+
+    __atomic_store_n(&stats->contended, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats->spilled, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats->dropped, 0, __ATOMIC_RELAXED);
+    discard_spilled_entries(instance);
+}
+
+/**
+ * \brief Gets the instance of the entry kept in the spill slot of the calling thread.
+ *
+ * An entry discarded since it has been spilled is removed from the slot.
+ *
+ * \return Instance of the spilled entry, NULL if the slot is free
+ */
+static const struct mulog_instance *get_spilled_instance(void)
+{
+    const struct mulog_instance *instance = spill_slot.instance;
+
+    if (instance != NULL &&
+        spill_slot.generation !=
+            __atomic_load_n(&spill_generations[instance->index], __ATOMIC_RELAXED)) {
+        spill_slot.instance = NULL;
+        return NULL;
+    }
+
+    return instance;
+}
+
+/**
+ * \brief Keeps the entry of a contended log call in the spill slot of the calling thread.
+ *
+ * \param instance The instance the entry is logged with
+ * \param level Log level of the entry
+ * \param fmt Format string of the entry
+ * \param args Format arguments
+ */
+static void spill_log_entry(const struct mulog_instance *instance, const enum mulog_log_level level,
+                            const char *fmt, va_list args)
+{
+    struct mulog_contention_stats *stats = &contention_stats[instance->index];
+
+    __atomic_add_fetch(&stats->contended, 1, __ATOMIC_RELAXED);
+
+    // a single entry is kept, so a thread never waits for the lock to log an older entry first
+    if (get_spilled_instance() != NULL) {
+        __atomic_add_fetch(&stats->dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    const int size = interface_format_log_entry(get_instance_logger(instance), level,
+                                                spill_slot.entry, sizeof(spill_slot.entry), fmt,
+                                                args);
+
+    if (size < 0) {
+        __atomic_add_fetch(&stats->dropped, 1, __ATOMIC_RELAXED);
+    }
+
+    if (size <= 0) {
+        // entries filtered out by the logger are not kept
+        return;
+    }
+
+    spill_slot.instance = instance;
+    spill_slot.generation = __atomic_load_n(&spill_generations[instance->index], __ATOMIC_RELAXED);
+    spill_slot.level = level;
+    spill_slot.size = (size_t)size;
+    __atomic_add_fetch(&stats->spilled, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * \brief Logs the spilled entry of the calling thread, the instance lock must be held.
+ *
+ * \param instance The instance the lock of which is held
+ * \return Number of bytes logged, 0 if there is no spilled entry of the instance
+ */
+static int log_spilled_entry(const struct mulog_instance *instance)
+{
+    if (get_spilled_instance() != instance) {
+        return 0;
+    }
+
+    spill_slot.instance = NULL;
+
+    return interface_output_log_entry(get_instance_logger(instance), spill_slot.level,
+                                      spill_slot.entry, spill_slot.size);
+}
+
+/**
+ * \brief Takes the instance lock for a log call without waiting.
+ *
+ * A contended entry is kept in the spill slot of the calling thread. Once the lock is acquired,
+ * the spilled entry is logged before the entry of the call.
+ *
+ * \param instance The instance to log the entry with
+ * \param level Log level of the entry
+ * \param fmt Format string of the entry
+ * \param args Format arguments, only used if the entry is spilled
+ * \return true if the lock has been acquired, false otherwise
+ */
+static bool lock_log_call(const struct mulog_instance *instance, const enum mulog_log_level level,
+                          const char *fmt, va_list args)
+{
+    if (!try_lock_instance(instance)) {
+        spill_log_entry(instance, level, fmt, args);
+        return false;
+    }
+
+    log_spilled_entry(instance);
+
+    return true;
+}
+#endif /* MULOG_ENABLE_NONBLOCKING_LOG */
+
+#if defined(MULOG_ENABLE_LOCK_DOMAINS) && MULOG_ENABLE_LOCK_DOMAINS == 1
+/**
+ * \brief Processes deferred log entries of the default logger with lock domains.
+ *
+ * Consumers are serialized with the output lock, producers only take the format lock, so they
+ * store entries while the outputs run.
+ *
+ * \param logger The default logger
+ * \param budget Processing limits, or NULL to process all stored entries
+ * \return Number of bytes passed to the outputs, or a negative status code
+ */
+static int process_domain_deferred_log(struct logger *logger,
+                                       const struct mulog_process_budget *budget)
+{
+    // producers remove the oldest stored entries, they must not run while entries are read
+    const bool producers_locked = interface_is_deferred_log_locked(logger);
+
+    if (producers_locked && !mulog_config_mulog_format_lock()) {
+        return MULOG_RET_CODE_LOCK_FAILED;
+    }
+
+    if (!mulog_config_mulog_output_lock()) {
+        if (producers_locked) {
+            mulog_config_mulog_format_unlock();
+        }
+
+        return MULOG_RET_CODE_LOCK_FAILED;
+    }
+
+    const int ret = interface_deferred_log(logger, budget);
+    mulog_config_mulog_output_unlock();
+
+    if (producers_locked) {
+        mulog_config_mulog_format_unlock();
+    }
+
+    return ret;
+}
+#endif /* MULOG_ENABLE_LOCK_DOMAINS */
+
+/**
+ * \brief Processes deferred log entries, takes the instance lock if producers may remove entries.
+ *
+ * \param instance The instance to process the entries of
+ * \param budget Processing limits, or NULL to process all stored entries
+ * \return Number of bytes passed to the outputs, or a negative status code
+ */
+static int process_deferred_log(const struct mulog_instance *instance,
+                                const struct mulog_process_budget *budget)
+{
+    struct logger *logger = get_instance_logger(instance);
+
+#if defined(MULOG_ENABLE_LOCK_DOMAINS) && MULOG_ENABLE_LOCK_DOMAINS == 1
+    if (has_lock_domains(instance)) {
+        return process_domain_deferred_log(logger, budget);
+    }
+#endif /* MULOG_ENABLE_LOCK_DOMAINS */
+
+    if (!interface_is_deferred_log_locked(logger)) {
+        return interface_deferred_log(logger, budget);
+    }
+
+    // producers remove the oldest stored entries, they must not run while entries are read
+    if (!lock_instance(instance)) {
+        return MULOG_RET_CODE_LOCK_FAILED;
+    }
+
+    const int ret = interface_deferred_log(logger, budget);
+    unlock_instance(instance);
+
+    return ret;
+}
+
+#if defined(MULOG_ENABLE_LOCK_DOMAINS) && MULOG_ENABLE_LOCK_DOMAINS == 1
+/**
+ * \brief Logs an entry through the default logger with lock domains.
+ *
+ * In realtime mode the output lock is taken before the format lock is released. So the next log
+ * call formats its entry while this one is in the outputs, but not into the same log buffer half.
+ * In deferred mode the entry is only stored, the outputs are called by the consumer.
+ *
+ * \param logger The default logger
+ * \param level Log level of the entry
+ * \param fmt Format string of the entry
+ * \param args Format arguments
+ * \return The result of the log call
+ */
+static int log_domain_output(struct logger *logger, const enum mulog_log_level level,
+                             const char *fmt, va_list args)
+{
+#if defined(MULOG_ENABLE_THREAD_LOG_BUFFER) && MULOG_ENABLE_THREAD_LOG_BUFFER == 1
+    if (interface_has_thread_log_buffer()) {
+        // the thread buffer is not shared, so only the output dispatch is serialized
+        const int size = interface_format_thread_log_entry(logger, level, fmt, args);
+
+        if (size <= 0 || !mulog_config_mulog_output_lock()) {
+            return size > 0 ? 0 : size;
+        }
+
+        const int ret = interface_output_thread_log_entry(logger, level, (size_t)size);
+        mulog_config_mulog_output_unlock();
+
+        return ret;
+    }
+#endif /* MULOG_ENABLE_THREAD_LOG_BUFFER */
+
+    if (!mulog_config_mulog_format_lock()) {
+        return 0;
+    }
+
+#if defined(MULOG_ENABLE_DEFERRED_LOGGING) && MULOG_ENABLE_DEFERRED_LOGGING == 1
+    const int ret = interface_log_output(logger, level, fmt, args);
+    mulog_config_mulog_format_unlock();
+
+    return ret;
+#else
+    const char *entry = NULL;
+    const int size = interface_format_shared_log_entry(logger, level, fmt, args, &entry);
+
+    if (size <= 0 || !mulog_config_mulog_output_lock()) {
+        mulog_config_mulog_format_unlock();
+        return size > 0 ? 0 : size;
+    }
+
+    mulog_config_mulog_format_unlock();
+
+    const int ret = interface_output_log_entry(logger, level, entry, (size_t)size);
+    mulog_config_mulog_output_unlock();
+
+    return ret;
+#endif /* MULOG_ENABLE_DEFERRED_LOGGING */
+}
+#endif /* MULOG_ENABLE_LOCK_DOMAINS */
+
+/**
+ * \brief Logs an entry through the logger of an instance.
+ *
+ * \param instance The instance to log the entry with
+ * \param level Log level of the entry
+ * \param fmt Format string of the entry
+ * \param args Format arguments
+ * \return The result of the log call
+ */
+static int log_output(const struct mulog_instance *instance, const enum mulog_log_level level,
+                      const char *fmt, va_list args)
+{
+    struct logger *logger = get_instance_logger(instance);
+    // the drain worker only processes the default instance
+    const bool notify = instance == &default_instance;
+
+#if defined(MULOG_ENABLE_LOCKFREE_DEFERRED) && MULOG_ENABLE_LOCKFREE_DEFERRED == 1
+    // log entries are reserved and committed atomically, no need to serialize producers
+    const int ret = interface_log_output(logger, level, fmt, args);
+
+    return notify ? notify_drain_worker(ret) : ret;
+#else
+#if defined(MULOG_ENABLE_LOCK_DOMAINS) && MULOG_ENABLE_LOCK_DOMAINS == 1
+    if (has_lock_domains(instance)) {
+        return notify_drain_worker(log_domain_output(logger, level, fmt, args));
+    }
+#endif /* MULOG_ENABLE_LOCK_DOMAINS */
+
+#if defined(MULOG_ENABLE_THREAD_LOG_BUFFER) && MULOG_ENABLE_THREAD_LOG_BUFFER == 1
+    if (interface_has_thread_log_buffer()) {
+        // the entry is formatted into the thread buffer, only the output dispatch is serialized
+#if defined(MULOG_ENABLE_NONBLOCKING_LOG) && MULOG_ENABLE_NONBLOCKING_LOG == 1
+        va_list spill_args;
+
+        // formatting consumes the arguments, a contended entry is formatted again when spilled
+        va_copy(spill_args, args);
+        const int size = interface_format_thread_log_entry(logger, level, fmt, args);
+        const bool locked = size > 0 && lock_log_call(instance, level, fmt, spill_args);
+        va_end(spill_args);
+#else
+        const int size = interface_format_thread_log_entry(logger, level, fmt, args);
+        const bool locked = size > 0 && lock_instance(instance);
+#endif /* MULOG_ENABLE_NONBLOCKING_LOG */
+
+        if (!locked) {
+            return size > 0 ? 0 : size;
+        }
+
+        const int ret = interface_output_thread_log_entry(logger, level, (size_t)size);
+        unlock_instance(instance);
+
+        return ret;
+    }
+#endif /* MULOG_ENABLE_THREAD_LOG_BUFFER */
+
+#if defined(MULOG_ENABLE_NONBLOCKING_LOG) && MULOG_ENABLE_NONBLOCKING_LOG == 1
+    if (!lock_log_call(instance, level, fmt, args)) {
+#else
+    if (!lock_instance(instance)) {
+#endif /* MULOG_ENABLE_NONBLOCKING_LOG */
+        return 0;
+    }
+
+    const int ret = interface_log_output(logger, level, fmt, args);
+    unlock_instance(instance);
+
+    return notify ? notify_drain_worker(ret) : ret;
+#endif /* MULOG_ENABLE_LOCKFREE_DEFERRED */
+}
 
 // PUBLIC FUNCTION DEFINITIONS
 
 enum mulog_ret_code mulog_set_log_buffer(char *buf, const size_t buf_size)
 {
-    if (!mulog_config_mulog_lock()) {
+    return mulog_instance_set_log_buffer(NULL, buf, buf_size);
+}
+
+enum mulog_ret_code mulog_set_priority_log_buffer(char *buf, const size_t buf_size)
+{
+    if (!lock_instance_buffer(&default_instance)) {
         return MULOG_RET_CODE_LOCK_FAILED;
     }
 
-    const int ret = interface_set_log_buffer(buf, buf_size);
-    mulog_config_mulog_unlock();
+    const int ret = interface_set_priority_log_buffer(get_default_logger(), buf, buf_size);
+    unlock_instance_buffer(&default_instance);
 
     return ret;
 }
 
-enum mulog_ret_code mulog_set_log_level(const enum mulog_log_level level)
+enum mulog_ret_code mulog_set_flight_recorder(char *buf, const size_t buf_size,
+                                              const enum mulog_log_level persist_level)
 {
-    if (!mulog_config_mulog_lock()) {
+    if (!lock_instance_buffer(&default_instance)) {
         return MULOG_RET_CODE_LOCK_FAILED;
     }
 
-    const int ret = interface_set_global_log_level(level);
-    mulog_config_mulog_unlock();
+    const int ret =
+        interface_set_flight_recorder(get_default_logger(), buf, buf_size, persist_level);
+    unlock_instance_buffer(&default_instance);
+
+    return ret;
+}
+
+int mulog_flight_recorder_dump(void)
+{
+    if (!lock_instance_buffer(&default_instance)) {
+        return MULOG_RET_CODE_LOCK_FAILED;
+    }
+
+    const int ret = interface_dump_flight_recorder(get_default_logger());
+    unlock_instance_buffer(&default_instance);
+
+    return notify_drain_worker(ret);
+}
+
+enum mulog_ret_code mulog_set_persistent_log_buffer(char *buf, const size_t buf_size)
+{
+    if (!lock_instance_buffer(&default_instance)) {
+        return MULOG_RET_CODE_LOCK_FAILED;
+    }
+
+    const int ret = interface_set_persistent_log_buffer(get_default_logger(), buf, buf_size);
+    unlock_instance_buffer(&default_instance);
 
     return ret;
 }
 
+enum mulog_ret_code mulog_set_thread_log_buffer(char *buf, const size_t buf_size)
+{
+    // the thread buffer is only accessed by the calling thread, no need to take the lock
+    return interface_set_thread_log_buffer(buf, buf_size);
+}
+
+enum mulog_ret_code mulog_set_log_level(const enum mulog_log_level level)
+{
+    return mulog_instance_set_log_level(NULL, level);
+}
+
 enum mulog_ret_code mulog_set_channel_log_level(const mulog_log_output_fn output,
                                                 const enum mulog_log_level level)
 {
-    if (!mulog_config_mulog_lock()) {
+    if (!lock_instance(&default_instance)) {
         return MULOG_RET_CODE_LOCK_FAILED;
     }
 
-    const int ret = interface_set_log_level_per_output(level, output);
-    mulog_config_mulog_unlock();
+    const int ret = interface_set_log_level_per_output(get_default_logger(), level, output);
+    unlock_instance(&default_instance);
 
     return ret;
 }
 
 enum mulog_ret_code mulog_add_output(const mulog_log_output_fn output)
 {
-    if (!mulog_config_mulog_lock()) {
+    if (!lock_instance(&default_instance)) {
         return MULOG_RET_CODE_LOCK_FAILED;
     }
 
-    const int ret = interface_add_output_default(output);
-    mulog_config_mulog_unlock();
+    const int ret = interface_add_output_default(get_default_logger(), output);
+    unlock_instance(&default_instance);
 
     return ret;
 }
@@ -64,66 +705,448 @@ enum mulog_ret_code mulog_add_output(const mulog_log_output_fn output)
 enum mulog_ret_code mulog_add_output_with_log_level(const mulog_log_output_fn output,
                                                     const enum mulog_log_level level)
 {
-    if (!mulog_config_mulog_lock()) {
+    return mulog_instance_add_output(NULL, output, level);
+}
+
+enum mulog_ret_code mulog_unregister_output(const mulog_log_output_fn output)
+{
+    return mulog_instance_unregister_output(NULL, output);
+}
+
+enum mulog_ret_code mulog_add_output_vec(const mulog_log_output_vec_fn output,
+                                         const enum mulog_log_level level)
+{
+    if (!lock_instance(&default_instance)) {
         return MULOG_RET_CODE_LOCK_FAILED;
     }
 
-    const int ret = interface_add_output(output, level);
-    mulog_config_mulog_unlock();
+    const int ret = interface_add_output_vec(get_default_logger(), output, level);
+    unlock_instance(&default_instance);
 
     return ret;
 }
 
-enum mulog_ret_code mulog_unregister_output(const mulog_log_output_fn output)
+enum mulog_ret_code mulog_unregister_output_vec(const mulog_log_output_vec_fn output)
 {
-    if (!mulog_config_mulog_lock()) {
+    if (!lock_instance(&default_instance)) {
         return MULOG_RET_CODE_LOCK_FAILED;
     }
 
-    const int ret = interface_unregister_output(output);
-    mulog_config_mulog_unlock();
+    const int ret = interface_unregister_output_vec(get_default_logger(), output);
+    unlock_instance(&default_instance);
 
     return ret;
 }
 
-void mulog_unregister_all_outputs(void)
+enum mulog_ret_code mulog_add_output_ctx(const struct mulog_output *output,
+                                         const enum mulog_log_level level)
 {
-    if (!mulog_config_mulog_lock()) {
-        return;
+    return mulog_instance_add_output_ctx(NULL, output, level);
+}
+
+enum mulog_ret_code mulog_unregister_output_ctx(const mulog_output_write_fn write, const void *ctx)
+{
+    return mulog_instance_unregister_output_ctx(NULL, write, ctx);
+}
+
+enum mulog_ret_code mulog_set_output_registry(struct mulog_output_slot *slots, const size_t count)
+{
+    return mulog_instance_set_output_registry(NULL, slots, count);
+}
+
+enum mulog_ret_code mulog_unregister_all_outputs(void)
+{
+    if (!lock_instance(&default_instance)) {
+        return MULOG_RET_CODE_LOCK_FAILED;
     }
 
-    interface_unregister_all_outputs();
-    mulog_config_mulog_unlock();
+    const enum mulog_ret_code ret = interface_unregister_all_outputs(get_default_logger());
+    unlock_instance(&default_instance);
+
+    return ret;
 }
 
 void mulog_reset(void)
 {
-    if (!mulog_config_mulog_lock()) {
+#if defined(MULOG_ENABLE_DRAIN_WORKER) && MULOG_ENABLE_DRAIN_WORKER == 1
+    // the worker may take the logger lock, so it is stopped before the lock is taken
+    worker_stop();
+#endif /* MULOG_ENABLE_DRAIN_WORKER */
+
+    if (!lock_instance_buffer(&default_instance)) {
         return;
     }
 
-    interface_unregister_all_outputs();
-    interface_reset();
-    mulog_config_mulog_unlock();
+    interface_unregister_all_outputs(get_default_logger());
+    interface_reset(get_default_logger());
+#if defined(MULOG_ENABLE_NONBLOCKING_LOG) && MULOG_ENABLE_NONBLOCKING_LOG == 1
+    reset_contention(&default_instance);
+#endif /* MULOG_ENABLE_NONBLOCKING_LOG */
+    unlock_instance_buffer(&default_instance);
 }
 
 int mulog_deferred_process(void)
 {
-    return interface_deferred_log();
+    return mulog_instance_process(NULL);
 }
 
-MULOG_PRINTF_ATTR int mulog_log(const enum mulog_log_level level, const char *fmt, ...)
+int mulog_deferred_process_budget(const struct mulog_process_budget *budget, size_t *remaining)
 {
-    va_list args;
+    if (budget == NULL) {
+        return MULOG_RET_CODE_INVALID_ARG;
+    }
 
-    if (!mulog_config_mulog_lock()) {
+    const int ret = process_deferred_log(&default_instance, budget);
+
+    if (remaining != NULL) {
+        *remaining = interface_get_deferred_usage(get_default_logger());
+    }
+
+    return ret;
+}
+
+size_t mulog_deferred_get_dropped_count(void)
+{
+    return mulog_instance_get_dropped_count(NULL);
+}
+
+int mulog_deferred_recover(const char *buf, const size_t buf_size,
+                           const mulog_log_output_fn output)
+{
+    if (buf == NULL || output == NULL) {
+        return MULOG_RET_CODE_INVALID_ARG;
+    }
+
+    // the buffer is not attached to the logger, so there is nothing to lock
+    return interface_recover_log(buf, buf_size, output);
+}
+
+int mulog_deferred_emergency_flush(const mulog_log_output_fn write, const char *message)
+{
+    if (write == NULL) {
+        return MULOG_RET_CODE_INVALID_ARG;
+    }
+
+    // the lock may be held by the code interrupted by the signal, so it must not be taken
+    return interface_emergency_flush(write, message);
+}
+
+size_t mulog_deferred_get_level_dropped_count(const enum mulog_log_level level)
+{
+    return interface_get_level_dropped_count(get_default_logger(), level);
+}
+
+enum mulog_ret_code mulog_deferred_set_overflow_policy(const enum mulog_overflow_policy policy,
+                                                       const size_t spin_limit)
+{
+    if (!lock_instance_buffer(&default_instance)) {
+        return MULOG_RET_CODE_LOCK_FAILED;
+    }
+
+    const int ret = interface_set_overflow_policy(get_default_logger(), policy, spin_limit);
+    unlock_instance_buffer(&default_instance);
+
+    return ret;
+}
+
+#if defined(MULOG_ENABLE_DRAIN_WORKER) && MULOG_ENABLE_DRAIN_WORKER == 1
+enum mulog_ret_code mulog_deferred_worker_start(const struct mulog_drain_worker_config *config)
+{
+    if (config == NULL || config->max_latency_ms == 0) {
+        return MULOG_RET_CODE_INVALID_ARG;
+    }
+
+    return worker_start(config->watermark, config->max_latency_ms);
+}
+
+void mulog_deferred_worker_stop(void)
+{
+    worker_stop();
+}
+#endif /* MULOG_ENABLE_DRAIN_WORKER */
+
+#if defined(MULOG_ENABLE_NONBLOCKING_LOG) && MULOG_ENABLE_NONBLOCKING_LOG == 1
+struct mulog_contention_stats mulog_get_contention_stats(void)
+{
+    return mulog_instance_get_contention_stats(NULL);
+}
+
+int mulog_flush_spill_slot(void)
+{
+    const struct mulog_instance *instance = get_spilled_instance();
+
+    if (instance == NULL) {
         return 0;
     }
 
+    if (!lock_instance(instance)) {
+        return MULOG_RET_CODE_LOCK_FAILED;
+    }
+
+    const int ret = log_spilled_entry(instance);
+    unlock_instance(instance);
+
+    return ret;
+}
+#endif /* MULOG_ENABLE_NONBLOCKING_LOG */
+
+#if defined(MULOG_ENABLE_CALL_SITES) && MULOG_ENABLE_CALL_SITES == 1
+size_t mulog_call_site_count(void)
+{
+    return (size_t)(__stop_mulog_call_sites - __start_mulog_call_sites);
+}
+
+struct mulog_call_site *mulog_call_site_get(const size_t index)
+{
+    return index < mulog_call_site_count() ? &__start_mulog_call_sites[index] : NULL;
+}
+
+void mulog_call_site_for_each(const mulog_call_site_fn fn, void *arg)
+{
+    if (fn == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < mulog_call_site_count(); ++i) {
+        fn(&__start_mulog_call_sites[i], arg);
+    }
+}
+
+size_t mulog_call_site_enable(const char *file, const unsigned int line, const bool enabled)
+{
+    size_t matched = 0;
+
+    for (size_t i = 0; i < mulog_call_site_count(); ++i) {
+        struct mulog_call_site *site = &__start_mulog_call_sites[i];
+
+        if (is_call_site_matched(site, file, line)) {
+            __atomic_store_n(&site->enabled, enabled, __ATOMIC_RELAXED);
+            ++matched;
+        }
+    }
+
+    return matched;
+}
+#endif /* MULOG_ENABLE_CALL_SITES */
+
+struct mulog_instance *mulog_instance_init(const struct mulog_instance_lock *lock)
+{
+    if (lock != NULL && (lock->lock == NULL || lock->unlock == NULL)) {
+        return NULL;
+    }
+
+#if defined(MULOG_ENABLE_NONBLOCKING_LOG) && MULOG_ENABLE_NONBLOCKING_LOG == 1
+    // log calls of an instance must not wait for its lock
+    if (lock != NULL && lock->trylock == NULL) {
+        return NULL;
+    }
+#endif /* MULOG_ENABLE_NONBLOCKING_LOG */
+
+#if MULOG_INSTANCES > 0
+    // instances are taken under the global lock, so concurrent calls get different instances
+    if (!mulog_config_mulog_lock()) {
+        return NULL;
+    }
+
+    struct mulog_instance *instance = NULL;
+
+    for (size_t i = 0; i < ARRAY_SIZE(instances); ++i) {
+        if (!__atomic_load_n(&instances[i].used, __ATOMIC_ACQUIRE)) {
+            instance = &instances[i];
+            instance->used = true;
+            break;
+        }
+    }
+
+    mulog_config_mulog_unlock();
+
+    if (instance == NULL) {
+        return NULL;
+    }
+
+    // the default instance takes the first logger
+    instance->index = (size_t)(instance - instances) + 1;
+    instance->lock = lock != NULL ? *lock : (struct mulog_instance_lock){.lock = NULL};
+    // the logger is not reachable by other threads before the handle is returned
+    interface_reset(get_instance_logger(instance));
+#if defined(MULOG_ENABLE_NONBLOCKING_LOG) && MULOG_ENABLE_NONBLOCKING_LOG == 1
+    reset_contention(instance);
+#endif /* MULOG_ENABLE_NONBLOCKING_LOG */
+
+    return instance;
+#else
+    return NULL;
+#endif /* MULOG_INSTANCES */
+}
+
+void mulog_instance_deinit(struct mulog_instance *instance)
+{
+    if (instance == NULL || instance == &default_instance || !lock_instance(instance)) {
+        return;
+    }
+
+    struct logger *logger = get_instance_logger(instance);
+
+    interface_unregister_all_outputs(logger);
+    interface_reset(logger);
+#if defined(MULOG_ENABLE_NONBLOCKING_LOG) && MULOG_ENABLE_NONBLOCKING_LOG == 1
+    discard_spilled_entries(instance);
+#endif /* MULOG_ENABLE_NONBLOCKING_LOG */
+    unlock_instance(instance);
+    __atomic_store_n(&instance->used, false, __ATOMIC_RELEASE);
+}
+
+enum mulog_ret_code mulog_instance_set_log_buffer(struct mulog_instance *instance, char *buf,
+                                                  const size_t buf_size)
+{
+    const struct mulog_instance *target = get_instance(instance);
+
+    if (!lock_instance_buffer(target)) {
+        return MULOG_RET_CODE_LOCK_FAILED;
+    }
+
+    const int ret = interface_set_log_buffer(get_instance_logger(target), buf, buf_size);
+    unlock_instance_buffer(target);
+
+    return ret;
+}
+
+enum mulog_ret_code mulog_instance_set_log_level(struct mulog_instance *instance,
+                                                 const enum mulog_log_level level)
+{
+    const struct mulog_instance *target = get_instance(instance);
+
+    if (!lock_instance(target)) {
+        return MULOG_RET_CODE_LOCK_FAILED;
+    }
+
+    const int ret = interface_set_global_log_level(get_instance_logger(target), level);
+    unlock_instance(target);
+
+    return ret;
+}
+
+enum mulog_ret_code mulog_instance_add_output(struct mulog_instance *instance,
+                                              const mulog_log_output_fn output,
+                                              const enum mulog_log_level level)
+{
+    const struct mulog_instance *target = get_instance(instance);
+
+    if (!lock_instance(target)) {
+        return MULOG_RET_CODE_LOCK_FAILED;
+    }
+
+    const int ret = interface_add_output(get_instance_logger(target), output, level);
+    unlock_instance(target);
+
+    return ret;
+}
+
+enum mulog_ret_code mulog_instance_unregister_output(struct mulog_instance *instance,
+                                                     const mulog_log_output_fn output)
+{
+    const struct mulog_instance *target = get_instance(instance);
+
+    if (!lock_instance(target)) {
+        return MULOG_RET_CODE_LOCK_FAILED;
+    }
+
+    const int ret = interface_unregister_output(get_instance_logger(target), output);
+    unlock_instance(target);
+
+    return ret;
+}
+
+enum mulog_ret_code mulog_instance_add_output_ctx(struct mulog_instance *instance,
+                                                  const struct mulog_output *output,
+                                                  const enum mulog_log_level level)
+{
+    const struct mulog_instance *target = get_instance(instance);
+
+    if (!lock_instance(target)) {
+        return MULOG_RET_CODE_LOCK_FAILED;
+    }
+
+    const int ret = interface_add_output_ctx(get_instance_logger(target), output, level);
+    unlock_instance(target);
+
+    return ret;
+}
+
+enum mulog_ret_code mulog_instance_unregister_output_ctx(struct mulog_instance *instance,
+                                                         const mulog_output_write_fn write,
+                                                         const void *ctx)
+{
+    const struct mulog_instance *target = get_instance(instance);
+
+    if (!lock_instance(target)) {
+        return MULOG_RET_CODE_LOCK_FAILED;
+    }
+
+    const int ret = interface_unregister_output_ctx(get_instance_logger(target), write, ctx);
+    unlock_instance(target);
+
+    return ret;
+}
+
+enum mulog_ret_code mulog_instance_set_output_registry(struct mulog_instance *instance,
+                                                       struct mulog_output_slot *slots,
+                                                       const size_t count)
+{
+    const struct mulog_instance *target = get_instance(instance);
+
+    if (!lock_instance(target)) {
+        return MULOG_RET_CODE_LOCK_FAILED;
+    }
+
+    const int ret = interface_set_output_registry(get_instance_logger(target), slots, count);
+    unlock_instance(target);
+
+    return ret;
+}
+
+int mulog_instance_process(struct mulog_instance *instance)
+{
+    return process_deferred_log(get_instance(instance), NULL);
+}
+
+size_t mulog_instance_get_dropped_count(struct mulog_instance *instance)
+{
+    return interface_get_dropped_count(get_instance_logger(get_instance(instance)));
+}
+
+#if defined(MULOG_ENABLE_NONBLOCKING_LOG) && MULOG_ENABLE_NONBLOCKING_LOG == 1
+struct mulog_contention_stats mulog_instance_get_contention_stats(struct mulog_instance *instance)
+{
+    const struct mulog_contention_stats *stats = &contention_stats[get_instance(instance)->index];
+
+    return (struct mulog_contention_stats){
+        .contended = __atomic_load_n(&stats->contended, __ATOMIC_RELAXED),
+        .spilled = __atomic_load_n(&stats->spilled, __ATOMIC_RELAXED),
+        .dropped = __atomic_load_n(&stats->dropped, __ATOMIC_RELAXED),
+    };
+}
+#endif /* MULOG_ENABLE_NONBLOCKING_LOG */
+
+int mulog_instance_log(struct mulog_instance *instance, const enum mulog_log_level level,
+                       const char *fmt, ...)
+{
+    va_list args;
+
     va_start(args, fmt);
-    const int ret = interface_log_output(level, fmt, args);
+    const int ret = log_output(get_instance(instance), level, fmt, args);
+    va_end(args);
+
+    return ret;
+}
+
+MULOG_PRINTF_ATTR int mulog_log(const enum mulog_log_level level, const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    const int ret = log_output(&default_instance, level, fmt, args);
     va_end(args);
-    mulog_config_mulog_unlock();
 
     return ret;
 }
@@ -0,0 +1,283 @@
+/**
+ * \file
+ * \brief mulog tests for the binary log records output and the host decoder
+ * \author Vladimir Petrigo
+ */
+#include "decoder.h"
+#include "internal/config.h"
+#include "internal/utils.h"
+#include "internal/wire.h"
+#include "mulog.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <fmt/format.h>
+
+#include <array>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr std::array log_levels{
+        MULOG_TRACE_LVL, MULOG_DEBUG_LVL, MULOG_INFO_LVL, MULOG_WARNING_LVL, MULOG_ERROR_LVL,
+    };
+
+    std::vector<unsigned char> stream;
+    unsigned long timestamp_ms = 0;
+
+    void collect_output(const char *buf, const size_t buf_size)
+    {
+        stream.insert(stream.end(), buf, buf + buf_size);
+    }
+
+    std::string generate_expected_output(const std::string &input, const mulog_log_level log_level,
+                                         const unsigned long timestamp)
+    {
+        if constexpr (MULOG_ENABLE_TIMESTAMP) {
+            return fmt::format("{:07}.{:03} {}: {}{}", timestamp / 1000, timestamp % 1000,
+                               log_levels[log_level], input, MULOG_LOG_LINE_TERMINATION);
+        } else {
+            return fmt::format("{}: {}{}", log_levels[log_level], input,
+                               MULOG_LOG_LINE_TERMINATION);
+        }
+    }
+
+    std::vector<std::string> decode_stream()
+    {
+        struct decoder decoder;
+        std::vector<std::string> lines;
+        std::array<char, 256> line{};
+        size_t offset = 0;
+
+        REQUIRE(DECODER_RET_CODE_OK == decoder_init(&decoder, MULOG_TEST_PROGRAM));
+
+        while (offset < stream.size()) {
+            size_t consumed = 0;
+            const auto ret = decoder_decode(&decoder, stream.data() + offset,
+                                            stream.size() - offset, line.data(), line.size(),
+                                            &consumed);
+
+            REQUIRE(ret >= 0);
+            lines.emplace_back(line.data(), static_cast<size_t>(ret));
+            offset += consumed;
+        }
+
+        decoder_free(&decoder);
+
+        return lines;
+    }
+
+    __attribute__((format(printf, 3, 4))) int encode(std::vector<unsigned char> &buf,
+                                                     const mulog_log_level level, const char *fmt,
+                                                     ...)
+    {
+        va_list args;
+
+        va_start(args, fmt);
+        const auto ret = wire_encode_record(buf.data(), buf.size(), level, 0, fmt, args);
+        va_end(args);
+
+        return ret;
+    }
+
+    extern "C" bool mulog_config_mulog_lock(void)
+    {
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_unlock(void)
+    {
+    }
+
+    extern "C" bool mulog_config_mulog_format_lock(void)
+    {
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_format_unlock(void)
+    {
+    }
+
+    extern "C" bool mulog_config_mulog_output_lock(void)
+    {
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_output_unlock(void)
+    {
+    }
+
+    extern "C" unsigned long mulog_config_mulog_timestamp_get(void)
+    {
+        return timestamp_ms;
+    }
+
+    extern "C" void putchar_(int c)
+    {
+    }
+} // namespace
+
+class MulogBinary {
+public:
+    std::array<char, 128> buffer{};
+
+    MulogBinary()
+    {
+        mulog_set_log_buffer(buffer.data(), buffer.size());
+        mulog_set_log_level(MULOG_LOG_LVL_TRACE);
+        mulog_add_output(collect_output);
+        stream.clear();
+        timestamp_ms = 0;
+    }
+
+    ~MulogBinary()
+    {
+        mulog_reset();
+    }
+};
+
+TEST_CASE_METHOD(MulogBinary, "MulogBinary - DecodedAsText", "[binary]")
+{
+    timestamp_ms = 1500;
+    REQUIRE(MULOG_LOG_INFO("value %d, name %s, ratio %.2f", -42, "sensor", 0.25) > 0);
+    timestamp_ms = 2750;
+    REQUIRE(MULOG_LOG_DBG("%zu bytes at %p", static_cast<size_t>(512), nullptr) > 0);
+    REQUIRE(MULOG_LOG_ERR("no arguments") > 0);
+    timestamp_ms = 1234567;
+    REQUIRE(MULOG_LOG_TRACE("[%*d] %x", 6, 42, 0xbeefU) > 0);
+
+    const std::vector<std::string> expected{
+        generate_expected_output("value -42, name sensor, ratio 0.25", MULOG_LOG_LVL_INFO, 1500),
+        generate_expected_output(fmt::format("512 bytes at {}", "(nil)"), MULOG_LOG_LVL_DEBUG,
+                                 2750),
+        generate_expected_output("no arguments", MULOG_LOG_LVL_ERROR, 2750),
+        generate_expected_output("[    42] beef", MULOG_LOG_LVL_TRACE, 1234567),
+    };
+    auto decoded = decode_stream();
+
+    // pointer formatting is up to the printf implementation, compare the rest of the line
+    REQUIRE(expected.size() == decoded.size());
+    REQUIRE(expected[0] == decoded[0]);
+    REQUIRE(decoded[1].starts_with(expected[1].substr(0, expected[1].find("512"))));
+    REQUIRE(expected[2] == decoded[2]);
+    REQUIRE(expected[3] == decoded[3]);
+}
+
+TEST_CASE_METHOD(MulogBinary, "MulogBinary - RecordSmallerThanText", "[binary]")
+{
+    const std::string message = fmt::format("temperature {} humidity {}", 23, 45);
+    const auto record_size = MULOG_LOG_INFO("temperature %d humidity %d", 23, 45);
+
+    REQUIRE(record_size > 0);
+    REQUIRE(static_cast<size_t>(record_size) == stream.size());
+    REQUIRE(static_cast<size_t>(record_size) <
+            generate_expected_output(message, MULOG_LOG_LVL_INFO, 0).size());
+}
+
+TEST_CASE_METHOD(MulogBinary, "MulogBinary - RecordDoesNotFitIsDropped", "[binary]")
+{
+    const std::string long_string(buffer.size(), 'x');
+
+    REQUIRE(0 == MULOG_LOG_INFO("%s", long_string.c_str()));
+    REQUIRE(stream.empty());
+    REQUIRE(MULOG_LOG_INFO("%s", "fits") > 0);
+    REQUIRE(std::vector<std::string>{generate_expected_output("fits", MULOG_LOG_LVL_INFO, 0)} ==
+            decode_stream());
+}
+
+TEST_CASE_METHOD(MulogBinary, "MulogBinary - StringPrecisionLimitsEncoding", "[binary]")
+{
+    // the buffer is not null terminated, only the printed characters are encoded
+    const auto packet = std::make_unique<char[]>(4);
+    std::memcpy(packet.get(), "pkt!", 4);
+
+    REQUIRE(MULOG_LOG_INFO("%.*s|%.3s", 4, packet.get(), packet.get()) > 0);
+
+    const auto record_size = MULOG_LOG_INFO("%.*s", 2, "truncated");
+    REQUIRE(record_size > 0);
+    REQUIRE(record_size == MULOG_LOG_INFO("%.*s", 2, "tr"));
+    REQUIRE(std::vector<std::string>{generate_expected_output("pkt!|pkt", MULOG_LOG_LVL_INFO, 0),
+                                     generate_expected_output("tr", MULOG_LOG_LVL_INFO, 0),
+                                     generate_expected_output("tr", MULOG_LOG_LVL_INFO, 0)} ==
+            decode_stream());
+}
+
+TEST_CASE_METHOD(MulogBinary, "MulogBinary - FilteredLevelIsNotEncoded", "[binary]")
+{
+    auto ret = mulog_set_channel_log_level(collect_output, MULOG_LOG_LVL_WARNING);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    REQUIRE(0 == MULOG_LOG_INFO("filtered %d", 1));
+    REQUIRE(0 == mulog_log(MULOG_LOG_LVL_INFO, "filtered %d", 2));
+    REQUIRE(stream.empty());
+}
+
+TEST_CASE_METHOD(MulogBinary, "MulogBinary - ResetRestartsTimestampDeltas", "[binary]")
+{
+    timestamp_ms = 5000;
+    REQUIRE(MULOG_LOG_INFO("first") > 0);
+    stream.clear();
+
+    mulog_reset();
+    mulog_set_log_buffer(buffer.data(), buffer.size());
+    mulog_add_output(collect_output);
+    timestamp_ms = 7000;
+    REQUIRE(MULOG_LOG_INFO("second") > 0);
+    REQUIRE(std::vector<std::string>{generate_expected_output("second", MULOG_LOG_LVL_INFO,
+                                                              7000)} == decode_stream());
+}
+
+TEST_CASE("DecoderTests - IncompleteAndMalformedRecords", "[binary]")
+{
+    struct decoder decoder;
+    std::vector<unsigned char> record(64);
+    std::array<char, 64> line{};
+    size_t consumed = 0;
+
+    REQUIRE(DECODER_RET_CODE_OK == decoder_init(&decoder, MULOG_TEST_PROGRAM));
+
+    const auto record_size = encode(record, MULOG_LOG_LVL_WARNING, "%s %d", "value", 1);
+    REQUIRE(record_size > 0);
+
+    for (int size = 0; size < record_size; ++size) {
+        REQUIRE(DECODER_RET_CODE_INCOMPLETE == decoder_decode(&decoder, record.data(), size,
+                                                              line.data(), line.size(),
+                                                              &consumed));
+    }
+
+    REQUIRE(decoder_decode(&decoder, record.data(), record_size, line.data(), line.size(),
+                           &consumed) > 0);
+    REQUIRE(static_cast<size_t>(record_size) == consumed);
+
+    record[WIRE_RECORD_LENGTH_SIZE] = MULOG_LOG_LVL_COUNT;
+    REQUIRE(DECODER_RET_CODE_MALFORMED == decoder_decode(&decoder, record.data(), record_size,
+                                                         line.data(), line.size(), &consumed));
+
+    const std::string dynamic_fmt{"not in the program image %d"};
+    const auto unknown_size = encode(record, MULOG_LOG_LVL_INFO, dynamic_fmt.c_str(), 1);
+    REQUIRE(unknown_size > 0);
+    REQUIRE(DECODER_RET_CODE_UNKNOWN_FORMAT == decoder_decode(&decoder, record.data(),
+                                                              unknown_size, line.data(),
+                                                              line.size(), &consumed));
+    REQUIRE(static_cast<size_t>(unknown_size) == consumed);
+    decoder_free(&decoder);
+}
+
+TEST_CASE("DecoderTests - InvalidProgramFile", "[binary]")
+{
+    struct decoder decoder;
+    const std::string not_elf = std::string{MULOG_TEST_PROGRAM} + ".not_elf";
+    FILE *file = std::fopen(not_elf.c_str(), "wb");
+
+    REQUIRE(file != nullptr);
+    std::fputs("definitely not an ELF file, but long enough to have an ELF header in it", file);
+    std::fclose(file);
+
+    REQUIRE(DECODER_RET_CODE_IO_ERROR == decoder_init(&decoder, "/nonexistent/program"));
+    REQUIRE(DECODER_RET_CODE_INVALID_ELF == decoder_init(&decoder, not_elf.c_str()));
+    std::remove(not_elf.c_str());
+}
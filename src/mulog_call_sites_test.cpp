@@ -0,0 +1,170 @@
+/**
+ * \file
+ * \brief mulog tests for the log call site registry
+ * \author Vladimir Petrigo
+ */
+#include "internal/config.h"
+#include "internal/utils.h"
+#include "mulog.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+    std::vector<std::string> collected;
+
+    void collect_output(const char *buf, const size_t buf_size)
+    {
+        collected.emplace_back(buf, buf_size);
+    }
+
+    int log_first_site(const int value)
+    {
+        return MULOG_LOG_INFO("first site %d", value);
+    }
+
+    int log_second_site(const int value)
+    {
+        return MULOG_LOG_WARN("second site %d", value);
+    }
+
+    struct mulog_call_site *find_call_site(const char *fmt)
+    {
+        for (size_t i = 0; i < mulog_call_site_count(); ++i) {
+            struct mulog_call_site *site = mulog_call_site_get(i);
+
+            if (std::strcmp(site->fmt, fmt) == 0) {
+                return site;
+            }
+        }
+
+        return nullptr;
+    }
+
+    extern "C" bool mulog_config_mulog_lock(void)
+    {
+        return true;
+    }
+
+    extern "C" bool mulog_config_mulog_trylock(void)
+    {
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_unlock(void)
+    {
+    }
+
+    extern "C" bool mulog_config_mulog_format_lock(void)
+    {
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_format_unlock(void)
+    {
+    }
+
+    extern "C" bool mulog_config_mulog_output_lock(void)
+    {
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_output_unlock(void)
+    {
+    }
+
+    extern "C" unsigned long mulog_config_mulog_timestamp_get(void)
+    {
+        return 42123UL;
+    }
+
+    extern "C" void putchar_(int c)
+    {
+    }
+} // namespace
+
+class MulogCallSites {
+public:
+    std::array<char, 128> buffer{};
+
+    MulogCallSites()
+    {
+        mulog_set_log_buffer(buffer.data(), buffer.size());
+        mulog_add_output_with_log_level(collect_output, MULOG_LOG_LVL_TRACE);
+        collected.clear();
+    }
+
+    ~MulogCallSites()
+    {
+        mulog_call_site_enable(nullptr, 0, true);
+        mulog_reset();
+    }
+};
+
+TEST_CASE_METHOD(MulogCallSites, "MulogCallSites - Enumerate", "[realtime][call_sites]")
+{
+    REQUIRE(mulog_call_site_count() >= 2);
+    REQUIRE(nullptr == mulog_call_site_get(mulog_call_site_count()));
+
+    const auto *first = find_call_site("first site %d");
+    REQUIRE(nullptr != first);
+    REQUIRE(MULOG_LOG_LVL_INFO == first->level);
+    REQUIRE(std::string{first->file}.ends_with("mulog_call_sites_test.cpp"));
+    REQUIRE(first->enabled);
+
+    const auto *second = find_call_site("second site %d");
+    REQUIRE(nullptr != second);
+    REQUIRE(MULOG_LOG_LVL_WARNING == second->level);
+    REQUIRE(second->line > first->line);
+
+    size_t visited = 0;
+    mulog_call_site_for_each(
+        [](struct mulog_call_site *site, void *arg) {
+            REQUIRE(nullptr != site->fmt);
+            ++*static_cast<size_t *>(arg);
+        },
+        &visited);
+    REQUIRE(mulog_call_site_count() == visited);
+    mulog_call_site_for_each(nullptr, nullptr);
+}
+
+TEST_CASE_METHOD(MulogCallSites, "MulogCallSites - DisableSingleSite", "[realtime][call_sites]")
+{
+    const auto *first = find_call_site("first site %d");
+    REQUIRE(nullptr != first);
+
+    REQUIRE(1 == mulog_call_site_enable("mulog_call_sites_test.cpp", first->line, false));
+    REQUIRE_FALSE(first->enabled);
+    REQUIRE(0 == log_first_site(1));
+    REQUIRE(log_second_site(2) > 0);
+    REQUIRE(1 == collected.size());
+
+    REQUIRE(1 == mulog_call_site_enable(nullptr, first->line, true));
+    REQUIRE(log_first_site(3) > 0);
+    REQUIRE(2 == collected.size());
+}
+
+TEST_CASE_METHOD(MulogCallSites, "MulogCallSites - DisableFile", "[realtime][call_sites]")
+{
+    REQUIRE(mulog_call_site_count() ==
+            mulog_call_site_enable("mulog_call_sites_test.cpp", 0, false));
+    REQUIRE(0 == log_first_site(1));
+    REQUIRE(0 == log_second_site(2));
+    REQUIRE(collected.empty());
+
+    REQUIRE(0 == mulog_call_site_enable("other.c", 0, true));
+    REQUIRE(0 == mulog_call_site_enable("a/much/longer/path/mulog_call_sites_test.cpp", 0, true));
+    REQUIRE(0 == log_first_site(3));
+}
+
+TEST_CASE_METHOD(MulogCallSites, "MulogCallSites - LogLevelStillApplies", "[realtime][call_sites]")
+{
+    REQUIRE(MULOG_RET_CODE_OK == mulog_set_log_level(MULOG_LOG_LVL_WARNING));
+    REQUIRE(0 == log_first_site(1));
+    REQUIRE(log_second_site(2) > 0);
+    REQUIRE(1 == collected.size());
+}
@@ -0,0 +1,122 @@
+/**
+ * \file
+ * \brief mulog tests for the log level macros stripped at compile time
+ * \author Vladimir Petrigo
+ */
+#include "internal/config.h"
+#include "internal/utils.h"
+#include "mulog.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <string>
+#include <vector>
+
+static_assert(MULOG_COMPILE_TIME_LEVEL == MULOG_LOG_LVL_INFO,
+              "The test expects the info compile time log level");
+
+namespace {
+    std::vector<std::string> collected;
+
+    void collect_output(const char *buf, const size_t buf_size)
+    {
+        collected.emplace_back(buf, buf_size);
+    }
+
+    extern "C" bool mulog_config_mulog_lock(void)
+    {
+        return true;
+    }
+
+    extern "C" bool mulog_config_mulog_trylock(void)
+    {
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_unlock(void)
+    {
+    }
+
+    extern "C" bool mulog_config_mulog_format_lock(void)
+    {
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_format_unlock(void)
+    {
+    }
+
+    extern "C" bool mulog_config_mulog_output_lock(void)
+    {
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_output_unlock(void)
+    {
+    }
+
+    extern "C" unsigned long mulog_config_mulog_timestamp_get(void)
+    {
+        return 42123UL;
+    }
+
+    extern "C" void putchar_(int c)
+    {
+    }
+} // namespace
+
+class MulogCompileTimeLevel {
+public:
+    std::array<char, 128> buffer{};
+
+    MulogCompileTimeLevel()
+    {
+        mulog_set_log_buffer(buffer.data(), buffer.size());
+        mulog_add_output_with_log_level(collect_output, MULOG_LOG_LVL_TRACE);
+        collected.clear();
+    }
+
+    ~MulogCompileTimeLevel()
+    {
+        mulog_reset();
+    }
+};
+
+TEST_CASE_METHOD(MulogCompileTimeLevel, "MulogCompileTimeLevel - StrippedLevels",
+                 "[realtime][compile_time_level]")
+{
+    int evaluated = 0;
+
+    REQUIRE_FALSE(mulog_is_log_level_enabled(MULOG_LOG_LVL_TRACE));
+    REQUIRE_FALSE(mulog_is_log_level_enabled(MULOG_LOG_LVL_DEBUG));
+    REQUIRE(0 == MULOG_LOG_TRACE("trace %d", ++evaluated));
+    REQUIRE(0 == MULOG_LOG_DBG("debug %d", ++evaluated));
+    REQUIRE(0 == evaluated);
+    REQUIRE(collected.empty());
+}
+
+TEST_CASE_METHOD(MulogCompileTimeLevel, "MulogCompileTimeLevel - EnabledLevels",
+                 "[realtime][compile_time_level]")
+{
+    int evaluated = 0;
+
+    REQUIRE(mulog_is_log_level_enabled(MULOG_LOG_LVL_INFO));
+    REQUIRE(MULOG_LOG_INFO("info %d", ++evaluated) > 0);
+    REQUIRE(MULOG_LOG_WARN("warning %d", ++evaluated) > 0);
+    REQUIRE(MULOG_LOG_ERR("error %d", ++evaluated) > 0);
+    REQUIRE(3 == evaluated);
+    REQUIRE(3 == collected.size());
+}
+
+TEST_CASE_METHOD(MulogCompileTimeLevel, "MulogCompileTimeLevel - DirectCallNotStripped",
+                 "[realtime][compile_time_level]")
+{
+    // only the macros are stripped, the runtime log level still applies to mulog_log()
+    REQUIRE(mulog_log(MULOG_LOG_LVL_DEBUG, "debug %d", 1) > 0);
+    REQUIRE(1 == collected.size());
+
+    if constexpr (!MULOG_ENABLE_BINARY_OUTPUT) {
+        REQUIRE(std::string::npos != collected.front().find(MULOG_DEBUG_LVL));
+    }
+}
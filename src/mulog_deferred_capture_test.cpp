@@ -0,0 +1,539 @@
+/**
+ * \file
+ * \brief mulog tests for the deferred logging mode with arguments capture
+ * \author Vladimir Petrigo
+ */
+#include "internal/config.h"
+#include "internal/utils.h"
+#include "mulog.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/trompeloeil.hpp>
+
+#include <fmt/format.h>
+
+#include <array>
+#include <cstdarg>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr std::array log_levels{
+        MULOG_TRACE_LVL, MULOG_DEBUG_LVL, MULOG_INFO_LVL, MULOG_WARNING_LVL, MULOG_ERROR_LVL,
+    };
+
+    class OutputMock {
+    public:
+        MAKE_MOCK2(test_output, void(const char *, const size_t));
+    };
+
+    OutputMock output_mock;
+    size_t format_calls = 0;
+    unsigned long timestamp = 42123UL;
+    std::vector<std::string> collected;
+
+    void test_output(const char *buf, const size_t buf_size)
+    {
+        const std::string expected_str{buf, buf_size};
+
+        output_mock.test_output(expected_str.c_str(), buf_size);
+    }
+
+    void collect_output(const char *buf, const size_t buf_size)
+    {
+        collected.emplace_back(buf, buf_size);
+    }
+
+    std::vector<std::vector<std::string>> collected_batches;
+
+    void collect_output_vec(const mulog_iovec *lines, const size_t count)
+    {
+        auto &batch = collected_batches.emplace_back();
+
+        for (size_t i = 0; i < count; ++i) {
+            batch.emplace_back(lines[i].base, lines[i].len);
+        }
+    }
+
+    std::string generate_expected_output(const std::string &input, const mulog_log_level log_level,
+                                         const unsigned long timestamp_ms = timestamp)
+    {
+        if constexpr (MULOG_ENABLE_TIMESTAMP) {
+            return fmt::format("{:07}.{:03} {}: {}{}", timestamp_ms / 1000, timestamp_ms % 1000,
+                               log_levels[log_level], input, MULOG_LOG_LINE_TERMINATION);
+        } else {
+            return fmt::format("{}: {}{}", log_levels[log_level], input,
+                               MULOG_LOG_LINE_TERMINATION);
+        }
+    }
+
+    extern "C" bool mulog_config_mulog_lock(void)
+    {
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_unlock(void)
+    {
+    }
+
+    extern "C" bool mulog_config_mulog_format_lock(void)
+    {
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_format_unlock(void)
+    {
+    }
+
+    extern "C" bool mulog_config_mulog_output_lock(void)
+    {
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_output_unlock(void)
+    {
+    }
+
+    extern "C" unsigned long mulog_config_mulog_timestamp_get(void)
+    {
+        return timestamp;
+    }
+
+    extern "C" void putchar_(int c)
+    {
+    }
+
+    extern "C" int __real_vsnprintf_(char *s, size_t count, const char *fmt, va_list ap);
+
+    extern "C" int __wrap_vsnprintf_(char *s, size_t count, const char *fmt, va_list ap)
+    {
+        ++format_calls;
+
+        return __real_vsnprintf_(s, count, fmt, ap);
+    }
+
+    extern "C" int __wrap_snprintf_(char *s, size_t count, const char *fmt, ...)
+    {
+        va_list ap;
+
+        ++format_calls;
+        va_start(ap, fmt);
+        const int value = __real_vsnprintf_(s, count, fmt, ap);
+        va_end(ap);
+
+        return value;
+    }
+} // namespace
+
+class MulogDeferredCapture {
+public:
+    alignas(uint32_t) std::array<char, 512> buffer{};
+
+    MulogDeferredCapture()
+    {
+        mulog_set_log_buffer(buffer.data(), buffer.size());
+        timestamp = 42123UL;
+        format_calls = 0;
+        collected.clear();
+    }
+
+    ~MulogDeferredCapture()
+    {
+        mulog_reset();
+    }
+};
+
+TEST_CASE_METHOD(MulogDeferredCapture, "MulogDeferredCapture - ProducerDoesNotFormat",
+                 "[deferred][capture]")
+{
+    auto ret = mulog_add_output(test_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    REQUIRE(MULOG_LOG_ERR("%s %d %05.2f %c", "value", 42, 3.14159, 'x') > 0);
+    REQUIRE(0 == format_calls);
+
+    const auto expected = generate_expected_output("value 42 03.14 x", MULOG_LOG_LVL_ERROR);
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::eq(expected), expected.size()));
+    REQUIRE(expected.size() == mulog_deferred_process());
+    REQUIRE(format_calls > 0);
+}
+
+TEST_CASE_METHOD(MulogDeferredCapture, "MulogDeferredCapture - TimestampCapturedByProducer",
+                 "[deferred][capture]")
+{
+    auto ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    REQUIRE(MULOG_LOG_INFO("first") > 0);
+    timestamp = 1000UL;
+    REQUIRE(MULOG_LOG_INFO("second") > 0);
+    timestamp = 5000UL;
+    mulog_deferred_process();
+
+    const std::vector<std::string> expected{
+        generate_expected_output("first", MULOG_LOG_LVL_INFO, 42123UL),
+        generate_expected_output("second", MULOG_LOG_LVL_INFO, 1000UL),
+    };
+    REQUIRE(expected == collected);
+}
+
+TEST_CASE_METHOD(MulogDeferredCapture, "MulogDeferredCapture - StringsAreCopied",
+                 "[deferred][capture]")
+{
+    auto ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    std::string str{"before"};
+    REQUIRE(MULOG_LOG_INFO("%s", str.c_str()) > 0);
+    str = "after!";
+    mulog_deferred_process();
+
+    REQUIRE(1 == collected.size());
+    REQUIRE(generate_expected_output("before", MULOG_LOG_LVL_INFO) == collected.front());
+}
+
+TEST_CASE_METHOD(MulogDeferredCapture, "MulogDeferredCapture - StringPrecisionLimitsCopy",
+                 "[deferred][capture]")
+{
+    auto ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    // a buffer without the null terminator is only read up to the precision
+    const auto packet = std::make_unique<char[]>(4);
+    std::memcpy(packet.get(), "pkt!", 4);
+    REQUIRE(MULOG_LOG_INFO("%.*s|%.3s", 4, packet.get(), packet.get()) > 0);
+    mulog_deferred_process();
+
+    REQUIRE(std::vector{generate_expected_output("pkt!|pkt", MULOG_LOG_LVL_INFO)} == collected);
+}
+
+TEST_CASE_METHOD(MulogDeferredCapture, "MulogDeferredCapture - OneLinePerOutputCall",
+                 "[deferred][capture]")
+{
+    auto ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_set_log_level(MULOG_LOG_LVL_TRACE);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    std::vector<std::string> expected;
+
+    // several rounds to make records wrap around the ring buffer end
+    for (size_t round = 0; round < 10; ++round) {
+        for (size_t lvl = MULOG_LOG_LVL_TRACE; lvl < MULOG_LOG_LVL_COUNT; ++lvl) {
+            const auto level = static_cast<mulog_log_level>(lvl);
+
+            REQUIRE(mulog_log(level, "round %zu level %zu", round, lvl) > 0);
+            expected.push_back(
+                generate_expected_output(fmt::format("round {} level {}", round, lvl), level));
+        }
+
+        mulog_deferred_process();
+    }
+
+    REQUIRE(expected == collected);
+}
+
+TEST_CASE_METHOD(MulogDeferredCapture, "MulogDeferredCapture - VectoredOutputBatches",
+                 "[deferred][capture]")
+{
+    auto ret = mulog_add_output_vec(collect_output_vec, MULOG_LOG_LVL_DEBUG);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    collected_batches.clear();
+
+    std::vector<std::string> expected;
+
+    // every line of a batch is formatted into its own storage
+    for (size_t i = 0; i <= MULOG_OUTPUT_BATCH_SIZE; ++i) {
+        REQUIRE(MULOG_LOG_INFO("line %zu", i) > 0);
+        expected.push_back(generate_expected_output(fmt::format("line {}", i), MULOG_LOG_LVL_INFO));
+    }
+
+    mulog_deferred_process();
+    REQUIRE(2 == collected_batches.size());
+    REQUIRE(MULOG_OUTPUT_BATCH_SIZE == collected_batches.front().size());
+    REQUIRE(1 == collected_batches.back().size());
+
+    std::vector<std::string> lines = collected_batches.front();
+    lines.push_back(collected_batches.back().front());
+    REQUIRE(expected == lines);
+}
+
+TEST_CASE_METHOD(MulogDeferredCapture, "MulogDeferredCapture - PriorityBufferOutputFirst",
+                 "[deferred][capture]")
+{
+    alignas(uint32_t) std::array<char, 256> priority_buffer{};
+    auto ret = mulog_set_priority_log_buffer(priority_buffer.data(), priority_buffer.size());
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    collected.clear();
+
+    REQUIRE(MULOG_LOG_INFO("first %d", 1) > 0);
+    REQUIRE(MULOG_LOG_WARN("second %d", 2) > 0);
+    REQUIRE(MULOG_LOG_INFO("third %d", 3) > 0);
+
+    // the warning is output first, sequence numbers keep the logging order
+    const std::vector<std::string> expected{
+        "#2 " + generate_expected_output("second 2", MULOG_LOG_LVL_WARNING),
+        "#1 " + generate_expected_output("first 1", MULOG_LOG_LVL_INFO),
+        "#3 " + generate_expected_output("third 3", MULOG_LOG_LVL_INFO),
+    };
+    REQUIRE(mulog_deferred_process() > 0);
+    REQUIRE(expected == collected);
+}
+
+TEST_CASE_METHOD(MulogDeferredCapture, "MulogDeferredCapture - PersistentBufferUnsupported",
+                 "[deferred][capture]")
+{
+    // captured entries refer to format strings of the running program
+    alignas(uint32_t) std::array<char, 256> persistent_buffer{};
+    auto ret = mulog_set_persistent_log_buffer(persistent_buffer.data(), persistent_buffer.size());
+    REQUIRE(MULOG_RET_CODE_UNSUPPORTED == ret);
+    REQUIRE(MULOG_RET_CODE_UNSUPPORTED == mulog_deferred_recover(persistent_buffer.data(),
+                                                                 persistent_buffer.size(),
+                                                                 collect_output));
+}
+
+TEST_CASE_METHOD(MulogDeferredCapture, "MulogDeferredCapture - EmergencyFlushFormatsEntries",
+                 "[deferred][capture]")
+{
+    // the output is registered for entries to be stored, the flush does not call it
+    auto ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE(MULOG_LOG_INFO("value %d", 42) > 0);
+    REQUIRE(MULOG_LOG_ERR("name %s", "abc") > 0);
+
+    const std::vector<std::string> expected{
+        generate_expected_output("value 42", MULOG_LOG_LVL_INFO),
+        generate_expected_output("name abc", MULOG_LOG_LVL_ERROR),
+        fmt::format("{}: crash{}", log_levels[MULOG_LOG_LVL_ERROR], MULOG_LOG_LINE_TERMINATION),
+    };
+    REQUIRE(mulog_deferred_emergency_flush(collect_output, "crash") > 0);
+    REQUIRE(expected == collected);
+}
+
+TEST_CASE_METHOD(MulogDeferredCapture, "MulogDeferredCapture - FlightRecorderDumpsContextOnError",
+                 "[deferred][capture]")
+{
+    alignas(uint32_t) std::array<char, 256> recorder{};
+    auto ret = mulog_set_flight_recorder(recorder.data(), recorder.size(), MULOG_LOG_LVL_WARNING);
+
+    if constexpr (MULOG_ENABLE_LOCKFREE_DEFERRED) {
+        REQUIRE(MULOG_RET_CODE_UNSUPPORTED == ret);
+        return;
+    }
+
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    REQUIRE(MULOG_LOG_INFO("context %d", 1) > 0);
+    REQUIRE(MULOG_LOG_WARN("warning %d", 2) > 0);
+    REQUIRE(mulog_deferred_process() > 0);
+    REQUIRE(std::vector{generate_expected_output("warning 2", MULOG_LOG_LVL_WARNING)} ==
+            collected);
+
+    // the recorded entry is formatted along with the error
+    collected.clear();
+    REQUIRE(MULOG_LOG_ERR("error %d", 3) > 0);
+    REQUIRE(mulog_deferred_process() > 0);
+    REQUIRE(std::vector{generate_expected_output("context 1", MULOG_LOG_LVL_INFO),
+                        generate_expected_output("error 3", MULOG_LOG_LVL_ERROR)} == collected);
+}
+
+TEST_CASE_METHOD(MulogDeferredCapture, "MulogDeferredCapture - LongLineTruncation",
+                 "[deferred][capture]")
+{
+    const std::string long_string(MULOG_SINGLE_LOG_LINE_SIZE + 10, '#');
+    auto ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    REQUIRE(MULOG_LOG_WARN("%s", long_string.c_str()) > 0);
+    mulog_deferred_process();
+
+    const auto expected = generate_expected_output(
+        long_string.substr(0, MULOG_SINGLE_LOG_LINE_SIZE), MULOG_LOG_LVL_WARNING);
+    REQUIRE(1 == collected.size());
+    REQUIRE(expected == collected.front());
+}
+
+TEST_CASE_METHOD(MulogDeferredCapture, "MulogDeferredCapture - FullBufferDropsRecord",
+                 "[deferred][capture]")
+{
+    const std::string entry(100, 'a');
+    auto ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    size_t logged = 0;
+
+    for (size_t i = 0; i < 10; ++i) {
+        if (MULOG_LOG_ERR("%s", entry.c_str()) > 0) {
+            ++logged;
+        }
+    }
+
+    REQUIRE(logged > 0);
+    REQUIRE(logged < 10);
+    REQUIRE(10 - logged == mulog_deferred_get_dropped_count());
+    mulog_deferred_process();
+    REQUIRE(logged + 1 == collected.size());
+    REQUIRE(generate_expected_output(fmt::format("{} log entries dropped", 10 - logged),
+                                     MULOG_LOG_LVL_WARNING) == collected.front());
+
+    for (size_t i = 1; i < collected.size(); ++i) {
+        REQUIRE(generate_expected_output(entry, MULOG_LOG_LVL_ERROR) == collected[i]);
+    }
+}
+
+TEST_CASE_METHOD(MulogDeferredCapture, "MulogDeferredCapture - DropOldestPolicy",
+                 "[deferred][capture]")
+{
+    auto ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_deferred_set_overflow_policy(MULOG_OVERFLOW_DROP_OLDEST, 0);
+
+    // lock-free producers cannot evict records the consumer may be reading
+    if constexpr (MULOG_ENABLE_LOCKFREE_DEFERRED) {
+        REQUIRE(MULOG_RET_CODE_UNSUPPORTED == ret);
+        return;
+    }
+
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    const std::string entry(100, 'o');
+
+    for (size_t i = 0; i < 10; ++i) {
+        REQUIRE(MULOG_LOG_INFO("%zu %s", i, entry.c_str()) > 0);
+    }
+
+    const auto dropped = mulog_deferred_get_dropped_count();
+    REQUIRE(dropped > 0);
+    REQUIRE(dropped == mulog_deferred_get_level_dropped_count(MULOG_LOG_LVL_INFO));
+    mulog_deferred_process();
+    REQUIRE(11 - dropped == collected.size());
+    REQUIRE(generate_expected_output(fmt::format("{} log entries dropped", dropped),
+                                     MULOG_LOG_LVL_WARNING) == collected.front());
+
+    for (size_t i = 1; i < collected.size(); ++i) {
+        REQUIRE(generate_expected_output(fmt::format("{} {}", dropped + i - 1, entry),
+                                         MULOG_LOG_LVL_INFO) == collected[i]);
+    }
+}
+
+TEST_CASE_METHOD(MulogDeferredCapture, "MulogDeferredCapture - ProcessTimeBudget",
+                 "[deferred][capture]")
+{
+    // every output call takes 10 ms
+    auto ret = mulog_add_output([](const char *buf, const size_t buf_size) {
+        collect_output(buf, buf_size);
+        timestamp += 10;
+    });
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    for (size_t i = 0; i < 5; ++i) {
+        REQUIRE(MULOG_LOG_INFO("entry %zu", i) > 0);
+    }
+
+    const mulog_process_budget budget{0, 0, 25};
+    size_t remaining = 0;
+    const auto processed = mulog_deferred_process_budget(&budget, &remaining);
+
+    if constexpr (!MULOG_ENABLE_TIMESTAMP) {
+        REQUIRE(MULOG_RET_CODE_UNSUPPORTED == processed);
+        return;
+    }
+
+    REQUIRE(3 == collected.size());
+    REQUIRE(remaining > 0);
+    REQUIRE(processed > 0);
+    REQUIRE(mulog_deferred_process_budget(&budget, &remaining) > 0);
+    REQUIRE(5 == collected.size());
+    REQUIRE(0 == remaining);
+
+    for (size_t i = 0; i < collected.size(); ++i) {
+        REQUIRE(generate_expected_output(fmt::format("entry {}", i), MULOG_LOG_LVL_INFO, 42123UL) ==
+                collected[i]);
+    }
+}
+
+TEST_CASE_METHOD(MulogDeferredCapture, "MulogDeferredCapture - FilteredLevels",
+                 "[deferred][capture]")
+{
+    auto ret = mulog_add_output(test_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_set_log_level(MULOG_LOG_LVL_WARNING);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    REQUIRE(0 == MULOG_LOG_INFO("info %d", 1));
+    REQUIRE(0 == mulog_log(MULOG_LOG_LVL_COUNT, "invalid"));
+    FORBID_CALL(output_mock, test_output(trompeloeil::_, trompeloeil::_));
+    REQUIRE(0 == mulog_deferred_process());
+}
+
+TEST_CASE_METHOD(MulogDeferredCapture, "MulogDeferredCapture - PerOutputLogLevel",
+                 "[deferred][capture]")
+{
+    auto ret = mulog_add_output_with_log_level(test_output, MULOG_LOG_LVL_ERROR);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_add_output_with_log_level(collect_output, MULOG_LOG_LVL_DEBUG);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    REQUIRE(0 == MULOG_LOG_TRACE("trace %d", 1));
+    REQUIRE(MULOG_LOG_DBG("debug %d", 2) > 0);
+    REQUIRE(MULOG_LOG_ERR("error %d", 3) > 0);
+
+    const auto expected_error = generate_expected_output("error 3", MULOG_LOG_LVL_ERROR);
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::eq(expected_error), expected_error.size()));
+    REQUIRE(mulog_deferred_process() > 0);
+    REQUIRE(std::vector<std::string>{generate_expected_output("debug 2", MULOG_LOG_LVL_DEBUG),
+                                     expected_error} == collected);
+}
+
+TEST_CASE("MulogDeferredCapture - NoBuffer", "[deferred][capture]")
+{
+    auto ret = mulog_add_output(test_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE(0 == MULOG_LOG_ERR("no buffer"));
+    REQUIRE(0 == mulog_deferred_process());
+    mulog_reset();
+}
+
+TEST_CASE_METHOD(MulogDeferredCapture, "MulogDeferredCapture - LoggerInstances",
+                 "[deferred][capture]")
+{
+    static std::vector<std::string> instance_collected;
+    alignas(uint32_t) std::array<char, 512> instance_buffer{};
+    const mulog_log_output_fn instance_output = [](const char *buf, const size_t buf_size) {
+        instance_collected.emplace_back(buf, buf_size);
+    };
+    auto *instance = mulog_instance_init(nullptr);
+
+    if constexpr (MULOG_INSTANCES == 0) {
+        REQUIRE(nullptr == instance);
+        return;
+    }
+
+    REQUIRE(nullptr != instance);
+    auto ret = mulog_instance_set_log_buffer(instance, instance_buffer.data(),
+                                             instance_buffer.size());
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_instance_add_output(instance, instance_output, MULOG_LOG_LVL_DEBUG);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    instance_collected.clear();
+
+    // arguments are captured into the logger buffer and formatted when the logger is processed
+    REQUIRE(mulog_instance_log(instance, MULOG_LOG_LVL_WARNING, "instance %d %s", 7, "x") > 0);
+    REQUIRE(MULOG_LOG_INFO("default %d", 3) > 0);
+    REQUIRE(0 == format_calls);
+    REQUIRE(mulog_instance_process(instance) > 0);
+    REQUIRE(std::vector{generate_expected_output("instance 7 x", MULOG_LOG_LVL_WARNING)} ==
+            instance_collected);
+    REQUIRE(collected.empty());
+    REQUIRE(mulog_deferred_process() > 0);
+    REQUIRE(std::vector{generate_expected_output("default 3", MULOG_LOG_LVL_INFO)} == collected);
+    mulog_instance_deinit(instance);
+}
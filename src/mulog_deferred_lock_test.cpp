@@ -3,6 +3,7 @@
  * \brief
  * \author
  */
+#include "internal/config.h"
 #include "internal/utils.h"
 #include "mulog.h"
 
@@ -13,6 +14,9 @@
 #include <cstdarg>
 
 namespace {
+    // a log buffer change also takes the format lock with lock domains
+    constexpr size_t buffer_locks = MULOG_ENABLE_LOCK_DOMAINS ? 2 : 1;
+
     class ApiMock {
     public:
         MAKE_MOCK0(mulog_config_mulog_lock, bool());
@@ -43,6 +47,26 @@ namespace {
         api.mulog_config_mulog_unlock();
     }
 
+    // formatting is serialized by the format lock with lock domains, the output lock is not mocked
+    extern "C" bool mulog_config_mulog_format_lock(void)
+    {
+        return api.mulog_config_mulog_lock();
+    }
+
+    extern "C" void mulog_config_mulog_format_unlock(void)
+    {
+        api.mulog_config_mulog_unlock();
+    }
+
+    extern "C" bool mulog_config_mulog_output_lock(void)
+    {
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_output_unlock(void)
+    {
+    }
+
     extern "C" unsigned long mulog_config_mulog_timestamp_get(void)
     {
         return 42123UL;
@@ -108,15 +132,15 @@ public:
 
     MulogDeferredLock()
     {
-        REQUIRE_CALL(api, mulog_config_mulog_lock()).RETURN(true);
-        REQUIRE_CALL(api, mulog_config_mulog_unlock());
+        REQUIRE_CALL(api, mulog_config_mulog_lock()).TIMES(buffer_locks).RETURN(true);
+        REQUIRE_CALL(api, mulog_config_mulog_unlock()).TIMES(buffer_locks);
         mulog_set_log_buffer(buffer.data(), buffer.size());
     }
 
     ~MulogDeferredLock()
     {
-        REQUIRE_CALL(api, mulog_config_mulog_lock()).RETURN(true);
-        REQUIRE_CALL(api, mulog_config_mulog_unlock());
+        REQUIRE_CALL(api, mulog_config_mulog_lock()).TIMES(buffer_locks).RETURN(true);
+        REQUIRE_CALL(api, mulog_config_mulog_unlock()).TIMES(buffer_locks);
         mulog_reset();
     }
 };
@@ -134,7 +158,7 @@ TEST_CASE_METHOD(MulogDeferredLock, "MulogDeferredLock - SimpleOperations", "[de
     REQUIRE_CALL(api, mulog_config_mulog_lock()).RETURN(true);
     REQUIRE_CALL(api, mulog_config_mulog_unlock());
     ret = mulog_set_channel_log_level(test_output, MULOG_LOG_LVL_ERROR);
-    REQUIRE(MULOG_RET_CODE_UNSUPPORTED == ret);
+    REQUIRE(MULOG_RET_CODE_NOT_FOUND == ret);
     REQUIRE_CALL(api, mulog_config_mulog_lock()).RETURN(false);
     ret = mulog_set_channel_log_level(test_output, MULOG_LOG_LVL_TRACE);
     REQUIRE(MULOG_RET_CODE_LOCK_FAILED == ret);
@@ -150,7 +174,7 @@ TEST_CASE_METHOD(MulogDeferredLock, "MulogDeferredLock - SimpleOperations", "[de
     REQUIRE_CALL(api, mulog_config_mulog_lock()).RETURN(true);
     REQUIRE_CALL(api, mulog_config_mulog_unlock());
     ret = mulog_add_output_with_log_level(test_output, MULOG_LOG_LVL_ERROR);
-    REQUIRE(MULOG_RET_CODE_UNSUPPORTED == ret);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
     REQUIRE_CALL(api, mulog_config_mulog_lock()).RETURN(false);
     ret = mulog_add_output_with_log_level(test_output, MULOG_LOG_LVL_ERROR);
     REQUIRE(MULOG_RET_CODE_LOCK_FAILED == ret);
@@ -211,13 +235,15 @@ TEST_CASE_METHOD(MulogDeferredLock, "MulogDeferredLock - SimpleOperations", "[de
 
 TEST_CASE_METHOD(MulogDeferredLock, "MulogDeferredLock - MockLogDeferredProcess", "[deferred][lock]")
 {
-    REQUIRE_CALL(api, __wrap_lwrb_get_full(trompeloeil::_)).RETURN(100UL);
-    REQUIRE_CALL(api, __wrap_lwrb_get_linear_block_read_length(trompeloeil::_)).RETURN(200UL);
+    // not enough data for a record length prefix
+    REQUIRE_CALL(api, __wrap_lwrb_get_full(trompeloeil::_)).RETURN(1UL);
+    FORBID_CALL(api, __wrap_lwrb_get_linear_block_read_length(trompeloeil::_));
     auto ret = mulog_deferred_process();
-    REQUIRE(100UL == ret);
+    REQUIRE(0 == ret);
 
-    REQUIRE_CALL(api, __wrap_lwrb_get_full(trompeloeil::_)).RETURN(300UL);
-    REQUIRE_CALL(api, __wrap_lwrb_get_linear_block_read_length(trompeloeil::_)).RETURN(300UL);
+    // no record is actually stored in the buffer
+    REQUIRE_CALL(api, __wrap_lwrb_get_full(trompeloeil::_)).RETURN(100UL);
+    FORBID_CALL(api, __wrap_lwrb_get_linear_block_read_length(trompeloeil::_));
     ret = mulog_deferred_process();
-    REQUIRE(300UL == ret);
+    REQUIRE(0 == ret);
 }
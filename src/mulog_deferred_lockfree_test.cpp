@@ -0,0 +1,544 @@
+/**
+ * \file
+ * \brief mulog tests for the lock-free deferred logging mode
+ * \author Vladimir Petrigo
+ */
+#include "internal/config.h"
+#include "internal/utils.h"
+#include "mulog.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/trompeloeil.hpp>
+
+#include <fmt/format.h>
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr std::array log_levels{
+        MULOG_TRACE_LVL, MULOG_DEBUG_LVL, MULOG_INFO_LVL, MULOG_WARNING_LVL, MULOG_ERROR_LVL,
+    };
+
+    class OutputMock {
+    public:
+        MAKE_MOCK2(test_output, void(const char *, const size_t));
+    };
+
+    OutputMock output_mock;
+    std::atomic<size_t> lock_calls{0};
+    std::mutex collected_mutex;
+    std::vector<std::string> collected;
+
+    void test_output(const char *buf, const size_t buf_size)
+    {
+        const std::string expected_str{buf, buf_size};
+
+        output_mock.test_output(expected_str.c_str(), buf_size);
+    }
+
+    void collect_output(const char *buf, const size_t buf_size)
+    {
+        const std::lock_guard lock{collected_mutex};
+
+        collected.emplace_back(buf, buf_size);
+    }
+
+    std::vector<size_t> batch_sizes;
+
+    void collect_output_vec(const mulog_iovec *lines, const size_t count)
+    {
+        const std::lock_guard lock{collected_mutex};
+
+        batch_sizes.push_back(count);
+
+        for (size_t i = 0; i < count; ++i) {
+            collected.emplace_back(lines[i].base, lines[i].len);
+        }
+    }
+
+    std::string generate_expected_output(const std::string &input, const mulog_log_level log_level)
+    {
+        if constexpr (MULOG_ENABLE_TIMESTAMP) {
+            const auto timestamp_ms = mulog_config_mulog_timestamp_get();
+
+            return fmt::format("{:07}.{:03} {}: {}{}", timestamp_ms / 1000, timestamp_ms % 1000,
+                               log_levels[log_level], input, MULOG_LOG_LINE_TERMINATION);
+        } else {
+            return fmt::format("{}: {}{}", log_levels[log_level], input,
+                               MULOG_LOG_LINE_TERMINATION);
+        }
+    }
+
+    extern "C" bool mulog_config_mulog_lock(void)
+    {
+        ++lock_calls;
+
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_unlock(void)
+    {
+    }
+
+    extern "C" bool mulog_config_mulog_format_lock(void)
+    {
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_format_unlock(void)
+    {
+    }
+
+    extern "C" bool mulog_config_mulog_output_lock(void)
+    {
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_output_unlock(void)
+    {
+    }
+
+    extern "C" unsigned long mulog_config_mulog_timestamp_get(void)
+    {
+        return 42123UL;
+    }
+
+    extern "C" void putchar_(int c)
+    {
+    }
+} // namespace
+
+class MulogDeferredLockFree {
+public:
+    alignas(uint32_t) std::array<char, 256> buffer{};
+
+    MulogDeferredLockFree()
+    {
+        mulog_set_log_buffer(buffer.data(), buffer.size());
+    }
+
+    ~MulogDeferredLockFree()
+    {
+        mulog_reset();
+    }
+};
+
+TEST_CASE("MulogDeferredLockFree - InvalidLogBuffer", "[deferred][lockfree]")
+{
+    std::array<char, 128> buffer{};
+    auto ret = mulog_set_log_buffer(nullptr, 0);
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG == ret);
+    ret = mulog_set_log_buffer(nullptr, buffer.size());
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG == ret);
+    ret = mulog_set_log_buffer(buffer.data(), 0);
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG == ret);
+    mulog_reset();
+}
+
+TEST_CASE_METHOD(MulogDeferredLockFree, "MulogDeferredLockFree - LogDoesNotLock",
+                 "[deferred][lockfree]")
+{
+    auto ret = mulog_add_output(test_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    const auto calls = lock_calls.load();
+    const auto log_ret = MULOG_LOG_ERR("%s", "no lock");
+    REQUIRE(calls == lock_calls.load());
+    REQUIRE(generate_expected_output("no lock", MULOG_LOG_LVL_ERROR).size() == log_ret);
+
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::_, trompeloeil::_));
+    const auto printed = mulog_deferred_process();
+    REQUIRE(calls == lock_calls.load());
+    REQUIRE(log_ret == printed);
+}
+
+TEST_CASE_METHOD(MulogDeferredLockFree, "MulogDeferredLockFree - OneEntryPerOutputCall",
+                 "[deferred][lockfree]")
+{
+    auto ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_set_log_level(MULOG_LOG_LVL_TRACE);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    collected.clear();
+
+    std::vector<std::string> expected;
+    size_t total = 0;
+
+    for (size_t lvl = MULOG_LOG_LVL_TRACE; lvl < MULOG_LOG_LVL_COUNT; ++lvl) {
+        const auto level = static_cast<mulog_log_level>(lvl);
+        const auto log_ret = mulog_log(level, "%zu", lvl);
+
+        expected.push_back(generate_expected_output(std::to_string(lvl), level));
+        REQUIRE(expected.back().size() == log_ret);
+        total += log_ret;
+    }
+
+    REQUIRE(total == mulog_deferred_process());
+    REQUIRE(expected == collected);
+    REQUIRE(0 == mulog_deferred_process());
+    REQUIRE(expected == collected);
+}
+
+TEST_CASE_METHOD(MulogDeferredLockFree, "MulogDeferredLockFree - VectoredOutputBatches",
+                 "[deferred][lockfree]")
+{
+    auto ret = mulog_add_output_vec(collect_output_vec, MULOG_LOG_LVL_DEBUG);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    collected.clear();
+    batch_sizes.clear();
+
+    alignas(uint32_t) std::array<char, 2048> large_buffer{};
+    ret = mulog_set_log_buffer(large_buffer.data(), large_buffer.size());
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    std::vector<std::string> expected;
+    size_t total = 0;
+
+    // more entries than a single batch holds
+    for (size_t i = 0; i <= MULOG_OUTPUT_BATCH_SIZE; ++i) {
+        const auto log_ret = MULOG_LOG_DBG("%zu", i);
+
+        expected.push_back(generate_expected_output(std::to_string(i), MULOG_LOG_LVL_DEBUG));
+        REQUIRE(expected.back().size() == log_ret);
+        total += log_ret;
+    }
+
+    REQUIRE(total == mulog_deferred_process());
+    REQUIRE(expected == collected);
+
+    std::vector<size_t> expected_sizes;
+
+    for (size_t left = expected.size(); left > 0;) {
+        expected_sizes.push_back(left < MULOG_OUTPUT_BATCH_SIZE ? left : MULOG_OUTPUT_BATCH_SIZE);
+        left -= expected_sizes.back();
+    }
+
+    REQUIRE(expected_sizes == batch_sizes);
+}
+
+TEST_CASE_METHOD(MulogDeferredLockFree, "MulogDeferredLockFree - PriorityBufferOutputFirst",
+                 "[deferred][lockfree]")
+{
+    alignas(uint32_t) std::array<char, 256> priority_buffer{};
+    auto ret = mulog_set_priority_log_buffer(priority_buffer.data(), priority_buffer.size());
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    collected.clear();
+
+    REQUIRE(MULOG_LOG_INFO("first %d", 1) > 0);
+    REQUIRE(MULOG_LOG_WARN("second %d", 2) > 0);
+    REQUIRE(MULOG_LOG_INFO("third %d", 3) > 0);
+
+    // the warning is output first, sequence numbers keep the logging order
+    const std::vector<std::string> expected{
+        "#2 " + generate_expected_output("second 2", MULOG_LOG_LVL_WARNING),
+        "#1 " + generate_expected_output("first 1", MULOG_LOG_LVL_INFO),
+        "#3 " + generate_expected_output("third 3", MULOG_LOG_LVL_INFO),
+    };
+    REQUIRE(mulog_deferred_process() > 0);
+    REQUIRE(expected == collected);
+}
+
+TEST_CASE_METHOD(MulogDeferredLockFree, "MulogDeferredLockFree - PersistentBufferRecovery",
+                 "[deferred][lockfree]")
+{
+    alignas(uint32_t) std::array<char, 256> persistent_buffer{};
+    alignas(uint32_t) std::array<char, 256> crashed{};
+    auto ret = mulog_set_persistent_log_buffer(persistent_buffer.data() + 1,
+                                               persistent_buffer.size() - 1);
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG == ret);
+    ret = mulog_set_persistent_log_buffer(persistent_buffer.data(), persistent_buffer.size());
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    // processed entries move the consumer position around the buffer end
+    for (size_t i = 0; i < 10; ++i) {
+        REQUIRE(MULOG_LOG_INFO("processed %zu", i) > 0);
+        REQUIRE(mulog_deferred_process() > 0);
+    }
+
+    std::vector<std::string> expected;
+
+    for (size_t i = 0; i < 3; ++i) {
+        REQUIRE(MULOG_LOG_WARN("pending %zu", i) > 0);
+        expected.push_back(
+            generate_expected_output(fmt::format("pending {}", i), MULOG_LOG_LVL_WARNING));
+    }
+
+    // only the buffer content is left after a crash
+    crashed = persistent_buffer;
+    collected.clear();
+    REQUIRE(mulog_deferred_recover(crashed.data(), crashed.size(), collect_output) > 0);
+    REQUIRE(expected == collected);
+
+    // processed entries are not recovered
+    REQUIRE(mulog_deferred_process() > 0);
+    crashed = persistent_buffer;
+    collected.clear();
+    REQUIRE(0 == mulog_deferred_recover(crashed.data(), crashed.size(), collect_output));
+    REQUIRE(collected.empty());
+}
+
+TEST_CASE_METHOD(MulogDeferredLockFree, "MulogDeferredLockFree - EmergencyFlush",
+                 "[deferred][lockfree]")
+{
+    // the output is registered for entries to be stored, the flush does not call it
+    auto ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    collected.clear();
+    REQUIRE(MULOG_LOG_INFO("first %d", 1) > 0);
+    REQUIRE(MULOG_LOG_WARN("second %d", 2) > 0);
+
+    const std::vector<std::string> expected{
+        generate_expected_output("first 1", MULOG_LOG_LVL_INFO),
+        generate_expected_output("second 2", MULOG_LOG_LVL_WARNING),
+        fmt::format("{}: crash{}", log_levels[MULOG_LOG_LVL_ERROR], MULOG_LOG_LINE_TERMINATION),
+    };
+    REQUIRE(mulog_deferred_emergency_flush(collect_output, "crash") > 0);
+    REQUIRE(expected == collected);
+
+    // without the final record only the stored entries are passed, they are not removed
+    collected.clear();
+    REQUIRE(mulog_deferred_emergency_flush(collect_output, nullptr) > 0);
+    REQUIRE(std::vector(expected.begin(), expected.end() - 1) == collected);
+}
+
+TEST_CASE_METHOD(MulogDeferredLockFree, "MulogDeferredLockFree - FlightRecorderUnsupported",
+                 "[deferred][lockfree]")
+{
+    // recorded entries are overwritten by producers, which needs the logger lock
+    std::array<char, 128> recorder{};
+    auto ret = mulog_set_flight_recorder(recorder.data(), recorder.size(), MULOG_LOG_LVL_INFO);
+    REQUIRE(MULOG_RET_CODE_UNSUPPORTED == ret);
+    REQUIRE(MULOG_RET_CODE_UNSUPPORTED == mulog_flight_recorder_dump());
+}
+
+TEST_CASE_METHOD(MulogDeferredLockFree, "MulogDeferredLockFree - LogLevelFiltering",
+                 "[deferred][lockfree]")
+{
+    auto ret = mulog_add_output(test_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_set_log_level(MULOG_LOG_LVL_WARNING);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    REQUIRE(0 == MULOG_LOG_TRACE("trace"));
+    REQUIRE(0 == MULOG_LOG_DBG("debug"));
+    REQUIRE(0 == MULOG_LOG_INFO("info"));
+    REQUIRE(0 == mulog_log(MULOG_LOG_LVL_COUNT, "invalid"));
+
+    const auto expected = generate_expected_output("warning", MULOG_LOG_LVL_WARNING);
+    REQUIRE(expected.size() == MULOG_LOG_WARN("warning"));
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::eq(expected), expected.size()));
+    REQUIRE(expected.size() == mulog_deferred_process());
+}
+
+TEST_CASE_METHOD(MulogDeferredLockFree, "MulogDeferredLockFree - NoOutputRegistered",
+                 "[deferred][lockfree]")
+{
+    REQUIRE(0 == MULOG_LOG_ERR("%s", "Hello"));
+    REQUIRE(0 == mulog_deferred_process());
+
+    auto ret = mulog_add_output(test_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_unregister_output(test_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE(0 == MULOG_LOG_ERR("%s", "Hello"));
+}
+
+TEST_CASE_METHOD(MulogDeferredLockFree, "MulogDeferredLockFree - LongEntryTruncation",
+                 "[deferred][lockfree]")
+{
+    const std::string long_string(MULOG_SINGLE_LOG_LINE_SIZE + 10, '#');
+    const auto expected = generate_expected_output(
+        long_string.substr(0, MULOG_SINGLE_LOG_LINE_SIZE), MULOG_LOG_LVL_ERROR);
+    auto ret = mulog_add_output(test_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    const auto log_ret = MULOG_LOG_ERR("%s", long_string.c_str());
+    REQUIRE(expected.size() == log_ret);
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::eq(expected), expected.size()));
+    REQUIRE(expected.size() == mulog_deferred_process());
+}
+
+TEST_CASE_METHOD(MulogDeferredLockFree, "MulogDeferredLockFree - FullRingDropsEntry",
+                 "[deferred][lockfree]")
+{
+    auto ret = mulog_add_output(test_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    const std::string entry(64, 'a');
+    size_t logged = 0;
+    size_t total = 0;
+
+    for (size_t i = 0; i < 10; ++i) {
+        const auto log_ret = MULOG_LOG_ERR("%s", entry.c_str());
+
+        if (log_ret > 0) {
+            ++logged;
+            total += log_ret;
+        }
+    }
+
+    REQUIRE(logged > 0);
+    REQUIRE(logged < 10);
+    REQUIRE(10 - logged == mulog_deferred_get_dropped_count());
+
+    const auto expected = generate_expected_output(entry, MULOG_LOG_LVL_ERROR);
+    const auto marker = generate_expected_output(
+        fmt::format("{} log entries dropped", 10 - logged), MULOG_LOG_LVL_WARNING);
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::eq(marker), marker.size()));
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::eq(expected), expected.size()))
+        .TIMES(logged);
+    REQUIRE(marker.size() + total == mulog_deferred_process());
+}
+
+TEST_CASE_METHOD(MulogDeferredLockFree, "MulogDeferredLockFree - OverflowPolicies",
+                 "[deferred][lockfree]")
+{
+    auto ret = mulog_deferred_set_overflow_policy(MULOG_OVERFLOW_DROP_OLDEST, 0);
+    REQUIRE(MULOG_RET_CODE_UNSUPPORTED == ret);
+    ret = mulog_deferred_set_overflow_policy(MULOG_OVERFLOW_BLOCK, 16);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    const std::string entry(100, 'b');
+    size_t logged = 0;
+
+    while (MULOG_LOG_ERR("%s", entry.c_str()) > 0) {
+        ++logged;
+    }
+
+    REQUIRE(logged > 0);
+    REQUIRE(1 == mulog_deferred_get_level_dropped_count(MULOG_LOG_LVL_ERROR));
+    REQUIRE(0 == mulog_deferred_get_level_dropped_count(MULOG_LOG_LVL_WARNING));
+}
+
+TEST_CASE_METHOD(MulogDeferredLockFree, "MulogDeferredLockFree - ResetClearsBuffer",
+                 "[deferred][lockfree]")
+{
+    auto ret = mulog_add_output(test_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE(MULOG_LOG_DBG("test") > 0);
+    mulog_reset();
+    FORBID_CALL(output_mock, test_output(trompeloeil::_, trompeloeil::_));
+    REQUIRE(0 == mulog_deferred_process());
+}
+
+TEST_CASE_METHOD(MulogDeferredLockFree, "MulogDeferredLockFree - MultipleProducers",
+                 "[deferred][lockfree]")
+{
+    constexpr size_t producers = 4;
+    constexpr size_t entries_per_producer = 2000;
+    auto ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    collected.clear();
+
+    std::atomic<size_t> running{producers};
+    std::vector<std::thread> threads;
+
+    for (size_t id = 0; id < producers; ++id) {
+        threads.emplace_back([id, &running]() {
+            for (size_t seq = 0; seq < entries_per_producer; ++seq) {
+                while (MULOG_LOG_INFO("producer=%zu seq=%zu", id, seq) == 0) {
+                    std::this_thread::yield();
+                }
+            }
+
+            --running;
+        });
+    }
+
+    while (running.load() != 0) {
+        mulog_deferred_process();
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    mulog_deferred_process();
+
+    // retried entries are reported as dropped between the stored ones
+    size_t reported = 0;
+
+    std::erase_if(collected, [&reported](const std::string &entry) {
+        size_t dropped = 0;
+        const auto position = entry.find(": ");
+
+        if (std::sscanf(entry.c_str() + position, ": %zu log entries dropped", &dropped) != 1) {
+            return false;
+        }
+
+        reported += dropped;
+
+        return true;
+    });
+    REQUIRE(mulog_deferred_get_dropped_count() == reported);
+    REQUIRE(producers * entries_per_producer == collected.size());
+
+    std::map<size_t, size_t> next_seq;
+
+    for (const auto &entry : collected) {
+        const auto position = entry.find("producer=");
+        REQUIRE(std::string::npos != position);
+
+        size_t id = 0;
+        size_t seq = 0;
+        REQUIRE(2 == std::sscanf(entry.c_str() + position, "producer=%zu seq=%zu", &id, &seq));
+        REQUIRE(next_seq[id] == seq);
+        REQUIRE(generate_expected_output(fmt::format("producer={} seq={}", id, seq),
+                                         MULOG_LOG_LVL_INFO) == entry);
+        next_seq[id] = seq + 1;
+    }
+}
+
+TEST_CASE_METHOD(MulogDeferredLockFree, "MulogDeferredLockFree - LoggerInstances",
+                 "[deferred][lockfree]")
+{
+    static std::vector<std::string> instance_collected;
+    alignas(uint32_t) std::array<char, 256> instance_buffer{};
+    const mulog_log_output_fn instance_output = [](const char *buf, const size_t buf_size) {
+        instance_collected.emplace_back(buf, buf_size);
+    };
+    auto *instance = mulog_instance_init(nullptr);
+
+    if constexpr (MULOG_INSTANCES == 0) {
+        REQUIRE(nullptr == instance);
+        return;
+    }
+
+    REQUIRE(nullptr != instance);
+    auto ret = mulog_instance_set_log_buffer(instance, instance_buffer.data(),
+                                             instance_buffer.size());
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_instance_add_output(instance, instance_output, MULOG_LOG_LVL_DEBUG);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    collected.clear();
+    instance_collected.clear();
+
+    // instance producers do not take the lock either
+    const auto locks_before = lock_calls.load();
+    REQUIRE(mulog_instance_log(instance, MULOG_LOG_LVL_INFO, "instance") > 0);
+    REQUIRE(MULOG_LOG_INFO("default") > 0);
+    REQUIRE(locks_before == lock_calls.load());
+
+    REQUIRE(mulog_instance_process(instance) > 0);
+    REQUIRE(std::vector{generate_expected_output("instance", MULOG_LOG_LVL_INFO)} ==
+            instance_collected);
+    REQUIRE(collected.empty());
+    REQUIRE(mulog_deferred_process() > 0);
+    REQUIRE(std::vector{generate_expected_output("default", MULOG_LOG_LVL_INFO)} == collected);
+    mulog_instance_deinit(instance);
+}
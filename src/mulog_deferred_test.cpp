@@ -13,8 +13,12 @@
 #include <fmt/format.h>
 
 #include <array>
+#include <csignal>
+#include <cstdint>
 #include <iostream>
+#include <string>
 #include <string_view>
+#include <vector>
 
 namespace {
     constexpr std::array expected{
@@ -30,9 +34,11 @@ namespace {
     class OutputMock {
     public:
         MAKE_MOCK2(test_output, void(const char *, const size_t));
+        MAKE_MOCK2(error_output, void(const char *, const size_t));
     };
 
     OutputMock output_mock;
+    std::vector<std::string> collected;
 
     void test_output(const char *buf, const size_t buf_size)
     {
@@ -41,6 +47,45 @@ namespace {
         output_mock.test_output(expected_str.c_str(), buf_size);
     }
 
+    void error_output(const char *buf, const size_t buf_size)
+    {
+        const std::string expected_str{buf, buf_size};
+
+        output_mock.error_output(expected_str.c_str(), buf_size);
+    }
+
+    void collect_output(const char *buf, const size_t buf_size)
+    {
+        collected.emplace_back(buf, buf_size);
+    }
+
+    std::vector<mulog_ret_code> reconfigure_rets;
+
+    void reconfiguring_output(const char *buf, const size_t buf_size)
+    {
+        collected.emplace_back(buf, buf_size);
+        reconfigure_rets.push_back(mulog_unregister_output(reconfiguring_output));
+        reconfigure_rets.push_back(mulog_add_output(collect_output));
+    }
+
+    std::vector<std::string> flushed;
+
+    void flush_output(const char *buf, const size_t buf_size)
+    {
+        flushed.emplace_back(buf, buf_size);
+    }
+
+    std::vector<std::vector<std::string>> collected_batches;
+
+    void collect_output_vec(const mulog_iovec *lines, const size_t count)
+    {
+        auto &batch = collected_batches.emplace_back();
+
+        for (size_t i = 0; i < count; ++i) {
+            batch.emplace_back(lines[i].base, lines[i].len);
+        }
+    }
+
     size_t get_expected_print_size(const std::string &input, mulog_log_level level)
     {
         if constexpr (MULOG_INTERNAL_ENABLE_TIMESTAMP_OUTPUT) {
@@ -76,6 +121,12 @@ namespace {
         }
     }
 
+    std::string generate_dropped_marker(const size_t dropped)
+    {
+        return generate_expected_output(fmt::format("{} log entries dropped", dropped),
+                                        MULOG_LOG_LVL_WARNING, SIZE_MAX);
+    }
+
     extern "C" bool mulog_config_mulog_lock(void)
     {
         return true;
@@ -85,6 +136,24 @@ namespace {
     {
     }
 
+    extern "C" bool mulog_config_mulog_format_lock(void)
+    {
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_format_unlock(void)
+    {
+    }
+
+    extern "C" bool mulog_config_mulog_output_lock(void)
+    {
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_output_unlock(void)
+    {
+    }
+
     extern "C" unsigned long mulog_config_mulog_timestamp_get(void)
     {
         return 42123UL;
@@ -126,22 +195,39 @@ TEST_CASE_METHOD(MulogDeferredNoBuf, "MulogDeferredNoBuf - ValidLogBuffer", "[de
     REQUIRE(MULOG_RET_CODE_OK == ret);
 }
 
-TEST_CASE_METHOD(MulogDeferredNoBuf, "MulogDeferredNoBuf - UnsupportedInterface", "[deferred]")
+TEST_CASE_METHOD(MulogDeferredNoBuf, "MulogDeferredNoBuf - PerOutputLogLevel", "[deferred]")
 {
     mulog_set_log_level(MULOG_LOG_LVL_DEBUG);
 
     for (size_t i = 0; i < MULOG_LOG_LVL_COUNT; ++i) {
-        const auto ret =
-            mulog_add_output_with_log_level(test_output, static_cast<mulog_log_level>(i));
-        REQUIRE((i == MULOG_LOG_LVL_DEBUG ? MULOG_RET_CODE_OK : MULOG_RET_CODE_UNSUPPORTED) == ret);
+        auto ret = mulog_add_output_with_log_level(test_output, static_cast<mulog_log_level>(i));
+        REQUIRE(MULOG_RET_CODE_OK == ret);
+        ret = mulog_unregister_output(test_output);
+        REQUIRE(MULOG_RET_CODE_OK == ret);
     }
 
+    auto ret = mulog_set_channel_log_level(test_output, MULOG_LOG_LVL_ERROR);
+    REQUIRE(MULOG_RET_CODE_NOT_FOUND == ret);
+    ret = mulog_add_output(test_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
     for (size_t i = 0; i < MULOG_LOG_LVL_COUNT; ++i) {
-        const auto ret = mulog_set_channel_log_level(test_output, static_cast<mulog_log_level>(i));
-        REQUIRE(MULOG_RET_CODE_UNSUPPORTED == ret);
+        ret = mulog_set_channel_log_level(test_output, static_cast<mulog_log_level>(i));
+        REQUIRE(MULOG_RET_CODE_OK == ret);
+        ret = mulog_set_channel_log_level(test_output,
+                                          static_cast<mulog_log_level>(MULOG_LOG_LVL_COUNT + i));
+        REQUIRE(MULOG_RET_CODE_INVALID_ARG == ret);
     }
 }
 
+TEST_CASE_METHOD(MulogDeferredNoBuf, "MulogDeferredNoBuf - ThreadLogBufferUnsupported",
+                 "[deferred]")
+{
+    std::array<char, 128> buffer{};
+    const auto ret = mulog_set_thread_log_buffer(buffer.data(), buffer.size());
+    REQUIRE(MULOG_RET_CODE_UNSUPPORTED == ret);
+}
+
 TEST_CASE_METHOD(MulogDeferredNoBuf, "MulogDeferredNoBuf - InvalidLogLevel", "[deferred]")
 {
     for (size_t i = 0; i < MULOG_LOG_LVL_COUNT; ++i) {
@@ -170,20 +256,21 @@ public:
     }
 };
 
-TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - UnsupportedInterface", "[deferred]")
+TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - PerOutputLogLevel", "[deferred]")
 {
-    mulog_set_log_level(MULOG_LOG_LVL_DEBUG);
+    auto ret = mulog_add_output_with_log_level(test_output, MULOG_LOG_LVL_ERROR);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE_FALSE(mulog_is_log_level_enabled(MULOG_LOG_LVL_WARNING));
+    REQUIRE(0 == MULOG_LOG_WARN("rejected by the producer"));
 
-    for (size_t i = 0; i < MULOG_LOG_LVL_COUNT; ++i) {
-        const auto ret =
-            mulog_add_output_with_log_level(test_output, static_cast<mulog_log_level>(i));
-        REQUIRE((i == MULOG_LOG_LVL_DEBUG ? MULOG_RET_CODE_OK : MULOG_RET_CODE_UNSUPPORTED) == ret);
-    }
+    ret = mulog_set_channel_log_level(test_output, MULOG_LOG_LVL_TRACE);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE(mulog_is_log_level_enabled(MULOG_LOG_LVL_TRACE));
 
-    for (size_t i = 0; i < MULOG_LOG_LVL_COUNT; ++i) {
-        const auto ret = mulog_set_channel_log_level(test_output, static_cast<mulog_log_level>(i));
-        REQUIRE(MULOG_RET_CODE_UNSUPPORTED == ret);
-    }
+    const auto expected_str = generate_expected_output("trace", MULOG_LOG_LVL_TRACE, buffer.size());
+    REQUIRE(expected_str.size() == MULOG_LOG_TRACE("trace"));
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::eq(expected_str), expected_str.size()));
+    REQUIRE(expected_str.size() == mulog_deferred_process());
 }
 
 TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - InvalidLogLevel", "[deferred]")
@@ -251,37 +338,47 @@ TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - MultipleShortLogE
     REQUIRE(expected_size == log_ret);
     total += log_ret;
 
-    REQUIRE_CALL(output_mock, test_output(trompeloeil::_, trompeloeil::_));
+    // every log entry is delivered with a separate output call
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::_, trompeloeil::_)).TIMES(2);
     log_ret = mulog_deferred_process();
     REQUIRE(total == log_ret);
 }
 
 TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - LogEntryTrunсation", "[deferred]")
 {
-    const std::string long_string(128, '#');
-    auto ret = mulog_add_output(test_output);
+    std::array<char, 2 * MULOG_SINGLE_LOG_LINE_SIZE + 128> large_buffer{};
+    const std::string long_string(MULOG_SINGLE_LOG_LINE_SIZE + 10, '#');
+    const std::string truncated{long_string.substr(0, MULOG_SINGLE_LOG_LINE_SIZE)};
+    auto ret = mulog_set_log_buffer(large_buffer.data(), large_buffer.size());
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_add_output(test_output);
     REQUIRE(MULOG_RET_CODE_OK == ret);
     ret = mulog_set_log_level(MULOG_LOG_LVL_ERROR);
     REQUIRE(MULOG_RET_CODE_OK == ret);
 
+    const auto expected_size = get_expected_print_size(truncated, MULOG_LOG_LVL_ERROR);
     auto log_ret = mulog_log(MULOG_LOG_LVL_ERROR, "%s", long_string.data());
-    REQUIRE(buffer.size() - 1 == log_ret);
+    REQUIRE(expected_size == log_ret);
 
-    REQUIRE_CALL(output_mock, test_output(trompeloeil::_, trompeloeil::_));
+    const auto expected_str =
+        generate_expected_output(truncated, MULOG_LOG_LVL_ERROR, expected_size);
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::eq(expected_str), expected_size));
     log_ret = mulog_deferred_process();
-    REQUIRE(buffer.size() - 1 == log_ret);
+    REQUIRE(expected_size == log_ret);
     mulog_set_log_level(MULOG_LOG_LVL_DEBUG);
+    mulog_set_log_buffer(buffer.data(), buffer.size());
 }
 
-TEST_CASE_METHOD(MulogDeferredWithBuf,
-                 "MulogDeferredWithBuf - LogEntryTrunсationWithMultipleEntries", "[deferred]")
+TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - LogEntryDropWithMultipleEntries",
+                 "[deferred]")
 {
     const std::string long_string1(42, '#');
     const std::string long_string2(24, '&');
-    const std::string long_string3(64, '$');
+    const std::string long_string3(100, '$');
     const auto expected_output1 =
         generate_expected_output(long_string1, MULOG_LOG_LVL_ERROR, buffer.size() - 1);
-    size_t expected_free_size = buffer.size() - 1; // lwrb implementation details
+    const auto expected_output2 =
+        generate_expected_output(long_string2, MULOG_LOG_LVL_ERROR, buffer.size() - 1);
     auto ret = mulog_add_output(test_output);
     REQUIRE(MULOG_RET_CODE_OK == ret);
     ret = mulog_set_log_level(MULOG_LOG_LVL_ERROR);
@@ -289,53 +386,66 @@ TEST_CASE_METHOD(MulogDeferredWithBuf,
 
     const auto expected_log_size1 = get_expected_print_size(long_string1, MULOG_LOG_LVL_ERROR);
     auto log_ret = mulog_log(MULOG_LOG_LVL_ERROR, "%s", long_string1.c_str());
-    expected_free_size -= log_ret;
     REQUIRE(expected_log_size1 == log_ret);
 
     REQUIRE_CALL(output_mock, test_output(trompeloeil::eq(expected_output1), trompeloeil::_));
     log_ret = mulog_deferred_process();
-    expected_free_size += log_ret;
     REQUIRE(expected_log_size1 == log_ret);
 
     const auto expected_log_size2 = get_expected_print_size(long_string2, MULOG_LOG_LVL_ERROR);
     log_ret = mulog_log(MULOG_LOG_LVL_ERROR, "%s", long_string2.c_str());
-    expected_free_size -= expected_log_size2;
     REQUIRE(expected_log_size2 == log_ret);
+    // the third entry does not fit into the remaining space and is dropped whole
     log_ret = mulog_log(MULOG_LOG_LVL_ERROR, "%s", long_string3.c_str());
-    REQUIRE(expected_free_size == log_ret);
-    expected_free_size -= log_ret;
-    REQUIRE(0 == expected_free_size);
-    const auto expected_output2 = generate_expected_output(long_string2, MULOG_LOG_LVL_ERROR,
-                                                           buffer.size() + 1 - expected_log_size1);
-    const auto expected_output3 = generate_expected_output(long_string3, MULOG_LOG_LVL_ERROR,
-                                                           buffer.size() - 1 - expected_log_size2);
+    REQUIRE(0 == log_ret);
+
+    const auto marker = generate_dropped_marker(1);
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::eq(marker), marker.size()));
     REQUIRE_CALL(output_mock, test_output(trompeloeil::eq(expected_output2), trompeloeil::_));
-    REQUIRE_CALL(output_mock, test_output(trompeloeil::eq(expected_output3), trompeloeil::_));
     log_ret = mulog_deferred_process();
-    REQUIRE(buffer.size() - 1 == log_ret);
+    REQUIRE(marker.size() + expected_log_size2 == log_ret);
     mulog_set_log_level(MULOG_LOG_LVL_DEBUG);
 }
 
 TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - LogFullAddNewLine", "[deferred]")
 {
-    const std::string long_string(127, 'a');
-    const std::string not_fitted(127, 'b');
+    const std::string long_string(80, 'a');
+    const std::string not_fitted(80, 'b');
     auto ret = mulog_add_output(test_output);
     REQUIRE(MULOG_RET_CODE_OK == ret);
     ret = mulog_set_log_level(MULOG_LOG_LVL_ERROR);
     REQUIRE(MULOG_RET_CODE_OK == ret);
+    const auto expected_size = get_expected_print_size(long_string, MULOG_LOG_LVL_ERROR);
     auto log_ret = MULOG_LOG_ERR("%s", long_string.c_str());
-    REQUIRE(long_string.size() == log_ret);
+    REQUIRE(expected_size == log_ret);
     log_ret = MULOG_LOG_ERR("%s", not_fitted.c_str());
     REQUIRE(0 == log_ret);
 
-    const std::string_view view{long_string.c_str(),
-                                long_string.size() - expected[MULOG_LOG_LVL_ERROR].size()};
     const auto expected_str =
-        generate_expected_output(std::string{view}, MULOG_LOG_LVL_ERROR, buffer.size() - 1);
+        generate_expected_output(long_string, MULOG_LOG_LVL_ERROR, buffer.size() - 1);
+    const auto marker = generate_dropped_marker(1);
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::eq(marker), marker.size()));
     REQUIRE_CALL(output_mock, test_output(trompeloeil::eq(expected_str), trompeloeil::_));
     log_ret = mulog_deferred_process();
-    REQUIRE(buffer.size() - 1 == log_ret);
+    REQUIRE(marker.size() + expected_size == log_ret);
+}
+
+TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - WrappedEntryDeliveredWhole",
+                 "[deferred]")
+{
+    const std::string msg(30, 'w');
+    auto ret = mulog_add_output(test_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    const auto expected_str = generate_expected_output(msg, MULOG_LOG_LVL_DEBUG, buffer.size());
+
+    // entries start at different offsets and eventually wrap around the buffer end
+    for (size_t i = 0; i < 10; ++i) {
+        const auto log_ret = MULOG_LOG_DBG("%s", msg.c_str());
+        REQUIRE(expected_str.size() == log_ret);
+        REQUIRE_CALL(output_mock, test_output(trompeloeil::eq(expected_str), expected_str.size()));
+        REQUIRE(log_ret == mulog_deferred_process());
+    }
 }
 
 TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - InvalidOutputConfiguration",
@@ -383,6 +493,30 @@ TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - UnregisterOutput"
     REQUIRE(MULOG_RET_CODE_NOT_FOUND == ret);
 }
 
+TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - OutputReconfiguresItself",
+                 "[deferred]")
+{
+    collected.clear();
+    reconfigure_rets.clear();
+    REQUIRE(MULOG_RET_CODE_OK == mulog_add_output(reconfiguring_output));
+    REQUIRE(MULOG_RET_CODE_OK == mulog_set_log_level(MULOG_LOG_LVL_TRACE));
+
+    const auto first = MULOG_LOG_INFO("first");
+    REQUIRE(first > 0);
+    // the processing holds the replaced snapshot, so only the next change has to wait for it
+    REQUIRE(first == mulog_deferred_process());
+    REQUIRE(std::vector{MULOG_RET_CODE_OK, MULOG_RET_CODE_LOCK_FAILED} == reconfigure_rets);
+    REQUIRE(MULOG_RET_CODE_NOT_FOUND == mulog_unregister_output(reconfiguring_output));
+    REQUIRE(MULOG_RET_CODE_OK == mulog_add_output(collect_output));
+
+    const auto second = MULOG_LOG_INFO("second");
+    REQUIRE(second == mulog_deferred_process());
+    REQUIRE(2 == reconfigure_rets.size());
+    REQUIRE(std::vector{generate_expected_output("first", MULOG_LOG_LVL_INFO, SIZE_MAX),
+                        generate_expected_output("second", MULOG_LOG_LVL_INFO, SIZE_MAX)} ==
+            collected);
+}
+
 TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - NoOutputRegistered", "[deferred]")
 {
     mulog_reset();
@@ -434,7 +568,7 @@ public:
 
 TEST_CASE_METHOD(SmallBuffer16, "SmallBuffer16 - LogSingle", "[deferred]")
 {
-    const std::string input{"Hello"};
+    const std::string input{"Hello, world"};
     mulog_add_output(test_output);
     const auto ret = MULOG_LOG_ERR("%s", input.c_str());
     REQUIRE(0 == ret);
@@ -574,7 +708,7 @@ TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - MixedLogLevels",
     log_ret = MULOG_LOG_ERR("error");
     total_written += log_ret;
 
-    REQUIRE_CALL(output_mock, test_output(trompeloeil::_, trompeloeil::_));
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::_, trompeloeil::_)).TIMES(3);
     const auto printed = mulog_deferred_process();
     REQUIRE(total_written == printed);
 }
@@ -600,7 +734,7 @@ TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - MultipleOutputsSa
     auto ret = mulog_add_output(output_1);
     REQUIRE(MULOG_RET_CODE_OK == ret);
     ret = mulog_add_output_with_log_level(test_output, MULOG_LOG_LVL_ERROR);
-    REQUIRE(MULOG_RET_CODE_UNSUPPORTED == ret);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
 }
 
 TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - BufferWrapAround", "[deferred]")
@@ -641,7 +775,7 @@ TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - PartialProcess",
     total += written1;
     const auto written2 = MULOG_LOG_DBG("msg2");
     total += written2;
-    REQUIRE_CALL(output_mock, test_output(trompeloeil::_, trompeloeil::_));
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::_, trompeloeil::_)).TIMES(2);
     const auto printed = mulog_deferred_process();
     REQUIRE(total == printed);
     FORBID_CALL(output_mock, test_output(trompeloeil::_, trompeloeil::_));
@@ -683,7 +817,7 @@ TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - TestLogLevelBound
     log_ret = MULOG_LOG_ERR("error");
     expected_size = get_expected_print_size("error", MULOG_LOG_LVL_ERROR);
     REQUIRE(expected_size == log_ret);
-    REQUIRE_CALL(output_mock, test_output(trompeloeil::_, trompeloeil::_));
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::_, trompeloeil::_)).TIMES(2);
     mulog_deferred_process();
 }
 
@@ -697,12 +831,13 @@ TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - VeryLongSingleMes
     const std::string very_long(256, 'L');
     const auto log_ret = MULOG_LOG_ERR("%s", very_long.c_str());
 
-    REQUIRE(log_ret <= buffer.size() - 1);
-    REQUIRE(log_ret > 0);
+    // even truncated to the single line limit the entry does not fit into the buffer
+    REQUIRE(0 == log_ret);
 
-    REQUIRE_CALL(output_mock, test_output(trompeloeil::_, trompeloeil::_));
+    const auto marker = generate_dropped_marker(1);
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::eq(marker), marker.size()));
     const auto printed = mulog_deferred_process();
-    REQUIRE(printed == log_ret);
+    REQUIRE(marker.size() == printed);
 }
 
 TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - SequentialLogAndProcess", "[deferred]")
@@ -729,20 +864,529 @@ TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - BufferFullPrevent
     ret = mulog_set_log_level(MULOG_LOG_LVL_ERROR);
     REQUIRE(MULOG_RET_CODE_OK == ret);
 
-    // Fill buffer completely
-    const std::string fill_msg(100, 'X');
-    auto log_ret = MULOG_LOG_ERR("%s", fill_msg.c_str());
+    // Fill buffer almost completely
+    const std::string fill_msg(80, 'X');
+    const auto log_ret = MULOG_LOG_ERR("%s", fill_msg.c_str());
     REQUIRE(log_ret > 0);
 
-    // Try to add more when buffer is nearly full
+    // Entry that does not fit is dropped whole
     const std::string another_msg(50, 'Y');
-    log_ret = MULOG_LOG_ERR("%s", another_msg.c_str());
+    REQUIRE(0 == MULOG_LOG_ERR("%s", another_msg.c_str()));
 
     // Process and verify
+    const auto expected_str =
+        generate_expected_output(fill_msg, MULOG_LOG_LVL_ERROR, buffer.size() - 1);
+    const auto marker = generate_dropped_marker(1);
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::eq(marker), marker.size()));
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::eq(expected_str), trompeloeil::_));
+    REQUIRE(marker.size() + log_ret == mulog_deferred_process());
+}
+
+TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - DroppedEntriesCounted", "[deferred]")
+{
+    auto ret = mulog_add_output(test_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE(0 == mulog_deferred_get_dropped_count());
+
+    // filtered entries are not counted as dropped
+    ret = mulog_set_log_level(MULOG_LOG_LVL_ERROR);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE(0 == MULOG_LOG_DBG("filtered"));
+    REQUIRE(0 == mulog_deferred_get_dropped_count());
+
+    const std::string msg(40, 'D');
+    size_t logged = 0;
+
+    for (size_t i = 0; i < 5; ++i) {
+        if (MULOG_LOG_ERR("%s", msg.c_str()) > 0) {
+            ++logged;
+        }
+    }
+
+    REQUIRE(logged > 0);
+    REQUIRE(logged < 5);
+    REQUIRE(5 - logged == mulog_deferred_get_dropped_count());
+
+    REQUIRE(5 - logged == mulog_deferred_get_level_dropped_count(MULOG_LOG_LVL_ERROR));
+    REQUIRE(0 == mulog_deferred_get_level_dropped_count(MULOG_LOG_LVL_DEBUG));
+    REQUIRE(0 == mulog_deferred_get_level_dropped_count(MULOG_LOG_LVL_COUNT));
+
+    const auto expected_str = generate_expected_output(msg, MULOG_LOG_LVL_ERROR, buffer.size());
+    const auto marker = generate_dropped_marker(5 - logged);
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::eq(marker), marker.size()));
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::eq(expected_str), expected_str.size()))
+        .TIMES(logged);
+    mulog_deferred_process();
+
+    // processing frees the space but keeps the counter, the drop is reported only once
+    REQUIRE(MULOG_LOG_ERR("%s", msg.c_str()) > 0);
+    REQUIRE(5 - logged == mulog_deferred_get_dropped_count());
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::eq(expected_str), expected_str.size()));
+    REQUIRE(expected_str.size() == mulog_deferred_process());
+    mulog_reset();
+    REQUIRE(0 == mulog_deferred_get_dropped_count());
+}
+
+TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - OverflowPolicyArguments", "[deferred]")
+{
+    auto ret = mulog_deferred_set_overflow_policy(MULOG_OVERFLOW_DROP_NEWEST, 0);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_deferred_set_overflow_policy(MULOG_OVERFLOW_DROP_OLDEST, 0);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_deferred_set_overflow_policy(MULOG_OVERFLOW_BLOCK, 100);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_deferred_set_overflow_policy(
+        static_cast<mulog_overflow_policy>(MULOG_OVERFLOW_BLOCK + 1), 0);
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG == ret);
+}
+
+TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - DropOldestKeepsNewest", "[deferred]")
+{
+    constexpr size_t entries = 10;
+    auto ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_deferred_set_overflow_policy(MULOG_OVERFLOW_DROP_OLDEST, 0);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    // every new entry is stored, older ones are evicted to make room for it
+    for (size_t i = 0; i < entries; ++i) {
+        REQUIRE(MULOG_LOG_WARN("entry %zu %s", i, std::string(20, 'o').c_str()) > 0);
+    }
+
+    const auto dropped = mulog_deferred_get_dropped_count();
+    REQUIRE(dropped > 0);
+    REQUIRE(dropped < entries);
+    REQUIRE(dropped == mulog_deferred_get_level_dropped_count(MULOG_LOG_LVL_WARNING));
+
+    collected.clear();
+    mulog_deferred_process();
+
+    std::vector<std::string> expected_lines{generate_dropped_marker(dropped)};
+
+    for (size_t i = dropped; i < entries; ++i) {
+        expected_lines.push_back(generate_expected_output(
+            fmt::format("entry {} {}", i, std::string(20, 'o')), MULOG_LOG_LVL_WARNING, SIZE_MAX));
+    }
+
+    REQUIRE(expected_lines == collected);
+}
+
+TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - BlockGivesUpAfterSpinLimit",
+                 "[deferred]")
+{
+    auto ret = mulog_add_output(test_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_deferred_set_overflow_policy(MULOG_OVERFLOW_BLOCK, 16);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    // nobody drains the buffer, so the producer drops the entry once it runs out of retries
+    const std::string msg(40, 'B');
+    size_t logged = 0;
+
+    while (MULOG_LOG_ERR("%s", msg.c_str()) > 0) {
+        ++logged;
+    }
+
+    REQUIRE(logged > 0);
+    REQUIRE(1 == mulog_deferred_get_dropped_count());
+    REQUIRE(1 == mulog_deferred_get_level_dropped_count(MULOG_LOG_LVL_ERROR));
+
+    const auto expected_str = generate_expected_output(msg, MULOG_LOG_LVL_ERROR, SIZE_MAX);
+    const auto marker = generate_dropped_marker(1);
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::eq(marker), marker.size()));
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::eq(expected_str), expected_str.size()))
+        .TIMES(logged);
+    mulog_deferred_process();
+
+    // reset restores the default policy
+    mulog_reset();
+    mulog_set_log_buffer(buffer.data(), buffer.size());
+    ret = mulog_add_output(test_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    while (MULOG_LOG_ERR("%s", msg.c_str()) > 0) {
+    }
+
+    REQUIRE(1 == mulog_deferred_get_dropped_count());
     ALLOW_CALL(output_mock, test_output(trompeloeil::_, trompeloeil::_));
     mulog_deferred_process();
 }
 
+TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - ProcessBudgetArguments", "[deferred]")
+{
+    size_t remaining = SIZE_MAX;
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG == mulog_deferred_process_budget(nullptr, &remaining));
+    REQUIRE(SIZE_MAX == remaining);
+
+    const mulog_process_budget budget{0, 0, 0};
+    REQUIRE(0 == mulog_deferred_process_budget(&budget, &remaining));
+    REQUIRE(0 == remaining);
+    REQUIRE(0 == mulog_deferred_process_budget(&budget, nullptr));
+
+    // a time limit requires the timestamp function to measure the processing time
+    const mulog_process_budget time_budget{0, 0, 10};
+    const auto ret = mulog_deferred_process_budget(&time_budget, &remaining);
+
+    if constexpr (MULOG_ENABLE_TIMESTAMP) {
+        REQUIRE(0 == ret);
+    } else {
+        REQUIRE(MULOG_RET_CODE_UNSUPPORTED == ret);
+    }
+}
+
+TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - ProcessRecordBudget", "[deferred]")
+{
+    auto ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    collected.clear();
+
+    for (size_t i = 0; i < 3; ++i) {
+        REQUIRE(MULOG_LOG_DBG("entry %zu", i) > 0);
+    }
+
+    const mulog_process_budget budget{0, 1, 0};
+    std::array<size_t, 3> remaining{};
+
+    // entries are processed one per call, the remaining usage shrinks with every call
+    for (size_t i = 0; i < remaining.size(); ++i) {
+        const auto expected_str =
+            generate_expected_output(fmt::format("entry {}", i), MULOG_LOG_LVL_DEBUG, SIZE_MAX);
+
+        REQUIRE(expected_str.size() == mulog_deferred_process_budget(&budget, &remaining[i]));
+        REQUIRE(i + 1 == collected.size());
+        REQUIRE(expected_str == collected.back());
+    }
+
+    REQUIRE(remaining[0] == 2 * remaining[1]);
+    REQUIRE(0 == remaining[2]);
+    REQUIRE(0 == mulog_deferred_process_budget(&budget, nullptr));
+}
+
+TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - ProcessByteBudget", "[deferred]")
+{
+    auto ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    collected.clear();
+
+    const std::string msg(4, 'b');
+    const auto expected_str = generate_expected_output(msg, MULOG_LOG_LVL_DEBUG, SIZE_MAX);
+
+    for (size_t i = 0; i < 3; ++i) {
+        REQUIRE(expected_str.size() == MULOG_LOG_DBG("%s", msg.c_str()));
+    }
+
+    // the entry that crosses the limit is output whole
+    const mulog_process_budget budget{expected_str.size() + 1, 0, 0};
+    size_t remaining = 0;
+    REQUIRE(2 * expected_str.size() == mulog_deferred_process_budget(&budget, &remaining));
+    REQUIRE(2 == collected.size());
+    REQUIRE(remaining > 0);
+    REQUIRE(expected_str.size() == mulog_deferred_process_budget(&budget, &remaining));
+    REQUIRE(3 == collected.size());
+    REQUIRE(0 == remaining);
+}
+
+TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - VectoredOutputArguments",
+                 "[deferred]")
+{
+    auto ret = mulog_add_output_vec(nullptr, MULOG_LOG_LVL_DEBUG);
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG == ret);
+    ret = mulog_add_output_vec(collect_output_vec, MULOG_LOG_LVL_COUNT);
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG == ret);
+    ret = mulog_unregister_output_vec(collect_output_vec);
+    REQUIRE(MULOG_RET_CODE_NOT_FOUND == ret);
+    ret = mulog_add_output_vec(collect_output_vec, MULOG_LOG_LVL_DEBUG);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    // vectored outputs are not matched by the regular output functions
+    ret = mulog_unregister_output(nullptr);
+    REQUIRE(MULOG_RET_CODE_NOT_FOUND == ret);
+    ret = mulog_set_channel_log_level(nullptr, MULOG_LOG_LVL_ERROR);
+    REQUIRE(MULOG_RET_CODE_NOT_FOUND == ret);
+    ret = mulog_unregister_output_vec(collect_output_vec);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE(MULOG_LOG_ERR("not stored") == 0);
+}
+
+TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - VectoredOutputBatch", "[deferred]")
+{
+    auto ret = mulog_add_output_vec(collect_output_vec, MULOG_LOG_LVL_INFO);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_add_output_with_log_level(collect_output, MULOG_LOG_LVL_DEBUG);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    collected.clear();
+    collected_batches.clear();
+
+    const std::array levels{MULOG_LOG_LVL_DEBUG, MULOG_LOG_LVL_INFO, MULOG_LOG_LVL_ERROR};
+    std::vector<std::string> expected_lines;
+    size_t expected_size = 0;
+
+    for (size_t i = 0; i < levels.size(); ++i) {
+        REQUIRE(mulog_log(levels[i], "e%zu", i) > 0);
+        expected_lines.push_back(
+            generate_expected_output(fmt::format("e{}", i), levels[i], SIZE_MAX));
+        expected_size += expected_lines.back().size();
+    }
+
+    // the vectored output gets all lines it accepts at once, others get one line per call
+    REQUIRE(expected_size == mulog_deferred_process());
+    REQUIRE(expected_lines == collected);
+    REQUIRE(1 == collected_batches.size());
+    REQUIRE(std::vector{expected_lines[1], expected_lines[2]} == collected_batches.front());
+
+    // no call is made if the vectored output does not accept any line of the batch
+    REQUIRE(MULOG_LOG_DBG("e%d", 3) > 0);
+    REQUIRE(mulog_deferred_process() > 0);
+    REQUIRE(1 == collected_batches.size());
+    REQUIRE(4 == collected.size());
+}
+
+TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - VectoredOutputWrappedEntries",
+                 "[deferred]")
+{
+    const std::string msg(25, 'v');
+    auto ret = mulog_add_output_vec(collect_output_vec, MULOG_LOG_LVL_DEBUG);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    collected_batches.clear();
+
+    const auto expected_str = generate_expected_output(msg, MULOG_LOG_LVL_DEBUG, SIZE_MAX);
+
+    // batches start at different offsets, so entries eventually wrap around the buffer end, all
+    // lines of a batch are valid during the output call
+    for (size_t i = 0; i < 10; ++i) {
+        REQUIRE(expected_str.size() == MULOG_LOG_DBG("%s", msg.c_str()));
+        REQUIRE(expected_str.size() == MULOG_LOG_DBG("%s", msg.c_str()));
+        REQUIRE(2 * expected_str.size() == mulog_deferred_process());
+        REQUIRE(i + 1 == collected_batches.size());
+        REQUIRE(std::vector{expected_str, expected_str} == collected_batches.back());
+    }
+}
+
+TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - VectoredOutputDroppedMarker",
+                 "[deferred]")
+{
+    const std::string msg(40, 'm');
+    auto ret = mulog_add_output_vec(collect_output_vec, MULOG_LOG_LVL_ERROR);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    collected_batches.clear();
+
+    const auto expected_str = generate_expected_output(msg, MULOG_LOG_LVL_ERROR, SIZE_MAX);
+    size_t stored = 0;
+
+    while (MULOG_LOG_ERR("%s", msg.c_str()) > 0) {
+        ++stored;
+    }
+
+    // the marker is passed on its own regardless of the output log level
+    REQUIRE(mulog_deferred_process() > 0);
+    REQUIRE(2 == collected_batches.size());
+    REQUIRE(std::vector{generate_dropped_marker(1)} == collected_batches.front());
+    REQUIRE(std::vector<std::string>(stored, expected_str) == collected_batches.back());
+}
+
+TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - PriorityBufferKeepsErrors",
+                 "[deferred]")
+{
+    std::array<char, 128> priority_buffer{};
+    auto ret = mulog_set_priority_log_buffer(priority_buffer.data(), 0);
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG == ret);
+    ret = mulog_set_priority_log_buffer(priority_buffer.data(), priority_buffer.size());
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    collected.clear();
+
+    const auto with_sequence = [](const size_t sequence, const std::string &line) {
+        return fmt::format("#{} {}", sequence, line);
+    };
+    std::vector<std::string> expected_debug;
+    size_t sequence = 0;
+
+    // debug entries fill the log buffer up, the error entry still has its own storage
+    while (MULOG_LOG_DBG("d%zu", sequence + 1) > 0) {
+        ++sequence;
+        expected_debug.push_back(with_sequence(
+            sequence,
+            generate_expected_output(fmt::format("d{}", sequence), MULOG_LOG_LVL_DEBUG, SIZE_MAX)));
+    }
+
+    REQUIRE(1 == mulog_deferred_get_dropped_count());
+    REQUIRE(MULOG_LOG_ERR("e") > 0);
+
+    // the dropped entry leaves a gap in the sequence, the error entry is output first
+    std::vector<std::string> expected{
+        generate_dropped_marker(1),
+        with_sequence(sequence + 2, generate_expected_output("e", MULOG_LOG_LVL_ERROR, SIZE_MAX)),
+    };
+    expected.insert(expected.end(), expected_debug.begin(), expected_debug.end());
+    REQUIRE(mulog_deferred_process() > 0);
+    REQUIRE(expected == collected);
+
+    // without the priority buffer all entries are stored in order and without sequence numbers
+    ret = mulog_set_priority_log_buffer(nullptr, 0);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    collected.clear();
+    REQUIRE(MULOG_LOG_DBG("d") > 0);
+    REQUIRE(MULOG_LOG_ERR("e") > 0);
+    REQUIRE(mulog_deferred_process() > 0);
+    REQUIRE(std::vector{generate_expected_output("d", MULOG_LOG_LVL_DEBUG, SIZE_MAX),
+                        generate_expected_output("e", MULOG_LOG_LVL_ERROR, SIZE_MAX)} ==
+            collected);
+}
+
+TEST_CASE_METHOD(MulogDeferredNoBuf, "MulogDeferredNoBuf - PersistentBufferRecovery", "[deferred]")
+{
+    alignas(uint32_t) std::array<char, 256> buffer{};
+    alignas(uint32_t) std::array<char, 256> crashed{};
+    auto ret = mulog_set_persistent_log_buffer(buffer.data() + 1, buffer.size() - 1);
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG == ret);
+    ret = mulog_set_persistent_log_buffer(buffer.data(), 16);
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG == ret);
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG ==
+            mulog_deferred_recover(nullptr, buffer.size(), collect_output));
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG ==
+            mulog_deferred_recover(buffer.data(), buffer.size(), nullptr));
+    REQUIRE(MULOG_RET_CODE_NOT_FOUND ==
+            mulog_deferred_recover(buffer.data(), buffer.size(), collect_output));
+
+    ret = mulog_set_persistent_log_buffer(buffer.data(), buffer.size());
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    // processed entries move the positions around the buffer end
+    for (size_t i = 0; i < 10; ++i) {
+        REQUIRE(MULOG_LOG_INFO("processed %zu", i) > 0);
+        REQUIRE(mulog_deferred_process() > 0);
+    }
+
+    std::vector<std::string> expected_lines;
+    size_t expected_size = 0;
+
+    for (size_t i = 0; i < 3; ++i) {
+        REQUIRE(MULOG_LOG_WARN("pending %zu", i) > 0);
+        expected_lines.push_back(generate_expected_output(fmt::format("pending {}", i),
+                                                          MULOG_LOG_LVL_WARNING, SIZE_MAX));
+        expected_size += expected_lines.back().size();
+    }
+
+    // only the buffer content is left after a crash
+    crashed = buffer;
+    collected.clear();
+    REQUIRE(expected_size ==
+            mulog_deferred_recover(crashed.data(), crashed.size(), collect_output));
+    REQUIRE(expected_lines == collected);
+
+    // processed entries are not recovered
+    REQUIRE(expected_size == mulog_deferred_process());
+    crashed = buffer;
+    collected.clear();
+    REQUIRE(0 == mulog_deferred_recover(crashed.data(), crashed.size(), collect_output));
+    REQUIRE(collected.empty());
+
+    // a damaged header is detected
+    crashed[0] ^= 1;
+    REQUIRE(MULOG_RET_CODE_NOT_FOUND ==
+            mulog_deferred_recover(crashed.data(), crashed.size(), collect_output));
+
+    // entries dropped by the reset are not recovered
+    REQUIRE(MULOG_LOG_INFO("dropped") > 0);
+    mulog_reset();
+    REQUIRE(MULOG_RET_CODE_NOT_FOUND ==
+            mulog_deferred_recover(buffer.data(), buffer.size(), collect_output));
+}
+
+TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - FlightRecorderDumpsContextOnError",
+                 "[deferred]")
+{
+    std::array<char, 96> recorder{};
+    auto ret = mulog_set_flight_recorder(recorder.data(), recorder.size(), MULOG_LOG_LVL_COUNT);
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG == ret);
+    ret = mulog_set_flight_recorder(recorder.data(), 0, MULOG_LOG_LVL_INFO);
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG == ret);
+    ret = mulog_set_flight_recorder(recorder.data(), recorder.size(), MULOG_LOG_LVL_INFO);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_set_log_level(MULOG_LOG_LVL_TRACE);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_add_output_with_log_level(collect_output, MULOG_LOG_LVL_TRACE);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    collected.clear();
+
+    constexpr size_t traces = 10;
+
+    // trace entries only overwrite each other in the recorder and are not output
+    for (size_t i = 0; i < traces; ++i) {
+        REQUIRE(MULOG_LOG_TRACE("t%zu", i) > 0);
+    }
+
+    REQUIRE(MULOG_LOG_INFO("info") > 0);
+    REQUIRE(mulog_deferred_process() > 0);
+    REQUIRE(std::vector{generate_expected_output("info", MULOG_LOG_LVL_INFO, SIZE_MAX)} ==
+            collected);
+
+    // the error brings the latest recorded entries along
+    collected.clear();
+    REQUIRE(MULOG_LOG_ERR("boom") > 0);
+    REQUIRE(mulog_deferred_process() > 0);
+    REQUIRE(collected.size() > 1);
+    REQUIRE(collected.size() <= traces);
+
+    const size_t context = collected.size() - 1;
+
+    for (size_t i = 0; i < context; ++i) {
+        REQUIRE(generate_expected_output(fmt::format("t{}", traces - context + i),
+                                         MULOG_LOG_LVL_TRACE, SIZE_MAX) == collected[i]);
+    }
+
+    REQUIRE(generate_expected_output("boom", MULOG_LOG_LVL_ERROR, SIZE_MAX) == collected.back());
+    REQUIRE(0 == mulog_deferred_get_dropped_count());
+
+    // the recorder can be dumped explicitly
+    REQUIRE(0 == mulog_flight_recorder_dump());
+    REQUIRE(MULOG_LOG_DBG("debug") > 0);
+    REQUIRE(1 == mulog_flight_recorder_dump());
+    collected.clear();
+    REQUIRE(mulog_deferred_process() > 0);
+    REQUIRE(std::vector{generate_expected_output("debug", MULOG_LOG_LVL_DEBUG, SIZE_MAX)} ==
+            collected);
+}
+
+TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - EmergencyFlushFromSignalHandler",
+                 "[deferred]")
+{
+    static int flushed_size = 0;
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG == mulog_deferred_emergency_flush(nullptr, "crash"));
+    auto ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    collected.clear();
+    flushed.clear();
+
+    const std::vector<std::string> entries{
+        generate_expected_output("first", MULOG_LOG_LVL_INFO, SIZE_MAX),
+        generate_expected_output("second", MULOG_LOG_LVL_ERROR, SIZE_MAX),
+    };
+    REQUIRE(MULOG_LOG_INFO("first") > 0);
+    REQUIRE(MULOG_LOG_ERR("second") > 0);
+
+    const auto previous = std::signal(SIGUSR1, [](int) {
+        flushed_size = mulog_deferred_emergency_flush(flush_output, "caught signal");
+    });
+    REQUIRE(0 == std::raise(SIGUSR1));
+    std::signal(SIGUSR1, previous);
+
+    // the final record has no timestamp, registered outputs are not called
+    std::vector<std::string> expected_flushed{entries};
+    expected_flushed.push_back(
+        fmt::format("{}: caught signal{}", log_levels[MULOG_LOG_LVL_ERROR], line_termination));
+    REQUIRE(expected_flushed == flushed);
+    REQUIRE(expected_flushed[0].size() + expected_flushed[1].size() + expected_flushed[2].size() ==
+            flushed_size);
+    REQUIRE(collected.empty());
+
+    // stored entries are left in the log buffer
+    REQUIRE(mulog_deferred_process() > 0);
+    REQUIRE(entries == collected);
+}
+
 TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - MultipleOutputsProcessing", "[deferred]")
 {
     mulog_log_output_fn output_1 = test_output;
@@ -763,6 +1407,49 @@ TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - MultipleOutputsPr
     REQUIRE(printed == log_ret);
 }
 
+TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - MultipleOutputsDifferentLogLevels",
+                 "[deferred]")
+{
+    auto ret = mulog_add_output_with_log_level(test_output, MULOG_LOG_LVL_DEBUG);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_add_output_with_log_level(error_output, MULOG_LOG_LVL_ERROR);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    REQUIRE(0 == MULOG_LOG_TRACE("trace"));
+    const auto debug_size = MULOG_LOG_DBG("debug");
+    REQUIRE(debug_size > 0);
+    const auto error_size = MULOG_LOG_ERR("error");
+    REQUIRE(error_size > 0);
+
+    const auto expected_debug =
+        generate_expected_output("debug", MULOG_LOG_LVL_DEBUG, buffer.size());
+    const auto expected_error =
+        generate_expected_output("error", MULOG_LOG_LVL_ERROR, buffer.size());
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::eq(expected_debug), expected_debug.size()));
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::eq(expected_error), expected_error.size()));
+    REQUIRE_CALL(output_mock, error_output(trompeloeil::eq(expected_error), expected_error.size()));
+    REQUIRE(debug_size + error_size == mulog_deferred_process());
+}
+
+TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - OutputLogLevelAppliedOnProcess",
+                 "[deferred]")
+{
+    auto ret = mulog_add_output_with_log_level(test_output, MULOG_LOG_LVL_DEBUG);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_add_output_with_log_level(error_output, MULOG_LOG_LVL_DEBUG);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    const auto log_ret = MULOG_LOG_DBG("debug");
+    REQUIRE(log_ret > 0);
+    ret = mulog_set_channel_log_level(error_output, MULOG_LOG_LVL_ERROR);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    // the stored entry is only passed to outputs that accept its level at processing time
+    REQUIRE_CALL(output_mock, test_output(trompeloeil::_, log_ret));
+    FORBID_CALL(output_mock, error_output(trompeloeil::_, trompeloeil::_));
+    REQUIRE(log_ret == mulog_deferred_process());
+}
+
 TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - ProcessEmptyBuffer", "[deferred]")
 {
     auto ret = mulog_add_output(test_output);
@@ -804,3 +1491,179 @@ TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - SetGlobalLevelAft
     mulog_deferred_process();
 }
 
+
+TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - LogLevelEnabledCheck", "[deferred]")
+{
+    int evaluated = 0;
+
+    // no outputs registered, nothing can be logged
+    REQUIRE_FALSE(mulog_is_log_level_enabled(MULOG_LOG_LVL_ERROR));
+    REQUIRE(0 == MULOG_LOG_ERR("%d", ++evaluated));
+    REQUIRE(0 == evaluated);
+
+    auto ret = mulog_add_output(test_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE_FALSE(mulog_is_log_level_enabled(MULOG_LOG_LVL_TRACE));
+    REQUIRE(mulog_is_log_level_enabled(MULOG_LOG_LVL_DEBUG));
+    REQUIRE(0 == MULOG_LOG_TRACE("%d", ++evaluated));
+    REQUIRE(0 == evaluated);
+
+    ret = mulog_set_log_level(MULOG_LOG_LVL_WARNING);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE_FALSE(mulog_is_log_level_enabled(MULOG_LOG_LVL_INFO));
+    REQUIRE(mulog_is_log_level_enabled(MULOG_LOG_LVL_WARNING));
+
+    ret = mulog_unregister_output(test_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE_FALSE(mulog_is_log_level_enabled(MULOG_LOG_LVL_ERROR));
+    REQUIRE(0 == mulog_deferred_get_dropped_count());
+    mulog_set_log_level(MULOG_LOG_LVL_DEBUG);
+}
+
+TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - LoggerInstances", "[deferred]")
+{
+    static std::vector<std::string> instance_collected;
+    static int instance_locks = 0;
+    std::array<char, 128> instance_buffer{};
+    const mulog_instance_lock incomplete_lock{[](void *) { return true; }, nullptr, nullptr};
+    const mulog_instance_lock lock{
+        [](void *arg) {
+            ++*static_cast<int *>(arg);
+            return true;
+        },
+        [](void *) {},
+        &instance_locks,
+    };
+    const mulog_log_output_fn instance_output = [](const char *buf, const size_t buf_size) {
+        instance_collected.emplace_back(buf, buf_size);
+    };
+    REQUIRE(nullptr == mulog_instance_init(&incomplete_lock));
+
+    auto *instance = mulog_instance_init(&lock);
+
+    if constexpr (MULOG_INSTANCES == 0) {
+        REQUIRE(nullptr == instance);
+        return;
+    }
+
+    REQUIRE(nullptr != instance);
+    auto ret = mulog_instance_set_log_buffer(instance, instance_buffer.data(),
+                                             instance_buffer.size());
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_instance_add_output(instance, instance_output, MULOG_LOG_LVL_INFO);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE(0 < instance_locks);
+    ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    collected.clear();
+    instance_collected.clear();
+
+    // each logger filters, stores and outputs its own entries
+    REQUIRE(MULOG_LOG_DBG("default") > 0);
+    REQUIRE(0 == mulog_instance_log(instance, MULOG_LOG_LVL_DEBUG, "filtered"));
+    REQUIRE(mulog_instance_log(instance, MULOG_LOG_LVL_INFO, "instance %d", 1) > 0);
+    REQUIRE(mulog_deferred_process() > 0);
+    REQUIRE(std::vector{generate_expected_output("default", MULOG_LOG_LVL_DEBUG, SIZE_MAX)} ==
+            collected);
+    REQUIRE(instance_collected.empty());
+    REQUIRE(mulog_instance_process(instance) > 0);
+    REQUIRE(std::vector{generate_expected_output("instance 1", MULOG_LOG_LVL_INFO, SIZE_MAX)} ==
+            instance_collected);
+
+    // entries dropped by the instance are not accounted by the default logger
+    while (mulog_instance_log(instance, MULOG_LOG_LVL_ERROR, "fill") > 0) {
+    }
+
+    REQUIRE(0 < mulog_instance_get_dropped_count(instance));
+    REQUIRE(0 == mulog_deferred_get_dropped_count());
+    REQUIRE(mulog_deferred_get_dropped_count() == mulog_instance_get_dropped_count(nullptr));
+
+    // the pool is exhausted by MULOG_INSTANCES instances, a released instance can be taken again
+    std::vector<mulog_instance *> instances{instance};
+
+    while (auto *next = mulog_instance_init(nullptr)) {
+        instances.push_back(next);
+    }
+
+    REQUIRE(MULOG_INSTANCES == instances.size());
+    mulog_instance_deinit(instance);
+    instances[0] = mulog_instance_init(nullptr);
+    REQUIRE(instance == instances[0]);
+    REQUIRE(0 == mulog_instance_get_dropped_count(instance));
+    REQUIRE(0 == mulog_instance_log(instance, MULOG_LOG_LVL_ERROR, "no outputs"));
+
+    for (auto *it : instances) {
+        mulog_instance_deinit(it);
+    }
+}
+
+TEST_CASE_METHOD(MulogDeferredWithBuf, "MulogDeferredWithBuf - OutputContext", "[deferred]")
+{
+    struct Shard {
+        std::array<char, 128> buffer{};
+        std::vector<std::string> lines;
+        int closed = 0;
+    };
+    std::array<Shard, MULOG_OUTPUT_HANDLERS + 1> shards{};
+    std::array<mulog_output_slot, MULOG_OUTPUT_HANDLERS + 2> registry{};
+    const mulog_output_write_fn write = [](void *ctx, const char *data, const size_t size) {
+        static_cast<Shard *>(ctx)->lines.emplace_back(data, size);
+    };
+    const mulog_output_close_fn close = [](void *ctx) { ++static_cast<Shard *>(ctx)->closed; };
+
+    // outputs with a context are batched along with the other outputs
+    REQUIRE(MULOG_RET_CODE_OK == mulog_add_output_vec(collect_output_vec, MULOG_LOG_LVL_TRACE));
+    REQUIRE(MULOG_RET_CODE_OK == mulog_set_output_registry(registry.data(), registry.size()));
+
+    for (auto &shard : shards) {
+        const mulog_output output{write, close, &shard};
+        REQUIRE(MULOG_RET_CODE_OK == mulog_add_output_ctx(&output, MULOG_LOG_LVL_INFO));
+    }
+
+    collected_batches.clear();
+    REQUIRE(MULOG_LOG_DBG("filtered") > 0);
+    REQUIRE(MULOG_LOG_INFO("line %d", 1) > 0);
+    REQUIRE(mulog_deferred_process() > 0);
+    REQUIRE(1 == collected_batches.size());
+    REQUIRE(2 == collected_batches[0].size());
+
+    for (auto &shard : shards) {
+        REQUIRE(std::vector{generate_expected_output("line 1", MULOG_LOG_LVL_INFO, SIZE_MAX)} ==
+                shard.lines);
+    }
+
+    REQUIRE(MULOG_RET_CODE_OK == mulog_unregister_output_ctx(write, &shards[0]));
+    REQUIRE(1 == shards[0].closed);
+    REQUIRE(MULOG_RET_CODE_OK == mulog_unregister_output_vec(collect_output_vec));
+    mulog_unregister_all_outputs();
+
+    for (const auto &shard : shards) {
+        REQUIRE(1 == shard.closed);
+    }
+
+    // a file sink per shard, each shard logs through its own instance
+    std::vector<mulog_instance *> instances;
+
+    for (size_t i = 0; i < MULOG_INSTANCES; ++i) {
+        auto &shard = shards[i];
+        const mulog_output output{write, close, &shard};
+        auto *instance = instances.emplace_back(mulog_instance_init(nullptr));
+        REQUIRE(nullptr != instance);
+        auto ret = mulog_instance_set_log_buffer(instance, shard.buffer.data(),
+                                                 shard.buffer.size());
+        REQUIRE(MULOG_RET_CODE_OK == ret);
+        ret = mulog_instance_add_output_ctx(instance, &output, MULOG_LOG_LVL_TRACE);
+        REQUIRE(MULOG_RET_CODE_OK == ret);
+        shard.lines.clear();
+        REQUIRE(mulog_instance_log(instance, MULOG_LOG_LVL_DEBUG, "shard %zu", i) > 0);
+    }
+
+    for (size_t i = 0; i < instances.size(); ++i) {
+        REQUIRE(mulog_instance_process(instances[i]) > 0);
+        REQUIRE(std::vector{generate_expected_output(fmt::format("shard {}", i),
+                                                     MULOG_LOG_LVL_DEBUG, SIZE_MAX)} ==
+                shards[i].lines);
+        mulog_instance_deinit(instances[i]);
+        REQUIRE(2 == shards[i].closed);
+    }
+}
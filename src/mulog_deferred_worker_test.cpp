@@ -0,0 +1,285 @@
+/**
+ * \file
+ * \brief mulog tests for the deferred logging drain worker
+ * \author Vladimir Petrigo
+ */
+#include "internal/config.h"
+#include "internal/utils.h"
+#include "mulog.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <fmt/format.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    using namespace std::chrono_literals;
+
+    constexpr std::array log_levels{
+        MULOG_TRACE_LVL, MULOG_DEBUG_LVL, MULOG_INFO_LVL, MULOG_WARNING_LVL, MULOG_ERROR_LVL,
+    };
+    constexpr unsigned long long_latency_ms = 60UL * 1000UL;
+
+    std::mutex logger_mutex;
+    std::mutex format_mutex;
+    std::mutex output_mutex;
+    std::mutex collected_mutex;
+    std::condition_variable collected_cond;
+    std::vector<std::string> collected;
+    std::atomic<size_t> output_calls_from_producer{0};
+    thread_local bool is_producer = false;
+
+    void collect_output(const char *buf, const size_t buf_size)
+    {
+        if (is_producer) {
+            ++output_calls_from_producer;
+        }
+
+        {
+            const std::lock_guard lock{collected_mutex};
+
+            collected.emplace_back(buf, buf_size);
+        }
+
+        collected_cond.notify_all();
+    }
+
+    bool wait_collected(const size_t count)
+    {
+        std::unique_lock lock{collected_mutex};
+
+        return collected_cond.wait_for(lock, 5s, [count]() { return collected.size() >= count; });
+    }
+
+    size_t get_collected_count()
+    {
+        const std::lock_guard lock{collected_mutex};
+
+        return collected.size();
+    }
+
+    std::string generate_expected_output(const std::string &input, const mulog_log_level log_level)
+    {
+        if constexpr (MULOG_ENABLE_TIMESTAMP) {
+            const auto timestamp_ms = mulog_config_mulog_timestamp_get();
+
+            return fmt::format("{:07}.{:03} {}: {}{}", timestamp_ms / 1000, timestamp_ms % 1000,
+                               log_levels[log_level], input, MULOG_LOG_LINE_TERMINATION);
+        } else {
+            return fmt::format("{}: {}{}", log_levels[log_level], input,
+                               MULOG_LOG_LINE_TERMINATION);
+        }
+    }
+
+    extern "C" bool mulog_config_mulog_lock(void)
+    {
+        logger_mutex.lock();
+
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_unlock(void)
+    {
+        logger_mutex.unlock();
+    }
+
+    extern "C" bool mulog_config_mulog_format_lock(void)
+    {
+        format_mutex.lock();
+
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_format_unlock(void)
+    {
+        format_mutex.unlock();
+    }
+
+    extern "C" bool mulog_config_mulog_output_lock(void)
+    {
+        output_mutex.lock();
+
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_output_unlock(void)
+    {
+        output_mutex.unlock();
+    }
+
+    extern "C" unsigned long mulog_config_mulog_timestamp_get(void)
+    {
+        return 42123UL;
+    }
+
+    extern "C" void putchar_(int c)
+    {
+    }
+} // namespace
+
+class MulogDrainWorker {
+public:
+    alignas(uint32_t) std::array<char, 1024> buffer{};
+
+    MulogDrainWorker()
+    {
+        mulog_set_log_buffer(buffer.data(), buffer.size());
+        mulog_add_output(collect_output);
+        collected.clear();
+        output_calls_from_producer = 0;
+        is_producer = true;
+    }
+
+    ~MulogDrainWorker()
+    {
+        is_producer = false;
+        mulog_reset();
+    }
+};
+
+TEST_CASE_METHOD(MulogDrainWorker, "MulogDrainWorker - InvalidConfig", "[deferred][worker]")
+{
+    auto ret = mulog_deferred_worker_start(nullptr);
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG == ret);
+
+    const mulog_drain_worker_config config{0, 0};
+    ret = mulog_deferred_worker_start(&config);
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG == ret);
+
+    // stopping a worker that has not been started does nothing
+    mulog_deferred_worker_stop();
+}
+
+TEST_CASE_METHOD(MulogDrainWorker, "MulogDrainWorker - WatermarkWakesWorker", "[deferred][worker]")
+{
+    // the latency timer does not expire during the test, only the watermark wakes the worker up
+    const mulog_drain_worker_config config{0, long_latency_ms};
+    auto ret = mulog_deferred_worker_start(&config);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    for (size_t i = 0; i < 3; ++i) {
+        REQUIRE(MULOG_LOG_INFO("entry %zu", i) > 0);
+        REQUIRE(wait_collected(i + 1));
+    }
+
+    mulog_deferred_worker_stop();
+    REQUIRE(0 == output_calls_from_producer);
+
+    for (size_t i = 0; i < collected.size(); ++i) {
+        REQUIRE(generate_expected_output(fmt::format("entry {}", i), MULOG_LOG_LVL_INFO) ==
+                collected[i]);
+    }
+}
+
+TEST_CASE_METHOD(MulogDrainWorker, "MulogDrainWorker - LatencyTimerDrains", "[deferred][worker]")
+{
+    // the watermark is never reached, entries are drained once the latency timer expires
+    const mulog_drain_worker_config config{buffer.size() * 2, 10};
+    auto ret = mulog_deferred_worker_start(&config);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE(MULOG_LOG_WARN("delayed") > 0);
+    REQUIRE(wait_collected(1));
+    REQUIRE(generate_expected_output("delayed", MULOG_LOG_LVL_WARNING) == collected.front());
+    REQUIRE(0 == output_calls_from_producer);
+}
+
+TEST_CASE_METHOD(MulogDrainWorker, "MulogDrainWorker - StopDrainsPendingEntries",
+                 "[deferred][worker]")
+{
+    const mulog_drain_worker_config config{buffer.size() * 2, long_latency_ms};
+    auto ret = mulog_deferred_worker_start(&config);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    for (size_t i = 0; i < 3; ++i) {
+        REQUIRE(MULOG_LOG_ERR("pending %zu", i) > 0);
+    }
+
+    mulog_deferred_worker_stop();
+    REQUIRE(3 == get_collected_count());
+
+    // the worker can be started again once it has been stopped
+    ret = mulog_deferred_worker_start(&config);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE(MULOG_LOG_ERR("pending %d", 3) > 0);
+    mulog_deferred_worker_stop();
+    REQUIRE(4 == get_collected_count());
+}
+
+TEST_CASE_METHOD(MulogDrainWorker, "MulogDrainWorker - ReconfigureRunningWorker",
+                 "[deferred][worker]")
+{
+    mulog_drain_worker_config config{buffer.size() * 2, long_latency_ms};
+    auto ret = mulog_deferred_worker_start(&config);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE(MULOG_LOG_INFO("first") > 0);
+
+    // the new watermark is applied to the running worker
+    config.watermark = 0;
+    ret = mulog_deferred_worker_start(&config);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE(wait_collected(1));
+    REQUIRE(MULOG_LOG_INFO("second") > 0);
+    REQUIRE(wait_collected(2));
+}
+
+TEST_CASE_METHOD(MulogDrainWorker, "MulogDrainWorker - ResetStopsWorker", "[deferred][worker]")
+{
+    const mulog_drain_worker_config config{buffer.size() * 2, long_latency_ms};
+    auto ret = mulog_deferred_worker_start(&config);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE(MULOG_LOG_INFO("before reset") > 0);
+    mulog_reset();
+    REQUIRE(1 == get_collected_count());
+}
+
+TEST_CASE_METHOD(MulogDrainWorker, "MulogDrainWorker - MultipleProducers", "[deferred][worker]")
+{
+    constexpr size_t producers = 4;
+    constexpr size_t entries_per_producer = 500;
+    const mulog_drain_worker_config config{buffer.size() / 4, 5};
+    auto ret = mulog_deferred_worker_start(&config);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    std::atomic<size_t> logged{0};
+    std::vector<std::thread> threads;
+
+    for (size_t id = 0; id < producers; ++id) {
+        threads.emplace_back([id, &logged]() {
+            is_producer = true;
+
+            for (size_t seq = 0; seq < entries_per_producer; ++seq) {
+                if (MULOG_LOG_INFO("producer=%zu seq=%zu", id, seq) > 0) {
+                    ++logged;
+                }
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    mulog_deferred_worker_stop();
+    REQUIRE(0 == output_calls_from_producer);
+    REQUIRE(producers * entries_per_producer == logged + mulog_deferred_get_dropped_count());
+
+    // every stored entry is delivered, drops are reported with a single marker line per drain
+    size_t delivered = 0;
+
+    for (const auto &line : collected) {
+        if (line.find("producer=") != std::string::npos) {
+            ++delivered;
+        }
+    }
+
+    REQUIRE(logged == delivered);
+}
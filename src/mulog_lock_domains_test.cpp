@@ -0,0 +1,294 @@
+/**
+ * \file
+ * \brief mulog tests for separate configuration, format and output lock domains
+ * \author Vladimir Petrigo
+ */
+#include "internal/config.h"
+#include "internal/utils.h"
+#include "mulog.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <fmt/format.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr std::array log_levels{
+        MULOG_TRACE_LVL, MULOG_DEBUG_LVL, MULOG_INFO_LVL, MULOG_WARNING_LVL, MULOG_ERROR_LVL,
+    };
+    constexpr auto wait_timeout = std::chrono::seconds{2};
+
+    std::mutex config_mutex;
+    std::mutex format_mutex;
+    std::mutex output_mutex;
+    std::atomic<size_t> config_locks{0};
+    std::atomic<size_t> format_locks{0};
+    std::atomic<size_t> output_locks{0};
+    // number of threads that have asked for the output lock, including the one holding it
+    std::atomic<size_t> output_waiters{0};
+    std::mutex collected_mutex;
+    std::vector<std::string> collected;
+    std::function<void()> on_output;
+
+    void collect_output(const char *buf, const size_t buf_size)
+    {
+        {
+            std::lock_guard lock{collected_mutex};
+            collected.emplace_back(buf, buf_size);
+        }
+
+        if (on_output) {
+            on_output();
+        }
+    }
+
+    std::string generate_expected_output(const std::string &input, const mulog_log_level log_level)
+    {
+        if constexpr (MULOG_ENABLE_TIMESTAMP) {
+            const auto timestamp_ms = mulog_config_mulog_timestamp_get();
+
+            return fmt::format("{:07}.{:03} {}: {}{}", timestamp_ms / 1000, timestamp_ms % 1000,
+                               log_levels[log_level], input, MULOG_LOG_LINE_TERMINATION);
+        } else {
+            return fmt::format("{}: {}{}", log_levels[log_level], input,
+                               MULOG_LOG_LINE_TERMINATION);
+        }
+    }
+
+    void reset_lock_counts()
+    {
+        config_locks = 0;
+        format_locks = 0;
+        output_locks = 0;
+        output_waiters = 0;
+    }
+
+    template <typename Predicate>
+    bool wait_for(Predicate predicate)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + wait_timeout;
+
+        while (!predicate()) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+
+            std::this_thread::yield();
+        }
+
+        return true;
+    }
+
+    extern "C" bool mulog_config_mulog_lock(void)
+    {
+        config_mutex.lock();
+        ++config_locks;
+
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_unlock(void)
+    {
+        config_mutex.unlock();
+    }
+
+    extern "C" bool mulog_config_mulog_format_lock(void)
+    {
+        format_mutex.lock();
+        ++format_locks;
+
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_format_unlock(void)
+    {
+        format_mutex.unlock();
+    }
+
+    extern "C" bool mulog_config_mulog_output_lock(void)
+    {
+        ++output_waiters;
+        output_mutex.lock();
+        ++output_locks;
+
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_output_unlock(void)
+    {
+        output_mutex.unlock();
+    }
+
+    extern "C" unsigned long mulog_config_mulog_timestamp_get(void)
+    {
+        return 42123UL;
+    }
+
+    extern "C" void putchar_(int c)
+    {
+    }
+} // namespace
+
+class MulogLockDomains {
+public:
+    std::array<char, 256> buffer{};
+
+    MulogLockDomains()
+    {
+        mulog_set_log_buffer(buffer.data(), buffer.size());
+        mulog_add_output(collect_output);
+        collected.clear();
+        on_output = nullptr;
+        reset_lock_counts();
+    }
+
+    ~MulogLockDomains()
+    {
+        on_output = nullptr;
+        mulog_reset();
+    }
+};
+
+TEST_CASE_METHOD(MulogLockDomains, "MulogLockDomains - ConfigurationLocks", "[lock_domains]")
+{
+    // outputs are published as snapshots, so they are changed under the configuration lock only
+    auto ret = mulog_set_log_level(MULOG_LOG_LVL_TRACE);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE(1 == config_locks);
+    REQUIRE(0 == format_locks);
+    REQUIRE(0 == output_locks);
+
+    ret = mulog_set_log_buffer(buffer.data(), buffer.size());
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE(2 == config_locks);
+    REQUIRE(1 == format_locks);
+    REQUIRE(1 == output_locks);
+
+    // instances keep a single lock
+    auto *instance = mulog_instance_init(nullptr);
+
+    if constexpr (MULOG_INSTANCES == 0) {
+        REQUIRE(nullptr == instance);
+        return;
+    }
+
+    REQUIRE(nullptr != instance);
+    reset_lock_counts();
+    ret = mulog_instance_set_log_buffer(instance, buffer.data(), buffer.size());
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE(1 == config_locks);
+    REQUIRE(0 == format_locks);
+    REQUIRE(0 == output_locks);
+    mulog_instance_deinit(instance);
+}
+
+#if !defined(MULOG_ENABLE_DEFERRED_LOGGING)
+TEST_CASE_METHOD(MulogLockDomains, "MulogLockDomains - LogCallLocks", "[lock_domains][realtime]")
+{
+    const auto expected = generate_expected_output("entry 1", MULOG_LOG_LVL_ERROR);
+
+    REQUIRE(expected.size() == MULOG_LOG_ERR("entry %d", 1));
+    REQUIRE(0 == config_locks);
+    REQUIRE(1 == format_locks);
+    REQUIRE(1 == output_locks);
+    REQUIRE(std::vector{expected} == collected);
+}
+
+TEST_CASE_METHOD(MulogLockDomains, "MulogLockDomains - FormatWhileOutputRuns",
+                 "[lock_domains][realtime]")
+{
+    std::atomic<bool> in_output{false};
+    std::atomic<bool> overlapped{false};
+
+    on_output = [&] {
+        if (!in_output.exchange(true)) {
+            // the second log call formats its entry and waits for the output lock meanwhile
+            overlapped = wait_for([] { return output_waiters >= 2; });
+        }
+    };
+
+    std::thread first{[] { MULOG_LOG_ERR("first %d", 1); }};
+
+    REQUIRE(wait_for([&] { return in_output.load(); }));
+
+    std::thread second{[] { MULOG_LOG_ERR("second %d", 2); }};
+
+    first.join();
+    second.join();
+
+    REQUIRE(overlapped);
+    // the entries are formatted into different halves of the log buffer
+    REQUIRE(std::vector{generate_expected_output("first 1", MULOG_LOG_LVL_ERROR),
+                        generate_expected_output("second 2", MULOG_LOG_LVL_ERROR)} == collected);
+}
+
+TEST_CASE_METHOD(MulogLockDomains, "MulogLockDomains - EntryFitsHalfOfLogBuffer",
+                 "[lock_domains][realtime]")
+{
+    const std::string long_string(buffer.size(), 'x');
+    const auto expected = generate_expected_output(long_string, MULOG_LOG_LVL_ERROR);
+    const auto size = MULOG_LOG_ERR("%s", long_string.c_str());
+
+    REQUIRE(size > 0);
+    REQUIRE(static_cast<size_t>(size) < buffer.size() / 2);
+    REQUIRE(1 == collected.size());
+    REQUIRE(expected.substr(0, size) == collected.front());
+}
+#else
+TEST_CASE_METHOD(MulogLockDomains, "MulogLockDomains - LogCallLocks", "[lock_domains][deferred]")
+{
+    REQUIRE(MULOG_LOG_ERR("entry %d", 1) > 0);
+    REQUIRE(0 == config_locks);
+    REQUIRE(1 == format_locks);
+    REQUIRE(0 == output_locks);
+
+    REQUIRE(mulog_deferred_process() > 0);
+    REQUIRE(0 == config_locks);
+    REQUIRE(1 == format_locks);
+    REQUIRE(1 == output_locks);
+    REQUIRE(std::vector{generate_expected_output("entry 1", MULOG_LOG_LVL_ERROR)} == collected);
+
+    // producers remove stored entries with this policy, so the consumer excludes them
+    auto ret = mulog_deferred_set_overflow_policy(MULOG_OVERFLOW_DROP_OLDEST, 0);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    reset_lock_counts();
+    REQUIRE(0 == mulog_deferred_process());
+    REQUIRE(1 == format_locks);
+    REQUIRE(1 == output_locks);
+}
+
+TEST_CASE_METHOD(MulogLockDomains, "MulogLockDomains - StoreWhileOutputRuns",
+                 "[lock_domains][deferred]")
+{
+    std::atomic<bool> stored{false};
+
+    REQUIRE(MULOG_LOG_ERR("first %d", 1) > 0);
+
+    on_output = [&] {
+        if (stored) {
+            return;
+        }
+
+        // a producer does not wait for the consumer that is in the outputs
+        auto producer = std::async(std::launch::async, [] { return MULOG_LOG_ERR("second"); });
+
+        stored = producer.wait_for(wait_timeout) == std::future_status::ready && producer.get() > 0;
+    };
+
+    REQUIRE(mulog_deferred_process() > 0);
+    REQUIRE(stored);
+    // the second entry may have already been taken by the first call
+    REQUIRE(mulog_deferred_process() >= 0);
+    REQUIRE(std::vector{generate_expected_output("first 1", MULOG_LOG_LVL_ERROR),
+                        generate_expected_output("second", MULOG_LOG_LVL_ERROR)} == collected);
+}
+#endif /* MULOG_ENABLE_DEFERRED_LOGGING */
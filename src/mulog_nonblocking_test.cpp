@@ -0,0 +1,344 @@
+/**
+ * \file
+ * \brief mulog tests for the non-blocking realtime logging mode
+ * \author Vladimir Petrigo
+ */
+#include "internal/config.h"
+#include "internal/utils.h"
+#include "mulog.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <fmt/format.h>
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr std::array log_levels{
+        MULOG_TRACE_LVL, MULOG_DEBUG_LVL, MULOG_INFO_LVL, MULOG_WARNING_LVL, MULOG_ERROR_LVL,
+    };
+
+    std::mutex logger_mutex;
+    // simulates another thread holding the logger lock
+    std::atomic<bool> contended{false};
+    std::vector<std::string> collected;
+
+    void collect_output(const char *buf, const size_t buf_size)
+    {
+        collected.emplace_back(buf, buf_size);
+    }
+
+    std::string generate_expected_output(const std::string &input, const mulog_log_level log_level)
+    {
+        if constexpr (MULOG_ENABLE_TIMESTAMP) {
+            const auto timestamp_ms = mulog_config_mulog_timestamp_get();
+
+            return fmt::format("{:07}.{:03} {}: {}{}", timestamp_ms / 1000, timestamp_ms % 1000,
+                               log_levels[log_level], input, MULOG_LOG_LINE_TERMINATION);
+        } else {
+            return fmt::format("{}: {}{}", log_levels[log_level], input,
+                               MULOG_LOG_LINE_TERMINATION);
+        }
+    }
+
+    void require_stats(const mulog_contention_stats &stats, const size_t contended,
+                       const size_t spilled, const size_t dropped)
+    {
+        REQUIRE(contended == stats.contended);
+        REQUIRE(spilled == stats.spilled);
+        REQUIRE(dropped == stats.dropped);
+    }
+
+    extern "C" bool mulog_config_mulog_lock(void)
+    {
+        logger_mutex.lock();
+
+        return true;
+    }
+
+    extern "C" bool mulog_config_mulog_trylock(void)
+    {
+        return !contended && logger_mutex.try_lock();
+    }
+
+    extern "C" void mulog_config_mulog_unlock(void)
+    {
+        logger_mutex.unlock();
+    }
+
+    extern "C" unsigned long mulog_config_mulog_timestamp_get(void)
+    {
+        return 42123UL;
+    }
+
+    extern "C" void putchar_(int c)
+    {
+    }
+} // namespace
+
+class MulogNonBlocking {
+public:
+    std::array<char, 128> buffer{};
+
+    MulogNonBlocking()
+    {
+        mulog_set_log_buffer(buffer.data(), buffer.size());
+        mulog_add_output(collect_output);
+        collected.clear();
+        contended = false;
+    }
+
+    ~MulogNonBlocking()
+    {
+        contended = false;
+        mulog_flush_spill_slot();
+        mulog_reset();
+    }
+};
+
+TEST_CASE_METHOD(MulogNonBlocking, "MulogNonBlocking - ContendedEntryIsSpilled",
+                 "[realtime][nonblocking]")
+{
+    contended = true;
+    REQUIRE(0 == MULOG_LOG_ERR("spilled %d", 1));
+    REQUIRE(collected.empty());
+    require_stats(mulog_get_contention_stats(), 1, 1, 0);
+
+    // the spill slot keeps a single entry
+    REQUIRE(0 == MULOG_LOG_ERR("dropped %d", 2));
+    require_stats(mulog_get_contention_stats(), 2, 1, 1);
+
+    contended = false;
+
+    const auto expected = generate_expected_output("logged 3", MULOG_LOG_LVL_ERROR);
+    REQUIRE(expected.size() == MULOG_LOG_ERR("logged %d", 3));
+    REQUIRE(std::vector{generate_expected_output("spilled 1", MULOG_LOG_LVL_ERROR), expected} ==
+            collected);
+    require_stats(mulog_get_contention_stats(), 2, 1, 1);
+    REQUIRE(0 == mulog_flush_spill_slot());
+
+    mulog_reset();
+    require_stats(mulog_get_contention_stats(), 0, 0, 0);
+}
+
+TEST_CASE_METHOD(MulogNonBlocking, "MulogNonBlocking - FlushSpillSlot", "[realtime][nonblocking]")
+{
+    contended = true;
+    // an invalid entry is counted as contended, but does not take the slot
+    REQUIRE(0 == mulog_log(MULOG_LOG_LVL_COUNT, "invalid"));
+    REQUIRE(0 == MULOG_LOG_WARN("flushed"));
+    require_stats(mulog_get_contention_stats(), 2, 1, 0);
+
+    // the flush waits for the lock instead of trying it
+    const auto expected = generate_expected_output("flushed", MULOG_LOG_LVL_WARNING);
+    REQUIRE(expected.size() == mulog_flush_spill_slot());
+    REQUIRE(0 == mulog_flush_spill_slot());
+    REQUIRE(std::vector{expected} == collected);
+}
+
+TEST_CASE_METHOD(MulogNonBlocking, "MulogNonBlocking - FilteredEntryIsNotSpilled",
+                 "[realtime][nonblocking]")
+{
+    auto ret = mulog_set_channel_log_level(collect_output, MULOG_LOG_LVL_ERROR);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    contended = true;
+    REQUIRE(0 == mulog_log(MULOG_LOG_LVL_INFO, "filtered"));
+    require_stats(mulog_get_contention_stats(), 1, 0, 0);
+    REQUIRE(0 == mulog_flush_spill_slot());
+    REQUIRE(collected.empty());
+}
+
+TEST_CASE_METHOD(MulogNonBlocking, "MulogNonBlocking - ThreadBufferEntryIsSpilled",
+                 "[realtime][nonblocking]")
+{
+    std::array<char, 128> thread_buffer{};
+
+    if (mulog_set_thread_log_buffer(thread_buffer.data(), thread_buffer.size()) ==
+        MULOG_RET_CODE_UNSUPPORTED) {
+        return;
+    }
+
+    contended = true;
+    REQUIRE(0 == MULOG_LOG_ERR("thread %d", 1));
+    require_stats(mulog_get_contention_stats(), 1, 1, 0);
+    contended = false;
+
+    const auto expected = generate_expected_output("thread 2", MULOG_LOG_LVL_ERROR);
+    REQUIRE(expected.size() == MULOG_LOG_ERR("thread %d", 2));
+    REQUIRE(std::vector{generate_expected_output("thread 1", MULOG_LOG_LVL_ERROR), expected} ==
+            collected);
+    mulog_set_thread_log_buffer(nullptr, 0);
+}
+
+TEST_CASE_METHOD(MulogNonBlocking, "MulogNonBlocking - SpillSlotPerThread",
+                 "[realtime][nonblocking]")
+{
+    std::string thread_expected;
+    int thread_flushed = 0;
+
+    contended = true;
+    REQUIRE(0 == MULOG_LOG_ERR("main"));
+
+    std::thread thread{[&] {
+        // the entry of the main thread does not take the slot of this thread
+        if (MULOG_LOG_ERR("thread") == 0) {
+            thread_expected = generate_expected_output("thread", MULOG_LOG_LVL_ERROR);
+            thread_flushed = mulog_flush_spill_slot();
+        }
+    }};
+    thread.join();
+
+    REQUIRE(thread_expected.size() == thread_flushed);
+    require_stats(mulog_get_contention_stats(), 2, 2, 0);
+    REQUIRE(std::vector{thread_expected} == collected);
+
+    const auto expected = generate_expected_output("main", MULOG_LOG_LVL_ERROR);
+    REQUIRE(expected.size() == mulog_flush_spill_slot());
+    REQUIRE(std::vector{thread_expected, expected} == collected);
+}
+
+TEST_CASE_METHOD(MulogNonBlocking, "MulogNonBlocking - ResetDiscardsSpilledEntries",
+                 "[realtime][nonblocking]")
+{
+    contended = true;
+    REQUIRE(0 == MULOG_LOG_ERR("before reset"));
+    require_stats(mulog_get_contention_stats(), 1, 1, 0);
+
+    // the spill slot of this thread is not reachable by the resetting thread
+    std::thread thread{[] { mulog_reset(); }};
+    thread.join();
+    require_stats(mulog_get_contention_stats(), 0, 0, 0);
+
+    mulog_set_log_buffer(buffer.data(), buffer.size());
+    mulog_add_output(collect_output);
+
+    // the discarded entry neither takes the slot nor reaches the new outputs
+    REQUIRE(0 == MULOG_LOG_ERR("contended"));
+    require_stats(mulog_get_contention_stats(), 1, 1, 0);
+    contended = false;
+
+    const auto expected = generate_expected_output("after reset", MULOG_LOG_LVL_ERROR);
+    REQUIRE(expected.size() == MULOG_LOG_ERR("after reset"));
+    REQUIRE(std::vector{generate_expected_output("contended", MULOG_LOG_LVL_ERROR), expected} ==
+            collected);
+    REQUIRE(0 == mulog_flush_spill_slot());
+}
+
+TEST_CASE_METHOD(MulogNonBlocking, "MulogNonBlocking - DeinitDiscardsSpilledEntries",
+                 "[realtime][nonblocking]")
+{
+    static std::vector<std::string> instance_collected;
+    static bool instance_contended = false;
+    std::array<char, 128> instance_buffer{};
+    const mulog_instance_lock lock{
+        .lock = [](void *) { return true; },
+        .unlock = [](void *) {},
+        .arg = nullptr,
+        .trylock = [](void *) { return !instance_contended; },
+    };
+    const mulog_log_output_fn instance_output = [](const char *buf, const size_t buf_size) {
+        instance_collected.emplace_back(buf, buf_size);
+    };
+    auto *instance = mulog_instance_init(&lock);
+
+    if constexpr (MULOG_INSTANCES == 0) {
+        REQUIRE(nullptr == instance);
+        return;
+    }
+
+    REQUIRE(nullptr != instance);
+    mulog_instance_set_log_buffer(instance, instance_buffer.data(), instance_buffer.size());
+    mulog_instance_add_output(instance, instance_output, MULOG_LOG_LVL_TRACE);
+    instance_contended = true;
+    REQUIRE(0 == mulog_instance_log(instance, MULOG_LOG_LVL_ERROR, "before deinit"));
+    require_stats(mulog_instance_get_contention_stats(instance), 1, 1, 0);
+    instance_contended = false;
+
+    // the instance is released and taken again by another thread
+    std::thread thread{[&] {
+        mulog_instance_deinit(instance);
+        instance = mulog_instance_init(&lock);
+    }};
+    thread.join();
+    REQUIRE(nullptr != instance);
+    mulog_instance_set_log_buffer(instance, instance_buffer.data(), instance_buffer.size());
+    mulog_instance_add_output(instance, instance_output, MULOG_LOG_LVL_TRACE);
+    instance_collected.clear();
+
+    const auto expected = generate_expected_output("after deinit", MULOG_LOG_LVL_ERROR);
+    REQUIRE(expected.size() == mulog_instance_log(instance, MULOG_LOG_LVL_ERROR, "after deinit"));
+    REQUIRE(std::vector{expected} == instance_collected);
+    REQUIRE(0 == mulog_flush_spill_slot());
+    mulog_instance_deinit(instance);
+}
+
+TEST_CASE_METHOD(MulogNonBlocking, "MulogNonBlocking - InstanceTryLock", "[realtime][nonblocking]")
+{
+    static std::vector<std::string> instance_collected;
+    static bool instance_contended = false;
+    std::array<char, 128> instance_buffer{};
+    const mulog_instance_lock lock{
+        .lock = [](void *) { return true; },
+        .unlock = [](void *) {},
+        .arg = nullptr,
+        .trylock = [](void *) { return !instance_contended; },
+    };
+    const mulog_instance_lock blocking_lock{
+        .lock = [](void *) { return true; },
+        .unlock = [](void *) {},
+        .arg = nullptr,
+        .trylock = nullptr,
+    };
+    const mulog_log_output_fn instance_output = [](const char *buf, const size_t buf_size) {
+        instance_collected.emplace_back(buf, buf_size);
+    };
+
+    // log calls of an instance without a try-lock would wait for its lock
+    REQUIRE(nullptr == mulog_instance_init(&blocking_lock));
+
+    auto *instance = mulog_instance_init(&lock);
+
+    if constexpr (MULOG_INSTANCES == 0) {
+        REQUIRE(nullptr == instance);
+        return;
+    }
+
+    REQUIRE(nullptr != instance);
+
+    auto ret = mulog_instance_set_log_buffer(instance, instance_buffer.data(),
+                                             instance_buffer.size());
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_instance_add_output(instance, instance_output, MULOG_LOG_LVL_TRACE);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    instance_collected.clear();
+
+    // the global try-lock is not used by the instance
+    contended = true;
+    instance_contended = true;
+    REQUIRE(0 == mulog_instance_log(instance, MULOG_LOG_LVL_ERROR, "instance %d", 1));
+    require_stats(mulog_instance_get_contention_stats(instance), 1, 1, 0);
+    require_stats(mulog_get_contention_stats(), 0, 0, 0);
+
+    // the slot is taken by the instance entry
+    REQUIRE(0 == MULOG_LOG_ERR("default"));
+    require_stats(mulog_get_contention_stats(), 1, 0, 1);
+
+    instance_contended = false;
+    REQUIRE(mulog_instance_log(instance, MULOG_LOG_LVL_ERROR, "instance %d", 2) > 0);
+    REQUIRE(std::vector{generate_expected_output("instance 1", MULOG_LOG_LVL_ERROR),
+                        generate_expected_output("instance 2", MULOG_LOG_LVL_ERROR)} ==
+            instance_collected);
+    REQUIRE(collected.empty());
+    mulog_instance_deinit(instance);
+
+    // a new instance starts without contention
+    instance = mulog_instance_init(nullptr);
+    REQUIRE(nullptr != instance);
+    require_stats(mulog_instance_get_contention_stats(instance), 0, 0, 0);
+    mulog_instance_deinit(instance);
+}
@@ -3,6 +3,7 @@
  * \brief
  * \author
  */
+#include "internal/config.h"
 #include "internal/utils.h"
 #include "mulog.h"
 
@@ -12,7 +13,18 @@
 #include <array>
 #include <cstdarg>
 
+// binary records are encoded without the formatting functions, so the tests of formatting errors
+// are hidden
+#if defined(MULOG_ENABLE_BINARY_OUTPUT) && MULOG_ENABLE_BINARY_OUTPUT == 1
+#define TEXT_FORMAT_TAGS "[.][realtime]"
+#else
+#define TEXT_FORMAT_TAGS "[realtime]"
+#endif /* MULOG_ENABLE_BINARY_OUTPUT */
+
 namespace {
+    // a log buffer change also takes the format lock with lock domains
+    constexpr size_t buffer_locks = MULOG_ENABLE_LOCK_DOMAINS ? 2 : 1;
+
     class API {
     public:
         MAKE_MOCK0(mulog_config_mulog_lock, bool(void));
@@ -39,11 +51,37 @@ namespace {
         return api.mulog_config_mulog_lock();
     }
 
+    // log calls of the non-blocking mode are expected to take the lock as in the blocking mode
+    bool mulog_config_mulog_trylock(void)
+    {
+        return api.mulog_config_mulog_lock();
+    }
+
     void mulog_config_mulog_unlock(void)
     {
         api.mulog_config_mulog_unlock();
     }
 
+    // formatting is serialized by the format lock with lock domains, the output lock is not mocked
+    bool mulog_config_mulog_format_lock(void)
+    {
+        return api.mulog_config_mulog_lock();
+    }
+
+    void mulog_config_mulog_format_unlock(void)
+    {
+        api.mulog_config_mulog_unlock();
+    }
+
+    bool mulog_config_mulog_output_lock(void)
+    {
+        return true;
+    }
+
+    void mulog_config_mulog_output_unlock(void)
+    {
+    }
+
     unsigned long mulog_config_mulog_timestamp_get(void)
     {
         return 42123UL;
@@ -94,15 +132,15 @@ class MulogRealtime {
 public:
     MulogRealtime()
     {
-        REQUIRE_CALL(api, mulog_config_mulog_lock()).RETURN(true);
-        REQUIRE_CALL(api, mulog_config_mulog_unlock());
+        REQUIRE_CALL(api, mulog_config_mulog_lock()).TIMES(buffer_locks).RETURN(true);
+        REQUIRE_CALL(api, mulog_config_mulog_unlock()).TIMES(buffer_locks);
         mulog_set_log_buffer(buffer.data(), buffer.size());
     }
 
     ~MulogRealtime()
     {
-        REQUIRE_CALL(api, mulog_config_mulog_lock()).RETURN(true);
-        REQUIRE_CALL(api, mulog_config_mulog_unlock());
+        REQUIRE_CALL(api, mulog_config_mulog_lock()).TIMES(buffer_locks).RETURN(true);
+        REQUIRE_CALL(api, mulog_config_mulog_unlock()).TIMES(buffer_locks);
         mulog_reset();
     }
 
@@ -177,7 +215,7 @@ TEST_CASE_METHOD(MulogRealtime, "Simple Operations", "[realtime]")
     REQUIRE(MULOG_RET_CODE_UNSUPPORTED == log_ret);
 }
 
-TEST_CASE_METHOD(MulogRealtime, "Log with log message error", "[realtime]")
+TEST_CASE_METHOD(MulogRealtime, "Log with log message error", TEXT_FORMAT_TAGS)
 {
     REQUIRE_CALL(api, mulog_config_mulog_lock()).RETURN(true);
     REQUIRE_CALL(api, mulog_config_mulog_unlock());
@@ -197,7 +235,7 @@ TEST_CASE_METHOD(MulogRealtime, "Log with log message error", "[realtime]")
     REQUIRE(-1 == log_ret);
 }
 
-TEST_CASE_METHOD(MulogRealtime, "Normal logging", "[realtime]")
+TEST_CASE_METHOD(MulogRealtime, "Normal logging", TEXT_FORMAT_TAGS)
 {
     REQUIRE_CALL(api, mulog_config_mulog_lock()).RETURN(true);
     REQUIRE_CALL(api, mulog_config_mulog_unlock());
@@ -246,3 +284,20 @@ TEST_CASE_METHOD(MulogRealtime, "Normal logging", "[realtime]")
     log_ret = MULOG_LOG_DBG("Hello %s", "Temp");
     REQUIRE(-1 == log_ret);
 }
+
+TEST_CASE_METHOD(MulogRealtime, "Disabled log level skips the lock", "[realtime]")
+{
+    REQUIRE_CALL(api, mulog_config_mulog_lock()).RETURN(true);
+    REQUIRE_CALL(api, mulog_config_mulog_unlock());
+    auto ret = mulog_add_output_with_log_level(test_output, MULOG_LOG_LVL_WARNING);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    FORBID_CALL(api, mulog_config_mulog_lock());
+    FORBID_CALL(api, mulog_config_mulog_unlock());
+    FORBID_CALL(api,
+                __wrap_vsnprintf_(trompeloeil::_, trompeloeil::_, trompeloeil::_, trompeloeil::_));
+    auto log_ret = MULOG_LOG_TRACE("Hello %s", "Temp");
+    REQUIRE(0 == log_ret);
+    log_ret = MULOG_LOG_INFO("Hello %s", "Temp");
+    REQUIRE(0 == log_ret);
+}
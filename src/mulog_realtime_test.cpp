@@ -15,8 +15,27 @@
 #include <array>
 #include <iostream>
 #include <string>
+#include <vector>
+
+// binary records replace the log lines, so the tests of the line format are hidden, see
+// mulog_binary_test
+#if defined(MULOG_ENABLE_BINARY_OUTPUT) && MULOG_ENABLE_BINARY_OUTPUT == 1
+#define TEXT_OUTPUT_TAGS "[.][mulog]"
+#else
+#define TEXT_OUTPUT_TAGS "[mulog]"
+#endif /* MULOG_ENABLE_BINARY_OUTPUT */
+
+// log lines alternate between the log buffer halves with lock domains, so the tests that expect
+// a line at the start of the log buffer are hidden, mulog_lock_domains_test covers the layout
+#if (defined(MULOG_ENABLE_LOCK_DOMAINS) && MULOG_ENABLE_LOCK_DOMAINS == 1) ||                      \
+    (defined(MULOG_ENABLE_BINARY_OUTPUT) && MULOG_ENABLE_BINARY_OUTPUT == 1)
+#define LOG_BUFFER_LAYOUT_TAGS "[.][mulog]"
+#else
+#define LOG_BUFFER_LAYOUT_TAGS "[mulog]"
+#endif /* MULOG_ENABLE_LOCK_DOMAINS || MULOG_ENABLE_BINARY_OUTPUT */
 
 namespace {
+    constexpr bool text_output = !MULOG_ENABLE_BINARY_OUTPUT;
     constexpr std::array log_levels{
         MULOG_TRACE_LVL, MULOG_DEBUG_LVL, MULOG_INFO_LVL, MULOG_WARNING_LVL, MULOG_ERROR_LVL,
     };
@@ -72,10 +91,33 @@ namespace {
         return true;
     }
 
+    extern "C" bool mulog_config_mulog_trylock(void)
+    {
+        return true;
+    }
+
     extern "C" void mulog_config_mulog_unlock(void)
     {
     }
 
+    extern "C" bool mulog_config_mulog_format_lock(void)
+    {
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_format_unlock(void)
+    {
+    }
+
+    extern "C" bool mulog_config_mulog_output_lock(void)
+    {
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_output_unlock(void)
+    {
+    }
+
     extern "C" unsigned long mulog_config_mulog_timestamp_get(void)
     {
         return 42123UL;
@@ -184,7 +226,8 @@ TEST_CASE_METHOD(MulogTestsWithBuffer,
     MULOG_LOG_DBG("123");
 }
 
-TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestWithLogBuffer", "[mulog]")
+TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestWithLogBuffer",
+                 LOG_BUFFER_LAYOUT_TAGS)
 {
     const auto ret = mulog_add_output(test_output);
     const std::string input1{"123"};
@@ -223,7 +266,8 @@ TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestOutputUnregis
     REQUIRE(MULOG_RET_CODE_NOT_FOUND == ret);
 }
 
-TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestMultipleOutputs", "[mulog]")
+TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestMultipleOutputs",
+                 TEXT_OUTPUT_TAGS)
 {
     const std::string test_str{"123"};
     const auto expected =
@@ -245,7 +289,8 @@ TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestMultipleOutpu
     REQUIRE(MULOG_RET_CODE_NOT_FOUND == ret);
 }
 
-TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestGlobalOutputLogLevel", "[mulog]")
+TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestGlobalOutputLogLevel",
+                 LOG_BUFFER_LAYOUT_TAGS)
 {
     const std::string test_str1{"123"};
     const std::string test_str2{"345"};
@@ -272,7 +317,7 @@ TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestGlobalOutputL
 }
 
 TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestDifferentOutputLogLevel",
-                 "[mulog]")
+                 LOG_BUFFER_LAYOUT_TAGS)
 {
     const std::string test_str1{"123"};
     const std::string test_str2{"345"};
@@ -293,7 +338,8 @@ TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestDifferentOutp
     mulog_set_log_level(MULOG_LOG_LVL_DEBUG);
 }
 
-TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestPerOutputLogLevel", "[mulog]")
+TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestPerOutputLogLevel",
+                 TEXT_OUTPUT_TAGS)
 {
     const std::string test_str1{"123"};
     const std::string test_str2{"345"};
@@ -321,7 +367,8 @@ TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestTooManyOutput
     }
 }
 
-TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestIncorrectLogLevel", "[mulog]")
+TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestIncorrectLogLevel",
+                 LOG_BUFFER_LAYOUT_TAGS)
 {
     constexpr std::string_view output{"Hello world"};
     auto ret = mulog_add_output(test_output);
@@ -348,6 +395,34 @@ TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestDeferredLogUn
     REQUIRE(MULOG_RET_CODE_OK == ret);
     const auto ret_int = mulog_deferred_process();
     REQUIRE(MULOG_RET_CODE_UNSUPPORTED == ret_int);
+    REQUIRE(0 == mulog_deferred_get_dropped_count());
+    REQUIRE(0 == mulog_deferred_get_level_dropped_count(MULOG_LOG_LVL_ERROR));
+    REQUIRE(MULOG_RET_CODE_UNSUPPORTED ==
+            mulog_deferred_set_overflow_policy(MULOG_OVERFLOW_DROP_OLDEST, 0));
+
+    const mulog_process_budget budget{0, 1, 0};
+    size_t remaining = SIZE_MAX;
+    REQUIRE(MULOG_RET_CODE_UNSUPPORTED == mulog_deferred_process_budget(&budget, &remaining));
+    REQUIRE(0 == remaining);
+
+    const mulog_log_output_vec_fn output_vec = [](const mulog_iovec *, size_t) {};
+    REQUIRE(MULOG_RET_CODE_UNSUPPORTED == mulog_add_output_vec(output_vec, MULOG_LOG_LVL_DEBUG));
+    REQUIRE(MULOG_RET_CODE_UNSUPPORTED == mulog_unregister_output_vec(output_vec));
+
+    std::array<char, 64> priority_buffer{};
+    REQUIRE(MULOG_RET_CODE_UNSUPPORTED ==
+            mulog_set_priority_log_buffer(priority_buffer.data(), priority_buffer.size()));
+    REQUIRE(MULOG_RET_CODE_UNSUPPORTED ==
+            mulog_set_persistent_log_buffer(priority_buffer.data(), priority_buffer.size()));
+    REQUIRE(MULOG_RET_CODE_UNSUPPORTED ==
+            mulog_deferred_recover(priority_buffer.data(), priority_buffer.size(),
+                                   [](const char *, size_t) {}));
+    REQUIRE(MULOG_RET_CODE_UNSUPPORTED ==
+            mulog_deferred_emergency_flush([](const char *, size_t) {}, "crash"));
+    REQUIRE(MULOG_RET_CODE_UNSUPPORTED ==
+            mulog_set_flight_recorder(priority_buffer.data(), priority_buffer.size(),
+                                      MULOG_LOG_LVL_INFO));
+    REQUIRE(MULOG_RET_CODE_UNSUPPORTED == mulog_flight_recorder_dump());
 }
 
 class Mulog4ByteBuffer {
@@ -365,7 +440,7 @@ public:
     }
 };
 
-TEST_CASE_METHOD(Mulog4ByteBuffer, "Mulog4ByteBuffer - SingleLog", "[mulog]")
+TEST_CASE_METHOD(Mulog4ByteBuffer, "Mulog4ByteBuffer - SingleLog", LOG_BUFFER_LAYOUT_TAGS)
 {
     const std::string input{"Hello world"};
     const auto ret = mulog_add_output(test_output);
@@ -391,7 +466,7 @@ public:
     }
 };
 
-TEST_CASE_METHOD(Mulog16ByteBuffer, "Mulog16ByteBuffer - SingleLog", "[mulog]")
+TEST_CASE_METHOD(Mulog16ByteBuffer, "Mulog16ByteBuffer - SingleLog", LOG_BUFFER_LAYOUT_TAGS)
 {
     const std::string input{"Hello world"};
     const auto ret = mulog_add_output(test_output);
@@ -417,7 +492,7 @@ public:
     }
 };
 
-TEST_CASE_METHOD(Mulog41ByteBuffer, "Mulog41ByteBuffer - SingleLog", "[mulog]")
+TEST_CASE_METHOD(Mulog41ByteBuffer, "Mulog41ByteBuffer - SingleLog", LOG_BUFFER_LAYOUT_TAGS)
 {
     const std::string input{"Hello world"};
     const auto ret = mulog_add_output(test_output);
@@ -428,7 +503,8 @@ TEST_CASE_METHOD(Mulog41ByteBuffer, "Mulog41ByteBuffer - SingleLog", "[mulog]")
     REQUIRE(expected == std::string(buffer.data()));
 }
 
-TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestAllLogLevelMacros", "[mulog]")
+TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestAllLogLevelMacros",
+                 LOG_BUFFER_LAYOUT_TAGS)
 {
     const std::string test_str{"test"};
     auto ret = mulog_add_output(test_output);
@@ -457,7 +533,8 @@ TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestAllLogLevelMa
     MULOG_LOG_ERR("%s", test_str.c_str());
 }
 
-TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestLogLevelFiltering", "[mulog]")
+TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestLogLevelFiltering",
+                 LOG_BUFFER_LAYOUT_TAGS)
 {
     const std::string test_str{"test"};
     auto ret = mulog_add_output(test_output);
@@ -483,7 +560,8 @@ TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestLogLevelFilte
     MULOG_LOG_ERR("%s", test_str.c_str());
 }
 
-TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestChannelLogLevelUpdate", "[mulog]")
+TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestChannelLogLevelUpdate",
+                 TEXT_OUTPUT_TAGS)
 {
     const std::string test_str{"test"};
     auto ret = mulog_add_output(test_output);
@@ -506,7 +584,8 @@ TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestChannelLogLev
     MULOG_LOG_ERR("%s", test_str.c_str());
 }
 
-TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestGlobalLogLevelChangeAffectsAll", "[mulog]")
+TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestGlobalLogLevelChangeAffectsAll",
+                 TEXT_OUTPUT_TAGS)
 {
     const std::string test_str{"test"};
     auto ret = mulog_add_output(multi_output_1);
@@ -559,7 +638,8 @@ TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestUnregisterAll
     MULOG_LOG_DBG("after unregister");
 }
 
-TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestEmptyFormatString", "[mulog]")
+TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestEmptyFormatString",
+                 TEXT_OUTPUT_TAGS)
 {
     auto ret = mulog_add_output(test_output);
     REQUIRE(MULOG_RET_CODE_OK == ret);
@@ -569,7 +649,8 @@ TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestEmptyFormatSt
     MULOG_LOG_DBG("");
 }
 
-TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestComplexFormatting", "[mulog]")
+TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestComplexFormatting",
+                 TEXT_OUTPUT_TAGS)
 {
     auto ret = mulog_add_output(test_output);
     REQUIRE(MULOG_RET_CODE_OK == ret);
@@ -615,7 +696,8 @@ TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestAllLogLevelsF
     REQUIRE(MULOG_RET_CODE_INVALID_ARG == ret);
 }
 
-TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestVeryLongMessage", "[mulog]")
+TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestVeryLongMessage",
+                 TEXT_OUTPUT_TAGS)
 {
     auto ret = mulog_add_output(test_output);
     REQUIRE(MULOG_RET_CODE_OK == ret);
@@ -636,7 +718,8 @@ TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestBufferBoundar
     MULOG_LOG_DBG("%s", exact_fit.c_str());
 }
 
-TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestSetChannelAfterGlobalChange", "[mulog]")
+TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestSetChannelAfterGlobalChange",
+                 TEXT_OUTPUT_TAGS)
 {
     auto ret = mulog_add_output(test_output);
     REQUIRE(MULOG_RET_CODE_OK == ret);
@@ -652,3 +735,249 @@ TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestSetChannelAft
     REQUIRE_CALL(output_mock, test_output(get_log_buffer(), expected.size()));
     MULOG_LOG_DBG("test");
 }
+
+TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestLogLevelEnabledCheck", "[mulog]")
+{
+    int evaluated = 0;
+
+    // no outputs registered, nothing can be logged
+    REQUIRE_FALSE(mulog_is_log_level_enabled(MULOG_LOG_LVL_ERROR));
+    REQUIRE(0 == MULOG_LOG_ERR("%d", ++evaluated));
+    REQUIRE(0 == evaluated);
+
+    auto ret = mulog_add_output_with_log_level(multi_output_1, MULOG_LOG_LVL_WARNING);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE_FALSE(mulog_is_log_level_enabled(MULOG_LOG_LVL_INFO));
+    REQUIRE(mulog_is_log_level_enabled(MULOG_LOG_LVL_WARNING));
+
+    // the lowest level among all outputs is used
+    ret = mulog_add_output_with_log_level(multi_output_2, MULOG_LOG_LVL_DEBUG);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE_FALSE(mulog_is_log_level_enabled(MULOG_LOG_LVL_TRACE));
+    REQUIRE(mulog_is_log_level_enabled(MULOG_LOG_LVL_DEBUG));
+
+    FORBID_CALL(output_mock, multi_output_1(trompeloeil::_, trompeloeil::_));
+    FORBID_CALL(output_mock, multi_output_2(trompeloeil::_, trompeloeil::_));
+    REQUIRE(0 == MULOG_LOG_TRACE("%d", ++evaluated));
+    REQUIRE(0 == evaluated);
+
+    ret = mulog_set_channel_log_level(multi_output_1, MULOG_LOG_LVL_TRACE);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE(mulog_is_log_level_enabled(MULOG_LOG_LVL_TRACE));
+
+    ret = mulog_unregister_output(multi_output_1);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE_FALSE(mulog_is_log_level_enabled(MULOG_LOG_LVL_TRACE));
+
+    ret = mulog_set_log_level(MULOG_LOG_LVL_ERROR);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE_FALSE(mulog_is_log_level_enabled(MULOG_LOG_LVL_WARNING));
+    REQUIRE(mulog_is_log_level_enabled(MULOG_LOG_LVL_ERROR));
+
+    mulog_reset();
+    REQUIRE_FALSE(mulog_is_log_level_enabled(MULOG_LOG_LVL_ERROR));
+}
+
+TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestLoggerInstances", "[mulog]")
+{
+    static std::vector<std::string> instance_collected;
+    static int instance_locks = 0;
+    std::array<char, 128> instance_buffer{};
+    const mulog_instance_lock lock{
+        [](void *arg) {
+            ++*static_cast<int *>(arg);
+            return true;
+        },
+        [](void *) {},
+        &instance_locks,
+#if defined(MULOG_ENABLE_NONBLOCKING_LOG) && MULOG_ENABLE_NONBLOCKING_LOG == 1
+        [](void *arg) {
+            ++*static_cast<int *>(arg);
+            return true;
+        },
+#endif /* MULOG_ENABLE_NONBLOCKING_LOG */
+    };
+    const mulog_log_output_fn instance_output = [](const char *buf, const size_t buf_size) {
+        instance_collected.emplace_back(buf, buf_size);
+    };
+    auto *instance = mulog_instance_init(&lock);
+
+    if constexpr (MULOG_INSTANCES == 0) {
+        REQUIRE(nullptr == instance);
+        return;
+    }
+
+    REQUIRE(nullptr != instance);
+
+    // nothing is logged before the instance gets its own buffer and outputs
+    REQUIRE(0 == mulog_instance_log(instance, MULOG_LOG_LVL_ERROR, "no buffer"));
+    auto ret = mulog_instance_set_log_buffer(instance, instance_buffer.data(),
+                                             instance_buffer.size());
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_instance_add_output(instance, instance_output, MULOG_LOG_LVL_TRACE);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_instance_set_log_level(instance, MULOG_LOG_LVL_WARNING);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    instance_collected.clear();
+
+    // the instance outputs do not enable the log macros of the default logger
+    REQUIRE_FALSE(mulog_is_log_level_enabled(MULOG_LOG_LVL_ERROR));
+    FORBID_CALL(output_mock, test_output(trompeloeil::_, trompeloeil::_));
+    REQUIRE(0 == mulog_instance_log(instance, MULOG_LOG_LVL_INFO, "filtered"));
+    instance_locks = 0;
+    REQUIRE(mulog_instance_log(instance, MULOG_LOG_LVL_ERROR, "instance %d", 1) > 0);
+    REQUIRE(1 == instance_locks);
+    REQUIRE(1 == instance_collected.size());
+
+    if constexpr (text_output) {
+        const auto expected = generate_expected_output("instance 1", MULOG_LOG_LVL_ERROR, SIZE_MAX);
+        REQUIRE(expected == instance_collected.front());
+    }
+
+    REQUIRE(MULOG_RET_CODE_UNSUPPORTED == mulog_instance_process(instance));
+
+    ret = mulog_instance_unregister_output(instance, instance_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_instance_unregister_output(instance, instance_output);
+    REQUIRE(MULOG_RET_CODE_NOT_FOUND == ret);
+    mulog_instance_deinit(instance);
+}
+
+TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestOutputContext", "[mulog]")
+{
+    struct Sink {
+        std::vector<std::string> lines;
+        int closed = 0;
+    };
+    std::array<Sink, MULOG_OUTPUT_HANDLERS + 2> sinks{};
+    std::array<mulog_output_slot, MULOG_OUTPUT_HANDLERS + 2> registry{};
+    const mulog_output_write_fn write = [](void *ctx, const char *data, const size_t size) {
+        static_cast<Sink *>(ctx)->lines.emplace_back(data, size);
+    };
+    const mulog_output_close_fn close = [](void *ctx) { ++static_cast<Sink *>(ctx)->closed; };
+    const auto make_output = [&](Sink &sink) { return mulog_output{write, close, &sink}; };
+
+    auto output = make_output(sinks[0]);
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG == mulog_add_output_ctx(nullptr, MULOG_LOG_LVL_TRACE));
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG == mulog_add_output_ctx(&output, MULOG_LOG_LVL_COUNT));
+    output.write = nullptr;
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG == mulog_add_output_ctx(&output, MULOG_LOG_LVL_TRACE));
+
+    // outputs sharing the write function are told apart by their context
+    for (size_t i = 0; i < MULOG_OUTPUT_HANDLERS; ++i) {
+        output = make_output(sinks[i]);
+        REQUIRE(MULOG_RET_CODE_OK == mulog_add_output_ctx(&output, MULOG_LOG_LVL_DEBUG));
+    }
+
+    output = make_output(sinks[MULOG_OUTPUT_HANDLERS]);
+    REQUIRE(MULOG_RET_CODE_NO_MEM == mulog_add_output_ctx(&output, MULOG_LOG_LVL_DEBUG));
+
+    // the registry grows without recompiling, registered outputs are moved to it
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG == mulog_set_output_registry(registry.data(), 0));
+    REQUIRE(MULOG_RET_CODE_NO_MEM == mulog_set_output_registry(registry.data(), 1));
+    REQUIRE(MULOG_RET_CODE_OK == mulog_set_output_registry(registry.data(), registry.size()));
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG ==
+            mulog_set_output_registry(registry.data(), registry.size()));
+
+    for (size_t i = MULOG_OUTPUT_HANDLERS; i < sinks.size(); ++i) {
+        output = make_output(sinks[i]);
+        REQUIRE(MULOG_RET_CODE_OK == mulog_add_output_ctx(&output, MULOG_LOG_LVL_DEBUG));
+    }
+
+    REQUIRE(MULOG_RET_CODE_NO_MEM == mulog_add_output(test_output));
+    REQUIRE(mulog_log(MULOG_LOG_LVL_INFO, "sink %d", 1) > 0);
+    REQUIRE(0 == mulog_log(MULOG_LOG_LVL_TRACE, "filtered"));
+
+    for (const auto &sink : sinks) {
+        REQUIRE(1 == sink.lines.size());
+
+        if constexpr (text_output) {
+            const auto expected = generate_expected_output("sink 1", MULOG_LOG_LVL_INFO, SIZE_MAX);
+            REQUIRE(expected == sink.lines.front());
+        }
+
+        REQUIRE(0 == sink.closed);
+    }
+
+    REQUIRE(MULOG_RET_CODE_OK == mulog_unregister_output_ctx(write, &sinks[0]));
+    REQUIRE(1 == sinks[0].closed);
+    REQUIRE(MULOG_RET_CODE_NOT_FOUND == mulog_unregister_output_ctx(write, &sinks[0]));
+    REQUIRE(MULOG_RET_CODE_NOT_FOUND == mulog_unregister_output(test_output));
+    REQUIRE(1 == sinks[0].closed);
+
+    // the remaining outputs fit into the built-in storage again
+    REQUIRE(MULOG_RET_CODE_NO_MEM == mulog_set_output_registry(nullptr, 0));
+    REQUIRE(MULOG_RET_CODE_OK == mulog_unregister_output_ctx(write, &sinks[1]));
+    REQUIRE(MULOG_RET_CODE_OK == mulog_unregister_output_ctx(write, &sinks[2]));
+    REQUIRE(MULOG_RET_CODE_OK == mulog_set_output_registry(nullptr, 0));
+    REQUIRE(mulog_log(MULOG_LOG_LVL_INFO, "sink %d", 2) > 0);
+    REQUIRE(2 == sinks.back().lines.size());
+
+    mulog_reset();
+
+    for (const auto &sink : sinks) {
+        REQUIRE(1 == sink.closed);
+    }
+}
+
+TEST_CASE_METHOD(MulogTestsWithBuffer, "MulogTestsWithBuffer - TestOutputDispatchTable",
+                 TEXT_OUTPUT_TAGS)
+{
+    std::array<std::vector<mulog_log_level>, 4> received{};
+    std::array<mulog_output_slot, 4> registry{};
+    const mulog_output_write_fn write = [](void *ctx, const char *data, const size_t size) {
+        auto *levels = static_cast<std::vector<mulog_log_level> *>(ctx);
+        const std::string_view line{data, size};
+
+        for (size_t level = 0; level < log_levels.size(); ++level) {
+            if (line.find(log_levels[level]) != std::string_view::npos) {
+                levels->push_back(static_cast<mulog_log_level>(level));
+            }
+        }
+    };
+    constexpr std::array output_levels{MULOG_LOG_LVL_ERROR, MULOG_LOG_LVL_TRACE,
+                                       MULOG_LOG_LVL_INFO, MULOG_LOG_LVL_INFO};
+
+    REQUIRE(MULOG_RET_CODE_OK == mulog_set_output_registry(registry.data(), registry.size()));
+
+    for (size_t i = 0; i < received.size(); ++i) {
+        const mulog_output output{write, nullptr, &received[i]};
+        REQUIRE(MULOG_RET_CODE_OK == mulog_add_output_ctx(&output, output_levels[i]));
+    }
+
+    const auto log_all_levels = [&] {
+        for (auto &levels : received) {
+            levels.clear();
+        }
+
+        for (size_t level = 0; level < log_levels.size(); ++level) {
+            mulog_log(static_cast<mulog_log_level>(level), "dispatch");
+        }
+    };
+
+    // every output only gets the levels it accepts, regardless of the registration order
+    log_all_levels();
+    REQUIRE(std::vector{MULOG_LOG_LVL_ERROR} == received[0]);
+    REQUIRE(5 == received[1].size());
+    REQUIRE(std::vector{MULOG_LOG_LVL_INFO, MULOG_LOG_LVL_WARNING, MULOG_LOG_LVL_ERROR} ==
+            received[2]);
+    REQUIRE(received[2] == received[3]);
+    REQUIRE(mulog_is_log_level_enabled(MULOG_LOG_LVL_TRACE));
+
+    // the table is rebuilt once an output leaves
+    REQUIRE(MULOG_RET_CODE_OK == mulog_unregister_output_ctx(write, &received[1]));
+    REQUIRE_FALSE(mulog_is_log_level_enabled(MULOG_LOG_LVL_DEBUG));
+    log_all_levels();
+    REQUIRE(received[1].empty());
+    REQUIRE(std::vector{MULOG_LOG_LVL_ERROR} == received[0]);
+    REQUIRE(3 == received[3].size());
+
+    REQUIRE(MULOG_RET_CODE_OK == mulog_set_log_level(MULOG_LOG_LVL_WARNING));
+    log_all_levels();
+
+    for (size_t i = 0; i < received.size(); ++i) {
+        REQUIRE((i == 1 ? 0 : 2) == received[i].size());
+    }
+
+    mulog_reset();
+}
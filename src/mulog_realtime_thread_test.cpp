@@ -0,0 +1,268 @@
+/**
+ * \file
+ * \brief mulog tests for the realtime logging mode with per-thread log buffers
+ * \author Vladimir Petrigo
+ */
+#include "internal/config.h"
+#include "internal/utils.h"
+#include "mulog.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <fmt/format.h>
+
+#include <array>
+#include <atomic>
+#include <cstdarg>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr std::array log_levels{
+        MULOG_TRACE_LVL, MULOG_DEBUG_LVL, MULOG_INFO_LVL, MULOG_WARNING_LVL, MULOG_ERROR_LVL,
+    };
+
+    std::mutex logger_mutex;
+    std::mutex format_mutex;
+    std::mutex output_mutex;
+    // tracked per thread, so formatting in one thread is not seen as locked by another thread
+    thread_local bool lock_held = false;
+    std::atomic<size_t> lock_count{0};
+    std::atomic<size_t> formatted_under_lock{0};
+    std::vector<std::string> collected;
+
+    void collect_output(const char *buf, const size_t buf_size)
+    {
+        collected.emplace_back(buf, buf_size);
+    }
+
+    std::string generate_expected_output(const std::string &input, const mulog_log_level log_level)
+    {
+        if constexpr (MULOG_ENABLE_TIMESTAMP) {
+            const auto timestamp_ms = mulog_config_mulog_timestamp_get();
+
+            return fmt::format("{:07}.{:03} {}: {}{}", timestamp_ms / 1000, timestamp_ms % 1000,
+                               log_levels[log_level], input, MULOG_LOG_LINE_TERMINATION);
+        } else {
+            return fmt::format("{}: {}{}", log_levels[log_level], input,
+                               MULOG_LOG_LINE_TERMINATION);
+        }
+    }
+
+    extern "C" bool mulog_config_mulog_lock(void)
+    {
+        logger_mutex.lock();
+        lock_held = true;
+        ++lock_count;
+
+        return true;
+    }
+
+    // every log line is checked, so log calls of the non-blocking mode wait for the lock
+    extern "C" bool mulog_config_mulog_trylock(void)
+    {
+        return mulog_config_mulog_lock();
+    }
+
+    extern "C" void mulog_config_mulog_unlock(void)
+    {
+        lock_held = false;
+        logger_mutex.unlock();
+    }
+
+    extern "C" bool mulog_config_mulog_format_lock(void)
+    {
+        format_mutex.lock();
+        lock_held = true;
+
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_format_unlock(void)
+    {
+        lock_held = false;
+        format_mutex.unlock();
+    }
+
+    extern "C" bool mulog_config_mulog_output_lock(void)
+    {
+        output_mutex.lock();
+        ++lock_count;
+
+        return true;
+    }
+
+    extern "C" void mulog_config_mulog_output_unlock(void)
+    {
+        output_mutex.unlock();
+    }
+
+    extern "C" unsigned long mulog_config_mulog_timestamp_get(void)
+    {
+        return 42123UL;
+    }
+
+    extern "C" void putchar_(int c)
+    {
+    }
+
+    extern "C" int __real_vsnprintf_(char *s, size_t count, const char *fmt, va_list ap);
+
+    extern "C" int __wrap_vsnprintf_(char *s, size_t count, const char *fmt, va_list ap)
+    {
+        if (lock_held) {
+            ++formatted_under_lock;
+        }
+
+        return __real_vsnprintf_(s, count, fmt, ap);
+    }
+} // namespace
+
+class MulogThreadBuffer {
+public:
+    std::array<char, 128> buffer{};
+    std::array<char, 128> thread_buffer{};
+
+    MulogThreadBuffer()
+    {
+        mulog_set_log_buffer(buffer.data(), buffer.size());
+        collected.clear();
+        lock_count = 0;
+        formatted_under_lock = 0;
+    }
+
+    ~MulogThreadBuffer()
+    {
+        mulog_set_thread_log_buffer(nullptr, 0);
+        mulog_reset();
+    }
+};
+
+TEST_CASE_METHOD(MulogThreadBuffer, "MulogThreadBuffer - InvalidThreadBuffer", "[realtime][thread]")
+{
+    auto ret = mulog_set_thread_log_buffer(thread_buffer.data(), 0);
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG == ret);
+    ret = mulog_set_thread_log_buffer(thread_buffer.data(), thread_buffer.size());
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_set_thread_log_buffer(nullptr, 0);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+}
+
+TEST_CASE_METHOD(MulogThreadBuffer, "MulogThreadBuffer - SharedBufferFormatsUnderLock",
+                 "[realtime][thread]")
+{
+    auto ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    const auto expected = generate_expected_output("shared 1", MULOG_LOG_LVL_ERROR);
+    REQUIRE(expected.size() == MULOG_LOG_ERR("shared %d", 1));
+    REQUIRE(formatted_under_lock > 0);
+    REQUIRE(std::vector<std::string>{expected} == collected);
+}
+
+TEST_CASE_METHOD(MulogThreadBuffer, "MulogThreadBuffer - ThreadBufferFormatsWithoutLock",
+                 "[realtime][thread]")
+{
+    auto ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_set_thread_log_buffer(thread_buffer.data(), thread_buffer.size());
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    lock_count = 0;
+
+    const auto expected = generate_expected_output("thread 1", MULOG_LOG_LVL_ERROR);
+    REQUIRE(expected.size() == MULOG_LOG_ERR("thread %d", 1));
+    REQUIRE(0 == formatted_under_lock);
+    REQUIRE(1 == lock_count);
+    REQUIRE(std::vector<std::string>{expected} == collected);
+    REQUIRE(std::string{expected} == std::string{thread_buffer.data(), expected.size()});
+}
+
+TEST_CASE_METHOD(MulogThreadBuffer, "MulogThreadBuffer - ThreadBufferTruncation",
+                 "[realtime][thread]")
+{
+    std::array<char, 16> small_buffer{};
+    auto ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    ret = mulog_set_thread_log_buffer(small_buffer.data(), small_buffer.size());
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    const std::string long_string(64, 'x');
+    const auto expected = generate_expected_output(long_string, MULOG_LOG_LVL_ERROR);
+    REQUIRE(small_buffer.size() - 1 == MULOG_LOG_ERR("%s", long_string.c_str()));
+    REQUIRE(1 == collected.size());
+    REQUIRE(expected.substr(0, small_buffer.size() - 1) == collected.front());
+    mulog_set_thread_log_buffer(nullptr, 0);
+}
+
+TEST_CASE_METHOD(MulogThreadBuffer, "MulogThreadBuffer - FilteredLevelIsNotOutput",
+                 "[realtime][thread]")
+{
+    auto ret = mulog_set_thread_log_buffer(thread_buffer.data(), thread_buffer.size());
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE(0 == MULOG_LOG_ERR("no outputs"));
+
+    ret = mulog_add_output_with_log_level(collect_output, MULOG_LOG_LVL_WARNING);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+    REQUIRE(0 == MULOG_LOG_INFO("filtered"));
+    REQUIRE(MULOG_LOG_WARN("passed") > 0);
+    REQUIRE(0 == mulog_log(MULOG_LOG_LVL_COUNT, "invalid"));
+    REQUIRE(std::vector<std::string>{generate_expected_output("passed", MULOG_LOG_LVL_WARNING)} ==
+            collected);
+}
+
+TEST_CASE_METHOD(MulogThreadBuffer, "MulogThreadBuffer - MultipleThreads", "[realtime][thread]")
+{
+    constexpr size_t threads_count = 4;
+    constexpr size_t entries_per_thread = 500;
+    auto ret = mulog_add_output(collect_output);
+    REQUIRE(MULOG_RET_CODE_OK == ret);
+
+    std::atomic<size_t> failures{0};
+    std::vector<std::thread> threads;
+
+    for (size_t id = 0; id < threads_count; ++id) {
+        threads.emplace_back([id, &failures]() {
+            std::array<char, 128> local_buffer{};
+
+            if (mulog_set_thread_log_buffer(local_buffer.data(), local_buffer.size()) !=
+                MULOG_RET_CODE_OK) {
+                ++failures;
+                return;
+            }
+
+            for (size_t seq = 0; seq < entries_per_thread; ++seq) {
+                if (MULOG_LOG_INFO("thread=%zu seq=%zu", id, seq) <= 0) {
+                    ++failures;
+                }
+            }
+
+            mulog_set_thread_log_buffer(nullptr, 0);
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    REQUIRE(0 == failures);
+    REQUIRE(0 == formatted_under_lock);
+    REQUIRE(threads_count * entries_per_thread == collected.size());
+
+    std::array<size_t, threads_count> next_seq{};
+
+    for (const auto &entry : collected) {
+        const auto position = entry.find("thread=");
+        REQUIRE(std::string::npos != position);
+
+        size_t id = 0;
+        size_t seq = 0;
+        REQUIRE(2 == std::sscanf(entry.c_str() + position, "thread=%zu seq=%zu", &id, &seq));
+        REQUIRE(id < threads_count);
+        REQUIRE(next_seq[id] == seq);
+        REQUIRE(generate_expected_output(fmt::format("thread={} seq={}", id, seq),
+                                         MULOG_LOG_LVL_INFO) == entry);
+        next_seq[id] = seq + 1;
+    }
+}
@@ -0,0 +1,325 @@
+/**
+ * \file
+ * \brief Copy-on-write output table tests
+ * \author Vladimir Petrigo
+ */
+#include "internal/output_table.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+    void output_a(const char *, size_t)
+    {
+    }
+
+    void output_b(const char *, size_t)
+    {
+    }
+
+    void output_c(const char *, size_t)
+    {
+    }
+
+    void ctx_write(void *, const char *, size_t)
+    {
+    }
+
+    void ctx_close(void *ctx)
+    {
+        ++*static_cast<int *>(ctx);
+    }
+
+    std::vector<mulog_log_output_fn> get_outputs(const out_table *snapshot)
+    {
+        std::vector<mulog_log_output_fn> outputs;
+
+        for (size_t i = 0; i < snapshot->count; ++i) {
+            outputs.push_back(snapshot->fns[i].output);
+        }
+
+        return outputs;
+    }
+
+    class OutputTable {
+    public:
+        OutputTable()
+        {
+            output_table_reset(&table);
+        }
+
+    protected:
+        output_table table{};
+    };
+} // namespace
+
+TEST_CASE_METHOD(OutputTable, "OutputTable - OrderedByLogLevel", "[output_table]")
+{
+    std::vector<out_function> storage(2 * 3);
+
+    REQUIRE(MULOG_LOG_LVL_COUNT == output_table_get_min_level(&table));
+    REQUIRE(MULOG_RET_CODE_OK == output_table_set_storage(&table, storage.data(), 3));
+
+    out_function out{.output = output_a, .log_level = MULOG_LOG_LVL_WARNING};
+    REQUIRE(MULOG_RET_CODE_OK == output_table_add(&table, &out));
+    out = {.output = output_b, .log_level = MULOG_LOG_LVL_DEBUG};
+    REQUIRE(MULOG_RET_CODE_OK == output_table_add(&table, &out));
+    out = {.output = output_c, .log_level = MULOG_LOG_LVL_WARNING};
+    REQUIRE(MULOG_RET_CODE_OK == output_table_add(&table, &out));
+    out = {.output = output_c, .log_level = MULOG_LOG_LVL_COUNT};
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG == output_table_add(&table, &out));
+    REQUIRE(MULOG_LOG_LVL_DEBUG == output_table_get_min_level(&table));
+
+    const auto *snapshot = output_table_acquire(&table);
+
+    REQUIRE(std::vector<mulog_log_output_fn>{output_b, output_a, output_c} ==
+            get_outputs(snapshot));
+    REQUIRE(0 == out_table_get_count(snapshot, MULOG_LOG_LVL_TRACE));
+    REQUIRE(1 == out_table_get_count(snapshot, MULOG_LOG_LVL_INFO));
+    REQUIRE(3 == out_table_get_count(snapshot, MULOG_LOG_LVL_ERROR));
+    REQUIRE(3 == out_table_get_count(snapshot, MULOG_LOG_LVL_COUNT));
+    output_table_release(snapshot);
+
+    REQUIRE(MULOG_RET_CODE_OK == output_table_set_level(&table, output_c, MULOG_LOG_LVL_TRACE));
+    REQUIRE(MULOG_RET_CODE_NOT_FOUND ==
+            output_table_set_level(&table, nullptr, MULOG_LOG_LVL_TRACE));
+    REQUIRE(MULOG_LOG_LVL_TRACE == output_table_get_min_level(&table));
+    snapshot = output_table_acquire(&table);
+    REQUIRE(std::vector<mulog_log_output_fn>{output_c, output_b, output_a} ==
+            get_outputs(snapshot));
+    output_table_release(snapshot);
+
+    out = {.output = output_b};
+    REQUIRE(MULOG_RET_CODE_OK == output_table_remove(&table, &out));
+    REQUIRE(MULOG_RET_CODE_NOT_FOUND == output_table_remove(&table, &out));
+    REQUIRE(MULOG_RET_CODE_OK == output_table_set_all_levels(&table, MULOG_LOG_LVL_ERROR));
+    REQUIRE(MULOG_LOG_LVL_ERROR == output_table_get_min_level(&table));
+    snapshot = output_table_acquire(&table);
+    REQUIRE(std::vector<mulog_log_output_fn>{output_c, output_a} == get_outputs(snapshot));
+    REQUIRE(0 == out_table_get_count(snapshot, MULOG_LOG_LVL_WARNING));
+    output_table_release(snapshot);
+}
+
+TEST_CASE("OutputTable - ZeroInitialized", "[output_table]")
+{
+    static output_table zeroed;
+
+    // readers see a table without outputs until the first update sets it up
+    REQUIRE(MULOG_LOG_LVL_COUNT == output_table_get_min_level(&zeroed));
+    auto *snapshot = output_table_acquire(&zeroed);
+    REQUIRE(0 == out_table_get_count(snapshot, MULOG_LOG_LVL_COUNT));
+    REQUIRE(0 == out_table_get_count(snapshot, MULOG_LOG_LVL_ERROR));
+
+    const out_function out{.output = output_a, .log_level = MULOG_LOG_LVL_INFO};
+    REQUIRE(MULOG_RET_CODE_OK == output_table_add(&zeroed, &out));
+    REQUIRE(MULOG_LOG_LVL_INFO == output_table_get_min_level(&zeroed));
+    output_table_release(snapshot);
+
+    snapshot = output_table_acquire(&zeroed);
+    REQUIRE(std::vector<mulog_log_output_fn>{output_a} == get_outputs(snapshot));
+    REQUIRE((zeroed.fns == snapshot->fns || zeroed.fns + MULOG_OUTPUT_HANDLERS == snapshot->fns));
+    output_table_release(snapshot);
+}
+
+TEST_CASE_METHOD(OutputTable, "OutputTable - Capacity", "[output_table]")
+{
+    const out_function out{.output = output_a, .log_level = MULOG_LOG_LVL_TRACE};
+
+    for (size_t i = 0; i < MULOG_OUTPUT_HANDLERS; ++i) {
+        REQUIRE(MULOG_RET_CODE_OK == output_table_add(&table, &out));
+    }
+
+    REQUIRE(MULOG_RET_CODE_NO_MEM == output_table_add(&table, &out));
+
+    std::vector<out_function> small(2 * MULOG_OUTPUT_HANDLERS);
+    std::vector<out_function> large(2 * (MULOG_OUTPUT_HANDLERS + 1));
+
+    REQUIRE(MULOG_RET_CODE_NO_MEM ==
+            output_table_set_storage(&table, small.data(), MULOG_OUTPUT_HANDLERS - 1));
+    REQUIRE(MULOG_RET_CODE_OK == output_table_set_storage(&table, large.data(), large.size() / 2));
+    REQUIRE(MULOG_RET_CODE_INVALID_ARG ==
+            output_table_set_storage(&table, large.data(), large.size() / 2));
+    REQUIRE(MULOG_RET_CODE_OK == output_table_add(&table, &out));
+    REQUIRE(MULOG_RET_CODE_NO_MEM == output_table_add(&table, &out));
+
+    const auto *snapshot = output_table_acquire(&table);
+
+    REQUIRE(MULOG_OUTPUT_HANDLERS + 1 == snapshot->count);
+    REQUIRE(snapshot->fns >= large.data());
+    REQUIRE(snapshot->fns < large.data() + large.size());
+    output_table_release(snapshot);
+
+    // the outputs do not fit into the built-in storage anymore
+    REQUIRE(MULOG_RET_CODE_NO_MEM == output_table_set_storage(&table, nullptr, 0));
+    REQUIRE(MULOG_RET_CODE_OK == output_table_remove(&table, &out));
+    REQUIRE(MULOG_RET_CODE_OK == output_table_set_storage(&table, nullptr, 0));
+    REQUIRE(MULOG_RET_CODE_OK == output_table_set_storage(&table, nullptr, 0));
+
+    // the user storage is not used anymore
+    large.clear();
+    snapshot = output_table_acquire(&table);
+    REQUIRE(MULOG_OUTPUT_HANDLERS == snapshot->count);
+    REQUIRE(output_a == snapshot->fns[MULOG_OUTPUT_HANDLERS - 1].output);
+    output_table_release(snapshot);
+}
+
+TEST_CASE_METHOD(OutputTable, "OutputTable - SnapshotNotChangedByUpdate", "[output_table]")
+{
+    int closed = 0;
+    const out_function ctx_out{
+        .ctx_output = {.write = ctx_write, .close = ctx_close, .ctx = &closed},
+        .log_level = MULOG_LOG_LVL_INFO};
+    const out_function out{.output = output_a, .log_level = MULOG_LOG_LVL_DEBUG};
+
+    REQUIRE(MULOG_RET_CODE_OK == output_table_add(&table, &ctx_out));
+
+    const auto *held = output_table_acquire(&table);
+
+    // the update is published without waiting for the reader of the previous snapshot
+    REQUIRE(MULOG_RET_CODE_OK == output_table_add(&table, &out));
+    REQUIRE(MULOG_LOG_LVL_DEBUG == output_table_get_min_level(&table));
+
+    const auto *current = output_table_acquire(&table);
+
+    REQUIRE(current != held);
+    REQUIRE(2 == current->count);
+    output_table_release(current);
+
+    // the next update fills the held snapshot, so it fails until the snapshot is released
+    REQUIRE(MULOG_RET_CODE_LOCK_FAILED == output_table_remove(&table, &ctx_out));
+    REQUIRE(MULOG_RET_CODE_LOCK_FAILED == output_table_set_all_levels(&table, MULOG_LOG_LVL_INFO));
+    REQUIRE(MULOG_RET_CODE_LOCK_FAILED == output_table_clear(&table));
+    REQUIRE(1 == held->count);
+    REQUIRE(ctx_write == held->fns[0].ctx_output.write);
+
+    output_table_release(held);
+
+    REQUIRE(MULOG_RET_CODE_OK == output_table_remove(&table, &ctx_out));
+    REQUIRE(1 == closed);
+
+    current = output_table_acquire(&table);
+    REQUIRE(std::vector<mulog_log_output_fn>{output_a} == get_outputs(current));
+    output_table_release(current);
+}
+
+TEST_CASE_METHOD(OutputTable, "OutputTable - LastReaderClosesRemovedOutput", "[output_table]")
+{
+    int closed = 0;
+    const out_function ctx_out{
+        .ctx_output = {.write = ctx_write, .close = ctx_close, .ctx = &closed},
+        .log_level = MULOG_LOG_LVL_INFO};
+    std::vector<out_function> storage(2 * 3);
+
+    REQUIRE(MULOG_RET_CODE_OK == output_table_add(&table, &ctx_out));
+
+    const auto *first = output_table_acquire(&table);
+    const auto *second = output_table_acquire(&table);
+
+    // a reader may remove the output it is called by
+    REQUIRE(MULOG_RET_CODE_OK == output_table_remove(&table, &ctx_out));
+    REQUIRE(MULOG_LOG_LVL_COUNT == output_table_get_min_level(&table));
+    REQUIRE(0 == closed);
+
+    output_table_release(first);
+    REQUIRE(0 == closed);
+    REQUIRE(ctx_write == second->fns[0].ctx_output.write);
+    output_table_release(second);
+    REQUIRE(1 == closed);
+
+    // the replaced storage is kept until the previous snapshot is released
+    REQUIRE(MULOG_RET_CODE_OK == output_table_add(&table, &ctx_out));
+
+    const auto *held = output_table_acquire(&table);
+
+    const auto in_storage = [&] {
+        return held->fns >= storage.data() && held->fns < storage.data() + storage.size();
+    };
+
+    REQUIRE(MULOG_RET_CODE_OK == output_table_set_storage(&table, storage.data(), 3));
+    REQUIRE_FALSE(in_storage());
+    REQUIRE(ctx_write == held->fns[0].ctx_output.write);
+    output_table_release(held);
+    REQUIRE(in_storage());
+    REQUIRE(MULOG_RET_CODE_OK == output_table_clear(&table));
+    REQUIRE(2 == closed);
+}
+
+TEST_CASE_METHOD(OutputTable, "OutputTable - ClearClosesOutputs", "[output_table]")
+{
+    int closed = 0;
+    const out_function ctx_out{
+        .ctx_output = {.write = ctx_write, .close = ctx_close, .ctx = &closed},
+        .log_level = MULOG_LOG_LVL_INFO};
+    const out_function out{.output = output_a, .log_level = MULOG_LOG_LVL_DEBUG};
+    std::vector<out_function> storage(2 * 3);
+
+    REQUIRE(MULOG_RET_CODE_OK == output_table_set_storage(&table, storage.data(), 3));
+    REQUIRE(MULOG_RET_CODE_OK == output_table_add(&table, &ctx_out));
+    REQUIRE(MULOG_RET_CODE_OK == output_table_add(&table, &out));
+    REQUIRE(MULOG_RET_CODE_OK == output_table_add(&table, &ctx_out));
+    REQUIRE(MULOG_RET_CODE_OK == output_table_clear(&table));
+
+    REQUIRE(2 == closed);
+    REQUIRE(MULOG_LOG_LVL_COUNT == output_table_get_min_level(&table));
+
+    const auto *snapshot = output_table_acquire(&table);
+
+    REQUIRE(0 == snapshot->count);
+    REQUIRE(0 == out_table_get_count(snapshot, MULOG_LOG_LVL_COUNT));
+    output_table_release(snapshot);
+}
+
+TEST_CASE_METHOD(OutputTable, "OutputTable - ConcurrentReaders", "[output_table]")
+{
+    const out_function out_a{.output = output_a, .log_level = MULOG_LOG_LVL_TRACE};
+    const out_function out_b{.output = output_b, .log_level = MULOG_LOG_LVL_ERROR};
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> inconsistent{0};
+    std::vector<std::thread> readers;
+
+    REQUIRE(MULOG_RET_CODE_OK == output_table_add(&table, &out_a));
+
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&] {
+            while (!stop) {
+                const auto *snapshot = output_table_acquire(&table);
+
+                // every published snapshot keeps output_a first and at most one output_b
+                if (snapshot->count < 1 || snapshot->count > 2 ||
+                    snapshot->fns[0].output != output_a ||
+                    (snapshot->count == 2 && snapshot->fns[1].output != output_b)) {
+                    ++inconsistent;
+                }
+
+                output_table_release(snapshot);
+            }
+        });
+    }
+
+    // an update fails while a reader still holds the snapshot replaced by the previous one
+    const auto update = [](auto &&fn) {
+        mulog_ret_code ret;
+
+        while (MULOG_RET_CODE_LOCK_FAILED == (ret = fn())) {
+            std::this_thread::yield();
+        }
+
+        return ret;
+    };
+
+    for (int i = 0; i < 1000; ++i) {
+        REQUIRE(MULOG_RET_CODE_OK == update([&] { return output_table_add(&table, &out_b); }));
+        REQUIRE(MULOG_RET_CODE_OK == update([&] { return output_table_remove(&table, &out_b); }));
+    }
+
+    stop = true;
+
+    for (auto &reader : readers) {
+        reader.join();
+    }
+
+    REQUIRE(0 == inconsistent);
+}
@@ -0,0 +1,320 @@
+/**
+ * \file
+ * \brief Host decoder for binary log records implementation
+ * \author Vladimir Petrigo
+ */
+
+#include "decoder.h"
+#include "internal/args.h"
+#include "internal/config.h"
+#include "internal/utils.h"
+#include "internal/wire.h"
+
+#include <printf/printf.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ELF_CLASS_32   1
+#define ELF_CLASS_64   2
+#define ELF_DATA_LSB   1
+#define ELF_SHT_SYMTAB 2
+#define ELF_SHT_NOBITS 8
+#define ELF_SHT_DYNSYM 11
+#define ELF_SHF_ALLOC  2
+
+/**
+ * \brief ELF section header fields used by the decoder
+ */
+struct elf_section {
+    uint32_t name;   /**< Section name offset in the section names table */
+    uint32_t type;   /**< Section type */
+    uint64_t flags;  /**< Section flags */
+    uint64_t addr;   /**< Section virtual address */
+    uint64_t offset; /**< Section offset in the file */
+    uint64_t size;   /**< Section size */
+    uint32_t link;   /**< Linked section index */
+};
+
+static uint64_t read_le(const unsigned char *data, const size_t size)
+{
+    uint64_t value = 0;
+
+    for (size_t i = 0; i < size; ++i) {
+        value |= (uint64_t)data[i] << (8 * i);
+    }
+
+    return value;
+}
+
+static bool image_has(const struct decoder *decoder, const uint64_t offset, const uint64_t size)
+{
+    return offset <= decoder->image_size && size <= decoder->image_size - offset;
+}
+
+static bool is_elf64(const struct decoder *decoder)
+{
+    return decoder->image[4] == ELF_CLASS_64;
+}
+
+static bool read_section(const struct decoder *decoder, const size_t index,
+                         struct elf_section *section)
+{
+    const unsigned char *image = decoder->image;
+    const bool elf64 = is_elf64(decoder);
+    const uint64_t shoff = elf64 ? read_le(image + 0x28, 8) : read_le(image + 0x20, 4);
+    const size_t shentsize = (size_t)read_le(image + (elf64 ? 0x3A : 0x2E), 2);
+    const uint64_t header = shoff + index * shentsize;
+
+    if (!image_has(decoder, header, elf64 ? 0x40 : 0x28)) {
+        return false;
+    }
+
+    const unsigned char *sh = image + header;
+
+    section->name = (uint32_t)read_le(sh, 4);
+    section->type = (uint32_t)read_le(sh + 4, 4);
+
+    if (elf64) {
+        section->flags = read_le(sh + 0x08, 8);
+        section->addr = read_le(sh + 0x10, 8);
+        section->offset = read_le(sh + 0x18, 8);
+        section->size = read_le(sh + 0x20, 8);
+        section->link = (uint32_t)read_le(sh + 0x28, 4);
+    } else {
+        section->flags = read_le(sh + 0x08, 4);
+        section->addr = read_le(sh + 0x0C, 4);
+        section->offset = read_le(sh + 0x10, 4);
+        section->size = read_le(sh + 0x14, 4);
+        section->link = (uint32_t)read_le(sh + 0x18, 4);
+    }
+
+    return section->type == ELF_SHT_NOBITS || image_has(decoder, section->offset, section->size);
+}
+
+static size_t section_count(const struct decoder *decoder)
+{
+    return (size_t)read_le(decoder->image + (is_elf64(decoder) ? 0x3C : 0x30), 2);
+}
+
+/**
+ * \brief Finds the address of a symbol in the given symbol table section.
+ */
+static bool find_symbol(const struct decoder *decoder, const struct elf_section *symtab,
+                        const char *name, uint64_t *value)
+{
+    struct elf_section strtab;
+    const bool elf64 = is_elf64(decoder);
+    const size_t entry_size = elf64 ? 24 : 16;
+    const size_t name_size = strlen(name) + 1;
+
+    if (!read_section(decoder, symtab->link, &strtab)) {
+        return false;
+    }
+
+    for (uint64_t offset = 0; offset + entry_size <= symtab->size; offset += entry_size) {
+        const unsigned char *sym = decoder->image + symtab->offset + offset;
+        const uint64_t sym_name = read_le(sym, 4);
+
+        if (sym_name >= strtab.size || strtab.size - sym_name < name_size ||
+            memcmp(decoder->image + strtab.offset + sym_name, name, name_size) != 0) {
+            continue;
+        }
+
+        *value = elf64 ? read_le(sym + 8, 8) : read_le(sym + 4, 4);
+
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * \brief Finds a null terminated string at the given address of the program image.
+ */
+static const char *find_string(const struct decoder *decoder, const uint64_t addr)
+{
+    struct elf_section section;
+
+    for (size_t i = 0; i < section_count(decoder); ++i) {
+        if (!read_section(decoder, i, &section) || (section.flags & ELF_SHF_ALLOC) == 0 ||
+            section.type == ELF_SHT_NOBITS || addr < section.addr ||
+            addr - section.addr >= section.size) {
+            continue;
+        }
+
+        const char *str = (const char *)decoder->image + section.offset + (addr - section.addr);
+
+        if (memchr(str, '\0', (size_t)(section.size - (addr - section.addr))) == NULL) {
+            return NULL;
+        }
+
+        return str;
+    }
+
+    return NULL;
+}
+
+static enum decoder_ret_code load_image(struct decoder *decoder, const char *elf_path)
+{
+    FILE *file = fopen(elf_path, "rb");
+
+    if (file == NULL) {
+        return DECODER_RET_CODE_IO_ERROR;
+    }
+
+    enum decoder_ret_code ret = DECODER_RET_CODE_IO_ERROR;
+    size_t capacity = 0;
+    size_t read = 0;
+
+    do {
+        if (read == capacity) {
+            capacity = capacity == 0 ? 64 * 1024 : capacity * 2;
+
+            unsigned char *image = realloc(decoder->image, capacity);
+
+            if (image == NULL) {
+                break;
+            }
+
+            decoder->image = image;
+        }
+
+        read += fread(decoder->image + read, 1, capacity - read, file);
+    } while (read == capacity);
+
+    if (read < capacity && ferror(file) == 0) {
+        decoder->image_size = read;
+        ret = DECODER_RET_CODE_OK;
+    }
+
+    fclose(file);
+
+    return ret;
+}
+
+enum decoder_ret_code decoder_init(struct decoder *decoder, const char *elf_path)
+{
+    static const unsigned char elf_magic[] = {0x7F, 'E', 'L', 'F'};
+
+    memset(decoder, 0, sizeof(*decoder));
+
+    enum decoder_ret_code ret = load_image(decoder, elf_path);
+
+    if (ret != DECODER_RET_CODE_OK) {
+        decoder_free(decoder);
+        return ret;
+    }
+
+    ret = DECODER_RET_CODE_INVALID_ELF;
+
+    if (decoder->image_size < 0x40 || memcmp(decoder->image, elf_magic, sizeof(elf_magic)) != 0 ||
+        (decoder->image[4] != ELF_CLASS_32 && decoder->image[4] != ELF_CLASS_64) ||
+        decoder->image[5] != ELF_DATA_LSB) {
+        decoder_free(decoder);
+        return ret;
+    }
+
+    struct elf_section section;
+
+    // the static symbol table is preferred, the dynamic one is used for stripped shared objects
+    for (size_t i = 0; i < section_count(decoder) && ret != DECODER_RET_CODE_OK; ++i) {
+        if (read_section(decoder, i, &section) && section.type == ELF_SHT_SYMTAB &&
+            find_symbol(decoder, &section, "mulog_wire_anchor", &decoder->anchor)) {
+            ret = DECODER_RET_CODE_OK;
+        }
+    }
+
+    for (size_t i = 0; i < section_count(decoder) && ret != DECODER_RET_CODE_OK; ++i) {
+        if (read_section(decoder, i, &section) && section.type == ELF_SHT_DYNSYM &&
+            find_symbol(decoder, &section, "mulog_wire_anchor", &decoder->anchor)) {
+            ret = DECODER_RET_CODE_OK;
+        }
+    }
+
+    if (ret != DECODER_RET_CODE_OK) {
+        decoder_free(decoder);
+    }
+
+    return ret;
+}
+
+void decoder_free(struct decoder *decoder)
+{
+    free(decoder->image);
+    decoder->image = NULL;
+    decoder->image_size = 0;
+    decoder->anchor = 0;
+    decoder->timestamp = 0;
+}
+
+/**
+ * \brief Formats a log line prefix the same way the library does in text mode.
+ */
+static int format_prefix(char *buf, const size_t buf_size, const enum mulog_log_level level,
+                         const unsigned long timestamp_ms)
+{
+    const char *level_str[] = {
+        [MULOG_LOG_LVL_TRACE] = MULOG_TRACE_LVL, [MULOG_LOG_LVL_DEBUG] = MULOG_DEBUG_LVL,
+        [MULOG_LOG_LVL_INFO] = MULOG_INFO_LVL,   [MULOG_LOG_LVL_WARNING] = MULOG_WARNING_LVL,
+        [MULOG_LOG_LVL_ERROR] = MULOG_ERROR_LVL,
+    };
+#if defined(MULOG_ENABLE_TIMESTAMP) && MULOG_ENABLE_TIMESTAMP == 1
+    const unsigned long ms = timestamp_ms % 1000;
+    const unsigned long sec = timestamp_ms / 1000;
+
+    return snprintf_(buf, buf_size, "%07lu.%03lu %s: ", sec, ms, level_str[level]);
+#else
+    UNUSED(timestamp_ms);
+    return snprintf_(buf, buf_size, "%s: ", level_str[level]);
+#endif /* MULOG_ENABLE_TIMESTAMP */
+}
+
+int decoder_decode(struct decoder *decoder, const void *data, const size_t size, char *line,
+                   const size_t line_size, size_t *consumed)
+{
+    struct wire_record record;
+    const int record_size = wire_decode_record(data, size, &record);
+
+    if (record_size == 0) {
+        return DECODER_RET_CODE_INCOMPLETE;
+    }
+
+    if (record_size < 0) {
+        return DECODER_RET_CODE_MALFORMED;
+    }
+
+    *consumed = (size_t)record_size;
+    decoder->timestamp += record.timestamp_delta;
+
+    const char *fmt = find_string(decoder, decoder->anchor + (uint64_t)record.fmt_id);
+
+    if (fmt == NULL) {
+        return DECODER_RET_CODE_UNKNOWN_FORMAT;
+    }
+
+    const int prefix_size = format_prefix(line, line_size, record.level, decoder->timestamp);
+
+    if (prefix_size < 0) {
+        return DECODER_RET_CODE_MALFORMED;
+    }
+
+    size_t offset = (size_t)prefix_size < line_size ? (size_t)prefix_size : line_size;
+    const int message_size = args_decode(line + offset, line_size - offset, fmt, record.args,
+                                         record.args_size);
+
+    if (message_size < 0) {
+        return DECODER_RET_CODE_MALFORMED;
+    }
+
+    offset += (size_t)message_size;
+
+    if (offset < line_size) {
+        offset += (size_t)snprintf_(line + offset, line_size - offset, "%s",
+                                    MULOG_LOG_LINE_TERMINATION);
+    }
+
+    return (int)(offset < line_size ? offset : line_size - 1);
+}
@@ -0,0 +1,80 @@
+/**
+ * \file
+ * \brief Host decoder for binary log records
+ * \author Vladimir Petrigo
+ */
+
+#ifndef DECODER_H
+#define DECODER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum decoder_ret_code {
+    DECODER_RET_CODE_OK = 0,
+    DECODER_RET_CODE_INCOMPLETE = -1,
+    DECODER_RET_CODE_MALFORMED = -2,
+    DECODER_RET_CODE_UNKNOWN_FORMAT = -3,
+    DECODER_RET_CODE_IO_ERROR = -4,
+    DECODER_RET_CODE_INVALID_ELF = -5,
+};
+
+/**
+ * \brief Binary log records decoder
+ *
+ * Format strings are looked up in the ELF file of the program that produced the records, so the
+ * decoder must be given the exact program image that was running. The ELF file must contain the
+ * symbol table.
+ */
+struct decoder {
+    unsigned char *image;    /**< Program ELF file contents */
+    size_t image_size;       /**< Program ELF file size */
+    uint64_t anchor;         /**< Address of the format string ID anchor in the program image */
+    unsigned long timestamp; /**< Timestamp of the last decoded record */
+};
+
+/**
+ * \brief Loads the program ELF file the records are decoded for.
+ *
+ * \param decoder Decoder to initialize
+ * \param elf_path Path to the program ELF file
+ * \return DECODER_RET_CODE_OK on success, or an error code
+ */
+enum decoder_ret_code decoder_init(struct decoder *decoder, const char *elf_path);
+
+/**
+ * \brief Releases the resources of the decoder.
+ *
+ * \param decoder Decoder to free
+ */
+void decoder_free(struct decoder *decoder);
+
+/**
+ * \brief Decodes a record from the beginning of a byte stream into a text log line.
+ *
+ * The line is the same as the one the library outputs when the binary output is disabled: the
+ * timestamp and the log level prefix, the message and the line termination. The line is
+ * truncated to the buffer size and always null terminated.
+ *
+ * \param decoder Decoder to use
+ * \param data Byte stream
+ * \param size Size of the byte stream in bytes
+ * \param line Buffer to decode the line into
+ * \param line_size Size of the line buffer in bytes
+ * \param[out] consumed Number of bytes of the stream taken by the record, set if the stream
+ *                      contains a complete record
+ * \return Length of the line, or an error code. DECODER_RET_CODE_INCOMPLETE is returned if more
+ *         data is required to decode a record.
+ */
+int decoder_decode(struct decoder *decoder, const void *data, size_t size, char *line,
+                   size_t line_size, size_t *consumed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DECODER_H */
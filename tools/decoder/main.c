@@ -0,0 +1,112 @@
+/**
+ * \file
+ * \brief Host tool that converts binary log records into text log lines
+ * \author Vladimir Petrigo
+ */
+
+#include "decoder.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define INPUT_BUFFER_SIZE (64 * 1024)
+#define LINE_BUFFER_SIZE  4096
+
+// required here to facilitate libprintf dependency requirements
+void putchar_(char c)
+{
+    (void)c;
+}
+
+/**
+ * \brief Decodes all complete records in the input buffer.
+ *
+ * \return Number of bytes consumed from the input buffer
+ */
+static size_t decode_records(struct decoder *decoder, const unsigned char *data, const size_t size)
+{
+    static char line[LINE_BUFFER_SIZE];
+    size_t offset = 0;
+
+    while (offset < size) {
+        size_t consumed = 0;
+        const int ret =
+            decoder_decode(decoder, data + offset, size - offset, line, sizeof(line), &consumed);
+
+        if (ret == DECODER_RET_CODE_INCOMPLETE) {
+            break;
+        }
+
+        if (ret == DECODER_RET_CODE_MALFORMED) {
+            // skip a byte and try to find the next record boundary
+            fprintf(stderr, "mulog_decode: malformed record at stream offset %zu\n", offset);
+            ++offset;
+            continue;
+        }
+
+        offset += consumed;
+
+        if (ret == DECODER_RET_CODE_UNKNOWN_FORMAT) {
+            fprintf(stderr, "mulog_decode: unknown format string, wrong program file?\n");
+            continue;
+        }
+
+        fwrite(line, 1, (size_t)ret, stdout);
+    }
+
+    return offset;
+}
+
+int main(int argc, char **argv)
+{
+    static unsigned char input[INPUT_BUFFER_SIZE];
+
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "usage: %s <program ELF file> [binary log file]\n", argv[0]);
+        fprintf(stderr, "Binary log records are read from stdin if no log file is given\n");
+        return 2;
+    }
+
+    struct decoder decoder;
+    const enum decoder_ret_code ret = decoder_init(&decoder, argv[1]);
+
+    if (ret != DECODER_RET_CODE_OK) {
+        fprintf(stderr, "mulog_decode: unable to load %s: %s\n", argv[1],
+                ret == DECODER_RET_CODE_IO_ERROR ? "read error"
+                                                 : "not an ELF file with mulog symbols");
+        return 1;
+    }
+
+    FILE *in = argc == 3 ? fopen(argv[2], "rb") : stdin;
+
+    if (in == NULL) {
+        fprintf(stderr, "mulog_decode: unable to open %s\n", argv[2]);
+        decoder_free(&decoder);
+        return 1;
+    }
+
+    size_t size = 0;
+    size_t read;
+
+    while ((read = fread(input + size, 1, sizeof(input) - size, in)) > 0) {
+        size += read;
+
+        const size_t consumed = decode_records(&decoder, input, size);
+
+        memmove(input, input + consumed, size - consumed);
+        size -= consumed;
+        fflush(stdout);
+    }
+
+    if (size > 0) {
+        fprintf(stderr, "mulog_decode: %zu trailing bytes do not form a complete record\n", size);
+    }
+
+    if (in != stdin) {
+        fclose(in);
+    }
+
+    decoder_free(&decoder);
+
+    return 0;
+}